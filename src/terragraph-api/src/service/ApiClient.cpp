@@ -26,12 +26,7 @@ using facebook::terragraph::stats::NMSConsts;
 // from RequestFunction signature
 using CLIENT = ApiClient*;
 using JSON = const std::string&;
-using RESPONSE = std::optional<std::string>;
-
-DEFINE_int32(
-    zmq_rcv_timeout_ms,
-    15000,
-    "The amount of time to wait for ZMQ responses (in milliseconds)");
+using RESPONSE = folly::SemiFuture<std::optional<std::string>>;
 
 DEFINE_string(
     api_role_prefix,
@@ -43,7 +38,7 @@ namespace terragraph {
 namespace api {
 
 ApiClient::RequestFunction::RequestFunction(
-    std::function<std::optional<std::string>(
+    std::function<folly::SemiFuture<std::optional<std::string>>(
         ApiClient* apiClient, const std::string& json)> function,
     thrift::ApiCategory category,
     thrift::ApiLevel level,
@@ -54,7 +49,7 @@ ApiClient::RequestFunction::RequestFunction(
       method_(method) {}
 
 ApiClient::RequestFunction::RequestFunction(
-    std::function<std::optional<std::string>(
+    std::function<folly::SemiFuture<std::optional<std::string>>(
         ApiClient* apiClient, const std::string& json)> function,
     RequestFunction::HTTPMethod method)
     : function_(function),
@@ -119,7 +114,7 @@ ApiClient::RequestFunction::hasPermission(
   return false;
 }
 
-std::optional<std::string>
+folly::SemiFuture<std::optional<std::string>>
 ApiClient::RequestFunction::applyFunction(
     ApiClient* apiClient, const std::string& body) {
   return function_(apiClient, body);
@@ -1233,11 +1228,12 @@ ApiClient::MethodMap ApiClient::methods_ = [] {
    * @apiPermission MANAGEMENT_READ
    * @apiGroup Management
    *
-   * @apiDescription Retrieves the latest status reports to the controller from all nodes in the network.
+   * @apiDescription Retrieves the latest status reports to the controller from all nodes in the network. To poll for changes only, pass the "generation" of the previous response as "sinceGeneration".
    *
    * @apiUse GetStatusDump
    * @apiExample {curl} Example:
    *    curl -i http://localhost:443/api/v2/getCtrlStatusDump
+   *    curl -id '{"sinceGeneration": 1640206000000123}' http://localhost:443/api/v2/getCtrlStatusDump
    * @apiUse StatusDump_SUCCESS
    * @apiUse StatusReport_SUCCESS
    * @apiUse UpgradeStatus_SUCCESS
@@ -3526,20 +3522,11 @@ ApiClient::get(const std::string& methodName) {
   return iter->second;
 }
 
-ApiClient::ApiClient(
-    fbzmq::Context& context,
-    const std::string& ctrlRouterUrl,
-    const std::string& aggrRouterUrl,
-    const std::string& zmqId)
-    : ctrlSock_{context, fbzmq::IdentityString{zmqId}},
-      aggrSock_{context, fbzmq::IdentityString{zmqId}},
-      ctrlRouterUrl_(ctrlRouterUrl),
-      aggrRouterUrl_(aggrRouterUrl),
-      zmqId_(zmqId) {
-}
+ApiClient::ApiClient(ZmqClientPool& zmqClientPool)
+    : zmqClientPool_(zmqClientPool) {}
 
 template <class ThriftRequestType, class ThriftResponseType>
-std::optional<std::string>
+folly::SemiFuture<std::optional<std::string>>
 ApiClient::makeCtrlRequest(
     const std::string& json,
     const std::string& receiverId,
@@ -3547,44 +3534,50 @@ ApiClient::makeCtrlRequest(
   // Try to deserialize the request (JSON -> Thrift)
   auto thriftRequest = deserializeFromJson<ThriftRequestType>(json);
   if (!thriftRequest) {
-    return std::nullopt;
-  }
-
-  // Connect to the controller (if necessary)
-  connectToCtrl();
-  if (!ctrlConnected_) {
-    return std::nullopt;
+    return folly::makeSemiFuture(std::optional<std::string>());
   }
 
   // Send the ZMQ request to the controller
-  sendToCtrl(receiverId, mType, thriftRequest.value());
-
-  // Wait for a reply
-  auto thriftResponse = receiveFromCtrl();
-  if (!thriftResponse) {
-    return std::nullopt;
-  }
-
-  // Deserialize the response and serialize it to the client (Thrift -> JSON)
-  if (thriftResponse->mType == thrift::MessageType::E2E_ACK) {
-    // Check if the response is an E2EAck (the default failure class)
-    auto ack = deserializeFromThrift<thrift::E2EAck>(thriftResponse->value);
-    if (ack) {
-      return serializeToJson<thrift::E2EAck>(ack.value());
-    }
-  } else {
-    // Try the supplied Thrift struct
-    auto msg = deserializeFromThrift<ThriftResponseType>(thriftResponse->value);
-    if (msg) {
-      return serializeToJson<ThriftResponseType>(msg.value());
-    }
-  }
-  LOG(ERROR) << "Thrift deserialization failed.";
-  return std::nullopt;
+  thrift::Message msg;
+  msg.mType = mType;
+  msg.value = fbzmq::util::writeThriftObjStr(thriftRequest.value(), serializer_);
+  return zmqClientPool_
+      .request(
+          ZmqClientPool::Peer::CTRL,
+          receiverId,
+          fbzmq::util::writeThriftObjStr(msg, serializer_))
+      .deferValue([this](std::optional<std::string> data) {
+        auto thriftResponse = parseCtrlReply(data);
+        if (!thriftResponse) {
+          return std::optional<std::string>();
+        }
+
+        // Deserialize the response and serialize it to the client
+        // (Thrift -> JSON)
+        if (thriftResponse->mType == thrift::MessageType::E2E_ACK) {
+          // Check if the response is an E2EAck (the default failure class)
+          auto ack =
+              deserializeFromThrift<thrift::E2EAck>(thriftResponse->value);
+          if (ack) {
+            return std::make_optional(
+                serializeToJson<thrift::E2EAck>(ack.value()));
+          }
+        } else {
+          // Try the supplied Thrift struct
+          auto msg =
+              deserializeFromThrift<ThriftResponseType>(thriftResponse->value);
+          if (msg) {
+            return std::make_optional(
+                serializeToJson<ThriftResponseType>(msg.value()));
+          }
+        }
+        LOG(ERROR) << "Thrift deserialization failed.";
+        return std::optional<std::string>();
+      });
 }
 
 template <class ThriftRequestType, class ThriftResponseType>
-std::optional<std::string>
+folly::SemiFuture<std::optional<std::string>>
 ApiClient::makeAggrRequest(
     const std::string& json,
     const std::string& receiverId,
@@ -3592,107 +3585,58 @@ ApiClient::makeAggrRequest(
   // Try to deserialize the request (JSON -> Thrift)
   auto thriftRequest = deserializeFromJson<ThriftRequestType>(json);
   if (!thriftRequest) {
-    return std::nullopt;
-  }
-
-  // Connect to the aggregator (if necessary)
-  connectToAggr();
-  if (!aggrConnected_) {
-    return std::nullopt;
+    return folly::makeSemiFuture(std::optional<std::string>());
   }
 
   // Send the ZMQ request to the aggregator
-  sendToAggr(receiverId, mType, thriftRequest.value());
-
-  // Wait for a reply
-  auto thriftResponse = receiveFromAggr();
-  if (!thriftResponse) {
-    return std::nullopt;
-  }
-
-  // Deserialize the response and serialize it to the client (Thrift -> JSON)
-  if (thriftResponse->mType == thrift::AggrMessageType::AGGR_ACK) {
-    // Check if the response is an AggrAck (the default failure class)
-    auto ack = deserializeFromThrift<thrift::AggrAck>(thriftResponse->value);
-    if (ack) {
-      return serializeToJson<thrift::AggrAck>(ack.value());
-    }
-  } else {
-    // Try the supplied Thrift struct
-    auto msg = deserializeFromThrift<ThriftResponseType>(thriftResponse->value);
-    if (msg) {
-      return serializeToJson<ThriftResponseType>(msg.value());
-    }
-  }
-  LOG(ERROR) << "Thrift deserialization failed.";
-  return std::nullopt;
-}
-
-template <class T>
-void
-ApiClient::sendToCtrl(
-    const std::string& receiverId,
-    const thrift::MessageType& mType,
-    const T& obj) {
-  thrift::Message msg;
-  msg.mType = mType;
-  msg.value = fbzmq::util::writeThriftObjStr(obj, serializer_);
-
-  const auto res = ctrlSock_.sendMultiple(
-      fbzmq::Message(),
-      fbzmq::Message::from(receiverId).value(),
-      fbzmq::Message::from(zmqId_).value(),
-      fbzmq::Message::fromThriftObj(msg, serializer_).value());
-
-  if (res.hasError()) {
-    LOG(FATAL) << "Error sending "
-               << TEnumMapFactory<thrift::MessageType>
-               ::makeValuesToNamesMap().at(mType) << " to :" << receiverId
-               << " from " << zmqId_ << ": "
-               << res.error();
-  }
-}
-
-template <class T>
-void
-ApiClient::sendToAggr(
-    const std::string& receiverId,
-    const thrift::AggrMessageType& mType,
-    const T& obj) {
   thrift::AggrMessage msg;
   msg.mType = mType;
-  msg.value = fbzmq::util::writeThriftObjStr(obj, serializer_);
-
-  const auto res = aggrSock_.sendMultiple(
-      fbzmq::Message(),
-      fbzmq::Message::from(receiverId).value(),
-      fbzmq::Message::from(zmqId_).value(),
-      fbzmq::Message::fromThriftObj(msg, serializer_).value());
-
-  if (res.hasError()) {
-    LOG(FATAL) << "Error sending "
-               << TEnumMapFactory<thrift::AggrMessageType>
-                  ::makeValuesToNamesMap().at(mType) << " to " << receiverId
-                  << " from " << zmqId_ << ": " << res.error();
-  }
+  msg.value = fbzmq::util::writeThriftObjStr(thriftRequest.value(), serializer_);
+  return zmqClientPool_
+      .request(
+          ZmqClientPool::Peer::AGGR,
+          receiverId,
+          fbzmq::util::writeThriftObjStr(msg, serializer_))
+      .deferValue([this](std::optional<std::string> data) {
+        auto thriftResponse = parseAggrReply(data);
+        if (!thriftResponse) {
+          return std::optional<std::string>();
+        }
+
+        // Deserialize the response and serialize it to the client
+        // (Thrift -> JSON)
+        if (thriftResponse->mType == thrift::AggrMessageType::AGGR_ACK) {
+          // Check if the response is an AggrAck (the default failure class)
+          auto ack =
+              deserializeFromThrift<thrift::AggrAck>(thriftResponse->value);
+          if (ack) {
+            return std::make_optional(
+                serializeToJson<thrift::AggrAck>(ack.value()));
+          }
+        } else {
+          // Try the supplied Thrift struct
+          auto msg =
+              deserializeFromThrift<ThriftResponseType>(thriftResponse->value);
+          if (msg) {
+            return std::make_optional(
+                serializeToJson<ThriftResponseType>(msg.value()));
+          }
+        }
+        LOG(ERROR) << "Thrift deserialization failed.";
+        return std::optional<std::string>();
+      });
 }
 
 std::optional<thrift::Message>
-ApiClient::receiveFromCtrl() {
-  fbzmq::Message minion, senderApp, data;
-  auto res = ctrlSock_.recvMultipleTimeout(
-      std::chrono::milliseconds(FLAGS_zmq_rcv_timeout_ms),
-      minion,
-      senderApp,
-      data);
-  if (res.hasError()) {
-    LOG(ERROR) << "Error reading message from controller: " << res.error();
+ApiClient::parseCtrlReply(const std::optional<std::string>& data) {
+  if (!data) {
+    LOG(ERROR) << "No response received from controller";
     return std::nullopt;
   }
 
-  auto message = data.readThriftObj<thrift::Message>(serializer_);
-  if (message.hasError()) {
-    LOG(ERROR) << "Error parsing message from controller: " << res.error();
+  auto message = deserializeFromThrift<thrift::Message>(data.value());
+  if (!message) {
+    LOG(ERROR) << "Error parsing message from controller";
     return std::nullopt;
   }
 
@@ -3704,25 +3648,19 @@ ApiClient::receiveFromCtrl() {
     return std::nullopt;
   }
 
-  return message.value();
+  return message;
 }
 
 std::optional<thrift::AggrMessage>
-ApiClient::receiveFromAggr() {
-  fbzmq::Message agent, senderApp, data;
-  auto res = aggrSock_.recvMultipleTimeout(
-      std::chrono::milliseconds(FLAGS_zmq_rcv_timeout_ms),
-      agent,
-      senderApp,
-      data);
-  if (res.hasError()) {
-    LOG(ERROR) << "Error reading message from aggregator: " << res.error();
+ApiClient::parseAggrReply(const std::optional<std::string>& data) {
+  if (!data) {
+    LOG(ERROR) << "No response received from aggregator";
     return std::nullopt;
   }
 
-  auto message = data.readThriftObj<thrift::AggrMessage>(serializer_);
-  if (message.hasError()) {
-    LOG(ERROR) << "Error parsing message from aggregator: " << res.error();
+  auto message = deserializeFromThrift<thrift::AggrMessage>(data.value());
+  if (!message) {
+    LOG(ERROR) << "Error parsing message from aggregator";
     return std::nullopt;
   }
 
@@ -3734,7 +3672,7 @@ ApiClient::receiveFromAggr() {
     return std::nullopt;
   }
 
-  return message.value();
+  return message;
 }
 
 template <class T>
@@ -3764,34 +3702,6 @@ ApiClient::deserializeFromThrift(const std::string& buf) {
   }
 }
 
-void
-ApiClient::connectToCtrl() {
-  if (ctrlConnected_ || ctrlRouterUrl_.empty()) {
-    return;
-  }
-  auto res = ctrlSock_.connect(fbzmq::SocketUrl{ctrlRouterUrl_});
-  if (res) {
-    ctrlConnected_ = true;
-  } else {
-    LOG(ERROR) << "Error connecting to controller URL '" << ctrlRouterUrl_
-               << "': " << res.error();
-  }
-}
-
-void
-ApiClient::connectToAggr() {
-  if (aggrConnected_ || aggrRouterUrl_.empty()) {
-    return;
-  }
-  auto res = aggrSock_.connect(fbzmq::SocketUrl{aggrRouterUrl_});
-  if (res) {
-    aggrConnected_ = true;
-  } else {
-    LOG(ERROR) << "Error connecting to aggregator URL '" << aggrRouterUrl_
-               << "': " << res.error();
-  }
-}
-
 } // namesapce api
 } // namespace terragraph
 } // namespace facebook
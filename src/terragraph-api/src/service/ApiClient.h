@@ -7,6 +7,7 @@
 #pragma once
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/futures/Future.h>
 #include <functional>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <unordered_map>
@@ -16,6 +17,8 @@
 #include "e2e/if/gen-cpp2/Controller_types.h"
 #include "stats/if/gen-cpp2/Aggregator_types.h"
 
+#include "ZmqClientPool.h"
+
 namespace facebook {
 namespace terragraph {
 namespace api {
@@ -26,6 +29,10 @@ namespace api {
  * This class translates JSON-encoded Thrift requests into ZMQ/Thrift calls
  * to the controller or aggregator, then returns a JSON-serialized response.
  *
+ * Requests are sent over the shared ZmqClientPool, and responses are returned
+ * asynchronously as futures. The deferred Thrift-to-JSON conversion runs on
+ * whichever executor the caller attaches (normally the proxygen IO thread).
+ *
  * NOTE: This class is not thread-safe (aside from static map access).
  */
 class ApiClient {
@@ -39,14 +46,14 @@ class ApiClient {
     };
 
     RequestFunction(
-        std::function<std::optional<std::string>(
+        std::function<folly::SemiFuture<std::optional<std::string>>(
             ApiClient* apiClient, const std::string& json)> function,
         thrift::ApiCategory category,
         thrift::ApiLevel level,
         HTTPMethod method);
 
     RequestFunction(
-        std::function<std::optional<std::string>(
+        std::function<folly::SemiFuture<std::optional<std::string>>(
             ApiClient* apiClient, const std::string& json)> function,
         HTTPMethod method);
 
@@ -54,7 +61,7 @@ class ApiClient {
     bool hasPermission(const std::vector<std::string>& roles);
 
     // Run the lambda function
-    std::optional<std::string> applyFunction(
+    folly::SemiFuture<std::optional<std::string>> applyFunction(
         ApiClient* apiClient, const std::string& body);
 
     // Returns true if function performs a write operation to the network
@@ -68,7 +75,7 @@ class ApiClient {
 
    private:
     // Underlying lambda function
-    std::function<std::optional<std::string>(
+    std::function<folly::SemiFuture<std::optional<std::string>>(
         ApiClient* apiClient, const std::string& json)>
         function_;
 
@@ -82,11 +89,7 @@ class ApiClient {
     HTTPMethod method_;
   };
 
-  ApiClient(
-      fbzmq::Context& context,
-      const std::string& ctrlRouterUrl,
-      const std::string& aggrRouterUrl,
-      const std::string& zmqId);
+  explicit ApiClient(ZmqClientPool& zmqClientPool);
 
   // Check if a given method exists
   static bool contains(const std::string& methodName);
@@ -104,37 +107,25 @@ class ApiClient {
 
   // Make a request to the controller, returning the JSON response if successful
   template <class ThriftRequestType, class ThriftResponseType>
-  std::optional<std::string> makeCtrlRequest(
+  folly::SemiFuture<std::optional<std::string>> makeCtrlRequest(
       const std::string& json,
       const std::string& receiverId,
       const thrift::MessageType& mType);
 
   // Make a request to the aggregator, returning the JSON response if successful
   template <class ThriftRequestType, class ThriftResponseType>
-  std::optional<std::string> makeAggrRequest(
+  folly::SemiFuture<std::optional<std::string>> makeAggrRequest(
       const std::string& json,
       const std::string& receiverId,
       const thrift::AggrMessageType& mType);
 
-  // Send the object to the controller
-  template <class T>
-  void sendToCtrl(
-      const std::string& receiverId,
-      const thrift::MessageType& mType,
-      const T& obj);
-
-  // Send the object to the aggregator
-  template <class T>
-  void sendToAggr(
-      const std::string& receiverId,
-      const thrift::AggrMessageType& mType,
-      const T& obj);
-
-  // Receive an object from the controller
-  std::optional<thrift::Message> receiveFromCtrl();
+  // Parse a raw reply from the controller
+  std::optional<thrift::Message> parseCtrlReply(
+      const std::optional<std::string>& data);
 
-  // Receive an object from the aggregator
-  std::optional<thrift::AggrMessage> receiveFromAggr();
+  // Parse a raw reply from the aggregator
+  std::optional<thrift::AggrMessage> parseAggrReply(
+      const std::optional<std::string>& data);
 
   // Serialize an object to JSON
   template <class T>
@@ -148,32 +139,8 @@ class ApiClient {
   template <class T>
   std::optional<T> deserializeFromThrift(const std::string& buf);
 
-  // Tries to connect to the controller
-  void connectToCtrl();
-
-  // Tries to connect to the aggregator
-  void connectToAggr();
-
-  // The zmq socket to talk to the controller
-  fbzmq::Socket<ZMQ_DEALER, fbzmq::ZMQ_CLIENT> ctrlSock_;
-
-  // The zmq socket to talk to the aggregator
-  fbzmq::Socket<ZMQ_DEALER, fbzmq::ZMQ_CLIENT> aggrSock_;
-
-  // The ZMQ socket URL of the controller
-  const std::string ctrlRouterUrl_;
-
-  // The ZMQ socket URL of the aggregator
-  const std::string aggrRouterUrl_;
-
-  // The zmq id
-  const std::string zmqId_;
-
-  // Whether the controller is connected
-  bool ctrlConnected_{false};
-
-  // Whether the aggregator is connected
-  bool aggrConnected_{false};
+  // The shared controller/aggregator socket pool
+  ZmqClientPool& zmqClientPool_;
 
   // The serializer for all the messages
   apache::thrift::CompactSerializer serializer_;
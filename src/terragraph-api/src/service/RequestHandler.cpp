@@ -11,6 +11,7 @@
 #include <ctime>
 
 #include <folly/dynamic.h>
+#include <folly/io/async/EventBaseManager.h>
 #include <jwt/jwt.hpp>
 #include <proxygen/httpserver/ResponseBuilder.h>
 
@@ -25,15 +26,12 @@ namespace api {
 
 RequestHandler::RequestHandler(
     const std::string& urlPrefix,
-    fbzmq::Context& context,
-    const std::string& ctrlRouterUrl,
-    const std::string& aggrRouterUrl,
-    const std::string& zmqId,
+    ZmqClientPool& zmqClientPool,
     const std::string& publicKey,
     const std::shared_ptr<AuditLogger>& auditor)
     : urlPrefix_(urlPrefix),
       publicKey_(publicKey),
-      apiClient_{context, ctrlRouterUrl, aggrRouterUrl, zmqId},
+      apiClient_{zmqClientPool},
       auditor_{auditor} {}
 
 RequestHandler::VersionInfo
@@ -188,26 +186,55 @@ RequestHandler::onEOM() noexcept {
     return sendErrorResponse("Only GET and POST methods are accepted");
   }
 
-  // Make the request and return the response to the client
-  auto resp = makeMethodRequest->applyFunction(&apiClient_, requestBody);
+  // Audit log entry to record if a write operation succeeds
+  folly::dynamic auditEntry = folly::dynamic::object
+      ("username", requestUsername)
+      ("email", requestEmail)
+      ("client", requestClient)
+      ("path", requestPath)
+      ("body", requestBody);
+
+  // Make the request, and return the response to the client on this
+  // EventBase once it arrives
+  auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+  bool isWriteOperation = makeMethodRequest->isWriteOperation();
+  requestInFlight_ = true;
+  folly::futures::detachOn(
+      folly::getKeepAliveToken(evb),
+      makeMethodRequest->applyFunction(&apiClient_, requestBody)
+          .defer([this, isWriteOperation, auditEntry = std::move(auditEntry)](
+                     folly::Try<std::optional<std::string>>&& resp) mutable {
+            onMethodResponse(
+                resp.hasValue() ? std::move(resp.value()) : std::nullopt,
+                isWriteOperation,
+                std::move(auditEntry));
+          }));
+}
+
+void
+RequestHandler::onMethodResponse(
+    std::optional<std::string> resp,
+    bool isWriteOperation,
+    folly::dynamic auditEntry) {
+  requestInFlight_ = false;
+  if (connectionClosed_) {
+    delete this;
+    return;
+  }
+
   if (!resp) {
     return sendServiceUnavailableResponse("No response from method");
   }
 
   // Reflect network changes in audit log
-  if (makeMethodRequest->isWriteOperation()) {
+  if (isWriteOperation) {
     // Get unix timestamp for audit log entry
     uint64_t req_timestamp =
         std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch())
             .count();
-    auditor_->logNetworkChange(folly::dynamic::object
-        ("time", req_timestamp)
-        ("username", requestUsername)
-        ("email", requestEmail)
-        ("client", requestClient)
-        ("path", requestPath)
-        ("body", requestBody));
+    auditEntry["time"] = req_timestamp;
+    auditor_->logNetworkChange(std::move(auditEntry));
   }
 
   ResponseBuilder(downstream_)
@@ -229,6 +256,11 @@ RequestHandler::requestComplete() noexcept {
 
 void
 RequestHandler::onError(ProxygenError /*err*/) noexcept {
+  if (requestInFlight_) {
+    // Defer deletion until the response callback runs
+    connectionClosed_ = true;
+    return;
+  }
   delete this;
 }
 
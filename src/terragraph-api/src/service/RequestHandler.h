@@ -7,6 +7,7 @@
 #pragma once
 
 #include <folly/Memory.h>
+#include <folly/dynamic.h>
 #include <proxygen/httpserver/RequestHandler.h>
 
 #include "ApiClient.h"
@@ -18,15 +19,16 @@ namespace api {
 
 /**
  * Handler for all proxygen requests.
+ *
+ * API methods are dispatched asynchronously over the shared ZmqClientPool; the
+ * response is sent from the handler's own EventBase when the reply arrives, so
+ * proxygen IO threads are never blocked on the controller or aggregator.
  */
 class RequestHandler : public proxygen::RequestHandler {
  public:
   explicit RequestHandler(
       const std::string& urlPrefix,
-      fbzmq::Context& context,
-      const std::string& ctrlRouterUrl,
-      const std::string& aggrRouterUrl,
-      const std::string& zmqId,
+      ZmqClientPool& zmqClientPool,
       const std::string& publicKey,
       const std::shared_ptr<AuditLogger>& auditor);
 
@@ -61,6 +63,12 @@ class RequestHandler : public proxygen::RequestHandler {
       const proxygen::HTTPMethod proxygenMethod,
       ApiClient::RequestFunction::HTTPMethod requestMethod);
 
+  // Called on this handler's EventBase when the API method completes.
+  void onMethodResponse(
+      std::optional<std::string> resp,
+      bool isWriteOperation,
+      folly::dynamic auditEntry);
+
   // Send a 400 error (Bad Request).
   void sendErrorResponse(const std::string& reason);
 
@@ -80,7 +88,7 @@ class RequestHandler : public proxygen::RequestHandler {
   const std::string publicKey_;
 
   // The API client
-    ApiClient apiClient_;
+  ApiClient apiClient_;
 
   // The HTTP headers
   std::unique_ptr<proxygen::HTTPMessage> message_;
@@ -90,6 +98,13 @@ class RequestHandler : public proxygen::RequestHandler {
 
   // AuditLogger instance for this request to log network changes to
   const std::shared_ptr<AuditLogger> auditor_;
+
+  // Whether an API method is awaiting a response
+  bool requestInFlight_{false};
+
+  // Whether the connection was closed while a request was in flight (the
+  // handler is deleted once the response arrives)
+  bool connectionClosed_{false};
 };
 
 } // namesapce api
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cerrno>
 #include <memory>
 
@@ -30,6 +31,7 @@
 #include "StaticHandler.h"
 #include "Streamer.h"
 #include "StreamRequestHandler.h"
+#include "ZmqClientPool.h"
 
 using namespace facebook::terragraph;
 using namespace api;
@@ -51,6 +53,15 @@ DEFINE_string(
     "localhost",
     "The hostname or IP of the aggregator we talk to");
 DEFINE_int32(aggregator_port, 18100, "The port aggregator listens on");
+DEFINE_int32(
+    zmq_pool_size,
+    4,
+    "Number of idle ZMQ sockets to keep open to each of the controller and "
+    "aggregator (more are opened while requests are outstanding)");
+DEFINE_int32(
+    zmq_rcv_timeout_ms,
+    15000,
+    "The amount of time to wait for ZMQ responses (in milliseconds)");
 
 // webserver configuration
 DEFINE_int32(http_port, 8080, "Port to listen on with HTTP protocol");
@@ -127,19 +138,16 @@ class NotFoundHandler : public proxygen::RequestHandler {
   }
 };
 
-// Constructs a new RequestHandler for each request using a shared ZMQ context.
+// Constructs a new RequestHandler for each request using a shared ZMQ socket
+// pool.
 class RequestHandlerFactory : public proxygen::RequestHandlerFactory {
  public:
   RequestHandlerFactory(
-      fbzmq::Context& context,
-      const std::string& ctrlRouterUrl,
-      const std::string& aggrRouterUrl,
+      ZmqClientPool& zmqClientPool,
       StreamRequestHandler::StreamClients& streamClients,
       const std::string& publicKey,
       std::shared_ptr<AuditLogger> auditor)
-      : context_(context),
-        ctrlRouterUrl_(ctrlRouterUrl),
-        aggrRouterUrl_(aggrRouterUrl),
+      : zmqClientPool_(zmqClientPool),
         streamClients_(streamClients),
         publicKey_(publicKey),
         auditor_(auditor) {
@@ -164,13 +172,9 @@ class RequestHandlerFactory : public proxygen::RequestHandlerFactory {
           folly::EventBaseManager::get()->getExistingEventBase(),
           streamClients_);
     } else if (headers->getPath().find(FLAGS_api_path) == 0) {
-      std::string zmqId = generateZmqId();
       return new RequestHandler(
           FLAGS_api_path,
-          context_,
-          ctrlRouterUrl_,
-          aggrRouterUrl_,
-          zmqId,
+          zmqClientPool_,
           publicKey_,
           auditor_);
     } else if (headers->getPath().find(FLAGS_docs_path) == 0) {
@@ -181,9 +185,7 @@ class RequestHandlerFactory : public proxygen::RequestHandlerFactory {
   }
 
  private:
-  fbzmq::Context& context_;
-  const std::string ctrlRouterUrl_;
-  const std::string aggrRouterUrl_;
+  ZmqClientPool& zmqClientPool_;
   StreamRequestHandler::StreamClients& streamClients_;
   const std::string publicKey_;
   const std::shared_ptr<AuditLogger> auditor_;
@@ -249,6 +251,22 @@ main(int argc, char** argv) {
   auto auditor = std::make_shared<AuditLogger>(
       FLAGS_audit_log_path, FLAGS_audit_log_buffer_size);
 
+  // Start the shared controller/aggregator socket pool
+  ZmqClientPool zmqClientPool(
+      context,
+      ctrlRouterUrl,
+      aggrRouterUrl,
+      generateZmqId(),
+      static_cast<size_t>(std::max(FLAGS_zmq_pool_size, 1)),
+      std::chrono::milliseconds(FLAGS_zmq_rcv_timeout_ms));
+  std::thread zmqClientPoolThread([&zmqClientPool]() noexcept {
+    LOG(INFO) << "Starting ZmqClientPool thread...";
+    folly::setThreadName("ZmqClientPool");
+    zmqClientPool.run();
+    LOG(INFO) << "ZmqClientPool thread got stopped";
+  });
+  zmqClientPool.waitUntilRunning();
+
   // Configure proxygen
   std::vector<proxygen::HTTPServer::IPConfig> IPs = {
       {socketAddr, proxygen::HTTPServer::Protocol::HTTP},
@@ -265,9 +283,7 @@ main(int argc, char** argv) {
   options.contentCompressionLevel = FLAGS_zlib_compression_level;
   options.handlerFactories = proxygen::RequestHandlerChain()
       .addThen<RequestHandlerFactory>(
-          context,
-          ctrlRouterUrl,
-          aggrRouterUrl,
+          zmqClientPool,
           streamClients,
           publicKey,
           auditor)
@@ -310,5 +326,9 @@ main(int argc, char** argv) {
   streamer.waitUntilStopped();
   streamerThread.join();
 
+  zmqClientPool.stop();
+  zmqClientPool.waitUntilStopped();
+  zmqClientPoolThread.join();
+
   return 0;
 }
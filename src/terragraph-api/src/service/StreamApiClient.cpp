@@ -75,6 +75,29 @@ StreamApiClient::StreamEventMap StreamApiClient::streamEvents_ = [] {
         thrift::MessageType::EVENT_LINK_STATUS
   }});
 
+  /**
+   * @api {get} /stream/statusReports Get Status Report Change Events
+   * @apiName StatusReportStream
+   * @apiGroup Streams
+   *
+   * @apiDescription Creates a stream of status report changes, published
+   *                 periodically when any node's status report changed
+   *                 (ignoring timestamps). To maintain a full copy, connect to
+   *                 this stream first, then fetch a full dump using
+   *                 getCtrlStatusDump.
+   *
+   * @apiUse StatusReportEvents
+   * @apiExample {curl} Example:
+   *    curl -i http://localhost:443/stream/statusReports
+   * @apiSuccessExample {json} Success-Response:
+   *  HTTP/1.1 200 OK
+   *  event: EVENT_STATUS_DELTA
+   *  data: {"timeStamp":1640206257,"statusReports":{"00:00:00:11:22:33":{"timeStamp":1640206255,"ipv6Address":"2001::1","status":3,"configMd5":"60f72d8eb83ba1b99fbcf200a7294aae"}},"generation":1640206000000123,"removedNodes":[],"incremental":true}
+   */
+  map.insert({"statusReports", {
+        thrift::MessageType::EVENT_STATUS_DELTA
+  }});
+
   return map;
 }();
 
@@ -169,6 +192,19 @@ StreamApiClient::EventFunctionMap StreamApiClient::eventFunctions_ = [] {
       }
   });
 
+  // Status report stream events
+  /**
+   * @apiDefine StatusReportEvents
+   * @apiParam (StatusReportEvents) {Object(StatusDump)} EVENT_STATUS_DELTA
+   *                                Status reports changed since the previous
+   *                                event (see getCtrlStatusDump)
+   */
+  map.insert({thrift::MessageType::EVENT_STATUS_DELTA,
+      [] (const thrift::Message& msg) -> std::optional<std::string> {
+        return serializeThriftObject<thrift::StatusDump>(msg);
+      }
+  });
+
   return map;
 }();
 
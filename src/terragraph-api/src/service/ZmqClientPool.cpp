@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ZmqClientPool.h"
+
+#include <algorithm>
+
+#include <folly/Format.h>
+
+using namespace fbzmq;
+
+namespace {
+// Keep-alive values for long-lived sockets (see Streamer)
+const int kKeepAliveEnable{1};
+// Idle Time before sending keep alives
+const std::chrono::seconds kKeepAliveTime{15};
+// max keep alives before resetting connection
+const int kKeepAliveCnt{3};
+// interval between keep alives
+const std::chrono::seconds kKeepAliveIntvl{5};
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace api {
+
+ZmqClientPool::ZmqClientPool(
+    fbzmq::Context& context,
+    const std::string& ctrlRouterUrl,
+    const std::string& aggrRouterUrl,
+    const std::string& zmqIdPrefix,
+    size_t poolSize,
+    std::chrono::milliseconds requestTimeout)
+    : context_(context),
+      zmqIdPrefix_(zmqIdPrefix),
+      poolSize_(std::max<size_t>(poolSize, 1)),
+      requestTimeout_(requestTimeout) {
+  ctrlSockets_.url = ctrlRouterUrl;
+  ctrlSockets_.name = "controller";
+  aggrSockets_.url = aggrRouterUrl;
+  aggrSockets_.name = "aggregator";
+
+  for (Peer peer : {Peer::CTRL, Peer::AGGR}) {
+    auto& peerSockets = getPeerSockets(peer);
+    if (peerSockets.url.empty()) {
+      continue;
+    }
+    for (size_t i = 0; i < poolSize_; i++) {
+      auto socket = createSocket(peer);
+      peerSockets.idle.push_back(socket.get());
+      peerSockets.sockets.emplace(socket.get(), std::move(socket));
+    }
+  }
+}
+
+folly::SemiFuture<std::optional<std::string>>
+ZmqClientPool::request(
+    Peer peer, const std::string& receiverId, std::string payload) {
+  auto [promise, future] =
+      folly::makePromiseContract<std::optional<std::string>>();
+  uint64_t requestId = nextRequestId_++;
+  runInEventLoop([this,
+                  peer,
+                  requestId,
+                  receiverId,
+                  payload = std::move(payload),
+                  promise = std::move(promise)]() mutable noexcept {
+    sendRequest(peer, requestId, receiverId, payload, std::move(promise));
+  });
+  return std::move(future);
+}
+
+void
+ZmqClientPool::sendRequest(
+    Peer peer,
+    uint64_t requestId,
+    const std::string& receiverId,
+    const std::string& payload,
+    folly::Promise<std::optional<std::string>> promise) {
+  auto& peerSockets = getPeerSockets(peer);
+  if (peerSockets.url.empty()) {
+    promise.setValue(std::nullopt);
+    return;
+  }
+
+  PooledSocket* socket = acquireSocket(peer);
+  const auto res = socket->sock->sendMultiple(
+      fbzmq::Message(),
+      fbzmq::Message::from(receiverId).value(),
+      fbzmq::Message::from(socket->zmqId).value(),
+      fbzmq::Message::from(payload).value());
+  if (res.hasError()) {
+    LOG(ERROR) << "Error sending request " << requestId << " to "
+               << peerSockets.name << ":" << receiverId << " from "
+               << socket->zmqId << ": " << res.error();
+    promise.setValue(std::nullopt);
+    closeSocket(peer, socket);
+    return;
+  }
+
+  int64_t timeoutId =
+      scheduleTimeout(requestTimeout_, [this, peer, requestId]() noexcept {
+        processTimeout(peer, requestId);
+      });
+  socket->requestId = requestId;
+  requests_.emplace(
+      requestId,
+      PendingRequest{std::move(promise), socket, receiverId, timeoutId});
+  VLOG(4) << "Sent request " << requestId << " to " << peerSockets.name << ":"
+          << receiverId << " on " << socket->zmqId << " ("
+          << requests_.size() << " outstanding)";
+}
+
+void
+ZmqClientPool::processReply(Peer peer, PooledSocket* socket) {
+  fbzmq::Message minionMsg, senderAppMsg, dataMsg;
+  const auto recvRet =
+      socket->sock->recvMultiple(minionMsg, senderAppMsg, dataMsg);
+  if (recvRet.hasError()) {
+    LOG(ERROR) << "Error reading message on " << socket->zmqId << ": "
+               << recvRet.error();
+    return;
+  }
+
+  // The socket's only outstanding request is the one being answered (even if
+  // the request was handed off to another app)
+  if (!socket->requestId) {
+    LOG(ERROR) << "Dropping unexpected reply from "
+               << getPeerSockets(peer).name << ":"
+               << senderAppMsg.read<std::string>().value() << " on "
+               << socket->zmqId;
+    return;
+  }
+  uint64_t requestId = socket->requestId.value();
+  socket->requestId.reset();
+
+  completeRequest(requestId, dataMsg.read<std::string>().value());
+
+  // Don't remove this socket from inside its own poll callback
+  runInEventLoop(
+      [this, peer, socket]() noexcept { releaseSocket(peer, socket); });
+}
+
+void
+ZmqClientPool::processTimeout(Peer peer, uint64_t requestId) {
+  auto iter = requests_.find(requestId);
+  if (iter == requests_.end()) {
+    return;
+  }
+  LOG(ERROR) << "Timed out waiting for reply to request " << requestId
+             << " from " << getPeerSockets(peer).name << ":"
+             << iter->second.receiverId;
+
+  // A late reply can't be told apart from the reply to a later request on the
+  // same socket, so close it (the ROUTER then drops the late reply)
+  PooledSocket* socket = iter->second.socket;
+  socket->requestId.reset();
+  completeRequest(requestId, std::nullopt);
+  closeSocket(peer, socket);
+}
+
+void
+ZmqClientPool::completeRequest(
+    uint64_t requestId, std::optional<std::string> reply) {
+  auto iter = requests_.find(requestId);
+  if (iter == requests_.end()) {
+    return;
+  }
+  cancelTimeout(iter->second.timeoutId);
+  auto promise = std::move(iter->second.promise);
+  requests_.erase(iter);
+  promise.setValue(std::move(reply));
+}
+
+ZmqClientPool::PooledSocket*
+ZmqClientPool::acquireSocket(Peer peer) {
+  auto& peerSockets = getPeerSockets(peer);
+  if (!peerSockets.idle.empty()) {
+    PooledSocket* socket = peerSockets.idle.back();
+    peerSockets.idle.pop_back();
+    return socket;
+  }
+
+  // All sockets are busy, so open another one
+  auto socket = createSocket(peer);
+  PooledSocket* rawSocket = socket.get();
+  peerSockets.sockets.emplace(rawSocket, std::move(socket));
+  VLOG(3) << "Opened " << peerSockets.name << " socket " << rawSocket->zmqId
+          << " (" << peerSockets.sockets.size() << " open)";
+  return rawSocket;
+}
+
+void
+ZmqClientPool::releaseSocket(Peer peer, PooledSocket* socket) {
+  auto& peerSockets = getPeerSockets(peer);
+  if (!peerSockets.sockets.count(socket) || socket->requestId) {
+    return;  // already closed or reused
+  }
+  if (peerSockets.idle.size() < poolSize_) {
+    peerSockets.idle.push_back(socket);
+  } else {
+    closeSocket(peer, socket);
+  }
+}
+
+std::unique_ptr<ZmqClientPool::PooledSocket>
+ZmqClientPool::createSocket(Peer peer) {
+  auto& peerSockets = getPeerSockets(peer);
+  auto socket = std::make_unique<PooledSocket>();
+  socket->zmqId = folly::sformat("{}-{}", zmqIdPrefix_, nextSocketId_++);
+  socket->sock = std::make_unique<Socket<ZMQ_DEALER, ZMQ_CLIENT>>(
+      context_, IdentityString{socket->zmqId});
+
+  if (socket->sock
+          ->setKeepAlive(
+              kKeepAliveEnable,
+              kKeepAliveTime.count(),
+              kKeepAliveCnt,
+              kKeepAliveIntvl.count())
+          .hasError()) {
+    LOG(ERROR) << "Could not set zmq keepAlive options on " << socket->zmqId;
+  }
+
+  // Connecting is asynchronous in ZMQ, and messages are queued until the peer
+  // is reachable (requests will time out otherwise)
+  auto res = socket->sock->connect(SocketUrl{peerSockets.url});
+  if (res.hasError()) {
+    LOG(ERROR) << "Error connecting to " << peerSockets.name << " URL '"
+               << peerSockets.url << "': " << res.error();
+  }
+
+  PooledSocket* rawSocket = socket.get();
+  addSocket(
+      RawZmqSocketPtr{**socket->sock},
+      ZMQ_POLLIN,
+      [this, peer, rawSocket](int) noexcept { processReply(peer, rawSocket); });
+  return socket;
+}
+
+void
+ZmqClientPool::closeSocket(Peer peer, PooledSocket* socket) {
+  auto& peerSockets = getPeerSockets(peer);
+  auto iter = peerSockets.sockets.find(socket);
+  if (iter == peerSockets.sockets.end()) {
+    return;
+  }
+  VLOG(3) << "Closing " << peerSockets.name << " socket " << socket->zmqId;
+  peerSockets.idle.erase(
+      std::remove(peerSockets.idle.begin(), peerSockets.idle.end(), socket),
+      peerSockets.idle.end());
+  removeSocket(RawZmqSocketPtr{**socket->sock});
+  peerSockets.sockets.erase(iter);
+}
+
+ZmqClientPool::PeerSockets&
+ZmqClientPool::getPeerSockets(Peer peer) {
+  return peer == Peer::CTRL ? ctrlSockets_ : aggrSockets_;
+}
+
+} // namespace api
+} // namespace terragraph
+} // namespace facebook
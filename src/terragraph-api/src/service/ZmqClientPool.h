@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <fbzmq/async/ZmqEventLoop.h>
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/futures/Future.h>
+
+namespace facebook {
+namespace terragraph {
+namespace api {
+
+/**
+ * Shared pool of long-lived ZMQ DEALER sockets to the controller and
+ * aggregator.
+ *
+ * Requests may be submitted from any thread via request(). Each request is
+ * assigned a unique ID and written to an idle pooled socket by the event loop
+ * thread, and the returned future is fulfilled with the raw reply payload (or
+ * std::nullopt on timeout/error) from the same thread.
+ *
+ * The controller and aggregator route replies back to the socket identity, and
+ * do not echo any request ID. Apps may also hold back a reply while answering
+ * later requests (e.g. TopologyBuilderApp for START_TOPOLOGY_SCAN), so replies
+ * cannot be matched by order. Each socket therefore carries at most one
+ * outstanding request, and any reply on it belongs to that request. Sockets
+ * are reused once their reply arrives (saving a connection setup per request),
+ * and more are opened when all are busy. If a request times out, its socket is
+ * closed so that a late reply is dropped by the ROUTER.
+ */
+class ZmqClientPool final : public fbzmq::ZmqEventLoop {
+ public:
+  // The peer a request is addressed to
+  enum class Peer {
+    CTRL,
+    AGGR,
+  };
+
+  ZmqClientPool(
+      fbzmq::Context& context,
+      const std::string& ctrlRouterUrl,
+      const std::string& aggrRouterUrl,
+      const std::string& zmqIdPrefix,
+      size_t poolSize,
+      std::chrono::milliseconds requestTimeout);
+
+  // Send a serialized Thrift message to the given app, returning a future
+  // holding the serialized Thrift reply.
+  //
+  // This is thread-safe.
+  folly::SemiFuture<std::optional<std::string>> request(
+      Peer peer, const std::string& receiverId, std::string payload);
+
+ private:
+  // A single pooled DEALER socket
+  struct PooledSocket {
+    // The socket
+    std::unique_ptr<fbzmq::Socket<ZMQ_DEALER, fbzmq::ZMQ_CLIENT>> sock;
+
+    // The socket identity (used by the ROUTER to route replies)
+    std::string zmqId;
+
+    // The request awaiting a reply on this socket (if any)
+    std::optional<uint64_t> requestId;
+  };
+
+  // An in-flight request
+  struct PendingRequest {
+    // The promise to fulfill with the reply
+    folly::Promise<std::optional<std::string>> promise;
+
+    // The socket the request was written to
+    PooledSocket* socket;
+
+    // The receiver app
+    std::string receiverId;
+
+    // The timeout ID (from scheduleTimeout())
+    int64_t timeoutId;
+  };
+
+  // The sockets for one peer
+  struct PeerSockets {
+    // The peer's ROUTER URL
+    std::string url;
+
+    // Human-readable name (for logging)
+    std::string name;
+
+    // All open sockets
+    std::unordered_map<PooledSocket*, std::unique_ptr<PooledSocket>> sockets;
+
+    // Open sockets with no outstanding request
+    std::vector<PooledSocket*> idle;
+  };
+
+  // Write a request to an idle socket (event loop thread only)
+  void sendRequest(
+      Peer peer,
+      uint64_t requestId,
+      const std::string& receiverId,
+      const std::string& payload,
+      folly::Promise<std::optional<std::string>> promise);
+
+  // Handle a reply on the given socket
+  void processReply(Peer peer, PooledSocket* socket);
+
+  // Handle an expired request
+  void processTimeout(Peer peer, uint64_t requestId);
+
+  // Fulfill and erase a pending request
+  void completeRequest(uint64_t requestId, std::optional<std::string> reply);
+
+  // Return an idle socket, opening a new one if none are left
+  PooledSocket* acquireSocket(Peer peer);
+
+  // Return a socket with no outstanding request to the idle list, or close it
+  // if enough sockets are already idle
+  void releaseSocket(Peer peer, PooledSocket* socket);
+
+  // Create, connect and poll a new socket
+  std::unique_ptr<PooledSocket> createSocket(Peer peer);
+
+  // Stop polling and close a socket
+  void closeSocket(Peer peer, PooledSocket* socket);
+
+  // Return the sockets for the given peer
+  PeerSockets& getPeerSockets(Peer peer);
+
+  // The ZMQ context
+  fbzmq::Context& context_;
+
+  // The ZMQ identity prefix (a counter is appended per socket)
+  const std::string zmqIdPrefix_;
+
+  // Number of idle sockets to keep open per peer
+  const size_t poolSize_;
+
+  // How long to wait for a reply
+  const std::chrono::milliseconds requestTimeout_;
+
+  // Monotonic counter for request IDs (shared by all threads)
+  std::atomic<uint64_t> nextRequestId_{1};
+
+  // Monotonic counter for socket identities
+  uint64_t nextSocketId_{0};
+
+  // Controller sockets
+  PeerSockets ctrlSockets_;
+
+  // Aggregator sockets
+  PeerSockets aggrSockets_;
+
+  // In-flight requests keyed by request ID
+  std::unordered_map<uint64_t, PendingRequest> requests_;
+};
+
+} // namespace api
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "../service/ZmqClientPool.h"
+
+#include <thread>
+
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::terragraph::api;
+using namespace fbzmq;
+
+namespace {
+const std::string kCtrlRouterUrl{"inproc://zmq-client-pool-test-ctrl"};
+const std::chrono::milliseconds kRequestTimeout{1000};
+
+// A request as received by the controller ROUTER
+struct ReceivedRequest {
+  std::string zmqId;
+  std::string receiverId;
+  std::string payload;
+};
+} // namespace
+
+class ZmqClientPoolFixture : public ::testing::Test {
+ public:
+  void
+  SetUp() override {
+    router = std::make_unique<Socket<ZMQ_ROUTER, ZMQ_SERVER>>(
+        context, IdentityString{"ctrl"});
+    ASSERT_TRUE(router->bind(SocketUrl{kCtrlRouterUrl}));
+
+    pool = std::make_unique<ZmqClientPool>(
+        context, kCtrlRouterUrl, "", "test", 1 /* poolSize */, kRequestTimeout);
+    poolThread = std::thread([this]() { pool->run(); });
+    pool->waitUntilRunning();
+  }
+
+  void
+  TearDown() override {
+    pool->stop();
+    pool->waitUntilStopped();
+    poolThread.join();
+  }
+
+  // Read the next request from the ROUTER
+  ReceivedRequest
+  recvRequest() {
+    Message zmqIdMsg, delimMsg, receiverMsg, senderMsg, dataMsg;
+    auto res = router->recvMultiple(
+        zmqIdMsg, delimMsg, receiverMsg, senderMsg, dataMsg);
+    EXPECT_FALSE(res.hasError());
+    return ReceivedRequest{
+        zmqIdMsg.read<std::string>().value(),
+        receiverMsg.read<std::string>().value(),
+        dataMsg.read<std::string>().value()};
+  }
+
+  // Send a reply from the given app to the given socket
+  void
+  sendReply(
+      const std::string& zmqId,
+      const std::string& senderApp,
+      const std::string& payload) {
+    auto res = router->sendMultiple(
+        Message::from(zmqId).value(),
+        Message(),
+        Message::from(senderApp).value(),
+        Message::from(payload).value());
+    EXPECT_FALSE(res.hasError());
+  }
+
+  Context context;
+  std::unique_ptr<Socket<ZMQ_ROUTER, ZMQ_SERVER>> router;
+  std::unique_ptr<ZmqClientPool> pool;
+  std::thread poolThread;
+};
+
+TEST_F(ZmqClientPoolFixture, Reply) {
+  auto future = pool->request(ZmqClientPool::Peer::CTRL, "appA", "request");
+  auto request = recvRequest();
+  EXPECT_EQ("appA", request.receiverId);
+  EXPECT_EQ("request", request.payload);
+
+  sendReply(request.zmqId, "appA", "reply");
+  auto reply = std::move(future).get(kRequestTimeout);
+  ASSERT_TRUE(reply.has_value());
+  EXPECT_EQ("reply", *reply);
+}
+
+TEST_F(ZmqClientPoolFixture, OutOfOrderReplies) {
+  // Apps may hold back a reply while answering later requests, so each
+  // outstanding request gets its own socket
+  auto future1 = pool->request(ZmqClientPool::Peer::CTRL, "appA", "request1");
+  auto request1 = recvRequest();
+  auto future2 = pool->request(ZmqClientPool::Peer::CTRL, "appA", "request2");
+  auto request2 = recvRequest();
+  EXPECT_NE(request1.zmqId, request2.zmqId);
+
+  sendReply(request2.zmqId, "appA", "reply2");
+  auto reply2 = std::move(future2).get(kRequestTimeout);
+  ASSERT_TRUE(reply2.has_value());
+  EXPECT_EQ("reply2", *reply2);
+  EXPECT_FALSE(future1.isReady());
+
+  // A reply from another app (e.g. after a hand-off) still matches
+  sendReply(request1.zmqId, "appB", "reply1");
+  auto reply1 = std::move(future1).get(kRequestTimeout);
+  ASSERT_TRUE(reply1.has_value());
+  EXPECT_EQ("reply1", *reply1);
+
+  // Idle sockets are reused
+  auto future3 = pool->request(ZmqClientPool::Peer::CTRL, "appA", "request3");
+  auto request3 = recvRequest();
+  EXPECT_TRUE(
+      request3.zmqId == request1.zmqId || request3.zmqId == request2.zmqId);
+  sendReply(request3.zmqId, "appA", "reply3");
+  EXPECT_TRUE(std::move(future3).get(kRequestTimeout).has_value());
+}
+
+TEST_F(ZmqClientPoolFixture, LateReplyAfterTimeout) {
+  // Send a request to app B while an earlier request to app A is pending, such
+  // that A's request times out while B's is still pending
+  auto futureA = pool->request(ZmqClientPool::Peer::CTRL, "appA", "requestA");
+  auto requestA = recvRequest();
+  std::this_thread::sleep_for(kRequestTimeout / 2);
+  auto futureB = pool->request(ZmqClientPool::Peer::CTRL, "appB", "requestB");
+  auto requestB = recvRequest();
+  ASSERT_NE(requestA.zmqId, requestB.zmqId);
+
+  EXPECT_FALSE(std::move(futureA).get().has_value());
+
+  // A's late reply must not be delivered to B's request
+  sendReply(requestA.zmqId, "appA", "replyA");
+  std::this_thread::sleep_for(kRequestTimeout / 5);
+  EXPECT_FALSE(futureB.isReady());
+
+  sendReply(requestB.zmqId, "appB", "replyB");
+  auto replyB = std::move(futureB).get(kRequestTimeout);
+  ASSERT_TRUE(replyB.has_value());
+  EXPECT_EQ("replyB", *replyB);
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
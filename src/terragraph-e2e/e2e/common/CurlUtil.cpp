@@ -14,25 +14,36 @@
 #include <folly/Uri.h>
 #include <sys/stat.h>
 
+namespace {
+const mode_t IMAGE_PERMS = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+
+// Destination of downloaded data
+struct DownloadContext {
+  FILE* fp;
+  const std::function<void(const char* data, size_t size)>* onData;
+};
+}
+
 extern "C" {
 static size_t
-curlWrite(void* ptr, size_t size, size_t nmemb, FILE* stream) {
-  return fwrite(ptr, size, nmemb, stream);
+curlWrite(void* ptr, size_t size, size_t nmemb, DownloadContext* ctx) {
+  size_t written = fwrite(ptr, size, nmemb, ctx->fp);
+  if (written == nmemb && *ctx->onData) {
+    (*ctx->onData)(static_cast<const char*>(ptr), size * nmemb);
+  }
+  return written;
 }
 }
 
 namespace facebook {
 namespace terragraph {
 
-namespace {
-const mode_t IMAGE_PERMS = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-}
-
 bool
 CurlUtil::download(
     const std::string& url,
     const std::string& savePath,
-    std::string& retError) {
+    std::string& retError,
+    const std::function<void(const char* data, size_t size)>& onData) {
   auto curl = curl_easy_init();
   if (!curl) {
     retError = "Unable to initialize curl";
@@ -63,7 +74,8 @@ CurlUtil::download(
   }
 
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curlWrite);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+  DownloadContext ctx{fp, &onData};
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
   curl_easy_setopt(curl, CURLOPT_FAILONERROR, true);
   auto res = curl_easy_perform(curl);
 
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace facebook {
@@ -20,10 +21,17 @@ class CurlUtil {
   /**
    * Download a file from the given URL and save it to the local path specified.
    *
+   * If 'onData' is given, it is also called with each chunk of data written
+   * (e.g. to hash the file while downloading it).
+   *
    * Upon failure, returns false and writes the reason to 'error'.
    */
   static bool download(
-      const std::string& url, const std::string& savePath, std::string& error);
+      const std::string& url,
+      const std::string& savePath,
+      std::string& error,
+      const std::function<void(const char* data, size_t size)>& onData =
+          nullptr);
 
   /**
    * Upload a file from the given local path to the given URL.
@@ -27,7 +27,6 @@ class Md5Utils {
   static std::string computeFileMd5(
       const std::string& path, size_t skipHeaderSize = 0);
 
- private:
   /** Returns the input byte array as a hex string. */
   static std::string bytesToHex(const unsigned char bytes[], size_t size);
 };
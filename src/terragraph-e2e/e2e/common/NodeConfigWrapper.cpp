@@ -12,6 +12,7 @@
 #include <sys/file.h>
 #include <unistd.h>
 
+#include <folly/MacAddress.h>
 #include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -19,12 +20,53 @@
 #include "WatchdogUtils.h"
 #include "JsonUtils.h"
 #include "Md5Utils.h"
+#include "StructuralHash.h"
 
 namespace facebook {
 namespace terragraph {
 
 namespace {
   const std::string kConfigLockFile{"/tmp/configlockfile"};
+
+// Returns the standardized MAC address, or the original string if it is not a
+// valid MAC address (without throwing, as this is called on lookups)
+std::string
+normalizeMac(const std::string& mac) {
+  auto macAddr = folly::MacAddress::tryFromString(mac);
+  return macAddr.hasValue() ? macAddr->toString() : mac;
+}
+
+// Merge each per-MAC override in config[overrideKey] with config[baseKey], and
+// deserialize the results (keyed by standardized MAC address)
+template <class T>
+std::unordered_map<std::string, T>
+mergeParamsOverrides(
+    const folly::dynamic& config,
+    const std::string& baseKey,
+    const std::string& overrideKey) {
+  std::unordered_map<std::string, T> paramsOverrides;
+  auto overridesIt = config.find(overrideKey);
+  auto baseIt = config.find(baseKey);
+  if (overridesIt == config.items().end() ||
+      !overridesIt->second.isObject() || baseIt == config.items().end()) {
+    return paramsOverrides;
+  }
+
+  apache::thrift::SimpleJSONSerializer jsonSerializer;
+  for (const auto& pair : overridesIt->second.items()) {
+    std::string mac = pair.first.asString();
+    try {
+      folly::dynamic params = baseIt->second;
+      JsonUtils::dynamicObjectMerge(params, pair.second);
+      paramsOverrides[normalizeMac(mac)] =
+          jsonSerializer.deserialize<T>(folly::toJson(params));
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Could not parse " << overrideKey << " struct for " << mac
+                 << " : " << folly::exceptionStr(ex);
+    }
+  }
+  return paramsOverrides;
+}
 }
 
 NodeConfigWrapper::NodeConfigWrapper() {
@@ -54,17 +96,19 @@ NodeConfigWrapper::readNodeConfigFile() {
                << folly::exceptionStr(ex);
   }
 
-  // Compute MD5
-  computeConfigMd5();
-
+  bool parsed = false;
   try {
     nodeConfigDynamic_ = folly::parseJson(nodeConfigJson_);
+    parsed = true;
   } catch (const std::exception& ex) {
     LOG(ERROR)
         << "Could not parse config into dynamic object"
         << folly::exceptionStr(ex);
   }
 
+  // Compute hashes
+  computeConfigHashes(parsed);
+
   // Deserialize config JSON
   apache::thrift::SimpleJSONSerializer jsonSerializer;
   *nodeConfig_ = thrift::NodeConfig();
@@ -77,6 +121,9 @@ NodeConfigWrapper::readNodeConfigFile() {
 
   // Create shared pointers
   initializePointers();
+
+  // Merge per-link and per-radio overrides
+  computeParamsOverrides();
 }
 
 bool
@@ -169,15 +216,24 @@ NodeConfigWrapper::setNodeConfig(const std::string& configJson) {
 }
 
 void
-NodeConfigWrapper::computeConfigMd5() {
+NodeConfigWrapper::computeConfigHashes(bool parsed) {
   prevConfigMd5_ = configMd5_;
-  try {
-    auto prettyJson = JsonUtils::toSortedPrettyJson(nodeConfigJson_);
-    configMd5_ = Md5Utils::computeMd5(prettyJson);
-  } catch (const std::exception& ex) {
-    LOG(ERROR) << "computeConfigMd5: Could not parse json "
-               << folly::exceptionStr(ex);
-    configMd5_ = "";
+  prevConfigHash_ = configHash_;
+  configMd5_ = "";
+  configHash_ = "";
+  if (!parsed) {
+    return;
+  }
+
+  configHash_ = StructuralHash::computeHash(nodeConfigDynamic_);
+  if (legacyConfigMd5Enabled_) {
+    try {
+      auto prettyJson = JsonUtils::toSortedPrettyJson(nodeConfigDynamic_);
+      configMd5_ = Md5Utils::computeMd5(prettyJson);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "computeConfigHashes: Could not serialize json "
+                 << folly::exceptionStr(ex);
+    }
   }
 }
 
@@ -219,57 +275,35 @@ NodeConfigWrapper::getNodeConfigJson() const {
   return nodeConfigJson_;
 }
 
-thrift::LinkParams
-NodeConfigWrapper::getLinkParams(std::string responderMac) const {
+void
+NodeConfigWrapper::computeParamsOverrides() {
+  linkParamsOverrides_ = mergeParamsOverrides<thrift::LinkParams>(
+      nodeConfigDynamic_, "linkParamsBase", "linkParamsOverride");
+  radioParamsOverrides_ = mergeParamsOverrides<thrift::RadioParams>(
+      nodeConfigDynamic_, "radioParamsBase", "radioParamsOverride");
+}
+
+const thrift::LinkParams&
+NodeConfigWrapper::getLinkParams(const std::string& responderMac) const {
   // Check if an override exists for responderMac
-  try {
-    auto linkParamsOverrideIt = nodeConfigDynamic_.find("linkParamsOverride");
-    if (linkParamsOverrideIt != nodeConfigDynamic_.items().end()) {
-      auto overrideIt = linkParamsOverrideIt->second.find(responderMac);
-      if (overrideIt != linkParamsOverrideIt->second.items().end()) {
-        auto linkParams = nodeConfigDynamic_["linkParamsBase"];
-
-        // Merge linkParamsBase with per-link override
-        JsonUtils::dynamicObjectMerge(linkParams, overrideIt->second);
-
-        // Deserialize and return merged linkParams
-        apache::thrift::SimpleJSONSerializer jsonSerializer;
-        return jsonSerializer.deserialize<thrift::LinkParams>(
-            folly::toJson(linkParams));
-      }
+  if (!linkParamsOverrides_.empty() && !responderMac.empty()) {
+    auto iter = linkParamsOverrides_.find(normalizeMac(responderMac));
+    if (iter != linkParamsOverrides_.end()) {
+      return iter->second;
     }
-  } catch (const std::exception& ex) {
-    LOG(ERROR) << "Could not parse link specific LinkParams struct for "
-               << responderMac << " : "
-               << folly::exceptionStr(ex);
   }
   // return base config if no override exists
   return *linkParamsBase_;
 }
 
-thrift::RadioParams
-NodeConfigWrapper::getRadioParams(std::string radioMac) const {
+const thrift::RadioParams&
+NodeConfigWrapper::getRadioParams(const std::string& radioMac) const {
   // Check if an override exists for radioMac
-  try {
-    auto radioParamsOverrideIt = nodeConfigDynamic_.find("radioParamsOverride");
-    if (radioParamsOverrideIt != nodeConfigDynamic_.items().end()) {
-      auto overrideIt = radioParamsOverrideIt->second.find(radioMac);
-      if (overrideIt != radioParamsOverrideIt->second.items().end()) {
-        auto radioParams = nodeConfigDynamic_["radioParamsBase"];
-
-        // Merge radioParamsBase with per-radio override
-        JsonUtils::dynamicObjectMerge(radioParams, overrideIt->second);
-
-        // Deserialize and return merged linkParams
-        apache::thrift::SimpleJSONSerializer jsonSerializer;
-        return jsonSerializer.deserialize<thrift::RadioParams>(
-            folly::toJson(radioParams));
-      }
+  if (!radioParamsOverrides_.empty() && !radioMac.empty()) {
+    auto iter = radioParamsOverrides_.find(normalizeMac(radioMac));
+    if (iter != radioParamsOverrides_.end()) {
+      return iter->second;
     }
-  } catch (const std::exception& ex) {
-    LOG(ERROR) << "Could not parse radio specific RadioParams struct for "
-               << radioMac << " : "
-               << folly::exceptionStr(ex);
   }
   // return base config if no override exists
   return *radioParamsBase_;
@@ -295,6 +329,33 @@ NodeConfigWrapper::getNodeAirtime() const {
   return nodeAirtime;
 }
 
+std::optional<std::string>
+NodeConfigWrapper::applyConfigPatch(
+    const std::string& patch,
+    const std::string& baseConfigHash,
+    const std::string& configHash) const {
+  if (configHash_.empty() || configHash_ != baseConfigHash) {
+    LOG(ERROR) << "Config patch base hash " << baseConfigHash
+               << " does not match current config hash " << configHash_;
+    return std::nullopt;
+  }
+
+  folly::dynamic config = nodeConfigDynamic_;
+  try {
+    config.merge_patch(folly::parseJson(patch));
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Could not apply config patch: " << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+  std::string patchedHash = StructuralHash::computeHash(config);
+  if (patchedHash != configHash) {
+    LOG(ERROR) << "Patched config hash " << patchedHash
+               << " does not match expected hash " << configHash;
+    return std::nullopt;
+  }
+  return JsonUtils::toSortedPrettyJson(config);
+}
+
 void
 NodeConfigWrapper::usePreviousConfigMd5(bool hasDelayedNodeAction) {
   hasDelayedNodeAction_ = hasDelayedNodeAction;
@@ -306,6 +367,17 @@ NodeConfigWrapper::getConfigMd5() const {
                                                           : configMd5_;
 }
 
+std::string
+NodeConfigWrapper::getConfigHash() const {
+  return hasDelayedNodeAction_ && !prevConfigHash_.empty() ? prevConfigHash_
+                                                           : configHash_;
+}
+
+void
+NodeConfigWrapper::setLegacyConfigMd5Enabled(bool enabled) {
+  legacyConfigMd5Enabled_ = enabled;
+}
+
 std::shared_ptr<const thrift::NodeConfig>
 NodeConfigWrapper::getNodeConfig() const {
   return nodeConfig_;
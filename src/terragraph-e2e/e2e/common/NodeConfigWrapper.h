@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <optional>
+#include <unordered_map>
+
 #include <folly/dynamic.h>
 
 #include "e2e/if/gen-cpp2/BWAllocation_types.h"
@@ -49,6 +52,19 @@ class NodeConfigWrapper {
   /** Returns the config file contents (as a JSON string). */
   std::string getNodeConfigJson() const;
 
+  /**
+   * Apply a JSON merge patch (RFC 7396) to the current config, and return the
+   * patched config as a JSON string (without writing it).
+   *
+   * Returns std::nullopt if the structural hash of the current config is not
+   * 'baseConfigHash', or the structural hash of the patched config is not
+   * 'configHash'.
+   */
+  std::optional<std::string> applyConfigPatch(
+      const std::string& patch,
+      const std::string& baseConfigHash,
+      const std::string& configHash) const;
+
   /**
    * Returns the MD5 hash of the config JSON, or an empty string upon an error.
    *
@@ -59,24 +75,46 @@ class NodeConfigWrapper {
    */
   std::string getConfigMd5() const;
 
+  /**
+   * Returns the structural hash of the config (see StructuralHash), or an
+   * empty string upon an error.
+   *
+   * If a delayed action was scheduled, returns the hash of the config prior to
+   * writing the new node config (same as getConfigMd5()).
+   */
+  std::string getConfigHash() const;
+
   /** Set true if a delayed node action is scheduled after a config change. */
   void usePreviousConfigMd5(bool hasDelayedNodeAction);
 
+  /**
+   * Set whether to compute the legacy MD5 hash of the config JSON (on the next
+   * config read) in addition to the structural hash.
+   *
+   * This is enabled by default. Controllers that only compare the legacy MD5
+   * hash will not manage nodes with this disabled.
+   */
+  void setLegacyConfigMd5Enabled(bool enabled);
+
   /**
    * Returns link parameters for the given responder.
    *
    * This combines per-link overrides (if present for responderMac) with the
-   * base parameters.
+   * base parameters. The returned reference is valid until the config is next
+   * read or set.
    */
-  thrift::LinkParams getLinkParams(std::string responderMac) const;
+  const thrift::LinkParams& getLinkParams(
+      const std::string& responderMac) const;
 
   /**
    * Returns radio parameters for the given radio.
    *
    * This combines per-radio overrides (if present for radioMac) with the base
-   * parameters.
+   * parameters. The returned reference is valid until the config is next read
+   * or set.
    */
-  thrift::RadioParams getRadioParams(std::string radioMac = "") const;
+  const thrift::RadioParams& getRadioParams(
+      const std::string& radioMac = "") const;
 
   /**
    * Construct and return the NodeAirtime config based on values in
@@ -122,10 +160,19 @@ class NodeConfigWrapper {
   void initializePointers();
 
   /**
-   * Compute the MD5 hash of the config JSON and save the old MD5 hash before
-   * writing the new node config.
+   * Compute the hashes of the config and save the old hashes before writing
+   * the new node config.
+   *
+   * @param parsed whether the config JSON was successfully parsed into
+   *               nodeConfigDynamic_
+   */
+  void computeConfigHashes(bool parsed);
+
+  /**
+   * Merge each per-link and per-radio override with the base parameters, and
+   * store the results in linkParamsOverrides_ and radioParamsOverrides_.
    */
-  void computeConfigMd5();
+  void computeParamsOverrides();
 
   /** The location of the config file. */
   std::string nodeConfigFile_;
@@ -142,9 +189,30 @@ class NodeConfigWrapper {
   /** The MD5 hash of the config JSON prior to writing the new node config. */
   std::string prevConfigMd5_;
 
+  /** The structural hash of the config. */
+  std::string configHash_;
+
+  /** The structural hash of the config prior to writing the new node config. */
+  std::string prevConfigHash_;
+
+  /** Whether to compute the legacy MD5 hash of the config JSON. */
+  bool legacyConfigMd5Enabled_{true};
+
   /** Whether or not the node is scheduled to perform a delayed node action. */
   bool hasDelayedNodeAction_{false};
 
+  /**
+   * Merged link parameters for each key in `linkParamsOverride`, keyed by
+   * standardized MAC address.
+   */
+  std::unordered_map<std::string, thrift::LinkParams> linkParamsOverrides_;
+
+  /**
+   * Merged radio parameters for each key in `radioParamsOverride`, keyed by
+   * standardized MAC address.
+   */
+  std::unordered_map<std::string, thrift::RadioParams> radioParamsOverrides_;
+
   // Shared pointers to config structs.
   /** \{ **/
   std::shared_ptr<thrift::NodeConfig> nodeConfig_;
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "StructuralHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <openssl/md5.h>
+#include <vector>
+
+#include "Md5Utils.h"
+
+namespace facebook {
+namespace terragraph {
+
+namespace {
+// Type tags
+const char kNullTag{'n'};
+const char kFalseTag{'f'};
+const char kTrueTag{'t'};
+const char kIntTag{'i'};
+const char kDoubleTag{'d'};
+const char kStringTag{'s'};
+const char kArrayTag{'a'};
+const char kObjectTag{'o'};
+// Digest of a nested array or object
+const char kDigestTag{'h'};
+
+// Doubles in this range with an integral value are hashed as integers
+const double kMinInt64AsDouble{-9223372036854775808.0};
+const double kMaxInt64AsDouble{9223372036854775808.0};
+
+void
+updateTag(MD5_CTX& context, char tag) {
+  MD5_Update(&context, &tag, 1);
+}
+
+void
+updateUint64(MD5_CTX& context, uint64_t value) {
+  // Fixed little-endian encoding
+  uint8_t bytes[8];
+  for (size_t i = 0; i < sizeof(bytes); i++) {
+    bytes[i] = (value >> (8 * i)) & 0xff;
+  }
+  MD5_Update(&context, bytes, sizeof(bytes));
+}
+
+void
+updateString(MD5_CTX& context, const std::string& str) {
+  updateUint64(context, str.size());
+  MD5_Update(&context, str.data(), str.size());
+}
+
+void
+updateDigest(MD5_CTX& context, const StructuralHash::Digest& digest) {
+  updateTag(context, kDigestTag);
+  MD5_Update(&context, digest.data(), digest.size());
+}
+
+StructuralHash::Digest
+finalize(MD5_CTX& context) {
+  StructuralHash::Digest digest;
+  MD5_Final(digest.data(), &context);
+  return digest;
+}
+
+StructuralHash::Digest digestArray(const folly::dynamic& array);
+StructuralHash::Digest digestObject(
+    const folly::dynamic& object,
+    const StructuralHash::MemberDigests* cachedMembers);
+
+// Scalars are hashed inline, and arrays/objects as the digest of their contents
+void
+updateValue(MD5_CTX& context, const folly::dynamic& value) {
+  switch (value.type()) {
+    case folly::dynamic::NULLT:
+      updateTag(context, kNullTag);
+      break;
+    case folly::dynamic::BOOL:
+      updateTag(context, value.getBool() ? kTrueTag : kFalseTag);
+      break;
+    case folly::dynamic::INT64:
+      updateTag(context, kIntTag);
+      updateUint64(context, static_cast<uint64_t>(value.getInt()));
+      break;
+    case folly::dynamic::DOUBLE: {
+      double d = value.getDouble();
+      if (std::trunc(d) == d && d >= kMinInt64AsDouble &&
+          d < kMaxInt64AsDouble) {
+        updateTag(context, kIntTag);
+        updateUint64(context, static_cast<uint64_t>(static_cast<int64_t>(d)));
+      } else {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        updateTag(context, kDoubleTag);
+        updateUint64(context, bits);
+      }
+      break;
+    }
+    case folly::dynamic::STRING:
+      updateTag(context, kStringTag);
+      updateString(context, value.getString());
+      break;
+    case folly::dynamic::ARRAY:
+      updateDigest(context, digestArray(value));
+      break;
+    case folly::dynamic::OBJECT:
+      updateDigest(context, digestObject(value, nullptr));
+      break;
+  }
+}
+
+StructuralHash::Digest
+digestArray(const folly::dynamic& array) {
+  MD5_CTX context;
+  MD5_Init(&context);
+  updateTag(context, kArrayTag);
+  updateUint64(context, array.size());
+  for (const auto& value : array) {
+    updateValue(context, value);
+  }
+  return finalize(context);
+}
+
+StructuralHash::Digest
+digestObject(
+    const folly::dynamic& object,
+    const StructuralHash::MemberDigests* cachedMembers) {
+  // Sort members by key
+  std::vector<std::pair<std::string, const folly::dynamic*>> members;
+  members.reserve(object.size());
+  for (const auto& pair : object.items()) {
+    members.emplace_back(pair.first.asString(), &pair.second);
+  }
+  std::sort(members.begin(), members.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+
+  MD5_CTX context;
+  MD5_Init(&context);
+  updateTag(context, kObjectTag);
+  updateUint64(context, members.size());
+  for (const auto& member : members) {
+    updateString(context, member.first);
+    if (cachedMembers) {
+      auto iter = cachedMembers->find(member.first);
+      if (iter != cachedMembers->end()) {
+        updateDigest(context, iter->second);
+        continue;
+      }
+    }
+    updateValue(context, *member.second);
+  }
+  return finalize(context);
+}
+} // namespace
+
+StructuralHash::Digest
+StructuralHash::hash(const folly::dynamic& value) {
+  if (value.isObject()) {
+    return digestObject(value, nullptr);
+  } else if (value.isArray()) {
+    return digestArray(value);
+  }
+
+  MD5_CTX context;
+  MD5_Init(&context);
+  updateValue(context, value);
+  return finalize(context);
+}
+
+StructuralHash::Digest
+StructuralHash::hashObject(
+    const folly::dynamic& object, const MemberDigests& cachedMembers) {
+  return digestObject(object, &cachedMembers);
+}
+
+StructuralHash::MemberDigests
+StructuralHash::hashMembers(const folly::dynamic& object) {
+  MemberDigests memberDigests;
+  if (!object.isObject()) {
+    return memberDigests;
+  }
+  for (const auto& pair : object.items()) {
+    if (pair.second.isObject() || pair.second.isArray()) {
+      memberDigests[pair.first.asString()] = hash(pair.second);
+    }
+  }
+  return memberDigests;
+}
+
+std::string
+StructuralHash::toHex(const Digest& digest) {
+  return Md5Utils::bytesToHex(digest.data(), digest.size());
+}
+
+std::string
+StructuralHash::computeHash(const folly::dynamic& value) {
+  return toHex(hash(value));
+}
+
+} // namespace terragraph
+} // namespace facebook
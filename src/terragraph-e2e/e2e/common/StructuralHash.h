@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <folly/dynamic.h>
+
+namespace facebook {
+namespace terragraph {
+
+/**
+ * Canonical structural hashing of JSON values.
+ *
+ * This computes an MD5-based hash directly over a folly::dynamic tree, without
+ * serializing it to a string first. Object keys are hashed in sorted order, and
+ * scalars are hashed with a type tag and a fixed-size binary encoding, so the
+ * hash only depends on the JSON value and not on key order or formatting.
+ * Doubles with an integral value are hashed as integers, since JSON
+ * serializers may write them either way.
+ *
+ * Each nested object or array is hashed separately and contributes its digest
+ * to its parent (a Merkle tree), which allows the digests of unchanged
+ * top-level members to be cached and reused (see hashMembers() and
+ * hashObject()).
+ */
+class StructuralHash {
+ public:
+  /** A raw hash digest. */
+  using Digest = std::array<uint8_t, 16>;
+
+  /** Digests of the object or array members of an object, by key. */
+  using MemberDigests = std::unordered_map<std::string, Digest>;
+
+  /** Hash the given value. */
+  static Digest hash(const folly::dynamic& value);
+
+  /**
+   * Hash the given object, reusing the digests in 'cachedMembers' instead of
+   * rehashing the corresponding members.
+   *
+   * The caller must guarantee that each member in 'cachedMembers' (e.g. from
+   * hashMembers() on a base object) is unchanged in 'object'.
+   */
+  static Digest hashObject(
+      const folly::dynamic& object, const MemberDigests& cachedMembers);
+
+  /**
+   * Hash each object or array member of the given object.
+   *
+   * Returns an empty map if 'object' is not an object.
+   */
+  static MemberDigests hashMembers(const folly::dynamic& object);
+
+  /** Returns the given digest as a hex string. */
+  static std::string toHex(const Digest& digest);
+
+  /** Hash the given value and return the digest as a hex string. */
+  static std::string computeHash(const folly::dynamic& value);
+};
+
+} // namespace terragraph
+} // namespace facebook
@@ -8,10 +8,13 @@
 #include "UpgradeUtils.h"
 #include "Md5Utils.h"
 
+#include <folly/File.h>
 #include <folly/FileUtil.h>
 
+#include <algorithm>
 #include <regex>
 #include <stdexcept>
+#include <vector>
 
 namespace {
 const std::string kHeaderSizePrefix{"HDRSIZE="};
@@ -19,18 +22,16 @@ const std::string kPreambleBlockSizePrefix{"PREAMBLE_BLOCK_SIZE="};
 // Expecting all the image parameters to appear near the beginning of
 // the upgrade binary, in the first few lines of the upgrade script.
 const size_t kImageParamMaxPosition{1024};
+// Buffer size for reading image files
+const size_t kImageReadBufferSize{1024 * 1024};
 } // namespace
 
 namespace facebook {
 namespace terragraph {
 
+// Parse the header size out of the start of an image
 static size_t
-getImageHeaderSize(const std::string& imageFile) {
-  std::string buf;
-  if (!folly::readFile(imageFile.c_str(), buf, kImageParamMaxPosition)) {
-    throw std::runtime_error(std::string("Can't read ") + imageFile);
-  }
-
+getImageHeaderSize(const std::string& buf, const std::string& imageFile) {
   // Find image header size
   std::regex reg_expr(kHeaderSizePrefix + "([0-9]+)");
   std::smatch m;
@@ -53,7 +54,23 @@ getImageHeaderSize(const std::string& imageFile) {
 
 std::string
 UpgradeUtils::getImageMd5(const std::string& path) {
-  return Md5Utils::computeFileMd5(path, getImageHeaderSize(path));
+  folly::File file;
+  try {
+    file = folly::File(path);
+  } catch (const std::system_error&) {
+    throw std::runtime_error(std::string("Can't read ") + path);
+  }
+
+  StreamingImageMd5 imageMd5(path);
+  std::vector<char> buf(kImageReadBufferSize);
+  ssize_t n;
+  while ((n = folly::readNoInt(file.fd(), buf.data(), buf.size())) > 0) {
+    imageMd5.update(buf.data(), n);
+  }
+  if (n < 0) {
+    throw std::runtime_error(std::string("Can't read ") + path);
+  }
+  return imageMd5.finalize();
 }
 
 void
@@ -67,5 +84,56 @@ UpgradeUtils::verifyImage(
   }
 }
 
+StreamingImageMd5::StreamingImageMd5(const std::string& name) : name_(name) {
+  MD5_Init(&context_);
+}
+
+void
+StreamingImageMd5::update(const char* data, size_t size) {
+  if (!headerSize_) {
+    // Buffer the start of the image until we can parse the header size
+    size_t len = std::min(size, kImageParamMaxPosition - prefix_.size());
+    prefix_.append(data, len);
+    data += len;
+    size -= len;
+    if (prefix_.size() < kImageParamMaxPosition) {
+      return;
+    }
+    processPrefix();
+  }
+  hashContents(data, size);
+}
+
+std::string
+StreamingImageMd5::finalize() {
+  if (!headerSize_) {
+    processPrefix();  // image is shorter than kImageParamMaxPosition
+  }
+  unsigned char result[MD5_DIGEST_LENGTH];
+  MD5_Final(result, &context_);
+  return Md5Utils::bytesToHex(result, MD5_DIGEST_LENGTH);
+}
+
+void
+StreamingImageMd5::hashContents(const char* data, size_t size) {
+  if (offset_ < headerSize_.value()) {
+    size_t skip = std::min(size, headerSize_.value() - offset_);
+    data += skip;
+    size -= skip;
+    offset_ += skip;
+  }
+  if (size > 0) {
+    MD5_Update(&context_, data, size);
+    offset_ += size;
+  }
+}
+
+void
+StreamingImageMd5::processPrefix() {
+  headerSize_ = getImageHeaderSize(prefix_, name_);
+  hashContents(prefix_.data(), prefix_.size());
+  prefix_.clear();
+}
+
 } // namespace terragraph
 } // namespace facebook
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 
+#include <openssl/md5.h>
+
 namespace facebook {
 namespace terragraph {
 
@@ -35,5 +38,52 @@ class UpgradeUtils {
       const std::string& path, const std::string& expectedMd5);
 };
 
+/**
+ * Incrementally computes the MD5 hash of an upgrade image (excluding the
+ * header section) from its contents, e.g. while the image is being downloaded,
+ * so that the image does not need to be read back afterwards.
+ */
+class StreamingImageMd5 {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param name the image name (for error messages only)
+   */
+  explicit StreamingImageMd5(const std::string& name = "image");
+
+  /** Add the next chunk of the image contents. */
+  void update(const char* data, size_t size);
+
+  /**
+   * Returns the MD5 hash of all contents added (excluding the header section).
+   *
+   * Throws std::runtime_error if the image header is invalid.
+   */
+  std::string finalize();
+
+ private:
+  /** Hash the given contents, skipping anything within the header section. */
+  void hashContents(const char* data, size_t size);
+
+  /** Parse the header size out of prefix_, then hash the rest of it. */
+  void processPrefix();
+
+  /** The image name. */
+  std::string name_;
+
+  /** The start of the image contents, until the header size is known. */
+  std::string prefix_;
+
+  /** The header size, once known. */
+  std::optional<size_t> headerSize_;
+
+  /** The number of bytes passed to hashContents() so far. */
+  size_t offset_{0};
+
+  /** The MD5 context. */
+  MD5_CTX context_;
+};
+
 } // namespace terragraph
 } // namespace facebook
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare hashing a real node config by serializing it to sorted, pretty JSON
+// and computing the MD5 of the string (the legacy config MD5) against
+// StructuralHash, both from scratch and with cached digests of the base
+// config's members (as the controller does when only a few top-level sections
+// are overridden per node).
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+
+#include "../JsonUtils.h"
+#include "../Md5Utils.h"
+#include "../StructuralHash.h"
+
+DEFINE_string(
+    config_file,
+    "/etc/e2e_config/base_versions/RELEASE_M81.json",
+    "Node config file to hash");
+
+using namespace facebook::terragraph;
+
+namespace {
+const folly::dynamic&
+getConfig() {
+  static folly::dynamic config = [] {
+    std::string contents = JsonUtils::readJsonFile2String(FLAGS_config_file);
+    CHECK(!contents.empty()) << "Unable to read " << FLAGS_config_file;
+    folly::dynamic config = folly::parseJson(contents);
+    // Typical per-node overrides
+    JsonUtils::dynamicObjectMerge(
+        config,
+        folly::dynamic::object(
+            "envParams", folly::dynamic::object("OPENR_ENABLED", "1"))(
+            "topologyInfo", folly::dynamic::object("nodeName", "node-1")));
+    return config;
+  }();
+  return config;
+}
+} // namespace
+
+BENCHMARK(SortedPrettyJsonMd5, iters) {
+  BENCHMARK_SUSPEND {
+    getConfig();
+  }
+  for (size_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(
+        Md5Utils::computeMd5(JsonUtils::toSortedPrettyJson(getConfig())));
+  }
+}
+
+BENCHMARK_RELATIVE(StructuralHashFull, iters) {
+  BENCHMARK_SUSPEND {
+    getConfig();
+  }
+  for (size_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(StructuralHash::computeHash(getConfig()));
+  }
+}
+
+BENCHMARK_RELATIVE(StructuralHashCached, iters) {
+  StructuralHash::MemberDigests memberDigests;
+  BENCHMARK_SUSPEND {
+    memberDigests = StructuralHash::hashMembers(getConfig());
+    memberDigests.erase("envParams");
+    memberDigests.erase("topologyInfo");
+  }
+  for (size_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(StructuralHash::toHex(
+        StructuralHash::hashObject(getConfig(), memberDigests)));
+  }
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare verifying a downloaded upgrade image by reading it back after the
+// download (Md5Utils::computeFileMd5) against hashing it while it is written
+// (StreamingImageMd5), end-to-end on a large generated image.
+//
+// The download is simulated by writing the image in curl-sized chunks. The
+// file is synced and evicted from the page cache before being read back, to
+// approximate a node where the image does not fit in memory.
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../Md5Utils.h"
+#include "../UpgradeUtils.h"
+
+DEFINE_int32(image_size_mb, 256, "Size of the generated image, in MB");
+DEFINE_string(image_dir, "/tmp", "Directory to write the image to");
+
+using namespace facebook::terragraph;
+
+namespace {
+const size_t kHeaderSize{4096};
+// Typical size of the chunks passed to the curl write callback
+const size_t kChunkSize{16 * 1024};
+
+const std::string&
+getImage() {
+  static std::string image = [] {
+    std::string header = folly::sformat(
+        "#!/bin/sh\nPREAMBLE_BLOCK_SIZE=512\nHDRSIZE={}\n", kHeaderSize);
+    header.resize(kHeaderSize, '#');
+    std::string image = header;
+    image.resize((size_t)FLAGS_image_size_mb * 1024 * 1024);
+    for (size_t i = kHeaderSize; i < image.size(); i++) {
+      image[i] = (char)((i * 7919) >> 3);
+    }
+    return image;
+  }();
+  return image;
+}
+
+std::string
+getImagePath() {
+  return folly::sformat("{}/image_hash_benchmark.bin", FLAGS_image_dir);
+}
+
+// "Download" the image to disk, passing each chunk to 'onData'
+template <class F>
+void
+writeImage(const std::string& path, F&& onData) {
+  const auto& image = getImage();
+  FILE* fp = fopen(path.c_str(), "w");
+  CHECK(fp) << "Unable to open " << path;
+  for (size_t i = 0; i < image.size(); i += kChunkSize) {
+    size_t size = std::min(kChunkSize, image.size() - i);
+    CHECK_EQ(size, fwrite(image.data() + i, 1, size, fp));
+    onData(image.data() + i, size);
+  }
+  fflush(fp);
+  fsync(fileno(fp));
+  posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_DONTNEED);
+  fclose(fp);
+}
+} // namespace
+
+BENCHMARK(DownloadThenReadBack, iters) {
+  std::string path = getImagePath();
+  BENCHMARK_SUSPEND {
+    getImage();
+  }
+  for (size_t i = 0; i < iters; i++) {
+    writeImage(path, [](const char*, size_t) {});
+    folly::doNotOptimizeAway(Md5Utils::computeFileMd5(path, kHeaderSize));
+  }
+  BENCHMARK_SUSPEND {
+    std::remove(path.c_str());
+  }
+}
+
+BENCHMARK_RELATIVE(DownloadWithStreamingHash, iters) {
+  std::string path = getImagePath();
+  BENCHMARK_SUSPEND {
+    getImage();
+  }
+  for (size_t i = 0; i < iters; i++) {
+    StreamingImageMd5 imageMd5(path);
+    writeImage(path, [&imageMd5](const char* data, size_t size) {
+      imageMd5.update(data, size);
+    });
+    folly::doNotOptimizeAway(imageMd5.finalize());
+  }
+  BENCHMARK_SUSPEND {
+    std::remove(path.c_str());
+  }
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
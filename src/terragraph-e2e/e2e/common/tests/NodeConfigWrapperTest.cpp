@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#include "../JsonUtils.h"
+#include "../NodeConfigWrapper.h"
+#include "../StructuralHash.h"
+
+using facebook::terragraph::JsonUtils;
+using facebook::terragraph::NodeConfigWrapper;
+using facebook::terragraph::StructuralHash;
+using folly::dynamic;
+
+namespace {
+const std::string kNodeConfigFile{"/tmp/node_config_wrapper_test.json"};
+} // namespace
+
+class NodeConfigWrapperTest : public ::testing::Test {
+ public:
+  void
+  SetUp() override {
+    config_ = dynamic::object(
+        "envParams", dynamic::object("OPENR_ENABLED", "1")("FOO", "bar"))(
+        "sysParams", dynamic::object("managedConfig", true))(
+        "kvstoreParams", dynamic::object("e2e-network-prefix", "face::/56,64"));
+    ASSERT_TRUE(folly::writeFile(
+        JsonUtils::toSortedPrettyJson(config_), kNodeConfigFile.c_str()));
+    nodeConfigWrapper_.setNodeConfigFile(kNodeConfigFile);
+  }
+
+  void
+  TearDown() override {
+    remove(kNodeConfigFile.c_str());
+  }
+
+  dynamic config_;
+  NodeConfigWrapper nodeConfigWrapper_;
+};
+
+TEST_F(NodeConfigWrapperTest, ConfigHash) {
+  EXPECT_EQ(
+      StructuralHash::computeHash(config_),
+      nodeConfigWrapper_.getConfigHash());
+  EXPECT_EQ(
+      JsonUtils::toSortedPrettyJson(config_),
+      nodeConfigWrapper_.getNodeConfigJson());
+}
+
+TEST_F(NodeConfigWrapperTest, ApplyConfigPatch) {
+  dynamic newConfig = config_;
+  newConfig["envParams"]["OPENR_ENABLED"] = "0";
+  newConfig["envParams"].erase("FOO");
+  newConfig.erase("kvstoreParams");
+  newConfig["radioParamsBase"] =
+      dynamic::object("fwParams", dynamic::object("txPower", 21));
+  dynamic patch = dynamic::merge_diff(config_, newConfig);
+  std::string baseHash = StructuralHash::computeHash(config_);
+  std::string newHash = StructuralHash::computeHash(newConfig);
+
+  auto configJson = nodeConfigWrapper_.applyConfigPatch(
+      folly::toJson(patch), baseHash, newHash);
+  ASSERT_TRUE(configJson.has_value());
+  EXPECT_EQ(JsonUtils::toSortedPrettyJson(newConfig), configJson.value());
+
+  // Nothing is written
+  EXPECT_EQ(baseHash, nodeConfigWrapper_.getConfigHash());
+
+  // Wrong base config
+  EXPECT_FALSE(nodeConfigWrapper_
+                   .applyConfigPatch(folly::toJson(patch), newHash, newHash)
+                   .has_value());
+
+  // Patched config does not match
+  EXPECT_FALSE(nodeConfigWrapper_
+                   .applyConfigPatch(folly::toJson(patch), baseHash, baseHash)
+                   .has_value());
+
+  // Invalid patch
+  EXPECT_FALSE(nodeConfigWrapper_.applyConfigPatch("{", baseHash, newHash)
+                   .has_value());
+}
+
+TEST_F(NodeConfigWrapperTest, ParamsOverrides) {
+  dynamic config = config_;
+  config["linkParamsBase"] = dynamic::object(
+      "fwParams", dynamic::object("txPower", 21)("mcs", 35))(
+      "openrLinkParams", dynamic::object("fixedMetric", 1));
+  config["linkParamsOverride"] = dynamic::object(
+      "00:00:00:00:00:AA",
+      dynamic::object("fwParams", dynamic::object("mcs", 9)))(
+      "not-a-mac",
+      dynamic::object("openrLinkParams", dynamic::object("softDisable", true)));
+  config["radioParamsBase"] =
+      dynamic::object("fwParams", dynamic::object("channel", 2));
+  config["radioParamsOverride"] = dynamic::object(
+      "00:00:00:00:00:bb",
+      dynamic::object("fwParams", dynamic::object("channel", 3)));
+  ASSERT_TRUE(folly::writeFile(
+      JsonUtils::toSortedPrettyJson(config), kNodeConfigFile.c_str()));
+  nodeConfigWrapper_.readNodeConfigFile();
+
+  // Overrides are merged with the base params and looked up by MAC address
+  const auto& linkParams = nodeConfigWrapper_.getLinkParams("0:0:0:0:0:aa");
+  EXPECT_EQ(9, linkParams.fwParams.mcs_ref().value());
+  EXPECT_EQ(21, linkParams.fwParams.txPower_ref().value());
+  EXPECT_EQ(1, linkParams.openrLinkParams.fixedMetric_ref().value());
+  EXPECT_EQ(
+      &linkParams, &nodeConfigWrapper_.getLinkParams("00:00:00:00:00:AA"));
+  EXPECT_TRUE(nodeConfigWrapper_.getLinkParams("not-a-mac")
+                  .openrLinkParams.softDisable_ref()
+                  .value());
+
+  // No override
+  EXPECT_EQ(
+      35,
+      nodeConfigWrapper_.getLinkParams("00:00:00:00:00:cc")
+          .fwParams.mcs_ref()
+          .value());
+  EXPECT_EQ(
+      3,
+      nodeConfigWrapper_.getRadioParams("00:00:00:00:00:BB")
+          .fwParams.channel_ref()
+          .value());
+  EXPECT_EQ(
+      2, nodeConfigWrapper_.getRadioParams().fwParams.channel_ref().value());
+
+  // Overrides are recomputed when the config is re-read
+  config.erase("linkParamsOverride");
+  ASSERT_TRUE(folly::writeFile(
+      JsonUtils::toSortedPrettyJson(config), kNodeConfigFile.c_str()));
+  nodeConfigWrapper_.readNodeConfigFile();
+  EXPECT_EQ(
+      35,
+      nodeConfigWrapper_.getLinkParams("00:00:00:00:00:aa")
+          .fwParams.mcs_ref()
+          .value());
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
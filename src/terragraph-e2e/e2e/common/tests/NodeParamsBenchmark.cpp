@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure looking up the link and radio parameters for every peer of a node
+// with per-link overrides (as the minion does during mass re-association):
+// merging each override with the base parameters and round-tripping it through
+// JSON on every call, versus NodeConfigWrapper's precomputed structs. Also
+// measure the added cost of precomputing them when the config is read. The
+// parameter is the number of peers.
+
+#include <cstdio>
+
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "../JsonUtils.h"
+#include "../NodeConfigWrapper.h"
+
+DEFINE_string(
+    base_config_file,
+    "/etc/e2e_config/base_versions/RELEASE_M81.json",
+    "Base node config file to add per-link and per-radio overrides to");
+DEFINE_string(
+    node_config_file,
+    "/tmp/node_params_benchmark.json",
+    "Node config file to write");
+
+using namespace facebook::terragraph;
+
+namespace {
+const uint32_t kNumRadios{4};
+
+std::string
+getPeerMac(uint32_t i) {
+  return folly::sformat("00:00:00:10:{:02x}:{:02x}", i / 256, i % 256);
+}
+
+std::string
+getRadioMac(uint32_t i) {
+  return folly::sformat("00:00:00:20:00:{:02x}", i);
+}
+
+// Write a node config with 'numPeers' per-link overrides
+void
+writeNodeConfig(uint32_t numPeers) {
+  std::string contents =
+      JsonUtils::readJsonFile2String(FLAGS_base_config_file);
+  CHECK(!contents.empty()) << "Unable to read " << FLAGS_base_config_file;
+  folly::dynamic config = folly::parseJson(contents);
+  config["linkParamsOverride"] = folly::dynamic::object;
+  for (uint32_t i = 0; i < numPeers; i++) {
+    config["linkParamsOverride"][getPeerMac(i)] = folly::dynamic::object(
+        "fwParams", folly::dynamic::object("txPower", 21)("laMaxMcs", 9));
+  }
+  config["radioParamsOverride"] = folly::dynamic::object;
+  for (uint32_t i = 0; i < kNumRadios; i++) {
+    config["radioParamsOverride"][getRadioMac(i)] = folly::dynamic::object(
+        "fwParams", folly::dynamic::object("channel", 1 + i % 4));
+  }
+  CHECK(folly::writeFile(
+      JsonUtils::toSortedPrettyJson(config), FLAGS_node_config_file.c_str()));
+}
+
+// Merge the base params and override for 'mac' and deserialize the result
+template <class T>
+T
+mergeParams(
+    const folly::dynamic& config,
+    const std::string& baseKey,
+    const std::string& overrideKey,
+    const std::string& mac) {
+  auto params = config[baseKey];
+  JsonUtils::dynamicObjectMerge(params, config[overrideKey][mac]);
+  apache::thrift::SimpleJSONSerializer jsonSerializer;
+  return jsonSerializer.deserialize<T>(folly::toJson(params));
+}
+} // namespace
+
+void
+JsonRoundTrip(uint32_t iters, uint32_t numPeers) {
+  folly::dynamic config;
+  BENCHMARK_SUSPEND {
+    writeNodeConfig(numPeers);
+    config = folly::parseJson(
+        JsonUtils::readJsonFile2String(FLAGS_node_config_file));
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    for (uint32_t j = 0; j < numPeers; j++) {
+      auto linkParams = mergeParams<thrift::LinkParams>(
+          config, "linkParamsBase", "linkParamsOverride", getPeerMac(j));
+      auto radioParams = mergeParams<thrift::RadioParams>(
+          config,
+          "radioParamsBase",
+          "radioParamsOverride",
+          getRadioMac(j % kNumRadios));
+      folly::doNotOptimizeAway(linkParams.fwParams);
+      folly::doNotOptimizeAway(radioParams.fwParams);
+    }
+  }
+  BENCHMARK_SUSPEND {
+    std::remove(FLAGS_node_config_file.c_str());
+  }
+}
+
+void
+Precomputed(uint32_t iters, uint32_t numPeers) {
+  NodeConfigWrapper nodeConfigWrapper;
+  BENCHMARK_SUSPEND {
+    writeNodeConfig(numPeers);
+    nodeConfigWrapper.setNodeConfigFile(FLAGS_node_config_file);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    for (uint32_t j = 0; j < numPeers; j++) {
+      const auto& linkParams = nodeConfigWrapper.getLinkParams(getPeerMac(j));
+      const auto& radioParams =
+          nodeConfigWrapper.getRadioParams(getRadioMac(j % kNumRadios));
+      folly::doNotOptimizeAway(linkParams.fwParams);
+      folly::doNotOptimizeAway(radioParams.fwParams);
+    }
+  }
+  BENCHMARK_SUSPEND {
+    std::remove(FLAGS_node_config_file.c_str());
+  }
+}
+
+void
+ReadNodeConfigFile(uint32_t iters, uint32_t numPeers) {
+  NodeConfigWrapper nodeConfigWrapper;
+  BENCHMARK_SUSPEND {
+    writeNodeConfig(numPeers);
+    nodeConfigWrapper.setNodeConfigFile(FLAGS_node_config_file);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    nodeConfigWrapper.readNodeConfigFile();
+  }
+  BENCHMARK_SUSPEND {
+    std::remove(FLAGS_node_config_file.c_str());
+  }
+}
+
+BENCHMARK_PARAM(JsonRoundTrip, 8)
+BENCHMARK_RELATIVE_PARAM(Precomputed, 8)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(JsonRoundTrip, 32)
+BENCHMARK_RELATIVE_PARAM(Precomputed, 32)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(JsonRoundTrip, 64)
+BENCHMARK_RELATIVE_PARAM(Precomputed, 64)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(ReadNodeConfigFile, 0)
+BENCHMARK_PARAM(ReadNodeConfigFile, 32)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#include "../JsonUtils.h"
+#include "../StructuralHash.h"
+
+using facebook::terragraph::JsonUtils;
+using facebook::terragraph::StructuralHash;
+using folly::dynamic;
+
+namespace {
+const std::string kConfig = R"({
+  "envParams": {"OPENR_ENABLED": "1", "FW_LOGGING_ENABLED": "0"},
+  "radioParamsBase": {"fwParams": {"txPower": 28, "mcs": 35}},
+  "sysParams": {"managedConfig": true, "dnsServers": ["1.1.1.1", "8.8.8.8"]},
+  "kvstoreParams": {}
+})";
+} // namespace
+
+TEST(StructuralHashTest, KeyOrderIndependent) {
+  dynamic obj1 = folly::parseJson(kConfig);
+  dynamic obj2 = folly::parseJson(JsonUtils::toSortedPrettyJson(obj1));
+  EXPECT_EQ(
+      StructuralHash::computeHash(obj1), StructuralHash::computeHash(obj2));
+
+  dynamic obj3 = dynamic::object("a", 1)("b", dynamic::object("c", 2)("d", 3));
+  dynamic obj4 = dynamic::object("b", dynamic::object("d", 3)("c", 2))("a", 1);
+  EXPECT_EQ(StructuralHash::hash(obj3), StructuralHash::hash(obj4));
+
+  // Array order still matters
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::array(1, 2)),
+      StructuralHash::hash(dynamic::array(2, 1)));
+}
+
+TEST(StructuralHashTest, TypeSensitive) {
+  EXPECT_NE(StructuralHash::hash(1), StructuralHash::hash("1"));
+  EXPECT_NE(StructuralHash::hash(true), StructuralHash::hash(1));
+  EXPECT_NE(StructuralHash::hash(false), StructuralHash::hash(nullptr));
+  EXPECT_NE(StructuralHash::hash(""), StructuralHash::hash(nullptr));
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::array()),
+      StructuralHash::hash(dynamic::object()));
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::array("a")),
+      StructuralHash::hash(dynamic::object("a", nullptr)));
+
+  // Strings are length-prefixed, so boundaries between keys/values matter
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::object("ab", "c")),
+      StructuralHash::hash(dynamic::object("a", "bc")));
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::array("ab", "c")),
+      StructuralHash::hash(dynamic::array("a", "bc")));
+
+  // Nesting matters
+  EXPECT_NE(
+      StructuralHash::hash(dynamic::array(dynamic::array(1), 2)),
+      StructuralHash::hash(dynamic::array(1, dynamic::array(2))));
+}
+
+TEST(StructuralHashTest, IntegralDoubles) {
+  EXPECT_EQ(StructuralHash::hash(2), StructuralHash::hash(2.0));
+  EXPECT_EQ(StructuralHash::hash(-7), StructuralHash::hash(-7.0));
+  EXPECT_NE(StructuralHash::hash(2), StructuralHash::hash(2.5));
+  EXPECT_NE(StructuralHash::hash(0.1), StructuralHash::hash(0.2));
+  EXPECT_EQ(
+      StructuralHash::hash(dynamic::object("x", 1)),
+      StructuralHash::hash(dynamic::object("x", 1.0)));
+}
+
+TEST(StructuralHashTest, CachedMembers) {
+  dynamic base = folly::parseJson(kConfig);
+  auto memberDigests = StructuralHash::hashMembers(base);
+
+  // Only object/array members are cached
+  EXPECT_EQ(4, memberDigests.size());
+  EXPECT_EQ(
+      StructuralHash::hash(base["envParams"]), memberDigests.at("envParams"));
+  EXPECT_TRUE(StructuralHash::hashMembers(dynamic::array(1)).empty());
+
+  EXPECT_EQ(
+      StructuralHash::hash(base),
+      StructuralHash::hashObject(base, memberDigests));
+
+  // Modify a member and drop its cached digest
+  dynamic config = base;
+  JsonUtils::dynamicObjectMerge(
+      config,
+      dynamic::object(
+          "envParams", dynamic::object("OPENR_ENABLED", "0"))("newKey", 5));
+  auto cachedMembers = memberDigests;
+  cachedMembers.erase("envParams");
+  EXPECT_EQ(
+      StructuralHash::hash(config),
+      StructuralHash::hashObject(config, cachedMembers));
+  EXPECT_NE(StructuralHash::hash(base), StructuralHash::hash(config));
+
+  // A stale cached digest is used as-is
+  EXPECT_NE(
+      StructuralHash::hash(config),
+      StructuralHash::hashObject(config, memberDigests));
+}
+
+TEST(StructuralHashTest, Hex) {
+  std::string hash = StructuralHash::computeHash(folly::parseJson(kConfig));
+  EXPECT_EQ(32, hash.size());
+  EXPECT_EQ(
+      std::string::npos, hash.find_first_not_of("0123456789abcdef"));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
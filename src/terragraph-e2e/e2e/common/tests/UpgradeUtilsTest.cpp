@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "../Md5Utils.h"
+#include "../UpgradeUtils.h"
+
+using namespace facebook::terragraph;
+
+namespace {
+
+// Build an upgrade image with the given header size and payload
+std::string
+makeImage(size_t headerSize, bool legacy, const std::string& payload) {
+  std::string header = "#!/bin/sh\n";
+  if (!legacy) {
+    header += "PREAMBLE_BLOCK_SIZE=512\n";
+  }
+  header += folly::sformat("HDRSIZE={}\n", headerSize);
+  header.resize(legacy ? 2 * headerSize : headerSize, '#');
+  return header + payload;
+}
+
+std::string
+makePayload(size_t size) {
+  std::string payload(size, '\0');
+  for (size_t i = 0; i < size; i++) {
+    payload[i] = (char)((i * 7919) >> 3);
+  }
+  return payload;
+}
+
+// Hash the image in chunks of the given size
+std::string
+getStreamingMd5(const std::string& image, size_t chunkSize) {
+  StreamingImageMd5 imageMd5;
+  for (size_t i = 0; i < image.size(); i += chunkSize) {
+    imageMd5.update(image.data() + i, std::min(chunkSize, image.size() - i));
+  }
+  return imageMd5.finalize();
+}
+
+} // namespace
+
+TEST(UpgradeUtilsTest, StreamingImageMd5) {
+  auto payload = makePayload(100000);
+  auto expectedMd5 = Md5Utils::computeMd5(payload);
+  for (size_t headerSize : {256, 1024, 4096}) {
+    for (bool legacy : {false, true}) {
+      auto image = makeImage(headerSize, legacy, payload);
+      for (size_t chunkSize : {1, 7, 1000, 1024, 16384, 1000000}) {
+        SCOPED_TRACE(folly::sformat(
+            "headerSize={} legacy={} chunkSize={}",
+            headerSize,
+            legacy,
+            chunkSize));
+        EXPECT_EQ(expectedMd5, getStreamingMd5(image, chunkSize));
+      }
+    }
+  }
+
+  // Image shorter than the header search window
+  auto image = makeImage(256, false, "abc");
+  EXPECT_EQ(Md5Utils::computeMd5("abc"), getStreamingMd5(image, 1));
+
+  // No header
+  EXPECT_THROW(getStreamingMd5(payload, 1000), std::runtime_error);
+  EXPECT_THROW(getStreamingMd5("", 1), std::runtime_error);
+}
+
+TEST(UpgradeUtilsTest, ImageFileMd5) {
+  auto payload = makePayload(3000000);
+  auto image = makeImage(1024, false, payload);
+  char path[] = "/tmp/upgrade_utils_test_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  SCOPE_EXIT { std::remove(path); };
+  ASSERT_TRUE(folly::writeFile(image, path));
+
+  auto md5 = Md5Utils::computeMd5(payload);
+  EXPECT_EQ(md5, UpgradeUtils::getImageMd5(path));
+  EXPECT_EQ(
+      Md5Utils::computeFileMd5(path, 1024), UpgradeUtils::getImageMd5(path));
+  EXPECT_NO_THROW(UpgradeUtils::verifyImage(path, md5));
+  EXPECT_THROW(UpgradeUtils::verifyImage(path, "abc"), std::runtime_error);
+  EXPECT_THROW(
+      UpgradeUtils::getImageMd5("/tmp/does/not/exist"), std::runtime_error);
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
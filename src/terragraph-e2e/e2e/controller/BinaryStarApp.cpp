@@ -9,6 +9,7 @@
 
 #include <folly/FileUtil.h>
 #include <folly/MapUtil.h>
+#include <folly/Random.h>
 #include <folly/String.h>
 #include <folly/gen/Base.h>
 
@@ -38,6 +39,18 @@ DEFINE_int32(
     "will yield to the primary (i.e. automatic recovery) after receiving this "
     "number of successive heartbeats (0 to disable). Ignored on primary.");
 
+DEFINE_int32(
+    bstar_replication_log_size,
+    1000,
+    "Number of recent data changes kept for syncing the passive controller "
+    "incrementally (older changes require a full data sync)");
+
+DEFINE_int32(
+    bstar_checkpoint_heartbeats,
+    6,
+    "Number of heartbeats between data checksums sent to the passive "
+    "controller, which triggers a full data sync upon mismatch (0 to disable)");
+
 namespace facebook {
 namespace terragraph {
 
@@ -272,32 +285,34 @@ BinaryStarApp::processBstarSync(const thrift::Message& message) {
       // Just became passive, don't do anything
       // (sequence number mismatch will trigger full data sent next heartbeat)
     } else {
-      seqNum_ = heartbeat->seqNum;
-
-      if (heartbeat->version == version_) {
+      thrift::BinaryStarAppData data;
+      if (heartbeat->version != version_) {
+        replica_.skipHeartbeat(heartbeat.value());
+      } else if (replica_.processHeartbeat(heartbeat.value(), data)) {
         // [DATA_SYNC_SECTION]
-        if (heartbeat->data.topology_ref().has_value()) {
+        if (data.topology_ref().has_value()) {
           sendToCtrlApp(
               E2EConsts::kTopologyAppCtrlId,
               thrift::MessageType::BSTAR_APP_DATA,
-              heartbeat->data);
+              data);
         }
-        if (heartbeat->data.configNetworkOverrides_ref().has_value() ||
-            heartbeat->data.configNodeOverrides_ref().has_value() ||
-            heartbeat->data.configAutoNodeOverrides_ref().has_value() ||
-            heartbeat->data.configController_ref().has_value()) {
+        if (data.configNetworkOverrides_ref().has_value() ||
+            data.configNodeOverrides_ref().has_value() ||
+            data.configAutoNodeOverrides_ref().has_value() ||
+            data.configController_ref().has_value()) {
           sendToCtrlApp(
               E2EConsts::kConfigAppCtrlId,
               thrift::MessageType::BSTAR_APP_DATA,
-              heartbeat->data);
+              data);
         }
       }
     }
   }
 
   // ACTIVE:
-  // - If received sequence number is different from ours, we will transmit the
-  //   full app data on the next heartbeat.
+  // - If received sequence number or epoch is different from what we sent, we
+  //   will re-send changes from there (or the full app data) on the next
+  //   heartbeat.
   // - If we are the backup controller: update successive heartbeat counter for
   //   automatic recovery of the primary.
   if (bstarFsm_.state == thrift::BinaryStarFsmState::STATE_ACTIVE) {
@@ -306,11 +321,12 @@ BinaryStarApp::processBstarSync(const thrift::Message& message) {
       doActiveStateChangeActions();
     } else {
       // Check received sequence number
-      if (heartbeat->seqNum != seqNum_) {
+      if (heartbeat->seqNum != peerSeqNum_ || heartbeat->epoch != peerEpoch_) {
         VLOG(2) << "Received unexpected sequence number from peer (saw "
-                << heartbeat->seqNum << ", expected " << seqNum_
-                << "). Queueing full data sync...";
-        sendFullData_ = true;
+                << heartbeat->seqNum << ", expected " << peerSeqNum_
+                << "). Queueing data sync...";
+        peerSeqNum_ = heartbeat->seqNum;
+        peerEpoch_ = heartbeat->epoch;
       }
 
       // If backup, check automatic recovery heartbeat counter (if enabled)
@@ -346,32 +362,33 @@ BinaryStarApp::sendHeartbeat() {
   heartbeat.state = bstarFsm_.state;
   heartbeat.version = version_;
   if (bstarFsm_.state == thrift::BinaryStarFsmState::STATE_ACTIVE) {
-    // If ACTIVE, include any new app data in this heartbeat
-    auto lockedSyncedAppData = SharedObjects::getSyncedAppData()->wlock();
-    thrift::BinaryStarAppData emptyData;
-    if (!sendFullData_ && lockedSyncedAppData->unsyncedAppData == emptyData) {
-      // No new data to send, so don't increment sequence number
-      heartbeat.seqNum = seqNum_;
-    } else {
-      // Send data with incremented sequence number
-      heartbeat.seqNum = ++seqNum_;
-      heartbeat.data = sendFullData_
-          ? lockedSyncedAppData->fullAppData
-          : lockedSyncedAppData->unsyncedAppData;
+    // If ACTIVE, include any app data the peer is missing in this heartbeat
+    auto lockedSyncedAppData = SharedObjects::getSyncedAppData()->rlock();
+    lockedSyncedAppData->getSyncData(peerSeqNum_, peerEpoch_, heartbeat);
+
+    // Periodically include a checksum, so the peer can detect divergence
+    if (FLAGS_bstar_checkpoint_heartbeats > 0 &&
+        ++heartbeatsSinceCheckpoint_ >= FLAGS_bstar_checkpoint_heartbeats &&
+        heartbeat.seqNum > 0) {
+      heartbeatsSinceCheckpoint_ = 0;
+      heartbeat.checksum_ref() = BinaryStarReplication::getContentHash(
+          lockedSyncedAppData->fullAppData);
     }
-
-    // Clear unsynced data for the next period
-    lockedSyncedAppData->unsyncedAppData = emptyData;
     lockedSyncedAppData.unlock();  // lockedSyncedAppData -> NULL
-    sendFullData_ = false;  // set to 'true' if we receive wrong seqNum
+
+    // Assume the peer receives this (if not, its next heartbeat will tell us)
+    peerSeqNum_ = heartbeat.seqNum;
+    peerEpoch_ = heartbeat.epoch;
   } else {
-    heartbeat.seqNum = seqNum_;
+    heartbeat.seqNum = replica_.getSeqNum();
+    heartbeat.epoch = replica_.getEpoch();
   }
 
   VLOG(2) << "Sending heartbeat to peer (state="
           << TEnumMapFactory<thrift::BinaryStarFsmState>::
               makeValuesToNamesMap().at(heartbeat.state)
-          << ", seqNum=" << heartbeat.seqNum << ")";
+          << ", seqNum=" << heartbeat.seqNum
+          << ", deltas=" << heartbeat.deltas.size() << ")";
   sendToPeer(thrift::MessageType::BSTAR_SYNC, heartbeat, true /* compress */);
 }
 
@@ -433,8 +450,10 @@ BinaryStarApp::yieldToPrimary() {
 
 void
 BinaryStarApp::clear() {
-  seqNum_ = 0;
-  sendFullData_ = false;
+  peerSeqNum_ = 0;
+  peerEpoch_ = 0;
+  heartbeatsSinceCheckpoint_ = 0;
+  replica_.clear();
   lastHeartbeatTime_ = 0;
   autoRecoveryHeartbeats_ = 0;
   SharedObjects::getSyncedAppData()->wlock()->clear();
@@ -458,5 +477,129 @@ BinaryStarApp::logStateChange(
       stateMsg);
 }
 
+void
+BinaryStarApp::SyncedAppData::setTopology(const thrift::Topology& topology) {
+  if (fullAppData.topology_ref().has_value()) {
+    thrift::BinaryStarDelta delta;
+    if (BinaryStarReplication::diffTopology(
+            fullAppData.topology_ref().value(), topology, delta)) {
+      addDelta(std::move(delta));
+    }
+  } else {
+    addUnloggedChange();
+  }
+  fullAppData.topology_ref() = topology;
+}
+
+void
+BinaryStarApp::SyncedAppData::setNetworkOverrides(
+    const std::string& configNetworkOverrides) {
+  auto field = fullAppData.configNetworkOverrides_ref();
+  setJsonField(
+      field.has_value() ? &field.value() : nullptr,
+      configNetworkOverrides,
+      &thrift::BinaryStarDelta::configNetworkOverrides);
+  field = configNetworkOverrides;
+}
+
+void
+BinaryStarApp::SyncedAppData::setNodeOverrides(
+    const std::string& configNodeOverrides) {
+  auto field = fullAppData.configNodeOverrides_ref();
+  setJsonField(
+      field.has_value() ? &field.value() : nullptr,
+      configNodeOverrides,
+      &thrift::BinaryStarDelta::configNodeOverrides);
+  field = configNodeOverrides;
+}
+
+void
+BinaryStarApp::SyncedAppData::setAutoNodeOverrides(
+    const std::string& configAutoNodeOverrides) {
+  auto field = fullAppData.configAutoNodeOverrides_ref();
+  setJsonField(
+      field.has_value() ? &field.value() : nullptr,
+      configAutoNodeOverrides,
+      &thrift::BinaryStarDelta::configAutoNodeOverrides);
+  field = configAutoNodeOverrides;
+}
+
+void
+BinaryStarApp::SyncedAppData::setControllerConfig(
+    const std::string& configController) {
+  auto field = fullAppData.configController_ref();
+  if (!field.has_value()) {
+    addUnloggedChange();
+  } else if (field.value() != configController) {
+    thrift::BinaryStarDelta delta;
+    delta.configController_ref() = configController;
+    addDelta(std::move(delta));
+  }
+  field = configController;
+}
+
+void
+BinaryStarApp::SyncedAppData::clear() {
+  fullAppData = thrift::BinaryStarAppData();
+  seqNum = 0;
+  log.clear();
+  epoch = static_cast<int64_t>(folly::Random::rand64() >> 1) + 1;
+}
+
+void
+BinaryStarApp::SyncedAppData::getSyncData(
+    int32_t peerSeqNum,
+    int64_t peerEpoch,
+    thrift::BinaryStarSync& heartbeat) const {
+  heartbeat.seqNum = seqNum;
+  heartbeat.epoch = epoch;
+  if (peerEpoch == epoch) {
+    if (peerSeqNum == seqNum) {
+      return;  // peer is up to date
+    }
+    if (peerSeqNum < seqNum && !log.empty() &&
+        log.front().seqNum <= peerSeqNum + 1) {
+      heartbeat.deltas.assign(
+          log.begin() + (peerSeqNum + 1 - log.front().seqNum), log.end());
+      return;
+    }
+  }
+  heartbeat.data = fullAppData;
+}
+
+void
+BinaryStarApp::SyncedAppData::addDelta(thrift::BinaryStarDelta&& delta) {
+  delta.seqNum = ++seqNum;
+  log.push_back(std::move(delta));
+  while (log.size() > (size_t)std::max(FLAGS_bstar_replication_log_size, 0)) {
+    log.pop_front();
+  }
+}
+
+void
+BinaryStarApp::SyncedAppData::addUnloggedChange() {
+  ++seqNum;
+  log.clear();
+}
+
+void
+BinaryStarApp::SyncedAppData::setJsonField(
+    const std::string* oldJson,
+    const std::string& newJson,
+    std::map<std::string, std::string> thrift::BinaryStarDelta::*changes) {
+  if (oldJson && *oldJson == newJson) {
+    return;
+  }
+  thrift::BinaryStarDelta delta;
+  if (oldJson && BinaryStarReplication::diffJsonObject(
+                     *oldJson, newJson, delta.*changes)) {
+    if (!(delta.*changes).empty()) {
+      addDelta(std::move(delta));
+    }
+  } else {
+    addUnloggedChange();
+  }
+}
+
 } // namespace terragraph
 } // namespace facebook
@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
+
 #include <fbzmq/async/ZmqTimeout.h>
 
+#include "BinaryStarReplication.h"
 #include "CtrlApp.h"
 #include "e2e/common/CompressionUtil.h"
 #include "e2e/if/gen-cpp2/Controller_types.h"
@@ -28,23 +32,27 @@ namespace terragraph {
  * fault-tolerant.
  *
  * Data synchronization protocol overview:
- * - The ACTIVE peer sends new application data to the PASSIVE as part of the
- *   heartbeat message. It also attaches a sequence number, which the PASSIVE
- *   echoes back in its heartbeat.
- * - If the ACTIVE receives a heartbeat with a mismatching sequence number, it
- *   will send a full copy of its data with the next heartbeat. Otherwise, it
- *   will only send data that changed (if any).
- * - The sequence number is only incremented when the ACTIVE sends either new
- *   data or a full copy of its data. It is NOT incremented on every heartbeat.
- * - When a peer becomes ACTIVE, it will reset its sequence number, then request
- *   current data to be sent from all its applications.
- * - Sequence numbers are initialized to 0. The first heartbeat from the ACTIVE
- *   will have a sequence number of 1, since it has requested data from its
- *   applications (see above).
+ * - The ACTIVE peer records every change to its application data as a delta
+ *   in a bounded replication log (see SyncedAppData), with consecutive
+ *   sequence numbers. Sequence numbers are only incremented on changes, NOT on
+ *   every heartbeat.
+ * - The ACTIVE peer sends its latest sequence number, along with an "epoch"
+ *   identifying its current session, to the PASSIVE as part of the heartbeat
+ *   message. The PASSIVE echoes back the sequence number and epoch of the last
+ *   change it applied (see BinaryStarReplica).
+ * - The ACTIVE sends all deltas following the PASSIVE's sequence number, or a
+ *   full copy of its data if the log does not reach back that far or the
+ *   epoch differs. It assumes the data was received, and re-sends from the
+ *   PASSIVE's sequence number if a later heartbeat says otherwise.
+ * - Periodically, the ACTIVE also sends a content hash of its data. If this
+ *   does not match the PASSIVE's data at the same sequence number, the PASSIVE
+ *   resets its sequence number to trigger a full data sync.
+ * - When a peer becomes ACTIVE, it will start a new session (epoch) with an
+ *   empty log, then request current data to be sent from all its applications.
  * - Only a PASSIVE peer (not PRIMARY/BACKUP) will update its sequence number
  *   when receiving a heartbeat. This guarantees that the first heartbeat sent
- *   to the ACTIVE will mismatch (since 0 cannot match), and thus trigger full
- *   data sync on the next heartbeat.
+ *   to a new ACTIVE will mismatch (since the epoch cannot match), and thus
+ *   trigger full data sync on the next heartbeat.
  *
  * When adding new fields to sync (using thrift::BinaryStarAppData), edit ALL
  * blocks labeled [DATA_SYNC_SECTION] in the implementation file.
@@ -79,42 +87,56 @@ class BinaryStarApp final : public CtrlApp {
       const std::string& peerPubSockUrl = "",
       const std::string& versionFile = "");
 
-  /** Wrapper for data synced with apps. */
+  /**
+   * Wrapper for data synced with apps.
+   *
+   * Every change is recorded in a bounded log of structured deltas with
+   * consecutive sequence numbers, so peers can be synced incrementally.
+   */
   struct SyncedAppData {
     /** Set the topology. */
-    void setTopology(const thrift::Topology& topology) {
-      fullAppData.topology_ref() = topology;
-      unsyncedAppData.topology_ref() = topology;
-    }
+    void setTopology(const thrift::Topology& topology);
     /** Set the network overrides. */
-    void setNetworkOverrides(const std::string& configNetworkOverrides) {
-      fullAppData.configNetworkOverrides_ref() = configNetworkOverrides;
-      unsyncedAppData.configNetworkOverrides_ref() = configNetworkOverrides;
-    }
+    void setNetworkOverrides(const std::string& configNetworkOverrides);
     /** Set the user node overrides. */
-    void setNodeOverrides(const std::string& configNodeOverrides) {
-      fullAppData.configNodeOverrides_ref() = configNodeOverrides;
-      unsyncedAppData.configNodeOverrides_ref() = configNodeOverrides;
-    }
+    void setNodeOverrides(const std::string& configNodeOverrides);
     /** Set the automatic node overrides. */
-    void setAutoNodeOverrides(const std::string& configAutoNodeOverrides) {
-      fullAppData.configAutoNodeOverrides_ref() = configAutoNodeOverrides;
-      unsyncedAppData.configAutoNodeOverrides_ref() = configAutoNodeOverrides;
-    }
+    void setAutoNodeOverrides(const std::string& configAutoNodeOverrides);
     /** Set the controller config. */
-    void setControllerConfig(const std::string& configController) {
-      fullAppData.configController_ref() = configController;
-      unsyncedAppData.configController_ref() = configController;
-    }
-    /** Clear all data. */
-    void clear() {
-      fullAppData = thrift::BinaryStarAppData();
-      unsyncedAppData = thrift::BinaryStarAppData();
-    }
+    void setControllerConfig(const std::string& configController);
+    /** Clear all data and the log, and start a new session (epoch). */
+    void clear();
+    /**
+     * Fill in the sync data (sequence number, epoch, and either deltas or the
+     * full app data) for a peer that has applied all changes up to
+     * 'peerSeqNum' within session 'peerEpoch'.
+     */
+    void getSyncData(
+        int32_t peerSeqNum,
+        int64_t peerEpoch,
+        thrift::BinaryStarSync& heartbeat) const;
     /** The full app data. */
     thrift::BinaryStarAppData fullAppData;
-    /** The unsynced app data. */
-    thrift::BinaryStarAppData unsyncedAppData;
+    /** The sequence number of the latest change. */
+    int32_t seqNum{0};
+    /** The current session, which seqNum belongs to. */
+    int64_t epoch{0};
+    /** The most recent changes, ending at seqNum. */
+    std::deque<thrift::BinaryStarDelta> log;
+
+   private:
+    /** Append a delta to the log, assigning it the next sequence number. */
+    void addDelta(thrift::BinaryStarDelta&& delta);
+    /** Record a change which is not in the log (requires full data sync). */
+    void addUnloggedChange();
+    /**
+     * Record a change to a JSON object field, as a delta of top-level keys if
+     * possible.
+     */
+    void setJsonField(
+        const std::string* oldJson,
+        const std::string& newJson,
+        std::map<std::string, std::string> thrift::BinaryStarDelta::*changes);
   };
 
  private:
@@ -142,7 +164,7 @@ class BinaryStarApp final : public CtrlApp {
 
   /**
    * Perform actions related to a state change to ACTIVE:
-   * - Reset the heartbeat sequence number.
+   * - Start a new replication session (reset the log and sequence number).
    * - Request new app data from all apps.
    */
   void doActiveStateChangeActions();
@@ -207,17 +229,19 @@ class BinaryStarApp final : public CtrlApp {
   thrift::BinaryStar bstarFsm_;
 
   /**
-   * The current heartbeat sequence number.
-   * This value is ONLY incremented when sending new app data (NOT every
-   * heartbeat), and is reset to 0 upon becoming ACTIVE.
+   * If ACTIVE, the sequence number of the last change assumed to be applied by
+   * the peer (i.e. sent to it, or reported in its last heartbeat).
    */
-  int32_t seqNum_{0};
+  int32_t peerSeqNum_{0};
 
-  /**
-   * If ACTIVE, whether to send the full app data on the next heartbeat
-   * (instead of only unsynced data).
-   */
-  bool sendFullData_{false};
+  /** If ACTIVE, the epoch which peerSeqNum_ belongs to. */
+  int64_t peerEpoch_{0};
+
+  /** If ACTIVE, the number of heartbeats sent since the last checkpoint. */
+  int32_t heartbeatsSinceCheckpoint_{0};
+
+  /** If PASSIVE, our copy of the ACTIVE peer's app data. */
+  BinaryStarReplica replica_;
 
   /**
    * The millisecond timestamp on the last heartbeat received.
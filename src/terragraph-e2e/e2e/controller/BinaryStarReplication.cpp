@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "BinaryStarReplication.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "e2e/common/JsonUtils.h"
+
+namespace {
+// Returns whether the delta changes the topology
+bool
+hasTopologyChanges(
+    const facebook::terragraph::thrift::BinaryStarDelta& delta) {
+  return !delta.nodesChanged.empty() || !delta.nodesRemoved.empty() ||
+         !delta.linksChanged.empty() || !delta.linksRemoved.empty() ||
+         !delta.sitesChanged.empty() || !delta.sitesRemoved.empty() ||
+         delta.topologyName_ref().has_value() ||
+         delta.topologyConfig_ref().has_value();
+}
+
+// Find elements (by name) added/changed or removed between two lists
+template <class T>
+void
+diffByName(
+    const std::vector<T>& oldList,
+    const std::vector<T>& newList,
+    std::vector<T>& changed,
+    std::vector<std::string>& removed) {
+  std::unordered_map<std::string, const T*> oldByName;
+  oldByName.reserve(oldList.size());
+  for (const auto& t : oldList) {
+    oldByName[t.name] = &t;
+  }
+  for (const auto& t : newList) {
+    auto iter = oldByName.find(t.name);
+    if (iter == oldByName.end()) {
+      changed.push_back(t);
+    } else {
+      if (!(*iter->second == t)) {
+        changed.push_back(t);
+      }
+      oldByName.erase(iter);
+    }
+  }
+  for (const auto& t : oldList) {
+    if (oldByName.count(t.name)) {
+      removed.push_back(t.name);
+    }
+  }
+}
+
+// Apply added/changed and removed elements (by name) to a list
+template <class T>
+void
+applyByName(
+    std::vector<T>& list,
+    const std::vector<T>& changed,
+    const std::vector<std::string>& removed) {
+  if (!removed.empty()) {
+    std::unordered_set<std::string> names(removed.begin(), removed.end());
+    list.erase(
+        std::remove_if(
+            list.begin(),
+            list.end(),
+            [&](const T& t) { return names.count(t.name) > 0; }),
+        list.end());
+  }
+  if (changed.empty()) {
+    return;
+  }
+  std::unordered_map<std::string, size_t> index;
+  index.reserve(list.size());
+  for (size_t i = 0; i < list.size(); i++) {
+    index[list[i].name] = i;
+  }
+  for (const auto& t : changed) {
+    auto iter = index.find(t.name);
+    if (iter != index.end()) {
+      list[iter->second] = t;
+    } else {
+      index[t.name] = list.size();
+      list.push_back(t);
+    }
+  }
+}
+
+// Apply changed top-level keys to a JSON object string
+template <class FieldRef>
+bool
+applyJsonChanges(
+    FieldRef field, const std::map<std::string, std::string>& changes) {
+  if (changes.empty()) {
+    return true;
+  }
+  if (!field.has_value()) {
+    return false;
+  }
+  try {
+    folly::dynamic obj = folly::parseJson(field.value());
+    if (!obj.isObject()) {
+      return false;
+    }
+    for (const auto& kv : changes) {
+      if (kv.second.empty()) {
+        obj.erase(kv.first);
+      } else {
+        obj[kv.first] = folly::parseJson(kv.second);
+      }
+    }
+    field = folly::toJson(obj);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Unable to apply JSON changes: " << ex.what();
+    return false;
+  }
+  return true;
+}
+
+// Sort all arrays in a JSON value (i.e. treat them as sets)
+void
+sortArrays(folly::dynamic& value) {
+  if (value.isArray()) {
+    for (auto& v : value) {
+      sortArrays(v);
+    }
+    std::sort(
+        value.begin(),
+        value.end(),
+        [](const folly::dynamic& a, const folly::dynamic& b) {
+          return folly::toJson(a) < folly::toJson(b);
+        });
+  } else if (value.isObject()) {
+    for (auto& kv : value.items()) {
+      sortArrays(kv.second);
+    }
+  }
+}
+
+// Hash the elements of a list in order of name
+template <class T>
+void
+hashByName(const std::vector<T>& list, folly::hash::SpookyHashV2& hasher) {
+  std::vector<const T*> sorted;
+  sorted.reserve(list.size());
+  for (const auto& t : list) {
+    sorted.push_back(&t);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const T* a, const T* b) {
+    return a->name < b->name;
+  });
+  std::string buf;
+  for (const T* t : sorted) {
+    buf.clear();
+    apache::thrift::CompactSerializer::serialize(*t, &buf);
+    hasher.Update(buf.data(), buf.size());
+  }
+  uint64_t size = list.size();
+  hasher.Update(&size, sizeof(size));
+}
+
+// Hash an optional JSON string field, ignoring formatting
+template <class FieldRef>
+void
+hashJson(FieldRef field, folly::hash::SpookyHashV2& hasher) {
+  if (!field.has_value()) {
+    hasher.Update("\0", 1);
+    return;
+  }
+  std::string canonical;
+  try {
+    canonical = facebook::terragraph::JsonUtils::toSortedPrettyJson(
+        field.value());
+  } catch (const std::invalid_argument&) {
+    canonical = field.value();
+  }
+  hasher.Update("\1", 1);
+  hasher.Update(canonical.data(), canonical.size());
+}
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+
+bool
+BinaryStarReplication::diffTopology(
+    const thrift::Topology& oldTopology,
+    const thrift::Topology& newTopology,
+    thrift::BinaryStarDelta& delta) {
+  diffByName(
+      oldTopology.nodes,
+      newTopology.nodes,
+      delta.nodesChanged,
+      delta.nodesRemoved);
+  diffByName(
+      oldTopology.links,
+      newTopology.links,
+      delta.linksChanged,
+      delta.linksRemoved);
+  diffByName(
+      oldTopology.sites,
+      newTopology.sites,
+      delta.sitesChanged,
+      delta.sitesRemoved);
+  if (oldTopology.name != newTopology.name) {
+    delta.topologyName_ref() = newTopology.name;
+  }
+  if (!(oldTopology.config == newTopology.config)) {
+    delta.topologyConfig_ref() = newTopology.config;
+  }
+  return hasTopologyChanges(delta);
+}
+
+bool
+BinaryStarReplication::diffJsonObject(
+    const std::string& oldJson,
+    const std::string& newJson,
+    std::map<std::string, std::string>& changes) {
+  folly::dynamic oldObj, newObj;
+  try {
+    oldObj = folly::parseJson(oldJson);
+    newObj = folly::parseJson(newJson);
+  } catch (const std::exception&) {
+    return false;
+  }
+  if (!oldObj.isObject() || !newObj.isObject()) {
+    return false;
+  }
+
+  for (const auto& kv : newObj.items()) {
+    auto iter = oldObj.find(kv.first);
+    if (iter == oldObj.items().end() || iter->second != kv.second) {
+      changes[kv.first.asString()] = folly::toJson(kv.second);
+    }
+  }
+  for (const auto& kv : oldObj.items()) {
+    if (!newObj.count(kv.first)) {
+      changes[kv.first.asString()] = "";
+    }
+  }
+  return true;
+}
+
+bool
+BinaryStarReplication::applyDelta(
+    thrift::BinaryStarAppData& data, const thrift::BinaryStarDelta& delta) {
+  if (hasTopologyChanges(delta)) {
+    if (!data.topology_ref().has_value()) {
+      return false;
+    }
+    thrift::Topology& topology = data.topology_ref().value();
+    applyByName(topology.nodes, delta.nodesChanged, delta.nodesRemoved);
+    applyByName(topology.links, delta.linksChanged, delta.linksRemoved);
+    applyByName(topology.sites, delta.sitesChanged, delta.sitesRemoved);
+    if (delta.topologyName_ref().has_value()) {
+      topology.name = delta.topologyName_ref().value();
+    }
+    if (delta.topologyConfig_ref().has_value()) {
+      topology.config = delta.topologyConfig_ref().value();
+    }
+  }
+
+  if (!applyJsonChanges(
+          data.configNetworkOverrides_ref(), delta.configNetworkOverrides) ||
+      !applyJsonChanges(
+          data.configNodeOverrides_ref(), delta.configNodeOverrides) ||
+      !applyJsonChanges(
+          data.configAutoNodeOverrides_ref(),
+          delta.configAutoNodeOverrides)) {
+    return false;
+  }
+  if (delta.configController_ref().has_value()) {
+    data.configController_ref() = delta.configController_ref().value();
+  }
+  return true;
+}
+
+int64_t
+BinaryStarReplication::getContentHash(const thrift::BinaryStarAppData& data) {
+  folly::hash::SpookyHashV2 hasher;
+  hasher.Init(0, 0);
+
+  if (data.topology_ref().has_value()) {
+    const thrift::Topology& topology = data.topology_ref().value();
+    hasher.Update("\1", 1);
+    hasher.Update(topology.name.data(), topology.name.size());
+    hashByName(topology.nodes, hasher);
+    hashByName(topology.links, hasher);
+    hashByName(topology.sites, hasher);
+
+    // Config contains unordered containers, so compare it as sorted JSON
+    folly::dynamic config =
+        folly::parseJson(JsonUtils::serializeToJson(topology.config));
+    sortArrays(config);
+    std::string configJson = JsonUtils::toSortedPrettyJson(config);
+    hasher.Update(configJson.data(), configJson.size());
+  } else {
+    hasher.Update("\0", 1);
+  }
+  hashJson(data.configNetworkOverrides_ref(), hasher);
+  hashJson(data.configNodeOverrides_ref(), hasher);
+  hashJson(data.configAutoNodeOverrides_ref(), hasher);
+  hashJson(data.configController_ref(), hasher);
+
+  uint64_t hash1, hash2;
+  hasher.Final(&hash1, &hash2);
+  return static_cast<int64_t>(hash1);
+}
+
+bool
+BinaryStarReplica::processHeartbeat(
+    const thrift::BinaryStarSync& heartbeat,
+    thrift::BinaryStarAppData& changed) {
+  // Full copy
+  if (!(heartbeat.data == thrift::BinaryStarAppData())) {
+    appData_ = heartbeat.data;
+    seqNum_ = heartbeat.seqNum;
+    epoch_ = heartbeat.epoch;
+    changed = heartbeat.data;
+    return true;
+  }
+
+  // Sequence numbers from another ACTIVE session are meaningless, so wait for
+  // a full copy (the mismatch will trigger one)
+  if (heartbeat.epoch != epoch_) {
+    VLOG(2) << "Ignoring heartbeat data from a different session";
+    return false;
+  }
+
+  // Apply deltas following our sequence number (skip duplicates, and stop at
+  // any gap to wait for a re-send)
+  bool topologyChanged = false;
+  bool networkOverridesChanged = false;
+  bool nodeOverridesChanged = false;
+  bool autoNodeOverridesChanged = false;
+  bool controllerConfigChanged = false;
+  for (const auto& delta : heartbeat.deltas) {
+    if (delta.seqNum <= seqNum_) {
+      continue;
+    }
+    if (delta.seqNum != seqNum_ + 1) {
+      VLOG(2) << "Missing changes " << (seqNum_ + 1) << " to "
+              << (delta.seqNum - 1) << ", waiting for re-send";
+      break;
+    }
+    if (!BinaryStarReplication::applyDelta(appData_, delta)) {
+      LOG(ERROR) << "Unable to apply change " << delta.seqNum
+                 << ", requesting full data sync...";
+      seqNum_ = 0;
+      break;
+    }
+    seqNum_ = delta.seqNum;
+
+    topologyChanged |= hasTopologyChanges(delta);
+    networkOverridesChanged |= !delta.configNetworkOverrides.empty();
+    nodeOverridesChanged |= !delta.configNodeOverrides.empty();
+    autoNodeOverridesChanged |= !delta.configAutoNodeOverrides.empty();
+    controllerConfigChanged |= delta.configController_ref().has_value();
+  }
+
+  // Verify checkpoint
+  if (seqNum_ != 0 && heartbeat.seqNum == seqNum_ &&
+      heartbeat.checksum_ref().has_value() &&
+      heartbeat.checksum_ref().value() !=
+          BinaryStarReplication::getContentHash(appData_)) {
+    LOG(ERROR) << "Data checksum mismatch at sequence number " << seqNum_
+               << ", requesting full data sync...";
+    seqNum_ = 0;
+  }
+
+  // [DATA_SYNC_SECTION]
+  if (topologyChanged && appData_.topology_ref().has_value()) {
+    changed.topology_ref() = appData_.topology_ref().value();
+  }
+  if (networkOverridesChanged &&
+      appData_.configNetworkOverrides_ref().has_value()) {
+    changed.configNetworkOverrides_ref() =
+        appData_.configNetworkOverrides_ref().value();
+  }
+  if (nodeOverridesChanged && appData_.configNodeOverrides_ref().has_value()) {
+    changed.configNodeOverrides_ref() =
+        appData_.configNodeOverrides_ref().value();
+  }
+  if (autoNodeOverridesChanged &&
+      appData_.configAutoNodeOverrides_ref().has_value()) {
+    changed.configAutoNodeOverrides_ref() =
+        appData_.configAutoNodeOverrides_ref().value();
+  }
+  if (controllerConfigChanged && appData_.configController_ref().has_value()) {
+    changed.configController_ref() = appData_.configController_ref().value();
+  }
+  return topologyChanged || networkOverridesChanged || nodeOverridesChanged ||
+         autoNodeOverridesChanged || controllerConfigChanged;
+}
+
+void
+BinaryStarReplica::skipHeartbeat(const thrift::BinaryStarSync& heartbeat) {
+  appData_ = thrift::BinaryStarAppData();
+  seqNum_ = heartbeat.seqNum;
+  epoch_ = heartbeat.epoch;
+}
+
+int32_t
+BinaryStarReplica::getSeqNum() const {
+  return seqNum_;
+}
+
+int64_t
+BinaryStarReplica::getEpoch() const {
+  return epoch_;
+}
+
+const thrift::BinaryStarAppData&
+BinaryStarReplica::getAppData() const {
+  return appData_;
+}
+
+void
+BinaryStarReplica::clear() {
+  appData_ = thrift::BinaryStarAppData();
+  seqNum_ = 0;
+  epoch_ = 0;
+}
+
+} // namespace terragraph
+} // namespace facebook
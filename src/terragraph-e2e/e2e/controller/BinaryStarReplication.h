@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "e2e/if/gen-cpp2/Controller_types.h"
+
+namespace facebook {
+namespace terragraph {
+
+/**
+ * Helpers for replicating thrift::BinaryStarAppData between controllers as a
+ * log of structured changes (thrift::BinaryStarDelta) instead of full copies.
+ */
+class BinaryStarReplication {
+ public:
+  /**
+   * Add the changes between two topologies to 'delta'.
+   *
+   * Nodes, links, and sites are compared by name.
+   *
+   * Returns true if anything changed.
+   */
+  static bool diffTopology(
+      const thrift::Topology& oldTopology,
+      const thrift::Topology& newTopology,
+      thrift::BinaryStarDelta& delta);
+
+  /**
+   * Compute the changed top-level keys between two JSON objects, mapping each
+   * to its new (serialized) value, or to an empty string if removed.
+   *
+   * Returns false if either string is not a JSON object.
+   */
+  static bool diffJsonObject(
+      const std::string& oldJson,
+      const std::string& newJson,
+      std::map<std::string, std::string>& changes);
+
+  /**
+   * Apply a delta to the given app data.
+   *
+   * Returns false if the delta could not be applied (i.e. a changed field was
+   * never synced), in which case 'data' may be partially modified.
+   */
+  static bool applyDelta(
+      thrift::BinaryStarAppData& data, const thrift::BinaryStarDelta& delta);
+
+  /**
+   * Returns a hash of the given app data which does not depend on the order
+   * of topology elements or on JSON formatting.
+   */
+  static int64_t getContentHash(const thrift::BinaryStarAppData& data);
+};
+
+/**
+ * The PASSIVE controller's copy of the ACTIVE controller's app data, which
+ * applies the data received in heartbeats.
+ */
+class BinaryStarReplica {
+ public:
+  /**
+   * Apply the app data within a heartbeat from the ACTIVE peer (either a full
+   * copy, or deltas following our sequence number).
+   *
+   * If the heartbeat contains a checksum that does not match our data, or if
+   * deltas cannot be applied, the sequence number is reset to request a full
+   * copy on the next heartbeat.
+   *
+   * All fields that changed are copied (in full) to 'changed'.
+   * Returns true if anything changed.
+   */
+  bool processHeartbeat(
+      const thrift::BinaryStarSync& heartbeat,
+      thrift::BinaryStarAppData& changed);
+
+  /**
+   * Acknowledge a heartbeat without applying its app data (e.g. upon version
+   * mismatch). Our copy is dropped.
+   */
+  void skipHeartbeat(const thrift::BinaryStarSync& heartbeat);
+
+  /** Returns the sequence number of the last change applied. */
+  int32_t getSeqNum() const;
+
+  /** Returns the ACTIVE session which the sequence number belongs to. */
+  int64_t getEpoch() const;
+
+  /** Returns our copy of the app data. */
+  const thrift::BinaryStarAppData& getAppData() const;
+
+  /** Clear all data. */
+  void clear();
+
+ private:
+  /** Our copy of the app data. */
+  thrift::BinaryStarAppData appData_;
+
+  /** The sequence number of the last change applied (0 if none). */
+  int32_t seqNum_{0};
+
+  /** The ACTIVE session which seqNum_ belongs to. */
+  int64_t epoch_{0};
+};
+
+} // namespace terragraph
+} // namespace facebook
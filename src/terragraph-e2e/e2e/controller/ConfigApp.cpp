@@ -16,7 +16,7 @@
 #include "GraphHelper.h"
 #include "SharedObjects.h"
 #include "e2e/common/GpsClock.h"
-#include "e2e/common/Md5Utils.h"
+#include "e2e/common/JsonUtils.h"
 #include "e2e/common/TimeUtils.h"
 #include "e2e/common/UuidUtils.h"
 #include "algorithms/PolarityHelper.h"
@@ -76,9 +76,93 @@ DEFINE_int32(
     "The minimum time period in seconds between consecutive requests for base "
     "configs from nodes running unknown hardware with the same board ID");
 
+DEFINE_int32(
+    config_render_threads,
+    4,
+    "Number of threads used to render and hash node configs outside of the "
+    "config lock");
+
+DEFINE_bool(
+    config_legacy_md5,
+    true,
+    "Whether to compute the legacy MD5 hash of node configs and use it to "
+    "detect config changes. Nodes also report a structural config hash, which "
+    "is used when this is disabled (or the MD5 is unavailable); nodes on older "
+    "software versions only report the MD5 and will not be configured while "
+    "this is disabled.");
+
+DEFINE_bool(
+    config_delta_push_enabled,
+    true,
+    "Whether to send config changes to nodes as JSON merge patches against the "
+    "last config each node reported running, instead of the full config");
+
 namespace facebook {
 namespace terragraph {
 
+namespace {
+// Returns whether the node's reported config matches its config state, or
+// std::nullopt if they cannot be compared.
+//
+// The legacy MD5 is authoritative whenever both sides have it; disagreements
+// with the structural hash are logged.
+std::optional<bool>
+isConfigInSync(
+    const std::string& nodeName,
+    const ConfigHelper::NodeConfigState& configState,
+    const thrift::StatusReport& report) {
+  std::optional<bool> hashMatch;
+  if (!configState.hash.empty() && report.configHash_ref().has_value()) {
+    hashMatch = configState.hash == report.configHash_ref().value();
+  }
+  if (!configState.md5.empty() && !report.configMd5.empty()) {
+    bool md5Match = configState.md5 == report.configMd5;
+    if (hashMatch && hashMatch.value() != md5Match) {
+      LOG(WARNING) << "Config MD5 and structural hash disagree for " << nodeName
+                   << " (MD5 " << (md5Match ? "match" : "mismatch")
+                   << ", hash " << (hashMatch.value() ? "match" : "mismatch")
+                   << ")";
+    }
+    return md5Match;
+  }
+  return hashMatch;
+}
+
+// Returns a patch from the node's synced config to 'config', or std::nullopt
+// if the node did not last report running its synced config.
+std::optional<thrift::MinionConfigPatch>
+buildConfigPatch(
+    const std::optional<ConfigHelper::SyncedConfig>& syncedConfig,
+    const std::optional<std::string>& reportedHash,
+    const folly::dynamic& config,
+    const std::string& configHash) {
+  if (!FLAGS_config_delta_push_enabled || !syncedConfig ||
+      reportedHash != syncedConfig->hash) {
+    return std::nullopt;
+  }
+  thrift::MinionConfigPatch configPatch;
+  configPatch.patch = folly::toJson(
+      folly::dynamic::merge_diff(*syncedConfig->configObj, config));
+  configPatch.baseConfigHash = syncedConfig->hash;
+  configPatch.configHash = configHash;
+  return configPatch;
+}
+
+// Returns the node's last reported structural config hash (if any).
+std::optional<std::string>
+getReportedConfigHash(
+    const std::unordered_map<std::string, StatusApp::StatusReport>&
+        statusReports,
+    const std::string& nodeMac) {
+  auto iter = statusReports.find(nodeMac);
+  if (iter == statusReports.end() ||
+      !iter->second.report.configHash_ref().has_value()) {
+    return std::nullopt;
+  }
+  return iter->second.report.configHash_ref().value();
+}
+} // namespace
+
 ConfigApp::ConfigApp(
     fbzmq::Context& zmqContext,
     const std::string& routerSockUrl,
@@ -94,6 +178,15 @@ ConfigApp::ConfigApp(
       agentSock_(
           zmqContext, fbzmq::IdentityString{E2EConsts::kConfigAppCtrlId}),
       controllerPid_(controllerPid) {
+  SharedObjects::getConfigHelper()->wlock()->setLegacyConfigMd5Enabled(
+      FLAGS_config_legacy_md5);
+
+  // Config render workers (kept for the lifetime of the app)
+  if (FLAGS_config_render_threads > 1) {
+    renderExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        FLAGS_config_render_threads);
+  }
+
   // Periodic status sync
   statusReportsSyncTimeout_ =
       ZmqTimeout::make(this, [this]() noexcept { syncWithStatusReports(); });
@@ -227,6 +320,9 @@ ConfigApp::processMessage(
     case thrift::MessageType::MINION_BASE_CONFIG:
       processMinionBaseConfig(minion, senderApp, message);
       break;
+    case thrift::MessageType::MINION_CONFIG_RESEND_REQ:
+      processMinionConfigResendReq(minion, senderApp, message);
+      break;
     case thrift::MessageType::UPDATE_TUNNEL_CONFIG:
       processUpdateTunnelConfig(senderApp, message);
       break;
@@ -315,9 +411,19 @@ ConfigApp::syncWithStatusReports() {
             << " node(s) at BWGD index " << bwgdIdx << ": "
             << folly::join(", ", currBatch_);
 
+  // New configs to send, which are serialized after releasing the config lock
+  struct PendingConfig {
+    std::string nodeName;
+    std::string nodeMac;
+    std::optional<ConfigHelper::SyncedConfig> syncedConfig;
+    folly::dynamic configObj;
+    std::string configHash;
+  };
+  std::vector<PendingConfig> pendingConfigs;
+
   auto lockedConfigHelper = SharedObjects::getConfigHelper()->wlock();
 
-  // Send new config to minion for each node
+  // Collect new config for each node
   batchStartTime_ = TimeUtils::getSteadyTimestamp();
   for (const auto& mapIt : name2MacMap) {
     const std::string& nodeName = mapIt.first;
@@ -374,8 +480,41 @@ ConfigApp::syncWithStatusReports() {
 
     // Send new config
     lockedConfigHelper->setNodeConfigTime(nodeName, batchStartTime_);
+    pendingConfigs.push_back(PendingConfig{
+        nodeName,
+        nodeMac,
+        lockedConfigHelper->getNodeConfigSynced(nodeName),
+        std::move(configState->configObj),
+        std::move(configState->hash)});
+  }
+
+  // Release lock before serializing configs (which is expensive on large
+  // networks)
+  lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
+
+  // Send new config to minion for each node
+  int64_t rolloutBytes = 0;
+  int64_t patchedNodes = 0;
+  int64_t fullNodes = 0;
+  for (const auto& pendingConfig : pendingConfigs) {
+    const std::string& nodeName = pendingConfig.nodeName;
+    const std::string& nodeMac = pendingConfig.nodeMac;
     thrift::SetMinionConfigReq setMinionConfigReq;
-    setMinionConfigReq.config = configState->configJson;
+    auto configPatch = buildConfigPatch(
+        pendingConfig.syncedConfig,
+        getReportedConfigHash(statusReports, nodeMac),
+        pendingConfig.configObj,
+        pendingConfig.configHash);
+    if (configPatch) {
+      rolloutBytes += configPatch->patch.size();
+      patchedNodes++;
+      setMinionConfigReq.configPatch_ref() = std::move(configPatch.value());
+    } else {
+      setMinionConfigReq.config =
+          JsonUtils::toSortedPrettyJson(pendingConfig.configObj);
+      rolloutBytes += setMinionConfigReq.config.size();
+      fullNodes++;
+    }
     setMinionConfigReq.bwgdIdx = bwgdIdx;
     sendToMinionApp(
         nodeMac,
@@ -392,6 +531,21 @@ ConfigApp::syncWithStatusReports() {
         std::make_optional(nodeMac),
         std::make_optional(nodeName));
   }
+
+  LOG(INFO) << "Sent " << rolloutBytes << " config bytes (" << patchedNodes
+            << " patched, " << fullNodes << " full)";
+  setCounter(
+      "e2e_controller.config_rollout.bytes",
+      rolloutBytes,
+      fbzmq::thrift::CounterValueType::GAUGE);
+  setCounter(
+      "e2e_controller.config_rollout.patched_nodes",
+      patchedNodes,
+      fbzmq::thrift::CounterValueType::GAUGE);
+  setCounter(
+      "e2e_controller.config_rollout.full_nodes",
+      fullNodes,
+      fbzmq::thrift::CounterValueType::GAUGE);
 }
 
 void
@@ -419,7 +573,35 @@ ConfigApp::getNodesPendingConfig(
   // Copy the full mac2NodeMap to avoid acquiring multiple locks
   auto mac2NodeName =
       SharedObjects::getTopologyWrapper()->rlock()->getMac2NodeNameMap();
+
+  // Render missing or outdated config states outside of the config lock
+  // (e.g. after network overrides change, every node needs a new config)
+  std::vector<ConfigHelper::NodeConfigRender> renders;
   auto lockedConfigHelper = SharedObjects::getConfigHelper()->wlock();
+  for (const auto& statusIt : statusReports) {
+    const thrift::StatusReport& report = statusIt.second.report;
+    auto nodeNameIt = mac2NodeName.find(statusIt.first);
+    if (nodeNameIt == mac2NodeName.end() ||
+        (report.configMd5.empty() && !report.configHash_ref().has_value())) {
+      continue;
+    }
+    auto configState = lockedConfigHelper->getConfigState(nodeNameIt->second);
+    if (!configState ||
+        configState->swVersion != report.version ||
+        configState->hwBoardId != report.hardwareBoardId) {
+      renders.push_back(lockedConfigHelper->prepareNodeConfigRender(
+          nodeNameIt->second,
+          report.version,
+          report.firmwareVersion,
+          report.hardwareBoardId));
+    }
+  }
+  if (!renders.empty()) {
+    lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
+    ConfigHelper::renderNodeConfigs(renders, renderExecutor_.get());
+    lockedConfigHelper = SharedObjects::getConfigHelper()->wlock();
+    lockedConfigHelper->setConfigStates(renders);
+  }
 
   std::unordered_set<string> nodesPendingConfig;
   for (const auto& statusIt : statusReports) {
@@ -432,9 +614,9 @@ ConfigApp::getNodesPendingConfig(
     }
     string nodeName = nodeNameIt->second;
 
-    // Skip if node reported empty MD5
+    // Skip if node reported neither a config MD5 nor a config hash
     // This happens when a node is running a SW version older than RELEASE_M17
-    if (report.configMd5.empty()) {
+    if (report.configMd5.empty() && !report.configHash_ref().has_value()) {
       VLOG(3) << "Skipping config for " << nodeName
               << " (node reported empty config MD5)";
       continue;
@@ -477,9 +659,16 @@ ConfigApp::getNodesPendingConfig(
       continue;
     }
 
-    // Skip config if MD5 matches
-    if (configState->md5 == report.configMd5) {
+    // Skip config if MD5/hash matches, or if there is nothing to compare
+    auto inSync = isConfigInSync(nodeName, configState.value(), report);
+    if (!inSync.has_value()) {
+      VLOG(3) << "Skipping config for " << nodeName
+              << " (no comparable config MD5 or hash)";
+      continue;
+    }
+    if (inSync.value()) {
       VLOG(5) << "Skipping config for " << nodeName << " (MD5 match)";
+      lockedConfigHelper->setNodeConfigSynced(nodeName);
       continue;
     }
 
@@ -525,13 +714,15 @@ ConfigApp::monitorCurrentBatchRollout(
     }
     const thrift::StatusReport& report = statusIt->second.report;
 
-    // Check if MD5 of current node matches the report's MD5
+    // Check if MD5/hash of current node matches the report's MD5/hash
     auto configState = lockedConfigHelper->getConfigState(nodeName);
     if (!configState) {
       LOG(ERROR) << "No config state for node " << nodeName << ", skipping...";
       currBatch_.erase(nodeName);
-    } else if (configState->md5 == report.configMd5) {
+    } else if (isConfigInSync(nodeName, configState.value(), report)
+                   .value_or(false)) {
       LOG(INFO) << "Config update for " << nodeName << " is complete";
+      lockedConfigHelper->setNodeConfigSynced(nodeName);
       currBatch_.erase(nodeName);
     }
   }
@@ -569,6 +760,80 @@ ConfigApp::processGetMinionConfigActionsResp(
   entry.actions = configActionsResp->actions;
 }
 
+void
+ConfigApp::processMinionConfigResendReq(
+    const string& minion,
+    const string& senderApp,
+    const thrift::Message& message) {
+  auto request = maybeReadThrift<thrift::MinionConfigResendReq>(message);
+  if (!request) {
+    handleInvalidMessage("MinionConfigResendReq", senderApp, minion, false);
+    return;
+  }
+  auto maybeNodeName =
+      SharedObjects::getTopologyWrapper()->rlock()->getNodeNameByMac(minion);
+  if (!maybeNodeName) {
+    LOG(ERROR) << "Discarding config resend request from " << minion
+               << " (not in topology)";
+    return;
+  }
+  const string& nodeName = maybeNodeName.value();
+  LOG(INFO) << nodeName << " could not apply config patch, resending full "
+            << "config";
+  bumpCounter("e2e_controller.config_rollout.resend_reqs");
+
+  // Send full configs to this node until it reports being in sync again
+  auto lockedConfigHelper = SharedObjects::getConfigHelper()->wlock();
+  lockedConfigHelper->clearNodeConfigSynced(nodeName);
+  auto configState = lockedConfigHelper->getConfigState(nodeName);
+  if (!configState) {
+    return;
+  }
+
+  if (request->id_ref().has_value()) {
+    // Re-render the config for the config actions request
+    const string& id = request->id_ref().value();
+    auto iter = configActionsOverrideLayers_.find(id);
+    if (iter == configActionsOverrideLayers_.end()) {
+      VLOG(2) << "Discarding config resend request from " << nodeName
+              << " for unknown or expired ID: " << id;
+      return;
+    }
+    std::vector<ConfigHelper::NodeConfigRender> renders;
+    renders.push_back(lockedConfigHelper->prepareNodeConfigRender(
+        nodeName,
+        configState->swVersion,
+        configState->fwVersion,
+        configState->hwBoardId,
+        iter->second));
+    lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
+    ConfigHelper::renderNodeConfigs(renders, nullptr);
+    if (renders[0].hash == request->configHash) {
+      sendConfigActionsRequestToMinion(id, configState.value(), renders[0]);
+    }
+    return;
+  }
+
+  // If the config changed since the patch was sent, the next status sync will
+  // send the new config instead
+  if (configState->hash != request->configHash) {
+    return;
+  }
+  lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
+
+  // Reuse the original BWGD index, which should still be in the future (see
+  // 'firmware_parameter_update_delay')
+  thrift::SetMinionConfigReq setMinionConfigReq;
+  setMinionConfigReq.config =
+      JsonUtils::toSortedPrettyJson(configState->configObj);
+  setMinionConfigReq.bwgdIdx = request->bwgdIdx;
+  sendToMinionApp(
+      minion,
+      E2EConsts::kConfigAppMinionId,
+      thrift::MessageType::SET_MINION_CONFIG_REQ,
+      setMinionConfigReq);
+}
+
 void
 ConfigApp::processGetConfigActionsResultsReq(
     const string& senderApp, const thrift::Message& message) {
@@ -1054,11 +1319,13 @@ ConfigApp::processGetConfigNodeOverridesActionsReq(
   // Send to all affected nodes that we have config state for
   // NOTE: If a SET command was recently processed and a node hasn't reported
   // its status yet, we won't send them a request.
-  std::unordered_map<
-      string,
-      std::pair<folly::dynamic, ConfigHelper::NodeConfigState>>
-      newNodeConfigs;
-  for (const auto& pair : newNodesOverrides.items()) {
+  auto overrideLayers = std::make_shared<ConfigHelper::OverrideLayers>(
+      *lockedConfigHelper->getOverrideLayers());
+  overrideLayers->nodesOverrides = std::move(newNodesOverrides);
+  configActionsOverrideLayers_[resp.id] = overrideLayers;
+  std::vector<ConfigHelper::NodeConfigRender> renders;
+  std::vector<ConfigHelper::NodeConfigState> configStates;
+  for (const auto& pair : overrideLayers->nodesOverrides.items()) {
     string nodeName = pair.first.asString();
     auto configState = lockedConfigHelper->getConfigState(nodeName);
 
@@ -1066,22 +1333,19 @@ ConfigApp::processGetConfigNodeOverridesActionsReq(
       continue;  // skip unknown or unmanaged nodes
     }
 
-    folly::dynamic nodeConfig = lockedConfigHelper->buildNodeConfig(
+    renders.push_back(lockedConfigHelper->prepareNodeConfigRender(
         nodeName,
         configState->swVersion,
         configState->fwVersion,
         configState->hwBoardId,
-        std::nullopt,
-        std::nullopt,
-        std::make_optional(newNodesOverrides));
-
-    newNodeConfigs[nodeName] = std::make_pair(nodeConfig, configState.value());
+        overrideLayers));
+    configStates.push_back(std::move(configState.value()));
   }
   lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
 
-  for (const auto& kv : newNodeConfigs) {
-    sendConfigActionsRequestToMinion(
-        resp.id, kv.first, kv.second.second, kv.second.first);
+  ConfigHelper::renderNodeConfigs(renders, renderExecutor_.get());
+  for (size_t i = 0; i < renders.size(); i++) {
+    sendConfigActionsRequestToMinion(resp.id, configStates[i], renders[i]);
   }
 }
 
@@ -1211,35 +1475,31 @@ ConfigApp::processGetConfigNetworkOverridesActionsReq(
   // Send to all nodes that we have config state for
   // NOTE: If a SET command was recently processed and a node hasn't reported
   // its status yet, we won't send them a request.
+  auto overrideLayers = std::make_shared<ConfigHelper::OverrideLayers>(
+      *lockedConfigHelper->getOverrideLayers());
+  overrideLayers->networkOverrides = std::move(newNetworkOverrides);
+  configActionsOverrideLayers_[resp.id] = overrideLayers;
   auto configStateMap = lockedConfigHelper->getAllConfigStates();
-  std::unordered_map<
-      string,
-      std::pair<folly::dynamic, ConfigHelper::NodeConfigState>>
-      newNodeConfigs;
-  for (const auto& kv : configStateMap) {
-    auto nodeName = kv.first;
-    auto configState = kv.second;
-
-    if (!configState.isManaged) {
+  std::vector<ConfigHelper::NodeConfigRender> renders;
+  std::vector<ConfigHelper::NodeConfigState> configStates;
+  for (auto& kv : configStateMap) {
+    if (!kv.second.isManaged) {
       continue;  // skip unmanaged nodes
     }
 
-    folly::dynamic nodeConfig = lockedConfigHelper->buildNodeConfig(
-        nodeName,
-        configState.swVersion,
-        configState.fwVersion,
-        configState.hwBoardId,
-        std::nullopt,
-        std::make_optional(newNetworkOverrides),
-        std::nullopt);
-
-    newNodeConfigs[nodeName] = {nodeConfig, configState};
+    renders.push_back(lockedConfigHelper->prepareNodeConfigRender(
+        kv.first,
+        kv.second.swVersion,
+        kv.second.fwVersion,
+        kv.second.hwBoardId,
+        overrideLayers));
+    configStates.push_back(std::move(kv.second));
   }
   lockedConfigHelper.unlock();  // lockedConfigHelper -> NULL
 
-  for (const auto& kv : newNodeConfigs) {
-    sendConfigActionsRequestToMinion(
-        resp.id, kv.first, kv.second.second, kv.second.first);
+  ConfigHelper::renderNodeConfigs(renders, renderExecutor_.get());
+  for (size_t i = 0; i < renders.size(); i++) {
+    sendConfigActionsRequestToMinion(resp.id, configStates[i], renders[i]);
   }
 }
 
@@ -1561,15 +1821,12 @@ ConfigApp::processBstarAppData(
 bool
 ConfigApp::sendConfigActionsRequestToMinion(
     const string& id,
-    const string& nodeName,
     const ConfigHelper::NodeConfigState& configState,
-    const folly::dynamic& nodeConfig) {
+    const ConfigHelper::NodeConfigRender& render) {
+  const string& nodeName = render.nodeName;
 
-  string configJson = JsonUtils::toSortedPrettyJson(nodeConfig);
-  string configMd5 = Md5Utils::computeMd5(configJson);
-
-  // If our config didn't change, don't send request
-  if (configMd5 == configState.md5) {
+  // If the config failed to render or didn't change, don't send request
+  if (!render.rendered || render.hash == configState.hash) {
     return false;
   }
 
@@ -1579,12 +1836,26 @@ ConfigApp::sendConfigActionsRequestToMinion(
   if (!maybeMacAddr) {
     return false;  // not in topology
   }
+  auto reportedHash = getReportedConfigHash(
+      *SharedObjects::getStatusReports()->rlock(), maybeMacAddr.value());
 
   // Send request message to minion
   VLOG(4) << "Sending config actions request to " << nodeName << " (id=" << id
           << ")";
   thrift::GetMinionConfigActionsReq getMinionConfigActionsReq;
-  getMinionConfigActionsReq.config = configJson;
+  auto configPatch = buildConfigPatch(
+      SharedObjects::getConfigHelper()->rlock()->getNodeConfigSynced(nodeName),
+      reportedHash,
+      render.configObj,
+      render.hash);
+  if (configPatch) {
+    getMinionConfigActionsReq.configPatch_ref() =
+        std::move(configPatch.value());
+  } else {
+    getMinionConfigActionsReq.config = render.configJson.empty()
+        ? JsonUtils::toSortedPrettyJson(render.configObj)
+        : render.configJson;
+  }
   getMinionConfigActionsReq.id = id;
   sendToMinionApp(
       maybeMacAddr.value(),
@@ -1723,7 +1994,10 @@ ConfigApp::generateGetConfigActionsResp(const string& overrides) {
   // Schedule timeout to discard these results
   scheduleTimeout(
       std::chrono::seconds(FLAGS_config_actions_req_timeout_s),
-      [&, resp ]() noexcept { configActionsResults_.erase(resp.id); });
+      [&, resp ]() noexcept {
+        configActionsResults_.erase(resp.id);
+        configActionsOverrideLayers_.erase(resp.id);
+      });
 
   return resp;
 }
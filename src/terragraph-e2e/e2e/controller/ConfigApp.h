@@ -10,6 +10,7 @@
 #include <fbzmq/async/ZmqTimeout.h>
 #include <folly/String.h>
 #include <folly/dynamic.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 
 #include "ConfigHelper.h"
 #include "CtrlApp.h"
@@ -63,6 +64,14 @@ class ConfigApp final : public CtrlApp {
       const std::string& minion,
       const std::string& senderApp,
       const thrift::Message& message);
+  /**
+   * Process thrift::MinionConfigResendReq, sent by a minion that could not
+   * apply a config patch.
+   */
+  void processMinionConfigResendReq(
+      const std::string& minion,
+      const std::string& senderApp,
+      const thrift::Message& message);
   /** Process thrift::GetCtrlConfigReq. */
   void processGetConfigReq(
       const std::string& senderApp, const thrift::Message& message);
@@ -184,16 +193,15 @@ class ConfigApp final : public CtrlApp {
           statusReports);
 
   /**
-   * Send a config actions request to node, using the given config state and
-   * overrides.
+   * Send a config actions request to a node for the given rendered config, if
+   * it differs from the node's current config state.
    *
    * GetMinionConfigActionsReq is constructed with the given ID.
    */
   bool sendConfigActionsRequestToMinion(
       const std::string& id,
-      const std::string& nodeName,
       const ConfigHelper::NodeConfigState& configState,
-      const folly::dynamic& nodeConfig);
+      const ConfigHelper::NodeConfigRender& render);
 
   /**
    * Build a config actions response to 'senderApp', generating a unique ID and
@@ -276,6 +284,15 @@ class ConfigApp final : public CtrlApp {
   std::unordered_map<std::string /* id */, ConfigActionsResults>
       configActionsResults_{};
 
+  /**
+   * The override layers used for each config actions request, indexed by ID
+   * (used to resend full configs to nodes that could not apply a config patch).
+   */
+  std::unordered_map<
+      std::string /* id */,
+      std::shared_ptr<const ConfigHelper::OverrideLayers>>
+      configActionsOverrideLayers_{};
+
   /** The process ID of the controller. */
   pid_t controllerPid_;
 
@@ -293,6 +310,9 @@ class ConfigApp final : public CtrlApp {
 
   /** The monotonic time when the current batch began configuration. */
   int64_t batchStartTime_;
+
+  /** Thread pool for rendering node configs (null to render inline). */
+  std::unique_ptr<folly::CPUThreadPoolExecutor> renderExecutor_;
 };
 
 } // namespace terragraph
@@ -7,11 +7,13 @@
 
 #include "ConfigHelper.h"
 
+#include <atomic>
 #include <ctime>
 
 #include <boost/filesystem.hpp>
 #include <folly/Conv.h>
 #include <folly/Format.h>
+#include <folly/futures/Future.h>
 #include <folly/gen/Base.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
@@ -80,6 +82,8 @@ ConfigHelper::setConfigFiles(
   // Load config files from disk
   readLocalConfigStore(topologyNodeNames);
 
+  invalidateBaseLayers();
+  invalidateOverrideLayers();
   configState_.clear();
 }
 
@@ -182,6 +186,7 @@ ConfigHelper::readBaseConfigs() {
   auto result = readBaseConfigFiles(baseConfigDir_);
   baseConfigObjects_ = result.first;
   latestBaseVersion_ = result.second;
+  invalidateBaseLayers();
 }
 
 void
@@ -204,6 +209,7 @@ ConfigHelper::readFirmwareBaseConfigs() {
   }
 
   fwConfigObjects_ = std::move(obj);
+  invalidateBaseLayers();
 }
 
 void
@@ -217,6 +223,7 @@ ConfigHelper::readHardwareBaseConfigs() {
     hwConfigObjects_[hwType] = result.first;
     latestHwBaseVersions_[hwType] = result.second;
   }
+  invalidateBaseLayers();
 }
 
 void
@@ -244,6 +251,7 @@ ConfigHelper::readHardwareTypesFile() {
       }
     }
   }
+  invalidateBaseLayers();
 }
 
 void
@@ -295,6 +303,7 @@ ConfigHelper::readNetworkConfigOverrides() {
   // Store network config overrides
   LOG(INFO) << "Loaded network config overrides";
   networkOverrides_ = std::move(cfg);
+  invalidateOverrideLayers();
 }
 
 void
@@ -417,6 +426,44 @@ ConfigHelper::buildNodeConfig(
     const std::optional<folly::dynamic> autoNodeOverrides,
     const std::optional<folly::dynamic> networkOverrides,
     const std::optional<folly::dynamic> nodeOverrides) {
+  // Get merged base, firmware base, and hardware base configs
+  folly::dynamic config =
+      getBaseLayers(swVersion, fwVersion, hwBoardId)->config;
+
+  // Merge with override layers
+  JsonUtils::dynamicObjectMerge(
+      config,
+      getConfigOverridesForNode(
+          nodeName, autoNodeOverrides, networkOverrides, nodeOverrides));
+  return config;
+}
+
+std::shared_ptr<const ConfigHelper::BaseLayers>
+ConfigHelper::getBaseLayers(
+    const std::string& swVersion,
+    const std::optional<std::string>& fwVersion,
+    const std::optional<std::string>& hwBoardId) {
+  // Look up in hardware types map
+  std::optional<std::string> hwConfigType;
+  if (hwBoardId) {
+    auto hwConfigTypeIter = hardwareConfigTypeMap_.find(hwBoardId.value());
+    if (hwConfigTypeIter != hardwareConfigTypeMap_.end()) {
+      hwConfigType = hwConfigTypeIter->second;
+    }
+  }
+
+  std::string key = folly::sformat(
+      "{}\n{}{}\n{}{}",
+      swVersion,
+      fwVersion ? "+" : "-",
+      fwVersion.value_or(""),
+      hwConfigType ? "+" : "-",
+      hwConfigType.value_or(""));
+  auto cacheIter = baseLayersCache_.find(key);
+  if (cacheIter != baseLayersCache_.end()) {
+    return cacheIter->second;
+  }
+
   SwVersion version(swVersion);
 
   // Get best base config match
@@ -430,30 +477,49 @@ ConfigHelper::buildNodeConfig(
     JsonUtils::dynamicObjectMerge(config, fwConfig);
   }
 
-  // Merge with hardware base config (if hwBoardId is provided)
-  if (hwBoardId) {
-    // Look up in hardware types map
-    auto hwConfigTypeIter = hardwareConfigTypeMap_.find(hwBoardId.value());
-    if (hwConfigTypeIter != hardwareConfigTypeMap_.end()) {
-      // Look up in hardware configs map
-      auto hwConfigIter = hwConfigObjects_.find(hwConfigTypeIter->second);
-      if (hwConfigIter != hwConfigObjects_.items().end()) {
-        auto hwVerIter = latestHwBaseVersions_.find(hwConfigTypeIter->second);
-        std::string hwDefaultVer = (hwVerIter != latestHwBaseVersions_.end())
-            ? hwVerIter->second : "";
-        folly::dynamic hwConfig = getBaseConfig(
-            version, hwConfigIter->second, hwDefaultVer, true);
-        JsonUtils::dynamicObjectMerge(config, hwConfig);
-      }
+  // Merge with hardware base config (if hwBoardId has a known type)
+  if (hwConfigType) {
+    // Look up in hardware configs map
+    auto hwConfigIter = hwConfigObjects_.find(hwConfigType.value());
+    if (hwConfigIter != hwConfigObjects_.items().end()) {
+      auto hwVerIter = latestHwBaseVersions_.find(hwConfigType.value());
+      std::string hwDefaultVer = (hwVerIter != latestHwBaseVersions_.end())
+          ? hwVerIter->second : "";
+      folly::dynamic hwConfig = getBaseConfig(
+          version, hwConfigIter->second, hwDefaultVer, true);
+      JsonUtils::dynamicObjectMerge(config, hwConfig);
     }
   }
 
-  // Merge with override layers
-  JsonUtils::dynamicObjectMerge(
-      config,
-      getConfigOverridesForNode(
-          nodeName, autoNodeOverrides, networkOverrides, nodeOverrides));
-  return config;
+  auto baseLayers = std::make_shared<BaseLayers>();
+  baseLayers->memberDigests = StructuralHash::hashMembers(config);
+  baseLayers->config = std::move(config);
+  baseLayersCache_[key] = baseLayers;
+  return baseLayers;
+}
+
+void
+ConfigHelper::invalidateBaseLayers() {
+  baseLayersCache_.clear();
+  layerGeneration_++;
+}
+
+void
+ConfigHelper::invalidateOverrideLayers() {
+  overrideLayers_.reset();
+  layerGeneration_++;
+}
+
+std::shared_ptr<const ConfigHelper::OverrideLayers>
+ConfigHelper::getOverrideLayers() {
+  if (!overrideLayers_) {
+    auto overrideLayers = std::make_shared<OverrideLayers>();
+    overrideLayers->autoNodesOverrides = autoNodesOverrides_;
+    overrideLayers->networkOverrides = networkOverrides_;
+    overrideLayers->nodesOverrides = nodesOverrides_;
+    overrideLayers_ = std::move(overrideLayers);
+  }
+  return overrideLayers_;
 }
 
 folly::dynamic
@@ -462,50 +528,37 @@ ConfigHelper::getConfigOverridesForNode(
     const std::optional<folly::dynamic> autoNodeOverrides,
     const std::optional<folly::dynamic> networkOverrides,
     const std::optional<folly::dynamic> nodeOverrides) const {
+  return mergeConfigOverrides(
+      nodeName,
+      autoNodeOverrides ? autoNodeOverrides.value() : autoNodesOverrides_,
+      networkOverrides ? networkOverrides.value() : networkOverrides_,
+      nodeOverrides ? nodeOverrides.value() : nodesOverrides_);
+}
+
+folly::dynamic
+ConfigHelper::mergeConfigOverrides(
+    const std::optional<std::string>& nodeName,
+    const folly::dynamic& autoNodesOverrides,
+    const folly::dynamic& networkOverrides,
+    const folly::dynamic& nodesOverrides) {
   folly::dynamic config = folly::dynamic::object;
 
   // Merge with automatic node overrides (if nodeName is provided)
-  if (nodeName) {
-    if (!autoNodeOverrides) {
-      if (autoNodesOverrides_.isObject()) {
-        auto iter = autoNodesOverrides_.find(*nodeName);
-        if (iter != autoNodesOverrides_.items().end()) {
-          config = iter->second;
-        }
-      }
-    } else {
-      if (autoNodeOverrides->isObject()) {
-        auto iter = autoNodeOverrides->find(*nodeName);
-        if (iter != autoNodeOverrides->items().end()) {
-          config = iter->second;
-        }
-      }
+  if (nodeName && autoNodesOverrides.isObject()) {
+    auto iter = autoNodesOverrides.find(*nodeName);
+    if (iter != autoNodesOverrides.items().end()) {
+      config = iter->second;
     }
   }
 
   // Merge with network overrides
-  if (!networkOverrides) {
-    JsonUtils::dynamicObjectMerge(config, networkOverrides_);
-  } else {
-    JsonUtils::dynamicObjectMerge(config, networkOverrides.value());
-  }
+  JsonUtils::dynamicObjectMerge(config, networkOverrides);
 
   // Merge with user node overrides (if nodeName is provided)
-  if (nodeName) {
-    if (!nodeOverrides) {
-      if (nodesOverrides_.isObject()) {
-        auto iter = nodesOverrides_.find(*nodeName);
-        if (iter != nodesOverrides_.items().end()) {
-          JsonUtils::dynamicObjectMerge(config, iter->second);
-        }
-      }
-    } else {
-      if (nodeOverrides->isObject()) {
-        auto iter = nodeOverrides->find(*nodeName);
-        if (iter != nodeOverrides->items().end()) {
-          JsonUtils::dynamicObjectMerge(config, iter->second);
-        }
-      }
+  if (nodeName && nodesOverrides.isObject()) {
+    auto iter = nodesOverrides.find(*nodeName);
+    if (iter != nodesOverrides.items().end()) {
+      JsonUtils::dynamicObjectMerge(config, iter->second);
     }
   }
   return config;
@@ -919,6 +972,7 @@ ConfigHelper::setNewPerNodeOverrides(
     LOG(ERROR) << errorMsg << ": " << folly::exceptionStr(ex);
     return false;
   }
+  invalidateOverrideLayers();
   configState_.clear();
   return true;
 }
@@ -1060,6 +1114,7 @@ ConfigHelper::setNewNetworkOverrides(
     LOG(ERROR) << errorMsg << ": " << folly::exceptionStr(ex);
     return false;
   }
+  invalidateOverrideLayers();
   configState_.clear();
   return true;
 }
@@ -1270,40 +1325,131 @@ ConfigHelper::loadConfigFile(
   return cfg;
 }
 
-std::optional<ConfigHelper::NodeConfigState>
-ConfigHelper::initConfigState(
+ConfigHelper::NodeConfigRender
+ConfigHelper::prepareNodeConfigRender(
     const std::string& nodeName,
     const std::string& swVersion,
     const std::string& fwVersion,
-    const std::string& hwBoardId) {
-  auto& nodeState = configState_[nodeName];
-  try {
-    auto nodeConfig = buildNodeConfig(
-        nodeName,
-        swVersion,
-        fwVersion,
-        hwBoardId,
-        std::make_optional(autoNodesOverrides_),
-        std::make_optional(networkOverrides_),
-        std::make_optional(nodesOverrides_));
+    const std::string& hwBoardId,
+    std::shared_ptr<const OverrideLayers> overrideLayers) {
+  NodeConfigRender render;
+  render.nodeName = nodeName;
+  render.swVersion = swVersion;
+  render.fwVersion = fwVersion;
+  render.hwBoardId = hwBoardId;
+  render.baseLayers = getBaseLayers(swVersion, fwVersion, hwBoardId);
+  render.overrideLayers =
+      overrideLayers ? std::move(overrideLayers) : getOverrideLayers();
+  render.layerGeneration = layerGeneration_;
+  render.computeMd5 = legacyConfigMd5Enabled_;
+  return render;
+}
+
+void
+ConfigHelper::setLegacyConfigMd5Enabled(bool enabled) {
+  legacyConfigMd5Enabled_ = enabled;
+}
+
+void
+ConfigHelper::renderNodeConfigs(
+    std::vector<NodeConfigRender>& renders,
+    folly::CPUThreadPoolExecutor* executor) {
+  auto renderOne = [](NodeConfigRender& render) {
+    try {
+      folly::dynamic overrides = mergeConfigOverrides(
+          render.nodeName,
+          render.overrideLayers->autoNodesOverrides,
+          render.overrideLayers->networkOverrides,
+          render.overrideLayers->nodesOverrides);
+      render.configObj = render.baseLayers->config;
+      JsonUtils::dynamicObjectMerge(render.configObj, overrides);
+
+      // Reuse the hashes of base layer members not touched by any override
+      auto memberDigests = render.baseLayers->memberDigests;
+      for (const auto& key : overrides.keys()) {
+        memberDigests.erase(key.asString());
+      }
+      render.hash = StructuralHash::toHex(
+          StructuralHash::hashObject(render.configObj, memberDigests));
+
+      if (render.computeMd5) {
+        render.configJson = JsonUtils::toSortedPrettyJson(render.configObj);
+        render.md5 = Md5Utils::computeMd5(render.configJson);
+      }
+      render.isManaged = isManaged(render.configObj);
+      render.rendered = true;
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Could not parse node config for " << render.nodeName
+                 << ": " << folly::exceptionStr(ex);
+      render.rendered = false;
+    }
+  };
+
+  size_t numTasks =
+      executor ? std::min<size_t>(executor->numThreads(), renders.size()) : 0;
+  if (numTasks <= 1) {
+    for (auto& render : renders) {
+      renderOne(render);
+    }
+    return;
+  }
+
+  // Each task claims the next unrendered node until none are left
+  std::atomic<size_t> nextIndex{0};
+  std::vector<folly::Future<folly::Unit>> tasks;
+  for (size_t i = 0; i < numTasks; i++) {
+    tasks.push_back(
+        folly::via(executor, [&renders, &nextIndex, &renderOne]() {
+          for (size_t j = nextIndex++; j < renders.size(); j = nextIndex++) {
+            renderOne(renders[j]);
+          }
+        }));
+  }
+  folly::collectAll(tasks.begin(), tasks.end()).wait();
+}
+
+std::unordered_set<std::string>
+ConfigHelper::setConfigStates(const std::vector<NodeConfigRender>& renders) {
+  std::unordered_set<std::string> nodeNames;
+  for (const auto& render : renders) {
+    if (render.layerGeneration != layerGeneration_) {
+      VLOG(3) << "Discarding stale config render for " << render.nodeName;
+      continue;
+    }
+    if (!render.rendered) {
+      configState_.erase(render.nodeName);
+      continue;
+    }
 
-    nodeState.swVersion = swVersion;
-    nodeState.fwVersion = fwVersion;
-    nodeState.hwBoardId = hwBoardId;
-    nodeState.configObj = nodeConfig;
-    nodeState.configJson = JsonUtils::toSortedPrettyJson(nodeConfig);
-    nodeState.isManaged = isManaged(nodeConfig);
-    nodeState.md5 = Md5Utils::computeMd5(nodeState.configJson);
+    auto& nodeState = configState_[render.nodeName];
+    nodeState.swVersion = render.swVersion;
+    nodeState.fwVersion = render.fwVersion;
+    nodeState.hwBoardId = render.hwBoardId;
+    nodeState.configObj = render.configObj;
+    nodeState.isManaged = render.isManaged;
+    nodeState.md5 = render.md5;
+    nodeState.hash = render.hash;
 
     // Check if this hardware type and version are recognized
-    nodeState.isUnknownHardware = isUnknownHardware(hwBoardId, swVersion);
-  } catch (const std::invalid_argument& ex) {
-    LOG(ERROR) << "Could not parse node config for " << nodeName << ": "
-               << folly::exceptionStr(ex);
-    configState_.erase(nodeName);
-    return std::nullopt;
+    nodeState.isUnknownHardware =
+        isUnknownHardware(render.hwBoardId, render.swVersion);
+    nodeNames.insert(render.nodeName);
   }
-  return nodeState;
+  return nodeNames;
+}
+
+std::optional<ConfigHelper::NodeConfigState>
+ConfigHelper::initConfigState(
+    const std::string& nodeName,
+    const std::string& swVersion,
+    const std::string& fwVersion,
+    const std::string& hwBoardId) {
+  std::vector<NodeConfigRender> renders;
+  renders.push_back(
+      prepareNodeConfigRender(nodeName, swVersion, fwVersion, hwBoardId));
+  renderNodeConfigs(renders, nullptr);
+  setConfigStates(renders);
+  return getConfigState(nodeName);
 }
 
 bool
@@ -1375,8 +1521,36 @@ ConfigHelper::setNodeBaseConfigRequestedTime(
   }
 }
 
+void
+ConfigHelper::setNodeConfigSynced(const std::string& nodeName) {
+  auto it = configState_.find(nodeName);
+  if (it == configState_.end()) {
+    return;
+  }
+  auto& syncedConfig = syncedConfigs_[nodeName];
+  if (syncedConfig.hash != it->second.hash) {
+    syncedConfig.configObj =
+        std::make_shared<const folly::dynamic>(it->second.configObj);
+    syncedConfig.hash = it->second.hash;
+  }
+}
+
+void
+ConfigHelper::clearNodeConfigSynced(const std::string& nodeName) {
+  syncedConfigs_.erase(nodeName);
+}
+
+std::optional<ConfigHelper::SyncedConfig>
+ConfigHelper::getNodeConfigSynced(const std::string& nodeName) const {
+  auto it = syncedConfigs_.find(nodeName);
+  if (it == syncedConfigs_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
 bool
-ConfigHelper::isManaged(const folly::dynamic& config) const {
+ConfigHelper::isManaged(const folly::dynamic& config) {
   if (config.isObject()) {
     auto sysParamsIter = config.find("sysParams");
     if (sysParamsIter != config.items().end() &&
@@ -1393,6 +1567,9 @@ ConfigHelper::isManaged(const folly::dynamic& config) const {
 bool
 ConfigHelper::migrateNodeOverrides(
     const std::string& oldNodeName, const std::string& newNodeName) {
+  // The renamed node's config changes, so send it in full next time
+  syncedConfigs_.erase(oldNodeName);
+
   // Migrate user node overrides
   auto success = migratePerNodeOverrides(
       oldNodeName, newNodeName, nodesOverrides_, nodeConfigOverridesFile_);
@@ -1446,6 +1623,7 @@ ConfigHelper::migratePerNodeOverrides(
 
   nodeOverrides = fullNodeOverrides;
   LOG(INFO) << "Migrated config from " << oldNodeName << " to " << newNodeName;
+  invalidateOverrideLayers();
   configState_.erase(oldNodeName);
   return true;
 }
@@ -2268,6 +2446,7 @@ ConfigHelper::updateAutoLinkTopologyConfigMacforNode(
 bool
 ConfigHelper::deleteAllNodeOverrides(
     const std::string& nodeName, std::string& errorMsg) {
+  syncedConfigs_.erase(nodeName);
   folly::dynamic newAutoNodesOverrides = autoNodesOverrides_;
   newAutoNodesOverrides.erase(nodeName);
   folly::dynamic newNodesOverrides = nodesOverrides_;
@@ -3070,6 +3249,7 @@ ConfigHelper::addBaseConfig(
 
   LOG(INFO) << "Adding new base config for version='" << ver << "'";
   baseConfigObjects_[ver] = obj;
+  invalidateBaseLayers();
   return true;
 }
 
@@ -3103,6 +3283,7 @@ ConfigHelper::addHardwareBaseConfig(
   LOG(INFO) << "Adding new hardware base config for type='" << hwType
             << "', version='" << ver << "'";
   hwConfigObjects_[hwType][ver] = obj;
+  invalidateBaseLayers();
   return true;
 }
 
@@ -3120,6 +3301,7 @@ ConfigHelper::addHardwareTypeMapping(
   LOG(INFO) << "Adding new hardware type mapping from type='" << hwType
             << "' to hwBoardId='" << hwBoardId << "'";
   hardwareConfigTypeMap_[hwBoardId] = hwType;
+  invalidateBaseLayers();
   return true;
 }
 
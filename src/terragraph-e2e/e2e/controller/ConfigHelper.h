@@ -8,13 +8,16 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 
 #include <folly/dynamic.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 
 #include "e2e/common/ConfigMetadata.h"
 #include "e2e/common/ConfigUtil.h"
 #include "e2e/common/Consts.h"
 #include "e2e/common/EventClient.h"
+#include "e2e/common/StructuralHash.h"
 #include "e2e/if/gen-cpp2/NodeConfig_types.h"
 #include "topology/TopologyWrapper.h"
 
@@ -42,8 +45,14 @@ class ConfigHelper {
   struct NodeConfigState {
     /** Whether this node's config is managed. */
     bool isManaged;
-    /** The MD5 hash of this node's config. */
+    /**
+     * The legacy MD5 hash of this node's config (as sorted and pretty-printed
+     * JSON), or empty if disabled.
+     * @see setLegacyConfigMd5Enabled()
+     */
     std::string md5;
+    /** The structural hash of this node's config (see StructuralHash). */
+    std::string hash;
     /** This node's software version. */
     std::string swVersion;
     /** This node's firmware version. */
@@ -55,8 +64,6 @@ class ConfigHelper {
      * @see buildNodeConfig()
      */
     folly::dynamic configObj;
-    /** This node's computed config, as a formatted JSON string. */
-    std::string configJson;
     /** The latest node status report timestamp. */
     std::int64_t statusTime;
     /** The latest time that new node config was set. */
@@ -67,6 +74,86 @@ class ConfigHelper {
     std::int64_t baseConfigRequestedTime;
   };
 
+  /**
+   * The last config that a node reported running, used as the base for config
+   * patches.
+   *
+   * This is kept apart from NodeConfigState, which is discarded whenever any
+   * config layer changes (i.e. exactly when a patch is needed).
+   *
+   * @see setNodeConfigSynced()
+   */
+  struct SyncedConfig {
+    /** The config. */
+    std::shared_ptr<const folly::dynamic> configObj;
+    /** The structural hash of 'configObj'. */
+    std::string hash;
+  };
+
+  /**
+   * An immutable copy of the node config override layers.
+   *
+   * @see getOverrideLayers()
+   */
+  struct OverrideLayers {
+    /** Automatic config overrides per node. */
+    folly::dynamic autoNodesOverrides = folly::dynamic::object;
+    /** Network config overrides. */
+    folly::dynamic networkOverrides = folly::dynamic::object;
+    /** User config overrides per node. */
+    folly::dynamic nodesOverrides = folly::dynamic::object;
+  };
+
+  /** Merged base config layers. */
+  struct BaseLayers {
+    /** The merged base, firmware base, and hardware base config layers. */
+    folly::dynamic config = folly::dynamic::object;
+    /** The structural hashes of the object and array members of 'config'. */
+    StructuralHash::MemberDigests memberDigests;
+  };
+
+  /**
+   * A node config to be rendered outside of the ConfigHelper lock.
+   *
+   * This is created by prepareNodeConfigRender() (with the lock held), filled
+   * in by renderNodeConfigs() (without the lock), and finally applied to the
+   * node's config state by setConfigStates() (with the lock held).
+   */
+  struct NodeConfigRender {
+    /** The node name. */
+    std::string nodeName;
+    /** The node's software version. */
+    std::string swVersion;
+    /** The node's firmware version. */
+    std::string fwVersion;
+    /** The node's hardware board ID. */
+    std::string hwBoardId;
+    /** The merged base config layers. */
+    std::shared_ptr<const BaseLayers> baseLayers;
+    /** The override layers to merge on top of 'baseLayers'. */
+    std::shared_ptr<const OverrideLayers> overrideLayers;
+    /** The config layer generation when this render was prepared. */
+    uint64_t layerGeneration{0};
+    /** Whether to serialize the config and compute the legacy MD5 hash. */
+    bool computeMd5{true};
+
+    /** Whether rendering succeeded. */
+    bool rendered{false};
+    /** The rendered config. */
+    folly::dynamic configObj = folly::dynamic::object;
+    /**
+     * The rendered config, as a formatted JSON string (only if 'computeMd5' is
+     * set).
+     */
+    std::string configJson;
+    /** The MD5 hash of 'configJson' (only if 'computeMd5' is set). */
+    std::string md5;
+    /** The structural hash of 'configObj'. */
+    std::string hash;
+    /** Whether the rendered config is managed. */
+    bool isManaged{false};
+  };
+
   /**
    * Per-link topology parameters.
    *
@@ -343,6 +430,64 @@ class ConfigHelper {
   /** Get the config state for all nodes. */
   std::unordered_map<std::string, NodeConfigState> getAllConfigStates() const;
 
+  /**
+   * Get an immutable snapshot of the current override layers.
+   *
+   * The snapshot is copied once and then shared until any override layer
+   * changes, so this is cheap to call repeatedly.
+   */
+  std::shared_ptr<const OverrideLayers> getOverrideLayers();
+
+  /**
+   * Prepare to render a node's config outside of the ConfigHelper lock.
+   *
+   * The merged base layers are memoized per (software version, firmware
+   * version, hardware type), so this only does real work for the first node
+   * of each kind.
+   *
+   * @param overrideLayers the override layers to use, or the current override
+   *                       layers if null
+   */
+  NodeConfigRender prepareNodeConfigRender(
+      const std::string& nodeName,
+      const std::string& swVersion,
+      const std::string& fwVersion,
+      const std::string& hwBoardId,
+      std::shared_ptr<const OverrideLayers> overrideLayers = nullptr);
+
+  /**
+   * Set whether to compute the legacy MD5 hash of each node config, in
+   * addition to the structural hash.
+   *
+   * This requires serializing each node config to JSON, which is slow. It is
+   * only needed for nodes that do not report a structural config hash.
+   */
+  void setLegacyConfigMd5Enabled(bool enabled);
+
+  /**
+   * Render the given node configs (merge the override layers and hash) on the
+   * given executor's threads, blocking until all are done. If 'executor' is
+   * null, the configs are rendered on the calling thread.
+   *
+   * This does not touch any ConfigHelper state, and should be called without
+   * holding the ConfigHelper lock.
+   */
+  static void renderNodeConfigs(
+      std::vector<NodeConfigRender>& renders,
+      folly::CPUThreadPoolExecutor* executor);
+
+  /**
+   * Set the config state for each of the given rendered node configs.
+   *
+   * Renders that failed are removed from the config state (same as
+   * initConfigState()). Renders prepared before any config layer changed are
+   * stale and are ignored.
+   *
+   * Returns the names of nodes whose config state was set.
+   */
+  std::unordered_set<std::string> setConfigStates(
+      const std::vector<NodeConfigRender>& renders);
+
   /** Initialize the config state for a node. */
   std::optional<NodeConfigState> initConfigState(
       const std::string& nodeName,
@@ -375,8 +520,24 @@ class ConfigHelper {
   void setNodeBaseConfigRequestedTime(
       const std::string& nodeName, const std::int64_t baseConfigRequestedTime);
 
+  /**
+   * Record that a node reported running its current computed config, which
+   * then becomes the base for config patches sent to the node.
+   */
+  void setNodeConfigSynced(const std::string& nodeName);
+
+  /**
+   * Forget a node's synced config (e.g. if a config patch could not be
+   * applied), so that the next config is sent in full.
+   */
+  void clearNodeConfigSynced(const std::string& nodeName);
+
+  /** Returns the last config that a node reported running (if known). */
+  std::optional<SyncedConfig> getNodeConfigSynced(
+      const std::string& nodeName) const;
+
   /** Check if the node configuration is managed. */
-  bool isManaged(const folly::dynamic& config) const;
+  static bool isManaged(const folly::dynamic& config);
 
   /**
    * Get the node config metadata as a JSON string.
@@ -551,7 +712,10 @@ class ConfigHelper {
   bool deleteAutoLinkOverrides(
       const thrift::Link& link, std::string& errorMsg);
 
-  /** Delete the automatic and user node overrides for the given node. */
+  /**
+   * Delete the automatic and user node overrides (and the synced config) for
+   * the given node.
+   */
   bool deleteAllNodeOverrides(
       const std::string& nodeName, std::string& errorMsg);
 
@@ -896,6 +1060,32 @@ class ConfigHelper {
       const std::optional<folly::dynamic> networkOverrides,
       const std::optional<folly::dynamic> nodeOverrides) const;
 
+  /**
+   * Merge the given automatic, network, and user override layers for a node.
+   *
+   * If 'nodeName' is not provided, only 'networkOverrides' are returned.
+   */
+  static folly::dynamic mergeConfigOverrides(
+      const std::optional<std::string>& nodeName,
+      const folly::dynamic& autoNodesOverrides,
+      const folly::dynamic& networkOverrides,
+      const folly::dynamic& nodesOverrides);
+
+  /**
+   * Get the merged base, firmware base, and hardware base config layers for
+   * the given versions, from 'baseLayersCache_' if possible.
+   */
+  std::shared_ptr<const BaseLayers> getBaseLayers(
+      const std::string& swVersion,
+      const std::optional<std::string>& fwVersion,
+      const std::optional<std::string>& hwBoardId);
+
+  /** Drop memoized base layers (after any base config changes). */
+  void invalidateBaseLayers();
+
+  /** Drop the override layers snapshot (after any override layer changes). */
+  void invalidateOverrideLayers();
+
   /**
    * Set the node override for 'controlSuperframe' for a single node in a link.
    */
@@ -1018,6 +1208,9 @@ class ConfigHelper {
   /** Per-node config state. */
   std::unordered_map<std::string, NodeConfigState> configState_{};
 
+  /** Per-node synced config (survives config state invalidation). */
+  std::unordered_map<std::string, SyncedConfig> syncedConfigs_{};
+
   /**
    * Base config objects (swVer -> config).
    *
@@ -1053,6 +1246,22 @@ class ConfigHelper {
 
   /** Map of hardware board IDs to hardware config types. */
   std::unordered_map<std::string, std::string> hardwareConfigTypeMap_;
+
+  /**
+   * Memoized merged base layers, keyed by software version, firmware version,
+   * and hardware config type.
+   */
+  std::unordered_map<std::string, std::shared_ptr<const BaseLayers>>
+      baseLayersCache_;
+
+  /** Snapshot of the override layers (null if not yet taken). */
+  std::shared_ptr<const OverrideLayers> overrideLayers_;
+
+  /** Incremented whenever any base or override layer changes. */
+  uint64_t layerGeneration_{0};
+
+  /** Whether to compute the legacy MD5 hash of each node config. */
+  bool legacyConfigMd5Enabled_{true};
 };
 
 } // namespace terragraph
@@ -492,7 +492,8 @@ IgnitionApp::linkUpTimeoutExpired() {
     lockedTopologyW, rlock, lockedConfigHelper, rlock);
 
   // Find all ignition candidates that can be done in parallel
-  auto igCandidates = IgnitionAppUtil::findAllParallelIgnitionCandidates(
+  ignitionPlanner_.update(*lockedTopologyW);
+  auto igCandidates = ignitionPlanner_.findAllParallelIgnitionCandidates(
       *lockedTopologyW,
       linkToAttemptTs_,
       linkToInitialAttemptTs_,
@@ -552,9 +553,12 @@ IgnitionApp::linkUpTimeoutExpired() {
   lastIgCandidates_ = igCandidates;
 
   // Clean up various ignition records
-  cleanUpInitialLinkUpAttempts(*lockedTopologyW);
-  cleanUpCnLinkUpAttempts(*lockedTopologyW);
-  cleanUpRadioLinkUpRecords(*lockedTopologyW);
+  ignitionPlanner_.cleanUpInitialLinkUpAttempts(
+      *lockedTopologyW, linkToInitialAttemptTs_);
+  ignitionPlanner_.cleanUpCnLinkUpAttempts(
+      *lockedTopologyW, cnToPossibleIgnitionTs_);
+  ignitionPlanner_.cleanUpRadioLinkUpRecords(
+      *lockedTopologyW, radioToLinkUpTs_);
 
   // Remove nodes which are responders in this ignition attempt from
   // the list of nodes which should stop being responders
@@ -892,80 +896,5 @@ IgnitionApp::sendSetLinkStatus(
   }
 }
 
-void
-IgnitionApp::cleanUpInitialLinkUpAttempts(const TopologyWrapper& topologyW) {
-  for (auto it = linkToInitialAttemptTs_.begin();
-       it != linkToInitialAttemptTs_.end();) {
-    auto link = topologyW.getLink(it->first);
-    if (!link) {
-      it = linkToInitialAttemptTs_.erase(it);
-      continue;  // shouldn't happen
-    }
-
-    auto aNode = topologyW.getNode(link->a_node_name);
-    auto zNode = topologyW.getNode(link->z_node_name);
-    if (!aNode || !zNode ||
-        (aNode->status == thrift::NodeStatusType::OFFLINE &&
-         zNode->status == thrift::NodeStatusType::OFFLINE)) {
-      it = linkToInitialAttemptTs_.erase(it);
-      continue;
-    }
-
-    it++;
-  }
-}
-
-void
-IgnitionApp::cleanUpCnLinkUpAttempts(const TopologyWrapper& topologyW) {
-  for (auto it = cnToPossibleIgnitionTs_.begin();
-       it != cnToPossibleIgnitionTs_.end();) {
-    bool shouldErase = true;
-    for (const auto& link : topologyW.getLinksByNodeName(it->first)) {
-      if (link.link_type == thrift::LinkType::ETHERNET) {
-        continue;  // shouldn't happen, but would break this logic
-      }
-      if (link.is_alive) {
-        break;  // a link is alive, so erase the entry
-      }
-
-      auto nbrNode = topologyW.getNbrNode(it->first, link);
-      if (!nbrNode || nbrNode->node_type != thrift::NodeType::DN) {
-        break;  // shouldn't happen
-      }
-      if (nbrNode->status == thrift::NodeStatusType::ONLINE_INITIATOR) {
-        shouldErase = false;
-        break;  // a valid initiator still exists, so keep the entry
-      }
-    }
-
-    if (shouldErase) {
-      it = cnToPossibleIgnitionTs_.erase(it);
-    } else {
-      it++;
-    }
-  }
-}
-
-void
-IgnitionApp::cleanUpRadioLinkUpRecords(const TopologyWrapper& topologyW) {
-  for (auto it = radioToLinkUpTs_.begin(); it != radioToLinkUpTs_.end();) {
-    bool shouldErase = true;
-    for (const auto& link : topologyW.getLinksByRadioMac(it->first)) {
-      if (link.link_type == thrift::LinkType::ETHERNET) {
-        continue;  // shouldn't happen
-      }
-      if (link.is_alive) {
-        shouldErase = false;
-        break;  // a link is alive, so keep the entry
-      }
-    }
-    if (shouldErase) {
-      it = radioToLinkUpTs_.erase(it);
-    } else {
-      it++;
-    }
-  }
-}
-
 } // namespace terragraph
 } // namespace facebook
@@ -10,6 +10,7 @@
 #include <fbzmq/async/ZmqTimeout.h>
 
 #include "CtrlApp.h"
+#include "IgnitionPlanner.h"
 #include "topology/TopologyWrapper.h"
 #include "e2e/if/gen-cpp2/Controller_types.h"
 #include "e2e/if/gen-cpp2/PassThru_types.h"
@@ -127,23 +128,6 @@ class IgnitionApp final : public CtrlApp {
       const thrift::LinkStatusType& linkStatus,
       const std::string& source);
 
-  /**
-   * Remove entries from linkToInitialAttemptTs_ if both ends of a link went
-   * offline.
-   */
-  void cleanUpInitialLinkUpAttempts(const TopologyWrapper& topologyW);
-
-  /**
-   * Remove entries from cnToPossibleIgnitionTs_ if the other ends of all links
-   * to a CN went offline.
-   */
-  void cleanUpCnLinkUpAttempts(const TopologyWrapper& topologyW);
-
-  /**
-   * Remove entries from radioToLinkUpTs_ if all links to a radio went offline.
-   */
-  void cleanUpRadioLinkUpRecords(const TopologyWrapper& topologyW);
-
   /**
    * Ignition loop interval (for linkupTimeout_) at which all new ignition
    * attempts are made.
@@ -193,6 +177,9 @@ class IgnitionApp final : public CtrlApp {
    */
   bool ignoreDampenIntervalAfterResp_{false};
 
+  /** Incremental ignition candidate search. */
+  IgnitionPlanner ignitionPlanner_;
+
   /** The last ignition candidates. */
   std::vector<thrift::IgnitionCandidate> lastIgCandidates_{};
 
@@ -221,7 +208,8 @@ class IgnitionApp final : public CtrlApp {
   /**
    * Mapping from links to the OLDEST ignition attempt made.
    *
-   * This is cleared when a link comes up or in cleanUpInitialLinkUpAttempts().
+   * This is cleared when a link comes up or in
+   * IgnitionPlanner::cleanUpInitialLinkUpAttempts().
    */
   std::unordered_map<std::string, std::chrono::steady_clock::time_point>
       linkToInitialAttemptTs_;
@@ -230,7 +218,8 @@ class IgnitionApp final : public CtrlApp {
    * Mapping from CNs to the EARLIEST time an ignition attempt could have been
    * made (but was not necessarily made, e.g. with backup links).
    *
-   * This is cleared when a link comes up or in cleanUpCnLinkUpAttempts().
+   * This is cleared when a link comes up or in
+   * IgnitionPlanner::cleanUpCnLinkUpAttempts().
    */
   std::unordered_map<std::string, std::chrono::steady_clock::time_point>
       cnToPossibleIgnitionTs_;
@@ -239,7 +228,7 @@ class IgnitionApp final : public CtrlApp {
    * Mapping from radio MACs to the MOST RECENT received LINK_UP.
    *
    * This is cleared when LINK_DOWN is received on the same radio/link or in
-   * cleanUpRadioLinkUpRecords().
+   * IgnitionPlanner::cleanUpRadioLinkUpRecords().
    */
   std::unordered_map<
       std::string /* radio MAC */,
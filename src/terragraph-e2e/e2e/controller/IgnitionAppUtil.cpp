@@ -374,6 +374,31 @@ IgnitionAppUtil::findAllParallelIgnitionCandidates(
       p2mpAssocDelay,
       linkupIterationIndex,
       linkAutoIgniteOff);
+
+  return selectParallelIgnitionCandidates(
+      topologyW,
+      std::move(igCandidates),
+      linkToAttemptTs,
+      linkToInitialAttemptTs,
+      initiatorToAttemptTs,
+      dampenInterval,
+      extendedDampenInterval,
+      extendedDampenFailureInterval);
+}
+
+std::vector<thrift::IgnitionCandidate>
+IgnitionAppUtil::selectParallelIgnitionCandidates(
+    const TopologyWrapper& topologyW,
+    std::vector<thrift::IgnitionCandidate> igCandidates,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        linkToAttemptTs,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        linkToInitialAttemptTs,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        initiatorToAttemptTs,
+    std::chrono::seconds dampenInterval,
+    std::chrono::seconds extendedDampenInterval,
+    std::chrono::seconds extendedDampenFailureInterval) {
   if (igCandidates.empty()) {
     return {};
   }
@@ -76,6 +76,27 @@ class IgnitionAppUtil {
         std::unordered_map<std::string, size_t>& linkupIterationIndex,
         const std::unordered_set<std::string>& linkAutoIgniteOff = {});
 
+  /**
+   * Select the given ignition candidates that can be attempted in parallel
+   * this cycle, and record the attempts for the selected candidates.
+   *
+   * This is called as the second step in findAllParallelIgnitionCandidates(),
+   * and by IgnitionPlanner.
+   */
+  static std::vector<thrift::IgnitionCandidate>
+    selectParallelIgnitionCandidates(
+        const TopologyWrapper& topologyW,
+        std::vector<thrift::IgnitionCandidate> igCandidates,
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+            linkToAttemptTs,
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+            linkToInitialAttemptTs,
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+            initiatorToAttemptTs,
+        std::chrono::seconds dampenInterval,
+        std::chrono::seconds extendedDampenInterval,
+        std::chrono::seconds extendedDampenFailureInterval);
+
   /**
    * Determine which links may be subject to interference from one of the
    * ignition candidate initiator nodes during initial beamforming.
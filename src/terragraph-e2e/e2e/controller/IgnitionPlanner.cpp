@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "IgnitionPlanner.h"
+
+#include <algorithm>
+#include <folly/Random.h>
+#include <random>
+
+#include "IgnitionAppUtil.h"
+
+namespace facebook {
+namespace terragraph {
+
+void
+IgnitionPlanner::update(const TopologyWrapper& topologyW) {
+  if (version_ && *version_ == topologyW.getVersion()) {
+    return;
+  }
+
+  std::optional<std::unordered_set<std::string>> changedNodeNames;
+  if (version_) {
+    changedNodeNames = topologyW.getStatusChangesSince(*version_);
+  }
+  if (changedNodeNames) {
+    for (const auto& nodeName : *changedNodeNames) {
+      updateNode(topologyW, nodeName);
+    }
+    VLOG(4) << "Updated ignition frontier for " << changedNodeNames->size()
+            << " node(s)";
+  } else {
+    rebuild(topologyW);
+    VLOG(3) << "Rebuilt ignition frontier (" << frontier_.size()
+            << " initiator(s))";
+  }
+  version_ = topologyW.getVersion();
+}
+
+void
+IgnitionPlanner::rebuild(const TopologyWrapper& topologyW) {
+  nodeToLinkIds_.clear();
+  radioToLinkIds_.clear();
+  frontier_.clear();
+  activeCns_.clear();
+
+  const auto links = topologyW.getAllLinksView();
+  for (size_t linkId = 0; linkId < links.size(); linkId++) {
+    const auto& link = links[linkId];
+    nodeToLinkIds_[link.a_node_name].push_back(linkId);
+    nodeToLinkIds_[link.z_node_name].push_back(linkId);
+    if (!link.a_node_mac.empty()) {
+      radioToLinkIds_[link.a_node_mac].push_back(linkId);
+    }
+    if (!link.z_node_mac.empty()) {
+      radioToLinkIds_[link.z_node_mac].push_back(linkId);
+    }
+  }
+
+  for (const auto& node : topologyW.getAllNodesView()) {
+    updateNode(topologyW, node.name);
+  }
+}
+
+void
+IgnitionPlanner::updateNode(
+    const TopologyWrapper& topologyW, const std::string& nodeName) {
+  frontier_.erase(nodeName);
+  activeCns_.erase(nodeName);
+
+  const thrift::Node* node = topologyW.getNodePtr(nodeName);
+  if (!node) {
+    return;
+  }
+  const auto& linkIds = getLinkIdsByNodeName(nodeName);
+
+  if (node->node_type == thrift::NodeType::CN) {
+    for (auto linkId : linkIds) {
+      const auto& link = topologyW.getLinkById(linkId);
+      if (link.is_alive && link.link_type != thrift::LinkType::ETHERNET) {
+        activeCns_.insert(nodeName);
+        break;
+      }
+    }
+    return;
+  }
+  if (node->status != thrift::NodeStatusType::ONLINE_INITIATOR) {
+    return;  // ignore offline or non-time-synced nodes
+  }
+
+  FrontierNode frontierNode;
+  size_t numWirelessLinks = 0;
+  for (auto linkId : linkIds) {
+    const auto& link = topologyW.getLinkById(linkId);
+    if (link.link_type == thrift::LinkType::WIRELESS) {
+      numWirelessLinks++;
+    }
+    if (link.is_alive) {
+      continue;  // nothing to do
+    }
+    if (link.a_node_mac.empty() || link.z_node_mac.empty()) {
+      continue;  // skip links with empty MAC address
+    }
+    const thrift::Node* nbrNode = topologyW.getNbrNodePtr(nodeName, link);
+    if (!nbrNode) {
+      continue;  // shouldn't happen
+    }
+    auto nbrNodeId = topologyW.getNodeId(nbrNode->name);
+    frontierNode.links.push_back(FrontierLink{linkId, *nbrNodeId});
+  }
+  if (!frontierNode.links.empty()) {
+    frontierNode.isP2mp = numWirelessLinks > 1;
+    frontier_[nodeName] = std::move(frontierNode);
+  }
+}
+
+const std::vector<TopologyWrapper::LinkId>&
+IgnitionPlanner::getLinkIdsByNodeName(const std::string& nodeName) const {
+  static const std::vector<TopologyWrapper::LinkId> kNoLinkIds;
+  auto iter = nodeToLinkIds_.find(nodeName);
+  return iter == nodeToLinkIds_.end() ? kNoLinkIds : iter->second;
+}
+
+const std::vector<TopologyWrapper::LinkId>&
+IgnitionPlanner::getLinkIdsByRadioMac(const std::string& radioMac) const {
+  static const std::vector<TopologyWrapper::LinkId> kNoLinkIds;
+  auto iter = radioToLinkIds_.find(radioMac);
+  return iter == radioToLinkIds_.end() ? kNoLinkIds : iter->second;
+}
+
+std::vector<thrift::IgnitionCandidate>
+IgnitionPlanner::findAllIgnitionCandidates(
+    const TopologyWrapper& topologyW,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        cnToPossibleIgnitionTs,
+    const std::unordered_map<
+        std::string,
+        std::chrono::steady_clock::time_point>& initiatorToAttemptTs,
+    const std::unordered_map<
+        std::string,
+        std::pair<std::chrono::steady_clock::time_point, std::string>>&
+            radioToLinkUpTs,
+    std::chrono::seconds bfTimeout,
+    std::chrono::seconds backupCnLinkInterval,
+    std::chrono::seconds p2mpAssocDelay,
+    std::unordered_map<std::string, size_t>& linkupIterationIndex,
+    const std::unordered_set<std::string>& linkAutoIgniteOff) const {
+  auto now = std::chrono::steady_clock::now();
+
+  // Shuffle all initiators
+  // This addresses the edge case when igniting CNs via backup links
+  std::vector<const std::string*> nodeNames;
+  nodeNames.reserve(frontier_.size());
+  for (const auto& kv : frontier_) {
+    nodeNames.push_back(&kv.first);
+  }
+  std::default_random_engine rng(folly::Random::rand32());
+  std::shuffle(nodeNames.begin(), nodeNames.end(), rng);
+
+  // Returns true if the radio received LINK_UP too recently for a DIFFERENT
+  // link (only if P2MP assoc delay is required/configured)
+  auto isRadioDampened = [&](
+      const std::string& radioMac, const std::string& linkName) {
+    auto iter = radioToLinkUpTs.find(radioMac);
+    if (iter == radioToLinkUpTs.end()) {
+      return false;
+    }
+    auto delta = std::chrono::duration_cast<std::chrono::seconds>(
+        now - iter->second.first);
+    return delta < p2mpAssocDelay && iter->second.second != linkName;
+  };
+
+  // Find ignition candidates
+  std::vector<thrift::IgnitionCandidate> igCandidates;
+  for (const std::string* nodeName : nodeNames) {
+    const FrontierNode& frontierNode = frontier_.at(*nodeName);
+
+    // Special handling for P2MP node that has tried to ignite other links
+    auto initiatorAttemptTime = initiatorToAttemptTs.find(*nodeName);
+    if (frontierNode.isP2mp &&
+        initiatorAttemptTime != initiatorToAttemptTs.end()) {
+      auto elapsedSec = std::chrono::duration_cast<std::chrono::seconds>(
+          now - initiatorAttemptTime->second);
+      if (elapsedSec < bfTimeout) {
+        continue; // This node has been used as an initator for another link too
+                  // recently
+      }
+    }
+
+    const auto& links = frontierNode.links;
+    size_t& startIndex = linkupIterationIndex[*nodeName];
+    for (size_t i = 0; i < links.size(); i++) {
+      const auto& frontierLink = links[(i + startIndex) % links.size()];
+      const auto& link = topologyW.getLinkById(frontierLink.linkId);
+      if (linkAutoIgniteOff.count(link.name)) {
+        continue;
+      }
+      if (p2mpAssocDelay.count() > 0 &&
+          (isRadioDampened(link.a_node_mac, link.name) ||
+           isRadioDampened(link.z_node_mac, link.name))) {
+        continue;
+      }
+
+      const auto& nbrNode = topologyW.getNodeById(frontierLink.nbrNodeId);
+      if (nbrNode.node_type == thrift::NodeType::CN) {
+        // Special handling for DN-to-CN links
+        if (activeCns_.count(nbrNode.name)) {
+          continue;  // this CN already has an active link
+        }
+
+        // At this point, ignition is possible
+        cnToPossibleIgnitionTs.insert(std::make_pair(nbrNode.name, now));
+
+        // Determine whether we can use backup links based on elapsed time
+        if (link.is_backup_cn_link_ref().value_or(false)) {
+          auto elapsedSec = std::chrono::duration_cast<std::chrono::seconds>(
+              now - cnToPossibleIgnitionTs.at(nbrNode.name));
+          if (elapsedSec < backupCnLinkInterval) {
+            continue;  // wait until the primary link has been down longer
+          }
+        }
+      }
+
+      // Ignite this link (initiator is valid and link is currently dead)
+      thrift::IgnitionCandidate ignitionCandidate;
+      ignitionCandidate.initiatorNodeName = *nodeName;
+      ignitionCandidate.linkName = link.name;
+      igCandidates.push_back(ignitionCandidate);
+    }
+    startIndex++;
+  }
+
+  return igCandidates;
+}
+
+std::vector<thrift::IgnitionCandidate>
+IgnitionPlanner::findAllParallelIgnitionCandidates(
+    const TopologyWrapper& topologyW,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        linkToAttemptTs,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        linkToInitialAttemptTs,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        cnToPossibleIgnitionTs,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        initiatorToAttemptTs,
+    const std::unordered_map<
+        std::string,
+        std::pair<std::chrono::steady_clock::time_point, std::string>>&
+            radioToLinkUpTs,
+    std::chrono::seconds bfTimeout,
+    std::chrono::seconds dampenInterval,
+    std::chrono::seconds extendedDampenInterval,
+    std::chrono::seconds extendedDampenFailureInterval,
+    std::chrono::seconds backupCnLinkInterval,
+    std::chrono::seconds p2mpAssocDelay,
+    std::unordered_map<std::string, size_t>& linkupIterationIndex,
+    const std::unordered_set<std::string>& linkAutoIgniteOff) const {
+  auto igCandidates = findAllIgnitionCandidates(
+      topologyW,
+      cnToPossibleIgnitionTs,
+      initiatorToAttemptTs,
+      radioToLinkUpTs,
+      bfTimeout,
+      backupCnLinkInterval,
+      p2mpAssocDelay,
+      linkupIterationIndex,
+      linkAutoIgniteOff);
+
+  return IgnitionAppUtil::selectParallelIgnitionCandidates(
+      topologyW,
+      std::move(igCandidates),
+      linkToAttemptTs,
+      linkToInitialAttemptTs,
+      initiatorToAttemptTs,
+      dampenInterval,
+      extendedDampenInterval,
+      extendedDampenFailureInterval);
+}
+
+void
+IgnitionPlanner::cleanUpInitialLinkUpAttempts(
+    const TopologyWrapper& topologyW,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        linkToInitialAttemptTs) const {
+  for (auto it = linkToInitialAttemptTs.begin();
+       it != linkToInitialAttemptTs.end();) {
+    auto link = topologyW.getLinkPtr(it->first);
+    if (!link) {
+      it = linkToInitialAttemptTs.erase(it);
+      continue;  // shouldn't happen
+    }
+
+    auto aNode = topologyW.getNodePtr(link->a_node_name);
+    auto zNode = topologyW.getNodePtr(link->z_node_name);
+    if (!aNode || !zNode ||
+        (aNode->status == thrift::NodeStatusType::OFFLINE &&
+         zNode->status == thrift::NodeStatusType::OFFLINE)) {
+      it = linkToInitialAttemptTs.erase(it);
+      continue;
+    }
+
+    it++;
+  }
+}
+
+void
+IgnitionPlanner::cleanUpCnLinkUpAttempts(
+    const TopologyWrapper& topologyW,
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+        cnToPossibleIgnitionTs) const {
+  for (auto it = cnToPossibleIgnitionTs.begin();
+       it != cnToPossibleIgnitionTs.end();) {
+    bool shouldErase = true;
+    for (auto linkId : getLinkIdsByNodeName(it->first)) {
+      const auto& link = topologyW.getLinkById(linkId);
+      if (link.link_type == thrift::LinkType::ETHERNET) {
+        continue;  // shouldn't happen, but would break this logic
+      }
+      if (link.is_alive) {
+        break;  // a link is alive, so erase the entry
+      }
+
+      auto nbrNode = topologyW.getNbrNodePtr(it->first, link);
+      if (!nbrNode || nbrNode->node_type != thrift::NodeType::DN) {
+        break;  // shouldn't happen
+      }
+      if (nbrNode->status == thrift::NodeStatusType::ONLINE_INITIATOR) {
+        shouldErase = false;
+        break;  // a valid initiator still exists, so keep the entry
+      }
+    }
+
+    if (shouldErase) {
+      it = cnToPossibleIgnitionTs.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void
+IgnitionPlanner::cleanUpRadioLinkUpRecords(
+    const TopologyWrapper& topologyW,
+    std::unordered_map<
+        std::string,
+        std::pair<std::chrono::steady_clock::time_point, std::string>>&
+            radioToLinkUpTs) const {
+  for (auto it = radioToLinkUpTs.begin(); it != radioToLinkUpTs.end();) {
+    bool shouldErase = true;
+    for (auto linkId : getLinkIdsByRadioMac(it->first)) {
+      const auto& link = topologyW.getLinkById(linkId);
+      if (link.link_type == thrift::LinkType::ETHERNET) {
+        continue;  // shouldn't happen
+      }
+      if (link.is_alive) {
+        shouldErase = false;
+        break;  // a link is alive, so keep the entry
+      }
+    }
+    if (shouldErase) {
+      it = radioToLinkUpTs.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "topology/TopologyWrapper.h"
+#include "e2e/if/gen-cpp2/Controller_types.h"
+
+namespace facebook {
+namespace terragraph {
+
+/**
+ * Incremental ignition candidate search for IgnitionApp.
+ *
+ * IgnitionAppUtil::findAllParallelIgnitionCandidates() scans every node and
+ * link in the topology on each ignition cycle, although in a mostly-ignited
+ * network almost nothing changes between cycles. This class instead maintains
+ * the ignition "frontier" (dead links of online initiator DNs), and on each
+ * cycle only re-examines nodes whose status or link status changed since the
+ * previous cycle (see TopologyWrapper::getStatusChangesSince()). The frontier
+ * is rebuilt from scratch after any structural topology change.
+ *
+ * This also indexes links by node name and radio MAC, which the ignition
+ * record clean-up methods use instead of scanning all links.
+ *
+ * update() must be called before the other methods, while holding the same
+ * topology lock.
+ */
+class IgnitionPlanner {
+ public:
+  /** Bring the frontier up to date with the given topology. */
+  void update(const TopologyWrapper& topologyW);
+
+  /**
+   * Find all possible ignition candidates on the frontier.
+   *
+   * This returns the same candidates as
+   * IgnitionAppUtil::findAllIgnitionCandidates(), though the round-robin
+   * order within each initiator only includes dead links.
+   */
+  std::vector<thrift::IgnitionCandidate> findAllIgnitionCandidates(
+      const TopologyWrapper& topologyW,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          cnToPossibleIgnitionTs,
+      const std::unordered_map<
+          std::string,
+          std::chrono::steady_clock::time_point>& initiatorToAttemptTs,
+      const std::unordered_map<
+          std::string,
+          std::pair<std::chrono::steady_clock::time_point, std::string>>&
+              radioToLinkUpTs,
+      std::chrono::seconds bfTimeout,
+      std::chrono::seconds backupCnLinkInterval,
+      std::chrono::seconds p2mpAssocDelay,
+      std::unordered_map<std::string, size_t>& linkupIterationIndex,
+      const std::unordered_set<std::string>& linkAutoIgniteOff = {}) const;
+
+  /**
+   * Identify all ignition candidates for this cycle that can be attempted in
+   * parallel.
+   *
+   * @see IgnitionAppUtil::findAllParallelIgnitionCandidates()
+   */
+  std::vector<thrift::IgnitionCandidate> findAllParallelIgnitionCandidates(
+      const TopologyWrapper& topologyW,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          linkToAttemptTs,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          linkToInitialAttemptTs,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          cnToPossibleIgnitionTs,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          initiatorToAttemptTs,
+      const std::unordered_map<
+          std::string,
+          std::pair<std::chrono::steady_clock::time_point, std::string>>&
+              radioToLinkUpTs,
+      std::chrono::seconds bfTimeout,
+      std::chrono::seconds dampenInterval,
+      std::chrono::seconds extendedDampenInterval,
+      std::chrono::seconds extendedDampenFailureInterval,
+      std::chrono::seconds backupCnLinkInterval,
+      std::chrono::seconds p2mpAssocDelay,
+      std::unordered_map<std::string, size_t>& linkupIterationIndex,
+      const std::unordered_set<std::string>& linkAutoIgniteOff = {}) const;
+
+  /**
+   * Remove entries from 'linkToInitialAttemptTs' if both ends of a link went
+   * offline.
+   */
+  void cleanUpInitialLinkUpAttempts(
+      const TopologyWrapper& topologyW,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          linkToInitialAttemptTs) const;
+
+  /**
+   * Remove entries from 'cnToPossibleIgnitionTs' if the other ends of all
+   * links to a CN went offline.
+   */
+  void cleanUpCnLinkUpAttempts(
+      const TopologyWrapper& topologyW,
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>&
+          cnToPossibleIgnitionTs) const;
+
+  /**
+   * Remove entries from 'radioToLinkUpTs' if all links to a radio went
+   * offline.
+   */
+  void cleanUpRadioLinkUpRecords(
+      const TopologyWrapper& topologyW,
+      std::unordered_map<
+          std::string,
+          std::pair<std::chrono::steady_clock::time_point, std::string>>&
+              radioToLinkUpTs) const;
+
+  /** Returns the number of initiator nodes on the frontier. */
+  size_t
+  getFrontierSize() const {
+    return frontier_.size();
+  }
+
+ private:
+  /** A dead link on the frontier. */
+  struct FrontierLink {
+    /** The link. */
+    TopologyWrapper::LinkId linkId;
+    /** The node on the other end of the link. */
+    TopologyWrapper::NodeId nbrNodeId;
+  };
+
+  /** An online initiator DN with dead links. */
+  struct FrontierNode {
+    /** The dead links (with both MACs set). */
+    std::vector<FrontierLink> links;
+    /** Whether the node has more than one wireless link. */
+    bool isP2mp{false};
+  };
+
+  /** Rebuild the link indexes and frontier from scratch. */
+  void rebuild(const TopologyWrapper& topologyW);
+
+  /** Recompute the frontier entry and CN state for the given node. */
+  void updateNode(const TopologyWrapper& topologyW, const std::string& nodeName);
+
+  /** Returns the IDs of all links to or from the given node. */
+  const std::vector<TopologyWrapper::LinkId>& getLinkIdsByNodeName(
+      const std::string& nodeName) const;
+
+  /** Returns the IDs of all links to or from the given radio MAC. */
+  const std::vector<TopologyWrapper::LinkId>& getLinkIdsByRadioMac(
+      const std::string& radioMac) const;
+
+  /** The topology version at the last update(), if any. */
+  std::optional<uint64_t> version_;
+
+  /** Link IDs by node name, in topology order. */
+  std::unordered_map<std::string, std::vector<TopologyWrapper::LinkId>>
+      nodeToLinkIds_;
+
+  /** Link IDs by radio MAC, in topology order. */
+  std::unordered_map<std::string, std::vector<TopologyWrapper::LinkId>>
+      radioToLinkIds_;
+
+  /** The ignition frontier, keyed by initiator node name. */
+  std::unordered_map<std::string, FrontierNode> frontier_;
+
+  /** CNs with any active (non-ETHERNET) links. */
+  std::unordered_set<std::string> activeCns_;
+};
+
+} // namespace terragraph
+} // namespace facebook
@@ -7,6 +7,7 @@
 
 #include "StatusApp.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
@@ -14,6 +15,8 @@
 #include <folly/MapUtil.h>
 #include <folly/Random.h>
 #include <folly/String.h>
+#include <folly/hash/Hash.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "SharedObjects.h"
 #include "e2e/common/Consts.h"
@@ -47,10 +50,92 @@ DEFINE_bool(
     "If a topology node has empty 'mac_addr' and non-empty 'wlan_mac_addrs', "
     "allow minion connections with a matching radio MAC.");
 
+DEFINE_int32(
+    status_stream_interval_s,
+    5,
+    "Interval at which to publish status report changes to the API event "
+    "stream, in seconds (0 to disable)");
+
 namespace {
 // Elapsed time allowed between receiving a status report ACK and
 // the next status report from a node.
 const std::chrono::seconds kStatusReportAllowedTime(30);
+
+// Maximum number of removed nodes to remember for incremental status dumps
+const size_t kMaxRemovedNodes{1024};
+
+// Hash a map value
+size_t
+hashValue(bool value) {
+  return std::hash<bool>()(value);
+}
+
+size_t
+hashValue(const std::string& value) {
+  return std::hash<std::string>()(value);
+}
+
+template <typename T>
+size_t
+hashValue(const T& value) {
+  return std::hash<std::string>()(
+      apache::thrift::CompactSerializer::serialize<std::string>(value));
+}
+
+// Hash the entries of an unordered map in key order, so that equal maps hash
+// equally regardless of their iteration (and thus serialization) order
+template <typename Map>
+size_t
+hashSortedMap(const Map& map) {
+  std::vector<const typename Map::value_type*> entries;
+  entries.reserve(map.size());
+  for (const auto& entry : map) {
+    entries.push_back(&entry);
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+    return a->first < b->first;
+  });
+  size_t hash = map.size();
+  for (const auto* entry : entries) {
+    hash = folly::hash::hash_combine(
+        hash, entry->first, hashValue(entry->second));
+  }
+  return hash;
+}
+
+// Hash an optional unordered map field in key order, then clear it
+template <typename Ref>
+size_t
+hashAndResetSortedMap(Ref ref) {
+  if (!ref.has_value()) {
+    return 0;
+  }
+  size_t hash = folly::hash::hash_combine(true, hashSortedMap(ref.value()));
+  ref.reset();
+  return hash;
+}
+
+// Hash the content of a status report, excluding timestamps
+size_t
+getStatusReportHash(thrift::StatusReport statusReport) {
+  statusReport.timeStamp = 0;
+  statusReport.lastAckGpsTimestamp = 0;
+  statusReport.sentGpsTimestamp = 0;
+
+  // Unordered maps serialize in iteration order, so hash them separately
+  size_t mapsHash = folly::hash::hash_combine(
+      hashSortedMap(statusReport.radioStatus),
+      hashAndResetSortedMap(statusReport.bgpStatus_ref()),
+      hashAndResetSortedMap(statusReport.neighborConnectionStatus_ref()),
+      hashAndResetSortedMap(statusReport.networkInterfaceMacs_ref()));
+  statusReport.radioStatus.clear();
+
+  return folly::hash::hash_combine(
+      std::hash<std::string>()(
+          apache::thrift::CompactSerializer::serialize<std::string>(
+              statusReport)),
+      mapsHash);
+}
 }
 
 namespace facebook {
@@ -77,6 +162,22 @@ StatusApp::StatusApp(
     version_ = folly::trimWhitespace(version_).str();
     LOG(INFO) << "Current Controller Version: " << version_;
   }
+
+  // Start status generations from the current time
+  statusGeneration_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  minDeltaGeneration_ = statusGeneration_;
+  streamedGeneration_ = statusGeneration_;
+
+  // Periodically publish status report changes to the API event stream
+  if (FLAGS_status_stream_interval_s > 0) {
+    statusStreamTimer_ = ZmqTimeout::make(this, [this]() noexcept {
+      publishStatusDelta();
+    });
+    statusStreamTimer_->scheduleTimeout(
+        std::chrono::seconds(FLAGS_status_stream_interval_s),
+        true /* isPeriodic */);
+  }
 }
 
 void
@@ -256,18 +357,19 @@ StatusApp::processStatusReport(
   // find all links for this node
   std::vector<std::string> wirelessNeighborMacs;
   std::vector<std::string> wiredNeighborMacs;
-  auto links = lockedTopologyW->getLinksByNodeName(node->name);
-  for (const auto& link : links) {
-    std::string nbrMac = (link.a_node_name == node->name)
-        ? link.z_node_mac : link.a_node_mac;
-    if (!nbrMac.empty()) {
-      if (link.link_type == thrift::LinkType::ETHERNET) {
-        wiredNeighborMacs.push_back(nbrMac);
-      } else {
-        wirelessNeighborMacs.push_back(nbrMac);
-      }
-    }
-  }
+  lockedTopologyW->forEachLinkByNodeName(
+      node->name, [&](const thrift::Link& link) {
+        const std::string& nbrMac = (link.a_node_name == node->name)
+            ? link.z_node_mac : link.a_node_mac;
+        if (!nbrMac.empty()) {
+          if (link.link_type == thrift::LinkType::ETHERNET) {
+            wiredNeighborMacs.push_back(nbrMac);
+          } else {
+            wirelessNeighborMacs.push_back(nbrMac);
+          }
+        }
+        return true;
+      });
 
   lockedTopologyW.unlock();  // lockedTopologyW -> NULL
 
@@ -324,12 +426,15 @@ StatusApp::processStatusReport(
         ipv6AddressChanged = true;
       }
       it->second.report = statusReport.value();
+      updateStatusGeneration(minion, it->second);
     } else if (statusReport->version.empty()) {
       // received a partial report from a new node: request the full report
       requestFullStatusReport = true;
     } else {
       // received a fully-formed report from a new node: store it
-      (*lockedStatusReports)[minion] = StatusReport(now, statusReport.value());
+      auto& status = (*lockedStatusReports)[minion] =
+          StatusReport(now, statusReport.value());
+      updateStatusGeneration(minion, status);
       ipv6AddressChanged = true;
     }
   }
@@ -502,27 +607,100 @@ void
 StatusApp::processGetStatusDump(
     const std::string& senderApp, const thrift::Message& message) {
   VLOG(5) << "Request for status dump from " << senderApp;
-  if (!maybeReadThrift<thrift::GetStatusDump>(message)) {
+  auto request = maybeReadThrift<thrift::GetStatusDump>(message);
+  if (!request) {
     handleInvalidMessage("GetStatusDump", senderApp);
     return;
   }
 
-  std::unordered_map<std::string, thrift::StatusReport> statusReports;
+  std::optional<int64_t> sinceGeneration;
+  if (request->sinceGeneration_ref().has_value()) {
+    sinceGeneration = request->sinceGeneration_ref().value();
+  }
+  sendToCtrlApp(
+      senderApp,
+      thrift::MessageType::STATUS_DUMP,
+      getStatusDump(sinceGeneration));
+}
+
+thrift::StatusDump
+StatusApp::getStatusDump(std::optional<int64_t> sinceGeneration) {
+  thrift::StatusDump statusDump;
+  statusDump.timeStamp = std::time(nullptr);
+  statusDump.version_ref() = version_;
+
+  // Copy only the changed reports (or all reports if we can't tell)
+  bool incremental = false;
   {
     auto lockedStatusReports = SharedObjects::getStatusReports()->rlock();
+    updateRemovedNodes(*lockedStatusReports);
+    incremental = sinceGeneration.has_value() &&
+                  sinceGeneration.value() >= minDeltaGeneration_ &&
+                  sinceGeneration.value() <= statusGeneration_;
     for (const auto& status : *lockedStatusReports) {
-      statusReports[status.first] = status.second.report;
+      if (!incremental || status.second.generation > sinceGeneration.value()) {
+        statusDump.statusReports[status.first] = status.second.report;
+      }
     }
   }
 
-  thrift::StatusDump statusDump;
-  statusDump.timeStamp = std::time(nullptr);
-  statusDump.statusReports = statusReports;
-  statusDump.version_ref() = version_;
-  sendToCtrlApp(
-      senderApp,
-      thrift::MessageType::STATUS_DUMP,
-      statusDump);
+  if (incremental) {
+    std::vector<std::string> removedNodes;
+    for (auto it = removedNodes_.upper_bound(sinceGeneration.value());
+         it != removedNodes_.end();
+         ++it) {
+      removedNodes.push_back(it->second);
+    }
+    statusDump.removedNodes_ref() = removedNodes;
+  }
+  statusDump.generation_ref() = statusGeneration_;
+  statusDump.incremental_ref() = incremental;
+  return statusDump;
+}
+
+void
+StatusApp::updateStatusGeneration(
+    const std::string& minion, StatusReport& status) {
+  size_t contentHash = getStatusReportHash(status.report);
+  if (status.generation == 0 || status.contentHash != contentHash) {
+    status.contentHash = contentHash;
+    status.generation = ++statusGeneration_;
+  }
+  reportedNodes_.insert(minion);
+}
+
+void
+StatusApp::updateRemovedNodes(
+    const std::unordered_map<std::string, StatusReport>& statusReports) {
+  // Status reports are removed elsewhere (e.g. by TopologyApp upon deleting a
+  // node), so compare against the nodes we have seen
+  for (auto it = reportedNodes_.begin(); it != reportedNodes_.end();) {
+    if (!statusReports.count(*it)) {
+      removedNodes_[++statusGeneration_] = *it;
+      it = reportedNodes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  while (removedNodes_.size() > kMaxRemovedNodes) {
+    minDeltaGeneration_ = removedNodes_.begin()->first;
+    removedNodes_.erase(removedNodes_.begin());
+  }
+}
+
+void
+StatusApp::publishStatusDelta() {
+  auto statusDump = getStatusDump(streamedGeneration_);
+  streamedGeneration_ = statusDump.generation_ref().value();
+  if (statusDump.statusReports.empty() &&
+      (!statusDump.removedNodes_ref().has_value() ||
+       statusDump.removedNodes_ref().value().empty())) {
+    return;  // nothing changed
+  }
+
+  VLOG(4) << "Publishing status changes for "
+          << statusDump.statusReports.size() << " node(s)";
+  sendToApiStream(thrift::MessageType::EVENT_STATUS_DELTA, statusDump);
 }
 
 std::optional<std::vector<thrift::Node>>
@@ -682,7 +860,7 @@ StatusApp::processGetCtrlNeighborsReq(
   // Send request to get neighbors to all nodes
   {
     auto lockedTopologyW = SharedObjects::getTopologyWrapper()->rlock();
-    for (const auto& node : lockedTopologyW->getAllNodes()) {
+    for (const auto& node : lockedTopologyW->getAllNodesView()) {
       if (!node.mac_addr.empty() &&
           node.status != thrift::NodeStatusType::OFFLINE) {
         thrift::GetMinionNeighborsReq getMinionNeighborsReq;
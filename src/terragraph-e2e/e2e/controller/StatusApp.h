@@ -12,6 +12,11 @@
 #include "CtrlApp.h"
 
 #include <deque>
+#include <map>
+#include <optional>
+#include <unordered_set>
+
+#include <fbzmq/async/ZmqTimeout.h>
 
 namespace facebook {
 namespace terragraph {
@@ -72,6 +77,15 @@ class StatusApp final : public CtrlApp {
      * was received (in monotonic seconds).
      */
     std::chrono::steady_clock::time_point lastFullReportTs;
+
+    /**
+     * The status generation at which the report content (excluding
+     * timestamps) last changed, or 0 if not yet recorded by StatusApp.
+     */
+    int64_t generation{0};
+
+    /** A hash of the report content (excluding timestamps). */
+    size_t contentHash{0};
   };
 
  private:
@@ -103,6 +117,28 @@ class StatusApp final : public CtrlApp {
   void processGetStatusDump(
       const std::string& senderApp, const thrift::Message& message);
 
+  /**
+   * Build a status dump. If 'sinceGeneration' is set (and recent enough), only
+   * include status reports that changed after that generation, along with
+   * removed nodes.
+   */
+  thrift::StatusDump getStatusDump(std::optional<int64_t> sinceGeneration);
+
+  /**
+   * Assign a new status generation to a status report if its content changed.
+   */
+  void updateStatusGeneration(const std::string& minion, StatusReport& status);
+
+  /**
+   * Record removed nodes (i.e. nodes with status generations that no longer
+   * have a status report).
+   */
+  void updateRemovedNodes(
+      const std::unordered_map<std::string, StatusReport>& statusReports);
+
+  /** Publish status report changes to the API event stream. */
+  void publishStatusDelta();
+
   /** Process a node reboot request. */
   void processRebootRequest(
       const std::string& senderApp,
@@ -161,6 +197,32 @@ class StatusApp final : public CtrlApp {
 
   /** Queue of the latest GPS timestamps received from nodes. */
   std::deque<int64_t> latestGpsTimestamps_{};
+
+  /**
+   * The latest status generation, incremented on every status report change.
+   *
+   * This is initialized from the system clock (in microseconds), so that
+   * generations from a previous controller run are always too old.
+   */
+  int64_t statusGeneration_{0};
+
+  /**
+   * The oldest status generation from which changes can be computed (i.e. no
+   * removed nodes after it have been forgotten).
+   */
+  int64_t minDeltaGeneration_{0};
+
+  /** The nodes with a recorded status generation. */
+  std::unordered_set<std::string> reportedNodes_;
+
+  /** The most recently removed nodes, keyed by status generation. */
+  std::map<int64_t, std::string> removedNodes_;
+
+  /** The status generation last published to the API event stream. */
+  int64_t streamedGeneration_{0};
+
+  /** Timer to publish status report changes to the API event stream. */
+  std::unique_ptr<fbzmq::ZmqTimeout> statusStreamTimer_{nullptr};
 };
 
 } // namespace terragraph
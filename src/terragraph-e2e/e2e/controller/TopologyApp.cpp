@@ -2269,7 +2269,6 @@ TopologyApp::processBstarAppData(
             << ", overwriting existing topology...";
   if (data->topology_ref().has_value()) {  // should always be true
     topologyW_->setTopology(data->topology_ref().value());
-    topologyW_->writeToTsFile();
 
     // Update globally-shared topology wrapper
     SharedObjects::getTopologyWrapper()->wlock()->setTopology(
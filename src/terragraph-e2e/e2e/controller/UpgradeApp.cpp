@@ -62,6 +62,12 @@ DEFINE_string(
     "",
     "The external IP of the controller that is announced to other BitTorrent "
     "clients for image upgrades");
+DEFINE_bool(
+    bt_hybrid_torrents,
+    false,
+    "Create hybrid BitTorrent v1/v2 torrents for upgrade images, so that nodes "
+    "verify downloaded pieces using SHA-256 instead of SHA-1 (requires "
+    "BitTorrent v2 support on all nodes)");
 DEFINE_bool(
     bt_high_performance_seed,
     true,
@@ -288,9 +294,10 @@ UpgradeApp::processImageFile(
     libtorrent::error_code errorCode;
     libtorrent::file_storage fileStorage;
     libtorrent::add_files(fileStorage, path);
-    // TODO support BitTorrent v2
     libtorrent::create_flags_t flags = {};
-    flags |= lt::create_torrent::v1_only;
+    if (!FLAGS_bt_hybrid_torrents) {
+      flags |= lt::create_torrent::v1_only;
+    }
     libtorrent::create_torrent torrent(fileStorage, 0 /* piece_size */, flags);
     torrent.add_tracker(btTrackerUrl_);
     if (!FLAGS_local_bt_tracker_override.empty()) {
@@ -729,7 +736,14 @@ UpgradeApp::processUpgradeAddImageReq(
       // Download image
       LOG(INFO) << "Start downloading " << addReq->imageUrl;
       std::string err;
-      if (!CurlUtil::download(addReq->imageUrl, savePath, err)) {
+      StreamingImageMd5 imageMd5(savePath);
+      if (!CurlUtil::download(
+              addReq->imageUrl,
+              savePath,
+              err,
+              [&imageMd5](const char* data, size_t size) {
+                imageMd5.update(data, size);
+              })) {
         LOG(ERROR) << err;
         this->sendE2EAck(senderApp, false, "Failed to download image");
         return;
@@ -737,10 +751,11 @@ UpgradeApp::processUpgradeAddImageReq(
       LOG(INFO) << "Successfully downloaded " << addReq->imageUrl << " to "
                 << savePath;
 
-      // Find the MD5 of the new image - excluding its header
+      // Find the MD5 of the new image - excluding its header (computed while
+      // downloading)
       std::string md5;
       try {
-        md5 = UpgradeUtils::getImageMd5(savePath);
+        md5 = imageMd5.finalize();
       } catch (std::exception& e) {
         LOG(ERROR) << folly::exceptionStr(e);
         std::remove(savePath.c_str());
@@ -9,7 +9,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <set>
 #include <folly/Random.h>
+#include <gflags/gflags.h>
 
 #include <e2e/if/gen-cpp2/Topology_types.h>
 
@@ -17,6 +20,13 @@
 #include "OccSolver.h"
 #include "PolarityHelper.h"
 
+DEFINE_int32(
+    interference_radius_m,
+    500,
+    "Only estimate interference between link groups with sites within this "
+    "distance of each other, in meters (or between all groups if not "
+    "positive)");
+
 namespace {
 // Parameter used to tune the color assignment algorithm for a new link,
 // default = 10
@@ -31,6 +41,11 @@ const int kMinInterferenceLevel{-80};
 const int kObserveLargeAngDiff{50};
 // Threshold narrow angle value between two links (in degrees)
 const int kObserveNarrowAngDiff{20};
+// Length of one degree of latitude, as used by approxDistance()
+const double kLengthPerDeg{40075017 / 360};
+
+// Grid cell of a location in the site index
+using GridCell = std::pair<int64_t, int64_t>;
 } // namespace
 
 namespace facebook {
@@ -42,69 +57,200 @@ InterferenceHelper::createGraphWithLinkAngles(
   std::unordered_map<std::string, std::vector<std::pair<std::string, double>>>
       graph;
 
-  std::vector<thrift::Link> links = topologyW.getAllLinks();
-  for (const auto& aLink : links) {
+  // Look up the sites and angle of every wireless link once
+  struct WirelessLink {
+    const thrift::Link* link;
+    std::string aSiteName;
+    std::string zSiteName;
+    double angle;
+  };
+  auto links = topologyW.getAllLinksView();
+  std::vector<WirelessLink> wirelessLinks;
+  std::unordered_map<std::string, std::vector<size_t>> site2Links;
+  for (const auto& link : links) {
     // Skip links that are not wireless
-    if (aLink.link_type != thrift::LinkType::WIRELESS) {
+    if (link.link_type != thrift::LinkType::WIRELESS) {
       continue;
     }
 
-    auto aLinkANode = topologyW.getNode(aLink.a_node_name);
-    auto aLinkZNode = topologyW.getNode(aLink.z_node_name);
-    std::string aLinkASiteName = aLinkANode->site_name;
-    std::string aLinkZSiteName = aLinkZNode->site_name;
-
-    auto l1 = topologyW.getSite(aLinkASiteName)->location;
-    auto l2 = topologyW.getSite(aLinkZSiteName)->location;
-    double aLinkAng = computeAngle(l1, l2);
+    auto aNode = topologyW.getNodePtr(link.a_node_name);
+    auto zNode = topologyW.getNodePtr(link.z_node_name);
+    if (!aNode || !zNode) {
+      continue;
+    }
+    auto aSite = topologyW.getSitePtr(aNode->site_name);
+    auto zSite = topologyW.getSitePtr(zNode->site_name);
+    if (!aSite || !zSite) {
+      continue;
+    }
 
-    for (const auto& bLink : links) {
-      // Skip links that are not wireless
-      if (bLink.link_type != thrift::LinkType::WIRELESS) {
-        continue;
-      }
+    size_t idx = wirelessLinks.size();
+    wirelessLinks.push_back(WirelessLink{
+        &link,
+        aSite->name,
+        zSite->name,
+        computeAngle(aSite->location, zSite->location)});
+    site2Links[aSite->name].push_back(idx);
+    if (zSite->name != aSite->name) {
+      site2Links[zSite->name].push_back(idx);
+    }
+  }
 
-      // Skip if same link
-      if (aLink.name == bLink.name) {
-        continue;
-      }
+  // Only links sharing a site are connected
+  std::vector<size_t> neighbors;
+  for (size_t i = 0; i < wirelessLinks.size(); i++) {
+    const WirelessLink& a = wirelessLinks[i];
+    neighbors = site2Links[a.aSiteName];
+    if (a.zSiteName != a.aSiteName) {
+      const auto& zSiteLinks = site2Links[a.zSiteName];
+      neighbors.insert(neighbors.end(), zSiteLinks.begin(), zSiteLinks.end());
+    }
+    // Keep the topology's link order
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(
+        std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
 
-      auto bLinkANode = topologyW.getNode(bLink.a_node_name);
-      auto bLinkZNode = topologyW.getNode(bLink.z_node_name);
-      std::string bLinkASiteName = bLinkANode->site_name;
-      std::string bLinkZSiteName = bLinkZNode->site_name;
+    for (size_t j : neighbors) {
+      const WirelessLink& b = wirelessLinks[j];
 
-      if (aLinkASiteName != bLinkASiteName &&
-          aLinkASiteName != bLinkZSiteName &&
-          aLinkZSiteName != bLinkASiteName &&
-          aLinkZSiteName != bLinkZSiteName) {
+      // Skip if same link
+      if (a.link->name == b.link->name) {
         continue;
       }
 
-      l1 = topologyW.getSite(bLinkASiteName)->location;
-      l2 = topologyW.getSite(bLinkZSiteName)->location;
-      double bLinkAng = computeAngle(l1, l2);
-
       bool flip = false;
-      if (aLinkASiteName == bLinkASiteName ||
-          aLinkZSiteName == bLinkZSiteName) {
+      if (a.aSiteName == b.aSiteName || a.zSiteName == b.zSiteName) {
         flip = false;
-      } else if (
-          aLinkZSiteName == bLinkASiteName ||
-          aLinkASiteName == bLinkZSiteName) {
+      } else if (a.zSiteName == b.aSiteName || a.aSiteName == b.zSiteName) {
         flip = true;
       }
 
-      double angleDiff =
-          computeUndirectedLinkAngleDiff(aLinkAng, bLinkAng, flip);
+      double angleDiff = computeUndirectedLinkAngleDiff(a.angle, b.angle, flip);
 
-      graph[aLink.name].push_back(std::make_pair(bLink.name, angleDiff));
+      graph[a.link->name].push_back(std::make_pair(b.link->name, angleDiff));
     }
   }
 
   return graph;
 }
 
+InterferenceHelper::LinkInfoMap
+InterferenceHelper::getLinkInfoMap(
+    const TopologyWrapper& topologyW,
+    const ConfigHelper& configHelper,
+    const LinkGroupHelper::GroupNameToLinkNames& group2Links) {
+  LinkInfoMap linkInfoMap;
+  for (const auto& groupIt : group2Links) {
+    for (const auto& linkName : groupIt.second) {
+      auto link = topologyW.getLinkPtr(linkName);
+      if (!link) {
+        continue;
+      }
+      auto aNode = topologyW.getNodePtr(link->a_node_name);
+      auto zNode = topologyW.getNodePtr(link->z_node_name);
+      if (!aNode || !zNode) {
+        continue;
+      }
+      auto aSite = topologyW.getSitePtr(aNode->site_name);
+      auto zSite = topologyW.getSitePtr(zNode->site_name);
+      if (!aSite || !zSite) {
+        continue;
+      }
+
+      LinkInfo& info = linkInfoMap[linkName];
+      info.aSiteName = aSite->name;
+      info.zSiteName = zSite->name;
+      info.aLocation = aSite->location;
+      info.zLocation = zSite->location;
+      info.channel = configHelper.getLinkChannel(
+          *link,
+          false, /* userConfiguredOnly */
+          false /* autoConfiguredOnly */);
+      info.aPolarity = configHelper.getRadioPolarity(
+          link->a_node_name, link->a_node_mac, false);
+      info.zPolarity = configHelper.getRadioPolarity(
+          link->z_node_name, link->z_node_mac, false);
+    }
+  }
+  return linkInfoMap;
+}
+
+std::vector<std::pair<size_t, size_t>>
+InterferenceHelper::getNearbyGroupPairs(
+    const std::vector<const std::unordered_set<std::string>*>& groupLinks,
+    const LinkInfoMap& linkInfoMap,
+    double radius) {
+  // Collect the site locations of every group
+  std::vector<std::vector<const thrift::Location*>> groupLocations(
+      groupLinks.size());
+  double maxAbsLatitude = 0;
+  for (size_t i = 0; i < groupLinks.size(); i++) {
+    for (const auto& linkName : *groupLinks[i]) {
+      auto iter = linkInfoMap.find(linkName);
+      if (iter == linkInfoMap.end()) {
+        continue;
+      }
+      for (const auto* location :
+           {&iter->second.aLocation, &iter->second.zLocation}) {
+        groupLocations[i].push_back(location);
+        maxAbsLatitude = std::max(maxAbsLatitude, fabs(location->latitude));
+      }
+    }
+  }
+
+  // Grid cells are at least "radius" wide everywhere in the topology (using
+  // the same flat-earth approximation as approxDistance()), so any two
+  // locations within "radius" of each other are in the same or adjacent cells.
+  // Longitude cells evenly divide the globe so that they wrap around.
+  double latStep = radius / kLengthPerDeg;
+  double cosLat = cos(std::min(maxAbsLatitude + latStep, 90.0) * M_PI / 180);
+  int64_t numLonCells = 1;
+  if (radius < kLengthPerDeg * cosLat * 360) {
+    numLonCells = (int64_t)(360 / (radius / (kLengthPerDeg * cosLat)));
+  }
+  double lonStep = 360.0 / numLonCells;
+  auto getCell = [&](const thrift::Location& location) {
+    return GridCell(
+        (int64_t)floor(location.latitude / latStep),
+        ((int64_t)floor((location.longitude + 180) / lonStep)) % numLonCells);
+  };
+
+  // Index groups by grid cell
+  std::map<GridCell, std::vector<size_t>> cell2Groups;
+  std::vector<std::set<GridCell>> groupCells(groupLinks.size());
+  for (size_t i = 0; i < groupLinks.size(); i++) {
+    for (const auto* location : groupLocations[i]) {
+      GridCell cell = getCell(*location);
+      if (groupCells[i].insert(cell).second) {
+        cell2Groups[cell].push_back(i);
+      }
+    }
+  }
+
+  // Find groups in the same or adjacent cells
+  std::set<std::pair<size_t, size_t>> pairs;
+  for (size_t i = 0; i < groupLinks.size(); i++) {
+    for (const GridCell& cell : groupCells[i]) {
+      for (int64_t dLat = -1; dLat <= 1; dLat++) {
+        for (int64_t dLon = -1; dLon <= 1; dLon++) {
+          auto iter = cell2Groups.find(GridCell(
+              cell.first + dLat,
+              (cell.second + dLon + numLonCells) % numLonCells));
+          if (iter == cell2Groups.end()) {
+            continue;
+          }
+          for (size_t j : iter->second) {
+            if (i < j) {
+              pairs.insert(std::make_pair(i, j));
+            }
+          }
+        }
+      }
+    }
+  }
+  return std::vector<std::pair<size_t, size_t>>(pairs.begin(), pairs.end());
+}
+
 InterferenceHelper::InterferenceMatrix
 InterferenceHelper::getInterferenceMatrix(
     const TopologyWrapper& topologyW,
@@ -112,30 +258,46 @@ InterferenceHelper::getInterferenceMatrix(
     const LinkGroupHelper::GroupNameToLinkNames& group2Links,
     const bool shouldAccountForChannel) {
   InterferenceHelper::InterferenceMatrix interferenceMatrix;
-  std::unordered_set<std::pair<std::string, std::string>> alreadyComputed;
-  for (const auto& aGroupIt : group2Links) {
-    for (const auto& bGroupIt : group2Links) {
-      if (aGroupIt.first == bGroupIt.first ||
-          alreadyComputed.count(
-              std::make_pair(bGroupIt.first, aGroupIt.first))) {
-        continue;
-      }
-
-      auto interference = estimateGroup2GroupInterference(
-          topologyW, configHelper, aGroupIt.second, bGroupIt.second,
-          shouldAccountForChannel);
-      if (interference > 0) {
-        // interferenceMatrix is symmetric
-        VLOG(3) << folly::format(
-            "Interference between groups {} and {} is {}",
-            aGroupIt.first,
-            bGroupIt.first,
-            interference);
-        interferenceMatrix[aGroupIt.first][bGroupIt.first] = interference;
-        interferenceMatrix[bGroupIt.first][aGroupIt.first] = interference;
+  LinkInfoMap linkInfoMap =
+      getLinkInfoMap(topologyW, configHelper, group2Links);
+
+  // Each pair of groups is evaluated once, with the group that comes first
+  // in "group2Links" as the first group
+  std::vector<const std::string*> groupNames;
+  std::vector<const std::unordered_set<std::string>*> groupLinks;
+  for (const auto& groupIt : group2Links) {
+    groupNames.push_back(&groupIt.first);
+    groupLinks.push_back(&groupIt.second);
+  }
+  std::vector<std::pair<size_t, size_t>> groupPairs;
+  if (FLAGS_interference_radius_m > 0) {
+    groupPairs = getNearbyGroupPairs(
+        groupLinks, linkInfoMap, FLAGS_interference_radius_m);
+  } else {
+    for (size_t i = 0; i < groupNames.size(); i++) {
+      for (size_t j = i + 1; j < groupNames.size(); j++) {
+        groupPairs.push_back(std::make_pair(i, j));
       }
+    }
+  }
 
-      alreadyComputed.insert(std::make_pair(aGroupIt.first, bGroupIt.first));
+  for (const auto& groupPair : groupPairs) {
+    const std::string& aGroupName = *groupNames[groupPair.first];
+    const std::string& bGroupName = *groupNames[groupPair.second];
+    auto interference = estimateGroup2GroupInterference(
+        linkInfoMap,
+        *groupLinks[groupPair.first],
+        *groupLinks[groupPair.second],
+        shouldAccountForChannel);
+    if (interference > 0) {
+      // interferenceMatrix is symmetric
+      VLOG(3) << folly::format(
+          "Interference between groups {} and {} is {}",
+          aGroupName,
+          bGroupName,
+          interference);
+      interferenceMatrix[aGroupName][bGroupName] = interference;
+      interferenceMatrix[bGroupName][aGroupName] = interference;
     }
   }
 
@@ -563,57 +725,36 @@ InterferenceHelper::getInterferenceEstimate(
 
 double
 InterferenceHelper::estimateGroup2GroupInterference(
-    const TopologyWrapper& topologyW,
-    ConfigHelper& configHelper,
+    const LinkInfoMap& linkInfoMap,
     const std::unordered_set<std::string>& group1,
     const std::unordered_set<std::string>& group2,
     const bool shouldAccountForChannel) {
 
   double totalInterference = 0.0;
   for (const auto& linkName1 : group1) {
+    auto link1Iter = linkInfoMap.find(linkName1);
+    if (link1Iter == linkInfoMap.end()) {
+      continue;
+    }
+    const LinkInfo& link1 = link1Iter->second;
+    double baseAng1 = computeAngle(link1.zLocation, link1.aLocation);
+
     for (const auto& linkName2 : group2) {
-      auto link1 = topologyW.getLink(linkName1);
-      auto link2 = topologyW.getLink(linkName2);
-      if (!link1 || !link2) {
+      auto link2Iter = linkInfoMap.find(linkName2);
+      if (link2Iter == linkInfoMap.end()) {
         continue;
       }
-      auto link1Channel = configHelper.getLinkChannel(
-          link1.value(),
-          false, /* userConfiguredOnly */
-          false /* autoConfiguredOnly */);
-      auto link2Channel = configHelper.getLinkChannel(
-          link2.value(),
-          false, /* userConfiguredOnly */
-          false /* autoConfiguredOnly */);
+      const LinkInfo& link2 = link2Iter->second;
 
       // Links on different channels have no interference
       if (shouldAccountForChannel &&
-          link1Channel &&
-          link2Channel &&
-          link1Channel.value() != link2Channel.value()) {
+          link1.channel &&
+          link2.channel &&
+          link1.channel.value() != link2.channel.value()) {
         continue;
       }
-      auto polarity11 = configHelper.getRadioPolarity(
-          link1->a_node_name, link1->a_node_mac, false);
-      auto polarity12 = configHelper.getRadioPolarity(
-          link1->z_node_name, link1->z_node_mac, false);
-      auto polarity21 = configHelper.getRadioPolarity(
-          link2->a_node_name, link2->a_node_mac, false);
-      auto polarity22 = configHelper.getRadioPolarity(
-          link2->z_node_name, link2->z_node_mac, false);
-
-      auto node11 = topologyW.getNode(link1->a_node_name);
-      auto node12 = topologyW.getNode(link1->z_node_name);
-      auto node21 = topologyW.getNode(link2->a_node_name);
-      auto node22 = topologyW.getNode(link2->z_node_name);
-
-      auto site11 = topologyW.getSite(node11->site_name);
-      auto site12 = topologyW.getSite(node12->site_name);
-      auto site21 = topologyW.getSite(node21->site_name);
-      auto site22 = topologyW.getSite(node22->site_name);
-
-      double baseAng1 = computeAngle(site12->location, site11->location);
-      double baseAng2 = computeAngle(site22->location, site21->location);
+
+      double baseAng2 = computeAngle(link2.zLocation, link2.aLocation);
 
       double interference = 0.0;
 
@@ -622,11 +763,12 @@ InterferenceHelper::estimateGroup2GroupInterference(
       // tx-rx interference as the nodes are transmitting and
       // receiving during the same intervals.
       // node11 -> node21
-      if (site11->name != site21->name &&
-          PolarityHelper::isValidLinkPolarity(polarity11, polarity21)) {
-        double crossAng = computeAngle(site21->location, site11->location);
+      if (link1.aSiteName != link2.aSiteName &&
+          PolarityHelper::isValidLinkPolarity(
+              link1.aPolarity, link2.aPolarity)) {
+        double crossAng = computeAngle(link2.aLocation, link1.aLocation);
         double crossDistance =
-            approxDistance(site11->location, site21->location);
+            approxDistance(link1.aLocation, link2.aLocation);
         auto angleTx = computeDirectedLinkAngleDiff(baseAng1, crossAng);
         auto angleRx = computeDirectedLinkAngleDiff(baseAng2, crossAng + 180);
         interference +=
@@ -634,11 +776,12 @@ InterferenceHelper::estimateGroup2GroupInterference(
       }
 
       // node11 -> node22
-      if (site11->name != site22->name &&
-          PolarityHelper::isValidLinkPolarity(polarity11, polarity22)) {
-        double crossAng = computeAngle(site22->location, site11->location);
+      if (link1.aSiteName != link2.zSiteName &&
+          PolarityHelper::isValidLinkPolarity(
+              link1.aPolarity, link2.zPolarity)) {
+        double crossAng = computeAngle(link2.zLocation, link1.aLocation);
         double crossDistance =
-            approxDistance(site11->location, site22->location);
+            approxDistance(link1.aLocation, link2.zLocation);
         auto angleTx = computeDirectedLinkAngleDiff(baseAng1, crossAng);
         auto angleRx =
             computeDirectedLinkAngleDiff(baseAng2 + 180, crossAng + 180);
@@ -647,11 +790,12 @@ InterferenceHelper::estimateGroup2GroupInterference(
       }
 
       // node12 -> node21
-      if (site12->name != site21->name &&
-          PolarityHelper::isValidLinkPolarity(polarity12, polarity21)) {
-        double crossAng = computeAngle(site21->location, site12->location);
+      if (link1.zSiteName != link2.aSiteName &&
+          PolarityHelper::isValidLinkPolarity(
+              link1.zPolarity, link2.aPolarity)) {
+        double crossAng = computeAngle(link2.aLocation, link1.zLocation);
         double crossDistance =
-            approxDistance(site12->location, site21->location);
+            approxDistance(link1.zLocation, link2.aLocation);
         auto angleTx = computeDirectedLinkAngleDiff(baseAng1 + 180, crossAng);
         auto angleRx = computeDirectedLinkAngleDiff(baseAng2, crossAng + 180);
         interference +=
@@ -659,11 +803,12 @@ InterferenceHelper::estimateGroup2GroupInterference(
       }
 
       // node12 -> node22
-      if (site12->name != site22->name &&
-          PolarityHelper::isValidLinkPolarity(polarity12, polarity22)) {
-        double crossAng = computeAngle(site22->location, site12->location);
+      if (link1.zSiteName != link2.zSiteName &&
+          PolarityHelper::isValidLinkPolarity(
+              link1.zPolarity, link2.zPolarity)) {
+        double crossAng = computeAngle(link2.zLocation, link1.zLocation);
         double crossDistance =
-            approxDistance(site12->location, site22->location);
+            approxDistance(link1.zLocation, link2.zLocation);
         auto angleTx = computeDirectedLinkAngleDiff(baseAng1 + 180, crossAng);
         auto angleRx =
             computeDirectedLinkAngleDiff(baseAng2 + 180, crossAng + 180);
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <functional>
+#include <optional>
 
 #include "../ConfigHelper.h"
 #include "../topology/TopologyWrapper.h"
@@ -88,7 +89,6 @@ class InterferenceHelper {
           getLinkColor,
       const std::set<int> choices);
 
- private:
   /**
    * Matrix that stores interference between link groups, with link group IDs
    * used as keys.
@@ -99,6 +99,11 @@ class InterferenceHelper {
   /**
    * Compute the estimated interference matrix between all link groups.
    *
+   * Only pairs of groups with sites within `interference_radius_m` of each
+   * other are evaluated (or all pairs, if it is not positive). Interference
+   * is always zero beyond 500 meters, so radii of at least that much give the
+   * same result as evaluating all pairs.
+   *
    * If `shouldAccountForChannel` is set to true, links on different channels
    * will be considered to have no interference.
    */
@@ -108,6 +113,43 @@ class InterferenceHelper {
       const LinkGroupHelper::GroupNameToLinkNames& group2Links,
       const bool shouldAccountForChannel);
 
+ private:
+  /** Geometry and config of a link, looked up once per computation. */
+  struct LinkInfo {
+    /** The A-node's site name. */
+    std::string aSiteName;
+    /** The Z-node's site name. */
+    std::string zSiteName;
+    /** The A-node's site location. */
+    thrift::Location aLocation;
+    /** The Z-node's site location. */
+    thrift::Location zLocation;
+    /** The link channel. */
+    std::optional<int8_t> channel;
+    /** The A-node radio polarity. */
+    std::optional<thrift::PolarityType> aPolarity;
+    /** The Z-node radio polarity. */
+    std::optional<thrift::PolarityType> zPolarity;
+  };
+
+  /** Map from link name to LinkInfo. */
+  using LinkInfoMap = std::unordered_map<std::string, LinkInfo>;
+
+  /** Look up LinkInfo for all links in the given groups. */
+  static LinkInfoMap getLinkInfoMap(
+      const TopologyWrapper& topologyW,
+      const ConfigHelper& configHelper,
+      const LinkGroupHelper::GroupNameToLinkNames& group2Links);
+
+  /**
+   * Return the pairs of groups (as indices into `groupLinks`, lower index
+   * first) that have sites within `radius` meters of each other.
+   */
+  static std::vector<std::pair<size_t, size_t>> getNearbyGroupPairs(
+      const std::vector<const std::unordered_set<std::string>*>& groupLinks,
+      const LinkInfoMap& linkInfoMap,
+      double radius);
+
   /** Check if the two power values are within 1dB of each other. */
   static bool almostEqualPower(float value1, float value2);
 
@@ -183,8 +225,7 @@ class InterferenceHelper {
    * will be considered to have no interference.
    */
   static double estimateGroup2GroupInterference(
-      const TopologyWrapper& topologyW,
-      ConfigHelper& configHelper,
+      const LinkInfoMap& linkInfoMap,
       const std::unordered_set<std::string>& aLinks,
       const std::unordered_set<std::string>& bLinks,
       const bool shouldAccountForChannel);
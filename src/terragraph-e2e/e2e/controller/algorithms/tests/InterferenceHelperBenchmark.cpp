@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure interference estimation on square grids of sites (~200m apart, with
+// links to the right and upper neighbor of each site) of increasing size.
+// Evaluating all pairs of link groups is compared against only evaluating
+// groups within "interference_radius_m" of each other.
+
+#include <map>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+#include "../../ConfigHelper.h"
+#include "../../topology/TopologyWrapper.h"
+#include "../InterferenceHelper.h"
+#include "../LinkGroupHelper.h"
+
+DECLARE_int32(interference_radius_m);
+
+using namespace facebook::terragraph;
+
+namespace {
+// Grid spacing, in degrees of latitude/longitude
+const double kGridSpacing{0.0018};
+
+// A grid topology with its configs
+struct GridNetwork {
+  std::unique_ptr<TopologyWrapper> topologyW;
+  ConfigHelper configHelper;
+  LinkGroupHelper::GroupNameToLinkNames group2Links;
+};
+
+// Build an n*n grid network (with 2n(n-1) links)
+std::unique_ptr<GridNetwork>
+createGridNetwork(int n) {
+  std::vector<thrift::Node> nodes;
+  std::vector<thrift::Link> links;
+  std::vector<thrift::Site> sites;
+  std::map<std::pair<int, int>, std::unordered_map<int, size_t>> siteNodes;
+  auto getNode = [&](int x, int y, int dir) -> const thrift::Node& {
+    auto& dirNodes = siteNodes[std::make_pair(x, y)];
+    auto iter = dirNodes.find(dir);
+    if (iter == dirNodes.end()) {
+      int nodeId = nodes.size();
+      std::string nodeMac = MacUtils::standardizeMac(folly::sformat(
+          "0:0:0:{:x}:{:x}:{:x}",
+          nodeId >> 16,
+          (nodeId >> 8) & 0xff,
+          nodeId & 0xff));
+      nodes.push_back(createNode(
+          folly::sformat("node-{}-{}-{}", x, y, dir),
+          nodeMac,
+          folly::sformat("site-{}-{}", x, y)));
+      iter = dirNodes.emplace(dir, nodes.size() - 1).first;
+    }
+    return nodes[iter->second];
+  };
+
+  for (int x = 0; x < n; x++) {
+    for (int y = 0; y < n; y++) {
+      sites.push_back(createSite(
+          folly::sformat("site-{}-{}", x, y),
+          37.4 + y * kGridSpacing,
+          -122.1 + x * kGridSpacing,
+          10,
+          1));
+    }
+  }
+  for (int x = 0; x < n; x++) {
+    for (int y = 0; y < n; y++) {
+      // Directions: 0 = right, 1 = up, 2 = left, 3 = down
+      if (x + 1 < n) {
+        links.push_back(createLink(getNode(x, y, 0), getNode(x + 1, y, 2)));
+      }
+      if (y + 1 < n) {
+        links.push_back(createLink(getNode(x, y, 1), getNode(x, y + 1, 3)));
+      }
+    }
+  }
+
+  auto network = std::make_unique<GridNetwork>();
+  network->topologyW = std::make_unique<TopologyWrapper>(
+      createTopology(nodes, links, sites), "", false, false);
+  network->configHelper.setConfigFiles(
+      "/etc/e2e_config/base_versions/",
+      "/etc/e2e_config/base_versions/fw_versions/",
+      "/etc/e2e_config/base_versions/hw_versions/",
+      "/etc/e2e_config/base_versions/hw_versions/hw_types.json",
+      "/tmp/node_config_overrides.json",
+      "/tmp/auto_node_config_overrides.json",
+      "/tmp/network_config_overrides.json",
+      "/etc/e2e_config/config_metadata.json",
+      "/tmp/cfg_backup/",
+      {});
+  std::string errorMsg;
+  for (const auto& node : nodes) {
+    // Alternate polarity along both axes, so every link is odd/even
+    int x, y, dir;
+    sscanf(node.name.c_str(), "node-%d-%d-%d", &x, &y, &dir);
+    network->configHelper.setNodePolarity(
+        node.name,
+        node.mac_addr,
+        (x + y) % 2 ? thrift::PolarityType::ODD : thrift::PolarityType::EVEN,
+        false /* forUserConfig */,
+        errorMsg);
+  }
+  network->group2Links =
+      LinkGroupHelper::getLinkGroups(*network->topologyW);
+  return network;
+}
+
+GridNetwork&
+getGridNetwork(int n) {
+  static std::map<int, std::unique_ptr<GridNetwork>> networks;
+  auto& network = networks[n];
+  if (!network) {
+    network = createGridNetwork(n);
+  }
+  return *network;
+}
+
+void
+runInterferenceMatrix(uint32_t iters, int n, int radius) {
+  GridNetwork* network;
+  BENCHMARK_SUSPEND {
+    network = &getGridNetwork(n);
+    FLAGS_interference_radius_m = radius;
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(InterferenceHelper::getInterferenceMatrix(
+        *network->topologyW,
+        network->configHelper,
+        network->group2Links,
+        true /* shouldAccountForChannel */));
+  }
+}
+} // namespace
+
+void
+AllPairsMatrix(uint32_t iters, int n) {
+  runInterferenceMatrix(iters, n, 0);
+}
+
+void
+IndexedMatrix(uint32_t iters, int n) {
+  runInterferenceMatrix(iters, n, 500);
+}
+
+void
+GraphWithLinkAngles(uint32_t iters, int n) {
+  GridNetwork* network;
+  BENCHMARK_SUSPEND {
+    network = &getGridNetwork(n);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(
+        InterferenceHelper::createGraphWithLinkAngles(*network->topologyW));
+  }
+}
+
+// 264 links
+BENCHMARK_PARAM(AllPairsMatrix, 12)
+BENCHMARK_RELATIVE_PARAM(IndexedMatrix, 12)
+BENCHMARK_PARAM(GraphWithLinkAngles, 12)
+BENCHMARK_DRAW_LINE();
+// 1012 links
+BENCHMARK_PARAM(AllPairsMatrix, 23)
+BENCHMARK_RELATIVE_PARAM(IndexedMatrix, 23)
+BENCHMARK_PARAM(GraphWithLinkAngles, 23)
+BENCHMARK_DRAW_LINE();
+// 1984 links
+BENCHMARK_PARAM(AllPairsMatrix, 32)
+BENCHMARK_RELATIVE_PARAM(IndexedMatrix, 32)
+BENCHMARK_PARAM(GraphWithLinkAngles, 32)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "../InterferenceHelper.h"
+
+#include "../../ConfigHelper.h"
+#include "../../topology/TopologyWrapper.h"
+#include "../LinkGroupHelper.h"
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+DECLARE_int32(interference_radius_m);
+
+using namespace std;
+using namespace facebook::terragraph;
+
+namespace { // anonymous namespace
+
+using LinkAngleGraph = std::
+    unordered_map<std::string, std::vector<std::pair<std::string, double>>>;
+
+class InterferenceFixture : public ::testing::Test {
+ public:
+  void
+  initConfigHelper(ConfigHelper& configHelper) {
+    configHelper.setConfigFiles(
+        "/etc/e2e_config/base_versions/",       // base_config_dir
+        "/etc/e2e_config/base_versions/fw_versions/",  // fw_base_config_dir
+        "/etc/e2e_config/base_versions/hw_versions/",  // hw_base_config_dir
+        // hw_config_types_file
+        "/etc/e2e_config/base_versions/hw_versions/hw_types.json",
+        "/tmp/node_config_overrides.json",      // node_config_overrides_file
+        // auto_node_config_overrides_file
+        "/tmp/auto_node_config_overrides.json",
+        "/tmp/network_config_overrides.json",   // network_config_overrides_file
+        "/etc/e2e_config/config_metadata.json", // node_config_metadata_file
+        "/tmp/cfg_backup/",                     // config_backup_dir
+        {});
+  }
+
+  // Add a chain of sites ~200m apart (starting at the given location), with a
+  // link between each pair of neighboring sites. Sites alternate polarity.
+  void
+  addChain(
+      const std::string& prefix,
+      int numSites,
+      double latitude,
+      double longitude) {
+    for (int i = 0; i < numSites; i++) {
+      std::string siteName = folly::sformat("{}-site-{}", prefix, i);
+      sites_.push_back(createSite(
+          siteName, latitude + 0.0006 * i, longitude + 0.0018 * i, 10, 1));
+      for (int j = 0; j < 2; j++) {
+        int nodeId = nodes_.size();
+        std::string nodeMac = MacUtils::standardizeMac(folly::sformat(
+            "0:0:0:{:x}:{:x}:{:x}",
+            nodeId >> 16,
+            (nodeId >> 8) & 0xff,
+            nodeId & 0xff));
+        nodes_.push_back(createNode(
+            folly::sformat("{}-node-{}-{}", prefix, i, j), nodeMac, siteName));
+        polarities_[nodeMac] = (i % 2 == 0)
+            ? thrift::PolarityType::ODD
+            : thrift::PolarityType::EVEN;
+      }
+      if (i > 0) {
+        // Previous site's second node to this site's first node
+        links_.push_back(
+            createLink(nodes_[nodes_.size() - 3], nodes_[nodes_.size() - 2]));
+      }
+    }
+  }
+
+  // Apply the node polarities
+  void
+  setPolarities(ConfigHelper& configHelper) {
+    std::string errorMsg;
+    for (const auto& node : nodes_) {
+      EXPECT_TRUE(configHelper.setNodePolarity(
+          node.name,
+          node.mac_addr,
+          polarities_.at(node.mac_addr),
+          false /* forUserConfig */,
+          errorMsg));
+    }
+  }
+
+  // The original all-pairs createGraphWithLinkAngles() algorithm
+  LinkAngleGraph
+  getAllPairsGraph(const TopologyWrapper& topologyW) {
+    LinkAngleGraph graph;
+    std::vector<thrift::Link> links = topologyW.getAllLinks();
+    auto getSiteName = [&](const std::string& nodeName) {
+      return topologyW.getNode(nodeName)->site_name;
+    };
+    auto getAngle = [&](const thrift::Link& link) {
+      return computeAngle(
+          topologyW.getSite(getSiteName(link.a_node_name))->location,
+          topologyW.getSite(getSiteName(link.z_node_name))->location);
+    };
+    for (const auto& aLink : links) {
+      std::string aSite = getSiteName(aLink.a_node_name);
+      std::string zSite = getSiteName(aLink.z_node_name);
+      for (const auto& bLink : links) {
+        if (aLink.name == bLink.name) {
+          continue;
+        }
+        std::string bASite = getSiteName(bLink.a_node_name);
+        std::string bZSite = getSiteName(bLink.z_node_name);
+        if (aSite != bASite && aSite != bZSite && zSite != bASite &&
+            zSite != bZSite) {
+          continue;
+        }
+        bool flip = !(aSite == bASite || zSite == bZSite);
+        double angleDiff = getAngle(aLink) - getAngle(bLink);
+        if (flip) {
+          angleDiff = 180 - getAngle(bLink);
+        }
+        angleDiff = abs(angleDiff);
+        if (angleDiff > 180) {
+          angleDiff = 360 - angleDiff;
+        }
+        if (angleDiff > 90) {
+          angleDiff = 180 - angleDiff;
+        }
+        graph[aLink.name].push_back(std::make_pair(bLink.name, angleDiff));
+      }
+    }
+    return graph;
+  }
+
+  std::vector<thrift::Node> nodes_;
+  std::vector<thrift::Link> links_;
+  std::vector<thrift::Site> sites_;
+  std::unordered_map<std::string, thrift::PolarityType> polarities_;
+};
+
+} // anonymous namespace
+
+// The site index must not change the interference matrix
+TEST_F(InterferenceFixture, InterferenceMatrixMatchesAllPairs) {
+  addChain("a", 6, 37.48, -122.15);
+  addChain("b", 6, 37.58, -122.15);  // ~11km away from chain "a"
+  TopologyWrapper topologyW(
+      createTopology(nodes_, links_, sites_), "", false, false);
+  ConfigHelper configHelper;
+  initConfigHelper(configHelper);
+  setPolarities(configHelper);
+  auto group2Links = LinkGroupHelper::getLinkGroups(topologyW);
+
+  FLAGS_interference_radius_m = 0;
+  auto allPairsMatrix = InterferenceHelper::getInterferenceMatrix(
+      topologyW, configHelper, group2Links, true);
+  FLAGS_interference_radius_m = 500;
+  auto indexedMatrix = InterferenceHelper::getInterferenceMatrix(
+      topologyW, configHelper, group2Links, true);
+
+  EXPECT_FALSE(allPairsMatrix.empty());
+  EXPECT_EQ(allPairsMatrix, indexedMatrix);
+
+  // No interference between the two chains
+  for (const auto& it1 : indexedMatrix) {
+    for (const auto& it2 : it1.second) {
+      EXPECT_EQ(it1.first.substr(0, 7), it2.first.substr(0, 7));
+    }
+  }
+}
+
+// The site index must also work across the 180th meridian
+TEST_F(InterferenceFixture, InterferenceMatrixAcrossMeridian) {
+  addChain("a", 6, -16.5, 179.995);
+  for (auto& site : sites_) {
+    if (site.location.longitude > 180) {
+      site.location.longitude -= 360;
+    }
+  }
+  TopologyWrapper topologyW(
+      createTopology(nodes_, links_, sites_), "", false, false);
+  ConfigHelper configHelper;
+  initConfigHelper(configHelper);
+  setPolarities(configHelper);
+  auto group2Links = LinkGroupHelper::getLinkGroups(topologyW);
+
+  FLAGS_interference_radius_m = 0;
+  auto allPairsMatrix = InterferenceHelper::getInterferenceMatrix(
+      topologyW, configHelper, group2Links, true);
+  FLAGS_interference_radius_m = 500;
+  auto indexedMatrix = InterferenceHelper::getInterferenceMatrix(
+      topologyW, configHelper, group2Links, true);
+
+  EXPECT_FALSE(allPairsMatrix.empty());
+  EXPECT_EQ(allPairsMatrix, indexedMatrix);
+}
+
+// Only links sharing a site are evaluated, in the original order
+TEST_F(InterferenceFixture, GraphWithLinkAnglesMatchesAllPairs) {
+  addChain("a", 8, 37.48, -122.15);
+  addChain("b", 4, 37.48, -122.10);
+  // Add a second link from the middle of chain "a" (a Y-street)
+  sites_.push_back(createSite("a-site-y", 37.4825, -122.1425, 10, 1));
+  nodes_.push_back(createNode(
+      "a-node-y", MacUtils::standardizeMac("0:0:0:1:0:0"), "a-site-y"));
+  links_.push_back(createLink(nodes_[8], nodes_.back()));
+  TopologyWrapper topologyW(
+      createTopology(nodes_, links_, sites_), "", false, false);
+
+  auto graph = InterferenceHelper::createGraphWithLinkAngles(topologyW);
+  EXPECT_FALSE(graph.empty());
+  EXPECT_EQ(getAllPairsGraph(topologyW), graph);
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -919,8 +919,6 @@ DeterministicPrefixAllocator::addLink(
     auto node = topologyW_->getNode(link.z_node_name);
     addNode(*node, configHelper);
   }
-
-  topologyW_->writeToTsFile();
 }
 
 void
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <e2e/common/CompressionUtil.h>
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+#include "../BinaryStarApp.h"
+#include "../BinaryStarReplication.h"
+
+using namespace facebook::terragraph;
+
+DECLARE_int32(bstar_replication_log_size);
+
+namespace {
+
+using SyncedAppData = BinaryStarApp::SyncedAppData;
+
+// Build a chain of sites with two nodes each, wired within each site and
+// linked wirelessly to the next site
+thrift::Topology
+getTopology(int numNodes) {
+  std::vector<thrift::Node> nodes;
+  std::vector<thrift::Link> links;
+  std::vector<thrift::Site> sites;
+  for (int i = 0; i < numNodes; i++) {
+    std::string siteName = folly::sformat("site-{}", i / 2);
+    if (i % 2 == 0) {
+      sites.push_back(
+          createSite(siteName, 37.4 + 0.0018 * (i / 2), -122.1, 10, 1));
+    }
+    nodes.push_back(createNode(
+        folly::sformat("node-{}", i),
+        MacUtils::standardizeMac(folly::sformat(
+            "0:0:0:{:x}:{:x}:{:x}", i >> 16, (i >> 8) & 0xff, i & 0xff)),
+        siteName,
+        i == 0 /* popNode */,
+        thrift::NodeStatusType::ONLINE_INITIATOR));
+    if (i % 2 == 1) {
+      links.push_back(createLink(nodes[i - 1], nodes[i]));
+      links.back().link_type = thrift::LinkType::ETHERNET;
+    } else if (i > 0) {
+      links.push_back(createLink(nodes[i - 1], nodes[i]));
+    }
+  }
+  return createTopology(nodes, links, sites);
+}
+
+// Returns the size of a heartbeat as sent to the peer (compressed)
+size_t
+getWireSize(const thrift::BinaryStarSync& heartbeat) {
+  apache::thrift::CompactSerializer serializer;
+  thrift::Message msg;
+  msg.mType = thrift::MessageType::BSTAR_SYNC;
+  msg.value = fbzmq::util::writeThriftObjStr(heartbeat, serializer);
+  CompressionUtil::compress(msg);
+  return fbzmq::util::writeThriftObjStr(msg, serializer).size();
+}
+
+// Send one heartbeat from 'active' to 'replica', and return its wire size
+size_t
+syncOnce(const SyncedAppData& active, BinaryStarReplica& replica) {
+  thrift::BinaryStarSync heartbeat;
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  heartbeat.checksum_ref() =
+      BinaryStarReplication::getContentHash(active.fullAppData);
+  thrift::BinaryStarAppData changed;
+  replica.processHeartbeat(heartbeat, changed);
+  return getWireSize(heartbeat);
+}
+
+void
+expectConverged(const SyncedAppData& active, const BinaryStarReplica& replica) {
+  EXPECT_EQ(active.seqNum, replica.getSeqNum());
+  EXPECT_EQ(active.epoch, replica.getEpoch());
+  EXPECT_EQ(
+      BinaryStarReplication::getContentHash(active.fullAppData),
+      BinaryStarReplication::getContentHash(replica.getAppData()));
+}
+
+SyncedAppData
+getActive(const thrift::Topology& topology) {
+  SyncedAppData active;
+  active.clear();
+  active.setTopology(topology);
+  active.setNetworkOverrides("{}");
+  active.setNodeOverrides("{}");
+  active.setAutoNodeOverrides("{}");
+  active.setControllerConfig("{}");
+  return active;
+}
+} // namespace
+
+// Single link changes are sent as small deltas instead of the full topology
+TEST(BinaryStarReplicationTest, LinkChangeBytesOnWire) {
+  auto topology = getTopology(1500);
+  auto active = getActive(topology);
+  BinaryStarReplica replica;
+
+  // Initial full sync
+  size_t fullBytes = syncOnce(active, replica);
+  expectConverged(active, replica);
+  EXPECT_TRUE(active.log.empty());
+
+  // Nothing changed, nothing sent
+  thrift::BinaryStarSync heartbeat;
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  EXPECT_TRUE(heartbeat.data == thrift::BinaryStarAppData());
+  EXPECT_TRUE(heartbeat.deltas.empty());
+  active.setTopology(topology);
+  EXPECT_EQ(replica.getSeqNum(), active.seqNum);
+
+  // Bring one link up
+  topology.links[100].is_alive = true;
+  active.setTopology(topology);
+  ASSERT_EQ(1, active.log.size());
+  EXPECT_EQ(1, active.log.back().linksChanged.size());
+  EXPECT_TRUE(active.log.back().nodesChanged.empty());
+  size_t deltaBytes = syncOnce(active, replica);
+  expectConverged(active, replica);
+  EXPECT_TRUE(replica.getAppData().topology_ref().value().links[100].is_alive);
+
+  LOG(INFO) << "Bytes on the wire: full sync=" << fullBytes
+            << ", one link change=" << deltaBytes;
+  EXPECT_LT(deltaBytes * 100, fullBytes);
+}
+
+// Removed and renamed topology elements are replicated
+TEST(BinaryStarReplicationTest, TopologyAddRemove) {
+  auto topology = getTopology(20);
+  auto active = getActive(topology);
+  BinaryStarReplica replica;
+  syncOnce(active, replica);
+
+  auto link = topology.links.back();
+  topology.links.pop_back();
+  topology.nodes.back().name = "renamed";
+  topology.sites.push_back(createSite("new-site", 37.5, -122.1, 10, 1));
+  active.setTopology(topology);
+  syncOnce(active, replica);
+  expectConverged(active, replica);
+
+  const auto& replicaTopology = replica.getAppData().topology_ref().value();
+  EXPECT_EQ(topology.links.size(), replicaTopology.links.size());
+  EXPECT_EQ(topology.nodes.size(), replicaTopology.nodes.size());
+  EXPECT_EQ("new-site", replicaTopology.sites.back().name);
+  for (const auto& l : replicaTopology.links) {
+    EXPECT_NE(link.name, l.name);
+  }
+}
+
+// Config overrides are sent as changed top-level keys
+TEST(BinaryStarReplicationTest, NodeOverridesDelta) {
+  auto active = getActive(getTopology(4));
+  BinaryStarReplica replica;
+  syncOnce(active, replica);
+
+  folly::dynamic overrides = folly::dynamic::object
+      ("node-0", folly::dynamic::object("a", 1))
+      ("node-1", folly::dynamic::object("b", 2));
+  active.setNodeOverrides(folly::toJson(overrides));
+  ASSERT_EQ(1, active.log.size());
+  EXPECT_EQ(2, active.log.back().configNodeOverrides.size());
+  syncOnce(active, replica);
+
+  overrides.erase("node-0");
+  overrides["node-1"]["b"] = 3;
+  active.setNodeOverrides(folly::toJson(overrides));
+  ASSERT_EQ(2, active.log.size());
+  EXPECT_EQ("", active.log.back().configNodeOverrides.at("node-0"));
+  syncOnce(active, replica);
+  expectConverged(active, replica);
+  EXPECT_EQ(
+      overrides,
+      folly::parseJson(replica.getAppData().configNodeOverrides_ref().value()));
+
+  // Not a JSON object, so it can only be sent in full
+  active.setNodeOverrides("[]");
+  EXPECT_TRUE(active.log.empty());
+  thrift::BinaryStarSync heartbeat;
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  EXPECT_FALSE(heartbeat.data == thrift::BinaryStarAppData());
+}
+
+// Lost and duplicate heartbeats are handled
+TEST(BinaryStarReplicationTest, GapsAndDuplicates) {
+  auto topology = getTopology(20);
+  auto active = getActive(topology);
+  BinaryStarReplica replica;
+  syncOnce(active, replica);
+  int32_t baseSeqNum = active.seqNum;
+
+  // Heartbeat with change 1 is lost
+  topology.links[0].is_alive = true;
+  active.setTopology(topology);
+  thrift::BinaryStarSync lost;
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), lost);
+
+  // Heartbeat with change 2 only cannot be applied
+  topology.links[1].is_alive = true;
+  active.setTopology(topology);
+  thrift::BinaryStarSync gap;
+  active.getSyncData(active.seqNum - 1, active.epoch, gap);
+  ASSERT_EQ(1, gap.deltas.size());
+  thrift::BinaryStarAppData changed;
+  EXPECT_FALSE(replica.processHeartbeat(gap, changed));
+  EXPECT_EQ(baseSeqNum, replica.getSeqNum());
+
+  // Re-send from the replica's sequence number
+  syncOnce(active, replica);
+  expectConverged(active, replica);
+
+  // Duplicate heartbeat is ignored
+  EXPECT_FALSE(replica.processHeartbeat(lost, changed));
+  expectConverged(active, replica);
+
+  // Changes older than the log require a full sync
+  FLAGS_bstar_replication_log_size = 1;
+  int32_t oldSeqNum = replica.getSeqNum();
+  topology.links[2].is_alive = true;
+  active.setTopology(topology);
+  topology.links[3].is_alive = true;
+  active.setTopology(topology);
+  thrift::BinaryStarSync heartbeat;
+  active.getSyncData(oldSeqNum, active.epoch, heartbeat);
+  EXPECT_FALSE(heartbeat.data == thrift::BinaryStarAppData());
+  FLAGS_bstar_replication_log_size = 1000;
+}
+
+// A checksum mismatch forces a full sync
+TEST(BinaryStarReplicationTest, ChecksumMismatch) {
+  auto topology = getTopology(20);
+  auto active = getActive(topology);
+  BinaryStarReplica replica;
+  syncOnce(active, replica);
+
+  // Diverge without the log knowing
+  auto diverged = active.fullAppData;
+  diverged.topology_ref().value().links[0].is_alive = true;
+  thrift::BinaryStarSync heartbeat;
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  heartbeat.checksum_ref() = BinaryStarReplication::getContentHash(diverged);
+  thrift::BinaryStarAppData changed;
+  replica.processHeartbeat(heartbeat, changed);
+  EXPECT_EQ(0, replica.getSeqNum());
+
+  // Full sync on the next heartbeat
+  heartbeat = thrift::BinaryStarSync();
+  active.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  EXPECT_FALSE(heartbeat.data == thrift::BinaryStarAppData());
+  syncOnce(active, replica);
+  expectConverged(active, replica);
+}
+
+// A new ACTIVE session always starts with a full sync
+TEST(BinaryStarReplicationTest, NewEpoch) {
+  auto topology = getTopology(20);
+  auto active = getActive(topology);
+  BinaryStarReplica replica;
+  syncOnce(active, replica);
+
+  auto newActive = getActive(topology);
+  EXPECT_NE(active.epoch, newActive.epoch);
+  thrift::BinaryStarSync heartbeat;
+  newActive.getSyncData(replica.getSeqNum(), replica.getEpoch(), heartbeat);
+  EXPECT_FALSE(heartbeat.data == thrift::BinaryStarAppData());
+  syncOnce(newActive, replica);
+  expectConverged(newActive, replica);
+}
+
+// Element order and JSON formatting do not affect the content hash
+TEST(BinaryStarReplicationTest, ContentHash) {
+  auto active = getActive(getTopology(20));
+  auto data = active.fullAppData;
+  auto& topology = data.topology_ref().value();
+  std::reverse(topology.nodes.begin(), topology.nodes.end());
+  std::reverse(topology.links.begin(), topology.links.end());
+  data.configNodeOverrides_ref() = "{ }";
+  EXPECT_EQ(
+      BinaryStarReplication::getContentHash(active.fullAppData),
+      BinaryStarReplication::getContentHash(data));
+
+  topology.nodes[0].status = thrift::NodeStatusType::OFFLINE;
+  EXPECT_NE(
+      BinaryStarReplication::getContentHash(active.fullAppData),
+      BinaryStarReplication::getContentHash(data));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
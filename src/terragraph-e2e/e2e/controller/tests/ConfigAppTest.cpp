@@ -510,6 +510,102 @@ TEST_F(ConfigFixture, ConfigSoftwareVersions) {
   }
 }
 
+// Test that a config change after a node reported being in sync is pushed as a
+// patch against the synced config
+TEST_F(ConfigFixture, DeltaPushAfterOverridesChange) {
+  const std::string nodeMac = "02:02:02:02:02:02";
+  const std::string swVersion =
+      "Facebook Terragraph Release RELEASE_M99 "
+      "(user@dev12345 Tue Jun 5 16:01:52 PDT 2018)";
+  const std::string fwVersion = "10.11.0.92";
+  const std::string hwBoardId = "NXP_LS1048A_PUMA";
+
+  auto node = createNode(
+      nodeName_,
+      nodeMac,
+      "test_site",
+      true,
+      thrift::NodeStatusType::ONLINE,
+      thrift::NodeType::DN);
+  auto site = createSite("test_site", 1, 1, 1, 1);
+  SharedObjects::getTopologyWrapper()->wlock()->setTopology(
+      createTopology({node}, {}, {site}));
+  auto minionSock = createMinionSock(nodeMac);
+
+  auto setNetworkOverrides = [this](const folly::dynamic& overrides) {
+    thrift::SetCtrlConfigNetworkOverridesReq req;
+    req.overrides = folly::toJson(overrides);
+    thrift::Message msg;
+    msg.mType = thrift::MessageType::SET_CTRL_CONFIG_NETWORK_OVERRIDES_REQ;
+    msg.value = fbzmq::util::writeThriftObjStr(req, serializer_);
+    sendInCtrlApp(
+        querySock_,
+        "",
+        E2EConsts::kConfigAppCtrlId,
+        querySockId_,
+        msg,
+        serializer_);
+    recvE2EAck(querySock_, E2EConsts::kConfigAppCtrlId, true, serializer_);
+  };
+  auto setStatusReport = [&](const std::string& configHash) {
+    thrift::StatusReport report;
+    report.version = swVersion;
+    report.firmwareVersion = fwVersion;
+    report.hardwareBoardId = hwBoardId;
+    report.configHash_ref() = configHash;
+    (*SharedObjects::getStatusReports()->wlock())[nodeMac] =
+        StatusApp::StatusReport(std::chrono::steady_clock::now(), report);
+  };
+  SCOPE_EXIT {
+    setNetworkOverrides(folly::dynamic::object);
+    SharedObjects::getStatusReports()->wlock()->clear();
+  };
+
+  // The node reports running its current config
+  folly::dynamic networkOverrides = folly::dynamic::object(
+      "sysParams", folly::dynamic::object("managedConfig", true));
+  setNetworkOverrides(networkOverrides);
+  auto configState =
+      SharedObjects::getConfigHelper()->wlock()->initConfigState(
+          nodeName_, swVersion, fwVersion, hwBoardId);
+  ASSERT_TRUE(configState.has_value());
+  ASSERT_TRUE(configState->isManaged);
+  setStatusReport(configState->hash);
+
+  // Wait for the status report sync to record the synced config
+  std::optional<ConfigHelper::SyncedConfig> syncedConfig;
+  for (int i = 0; i < 100 && !syncedConfig; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    syncedConfig =
+        SharedObjects::getConfigHelper()->rlock()->getNodeConfigSynced(
+            nodeName_);
+  }
+  ASSERT_TRUE(syncedConfig.has_value());
+  EXPECT_EQ(configState->hash, syncedConfig->hash);
+
+  // Changing the network overrides discards the config state, but not the
+  // synced config, so the new config is sent as a patch
+  networkOverrides["testKey"] = "testValue";
+  setNetworkOverrides(networkOverrides);
+  setStatusReport(configState->hash);
+
+  thrift::Message msg;
+  do {
+    std::tie(std::ignore, std::ignore, msg) =
+        recvInMinionBroker(minionSock, serializer_);
+  } while (msg.mType != thrift::MessageType::SET_MINION_CONFIG_REQ);
+  auto setMinionConfigReq =
+      fbzmq::util::readThriftObjStr<thrift::SetMinionConfigReq>(
+          msg.value, serializer_);
+  ASSERT_TRUE(setMinionConfigReq.configPatch_ref().has_value());
+  const auto& configPatch = setMinionConfigReq.configPatch_ref().value();
+  EXPECT_EQ(configState->hash, configPatch.baseConfigHash);
+  EXPECT_EQ(
+      folly::dynamic::object("testKey", "testValue"),
+      folly::parseJson(configPatch.patch));
+  EXPECT_TRUE(setMinionConfigReq.config.empty());
+}
+
 int
 main(int argc, char* argv[]) {
   folly::init(&argc, &argv);
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure how long it takes to rebuild the config state of every node after a
+// network overrides change: building, serializing, and hashing each node's
+// config serially (as ConfigApp did while holding the ConfigHelper lock),
+// versus ConfigHelper::renderNodeConfigs() on a thread pool. The parameter
+// is the number of nodes.
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../ConfigHelper.h"
+#include "e2e/common/JsonUtils.h"
+#include "e2e/common/Md5Utils.h"
+
+DEFINE_int32(render_threads, 4, "Number of threads used to render configs");
+
+using namespace facebook::terragraph;
+
+namespace {
+const std::vector<std::string> kSwVersions = {
+    "Facebook Terragraph Release RELEASE_M78 "
+    "(user@dev12345 Tue Jun 5 16:01:52 PDT 2021)",
+    "Facebook Terragraph Release RELEASE_M79 "
+    "(user@dev12345 Tue Jun 5 16:01:52 PDT 2021)",
+};
+const std::vector<std::string> kHwBoardIds = {
+    "NXP_LS1048A_PUMA", "NXP_LS1088A_RDB"};
+const std::string kFwVersion = "10.11.0.92";
+
+// Create a ConfigHelper with per-node user and automatic overrides for
+// 'numNodes' nodes
+std::unique_ptr<ConfigHelper>
+makeConfigHelper(uint32_t numNodes) {
+  auto configHelper = std::make_unique<ConfigHelper>();
+  configHelper->setConfigFiles(
+      "/etc/e2e_config/base_versions/",
+      "/etc/e2e_config/base_versions/fw_versions/",
+      "/etc/e2e_config/base_versions/hw_versions/",
+      "/etc/e2e_config/base_versions/hw_versions/hw_types.json",
+      "/tmp/node_config_overrides.json",
+      "/tmp/auto_node_config_overrides.json",
+      "/tmp/network_config_overrides.json",
+      "/etc/e2e_config/config_metadata.json",
+      "/tmp/cfg_backup/",
+      {});
+
+  folly::dynamic nodesOverrides = folly::dynamic::object;
+  folly::dynamic autoNodesOverrides = folly::dynamic::object;
+  for (uint32_t i = 0; i < numNodes; i++) {
+    std::string nodeName = folly::sformat("node-{}", i);
+    nodesOverrides[nodeName] = folly::dynamic::object(
+        "envParams", folly::dynamic::object("OPENR_ENABLED", "1"));
+    autoNodesOverrides[nodeName] = folly::dynamic::object(
+        "topologyInfo", folly::dynamic::object("nodeName", nodeName));
+  }
+  std::string errorMsg;
+  configHelper->setNewNodeOverrides(nodesOverrides, errorMsg);
+  configHelper->setNewAutoNodeOverrides(autoNodesOverrides, errorMsg);
+  configHelper->setNewNetworkOverrides(
+      R"({"sysParams": {"managedConfig": true}})", errorMsg);
+  return configHelper;
+}
+
+std::string
+getSwVersion(uint32_t i) {
+  return kSwVersions[i % kSwVersions.size()];
+}
+
+std::string
+getHwBoardId(uint32_t i) {
+  return kHwBoardIds[i % kHwBoardIds.size()];
+}
+} // namespace
+
+void
+SerialRender(uint32_t iters, uint32_t numNodes) {
+  std::unique_ptr<ConfigHelper> configHelper;
+  BENCHMARK_SUSPEND {
+    configHelper = makeConfigHelper(numNodes);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    auto overrideLayers = configHelper->getOverrideLayers();
+    for (uint32_t j = 0; j < numNodes; j++) {
+      auto nodeConfig = configHelper->buildNodeConfig(
+          folly::sformat("node-{}", j),
+          getSwVersion(j),
+          kFwVersion,
+          getHwBoardId(j),
+          std::make_optional(overrideLayers->autoNodesOverrides),
+          std::make_optional(overrideLayers->networkOverrides),
+          std::make_optional(overrideLayers->nodesOverrides));
+      auto configJson = JsonUtils::toSortedPrettyJson(nodeConfig);
+      auto md5 = Md5Utils::computeMd5(configJson);
+      folly::doNotOptimizeAway(md5);
+    }
+  }
+}
+
+void
+PooledRender(uint32_t iters, uint32_t numNodes) {
+  std::unique_ptr<ConfigHelper> configHelper;
+  std::unique_ptr<folly::CPUThreadPoolExecutor> executor;
+  BENCHMARK_SUSPEND {
+    configHelper = makeConfigHelper(numNodes);
+    executor =
+        std::make_unique<folly::CPUThreadPoolExecutor>(FLAGS_render_threads);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    std::vector<ConfigHelper::NodeConfigRender> renders;
+    for (uint32_t j = 0; j < numNodes; j++) {
+      renders.push_back(configHelper->prepareNodeConfigRender(
+          folly::sformat("node-{}", j),
+          getSwVersion(j),
+          kFwVersion,
+          getHwBoardId(j)));
+    }
+    ConfigHelper::renderNodeConfigs(renders, executor.get());
+    configHelper->setConfigStates(renders);
+  }
+}
+
+BENCHMARK_PARAM(SerialRender, 100)
+BENCHMARK_RELATIVE_PARAM(PooledRender, 100)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(SerialRender, 1000)
+BENCHMARK_RELATIVE_PARAM(PooledRender, 1000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(SerialRender, 3000)
+BENCHMARK_RELATIVE_PARAM(PooledRender, 3000)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+
+#include "../ConfigHelper.h"
+#include "e2e/common/JsonUtils.h"
+#include "e2e/common/Md5Utils.h"
+#include "e2e/common/StructuralHash.h"
+
+using namespace facebook::terragraph;
+
+namespace {
+const std::string kSwVersion =
+    "Facebook Terragraph Release RELEASE_M99 "
+    "(user@dev12345 Tue Jun 5 16:01:52 PDT 2018)";
+const std::string kFwVersion = "10.11.0.92";
+const std::string kHwBoardId = "NXP_LS1048A_PUMA";
+} // namespace
+
+class ConfigRenderTest : public ::testing::Test {
+public:
+  void
+  SetUp() override {
+    configHelper_.setConfigFiles(
+        "/etc/e2e_config/base_versions/",       // base_config_dir
+        "/etc/e2e_config/base_versions/fw_versions/",  // fw_base_config_dir
+        "/etc/e2e_config/base_versions/hw_versions/",  // hw_base_config_dir
+        // hw_config_types_file
+        "/etc/e2e_config/base_versions/hw_versions/hw_types.json",
+        "/tmp/node_config_overrides.json",      // node_config_overrides_file
+        // auto_node_config_overrides_file
+        "/tmp/auto_node_config_overrides.json",
+        // network_config_overrides_file
+        "/tmp/network_config_overrides.json",
+        "/etc/e2e_config/config_metadata.json", // node_config_metadata_file
+        "/tmp/cfg_backup/",                     // config_backup_dir
+        {});
+  }
+
+  void
+  TearDown() override {
+    // Delete any configs created by tests
+    remove("/tmp/node_config_overrides.json");
+    remove("/tmp/auto_node_config_overrides.json");
+    remove("/tmp/network_config_overrides.json");
+  }
+
+  ConfigHelper configHelper_;
+};
+
+TEST_F(ConfigRenderTest, MatchesBuildNodeConfig) {
+  std::string errorMsg;
+  ASSERT_TRUE(configHelper_.setNewNetworkOverrides(
+      R"({"sysParams": {"managedConfig": true}})", errorMsg));
+  ASSERT_TRUE(configHelper_.setNewNodeOverrides(
+      R"({"node-1": {"envParams": {"OPENR_ENABLED": "0"}}})", errorMsg));
+
+  std::vector<ConfigHelper::NodeConfigRender> renders;
+  for (int i = 0; i < 8; i++) {
+    renders.push_back(configHelper_.prepareNodeConfigRender(
+        folly::sformat("node-{}", i),
+        kSwVersion,
+        i % 2 ? kFwVersion : "",
+        i % 4 ? kHwBoardId : "",
+        nullptr));
+  }
+  folly::CPUThreadPoolExecutor executor(3);
+  ConfigHelper::renderNodeConfigs(renders, &executor);
+
+  for (const auto& render : renders) {
+    ASSERT_TRUE(render.rendered);
+    auto nodeConfig = configHelper_.buildNodeConfig(
+        render.nodeName,
+        render.swVersion,
+        render.fwVersion,
+        render.hwBoardId,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt);
+    EXPECT_EQ(nodeConfig, render.configObj);
+    EXPECT_EQ(JsonUtils::toSortedPrettyJson(nodeConfig), render.configJson);
+    EXPECT_EQ(Md5Utils::computeMd5(render.configJson), render.md5);
+    EXPECT_EQ(StructuralHash::computeHash(nodeConfig), render.hash);
+    EXPECT_TRUE(render.isManaged);
+  }
+  EXPECT_EQ(
+      "0",
+      renders[1].configObj["envParams"]["OPENR_ENABLED"].asString());
+
+  // All renders are applied
+  EXPECT_EQ(renders.size(), configHelper_.setConfigStates(renders).size());
+  auto configState = configHelper_.getConfigState("node-3");
+  ASSERT_TRUE(configState.has_value());
+  EXPECT_EQ(renders[3].md5, configState->md5);
+  EXPECT_EQ(renders[3].hash, configState->hash);
+  EXPECT_EQ(kHwBoardId, configState->hwBoardId);
+}
+
+TEST_F(ConfigRenderTest, LegacyMd5Disabled) {
+  std::string errorMsg;
+  ASSERT_TRUE(configHelper_.setNewNodeOverrides(
+      R"({"node-0": {"envParams": {"OPENR_ENABLED": "0"}}})", errorMsg));
+  auto md5Render = configHelper_.prepareNodeConfigRender(
+      "node-0", kSwVersion, kFwVersion, kHwBoardId, nullptr);
+  configHelper_.setLegacyConfigMd5Enabled(false);
+  auto hashRender = configHelper_.prepareNodeConfigRender(
+      "node-0", kSwVersion, kFwVersion, kHwBoardId, nullptr);
+  EXPECT_FALSE(hashRender.computeMd5);
+
+  std::vector<ConfigHelper::NodeConfigRender> renders = {
+      md5Render, hashRender};
+  folly::CPUThreadPoolExecutor executor(2);
+  ConfigHelper::renderNodeConfigs(renders, &executor);
+  ASSERT_TRUE(renders[1].rendered);
+  EXPECT_TRUE(renders[1].configJson.empty());
+  EXPECT_TRUE(renders[1].md5.empty());
+  EXPECT_FALSE(renders[0].md5.empty());
+  EXPECT_EQ(renders[0].hash, renders[1].hash);
+  EXPECT_EQ(renders[0].configObj, renders[1].configObj);
+
+  // The structural hash is independent of the serialized JSON
+  EXPECT_EQ(
+      StructuralHash::computeHash(
+          folly::parseJson(renders[0].configJson)),
+      renders[1].hash);
+}
+
+TEST_F(ConfigRenderTest, StaleRenderDiscarded) {
+  std::vector<ConfigHelper::NodeConfigRender> renders;
+  renders.push_back(configHelper_.prepareNodeConfigRender(
+      "node-0", kSwVersion, kFwVersion, kHwBoardId, nullptr));
+
+  // Network overrides change while rendering
+  std::string errorMsg;
+  ASSERT_TRUE(configHelper_.setNewNetworkOverrides(
+      R"({"sysParams": {"managedConfig": true}})", errorMsg));
+  ConfigHelper::renderNodeConfigs(renders, nullptr);
+  ASSERT_TRUE(renders[0].rendered);
+  EXPECT_FALSE(renders[0].isManaged);
+  EXPECT_TRUE(configHelper_.setConfigStates(renders).empty());
+  EXPECT_FALSE(configHelper_.getConfigState("node-0").has_value());
+
+  auto configState = configHelper_.initConfigState(
+      "node-0", kSwVersion, kFwVersion, kHwBoardId);
+  ASSERT_TRUE(configState.has_value());
+  EXPECT_TRUE(configState->isManaged);
+}
+
+TEST_F(ConfigRenderTest, BaseLayersInvalidated) {
+  // Populate the base layers cache
+  configHelper_.buildNodeConfig(
+      std::nullopt,
+      kSwVersion,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt);
+
+  // Adding an exact base version match replaces the cached base layers
+  folly::dynamic baseConfig = folly::dynamic::object(
+      "envParams", folly::dynamic::object("OPENR_ENABLED", "0"));
+  ASSERT_TRUE(
+      configHelper_.addBaseConfig("RELEASE_M99", folly::toJson(baseConfig)));
+  auto nodeConfig = configHelper_.buildNodeConfig(
+      std::nullopt,
+      kSwVersion,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt);
+  EXPECT_EQ(baseConfig, nodeConfig);
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure how long one IgnitionApp::linkUpTimeoutExpired() tick holds the
+// topology read lock on a generated, mostly-ignited topology: a full search
+// with IgnitionAppUtil plus clean-ups that scan all links, versus
+// IgnitionPlanner. The parameter is the number of link status changes between
+// ticks (applied outside of the measured time).
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+#include "../IgnitionAppUtil.h"
+#include "../IgnitionPlanner.h"
+
+DEFINE_int32(num_nodes, 2000, "Number of nodes in the generated topology");
+DEFINE_int32(
+    num_offline_nodes, 40, "Number of offline nodes (with dead links)");
+
+using namespace facebook::terragraph;
+
+namespace {
+using LockedTopology = folly::Synchronized<TopologyWrapper>;
+
+const std::chrono::seconds kBfTimeout{15 + 1};
+const std::chrono::seconds kDampenInterval{10};
+const std::chrono::seconds kExtendedDampenInterval{300};
+const std::chrono::seconds kExtendedDampenFailureInterval{1800};
+const std::chrono::seconds kBackupCnLinkInterval{300};
+const std::chrono::seconds kP2mpAssocDelay{0};
+
+// IgnitionApp state carried across ticks
+struct IgnitionState {
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      linkToAttemptTs;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      linkToInitialAttemptTs;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      cnToPossibleIgnitionTs;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      initiatorToAttemptTs;
+  std::unordered_map<
+      std::string,
+      std::pair<std::chrono::steady_clock::time_point, std::string>>
+          radioToLinkUpTs;
+  std::unordered_map<std::string, size_t> linkupIterationIndex;
+};
+
+// Build a binary tree of DNs with one CN for every 10 nodes, where the last
+// 'num_offline_nodes' nodes (and the links to them) are down
+std::unique_ptr<LockedTopology>
+makeTopology() {
+  const int numCns = FLAGS_num_nodes / 10;
+  const int numDns = FLAGS_num_nodes - numCns;
+  std::vector<thrift::Node> nodes;
+  std::vector<thrift::Link> links;
+  std::vector<thrift::Site> sites;
+  for (int i = 0; i < FLAGS_num_nodes; i++) {
+    std::string siteName = folly::sformat("site-{}", i);
+    sites.push_back(createSite(siteName, 37.4 + 0.001 * i, -122.1, 10, 1));
+    const bool isOnline = i < FLAGS_num_nodes - FLAGS_num_offline_nodes;
+    const bool isCn = i >= numDns;
+    nodes.push_back(createNode(
+        folly::sformat("node-{}", i),
+        MacUtils::standardizeMac(folly::sformat(
+            "0:0:0:{:x}:{:x}:{:x}", i >> 16, (i >> 8) & 0xff, i & 0xff)),
+        siteName,
+        i == 0 /* popNode */,
+        !isOnline ? thrift::NodeStatusType::OFFLINE
+                  : isCn ? thrift::NodeStatusType::ONLINE
+                         : thrift::NodeStatusType::ONLINE_INITIATOR,
+        isCn ? thrift::NodeType::CN : thrift::NodeType::DN));
+    if (i > 0) {
+      const int parent = isCn ? (i - numDns) * 9 % numDns : (i - 1) / 2;
+      links.push_back(createLink(nodes[parent], nodes[i]));
+      links.back().is_alive = isOnline;
+    }
+  }
+  return std::make_unique<LockedTopology>(
+      std::in_place, createTopology(nodes, links, sites), "", false, false);
+}
+
+// Initialize IgnitionApp state as if all live links were ignited
+IgnitionState
+makeIgnitionState(const TopologyWrapper& topologyW) {
+  IgnitionState state;
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& link : topologyW.getAllLinksView()) {
+    if (link.is_alive) {
+      state.radioToLinkUpTs[link.a_node_mac] = std::make_pair(now, link.name);
+      state.radioToLinkUpTs[link.z_node_mac] = std::make_pair(now, link.name);
+    }
+  }
+  return state;
+}
+
+// Flip the status of 'numChanges' live links (and back on the next call)
+void
+applyStatusChanges(LockedTopology& topology, uint32_t numChanges) {
+  auto lockedTopologyW = topology.wlock();
+  const auto links = lockedTopologyW->getAllLinksView();
+  for (uint32_t i = 0; i < numChanges; i++) {
+    const auto& link = links[(i * 7919) % (links.size() / 2)];
+    lockedTopologyW->setLinkStatus(link.name, !link.is_alive);
+  }
+}
+
+// IgnitionApp clean-ups, scanning all links for each record
+void
+cleanUpByScan(const TopologyWrapper& topologyW, IgnitionState& state) {
+  for (auto it = state.linkToInitialAttemptTs.begin();
+       it != state.linkToInitialAttemptTs.end();) {
+    auto link = topologyW.getLinkPtr(it->first);
+    auto aNode = link ? topologyW.getNodePtr(link->a_node_name) : nullptr;
+    auto zNode = link ? topologyW.getNodePtr(link->z_node_name) : nullptr;
+    if (!aNode || !zNode ||
+        (aNode->status == thrift::NodeStatusType::OFFLINE &&
+         zNode->status == thrift::NodeStatusType::OFFLINE)) {
+      it = state.linkToInitialAttemptTs.erase(it);
+    } else {
+      it++;
+    }
+  }
+  for (auto it = state.cnToPossibleIgnitionTs.begin();
+       it != state.cnToPossibleIgnitionTs.end();) {
+    bool shouldErase = true;
+    topologyW.forEachLinkByNodeName(it->first, [&](const thrift::Link& link) {
+      if (link.is_alive) {
+        return false;
+      }
+      auto nbrNode = topologyW.getNbrNodePtr(it->first, link);
+      if (nbrNode &&
+          nbrNode->status == thrift::NodeStatusType::ONLINE_INITIATOR) {
+        shouldErase = false;
+        return false;
+      }
+      return true;
+    });
+    it = shouldErase ? state.cnToPossibleIgnitionTs.erase(it) : std::next(it);
+  }
+  for (auto it = state.radioToLinkUpTs.begin();
+       it != state.radioToLinkUpTs.end();) {
+    bool shouldErase = true;
+    topologyW.forEachLinkByRadioMac(it->first, [&](const thrift::Link& link) {
+      if (link.is_alive) {
+        shouldErase = false;
+        return false;
+      }
+      return true;
+    });
+    it = shouldErase ? state.radioToLinkUpTs.erase(it) : std::next(it);
+  }
+}
+} // namespace
+
+void
+FullSearchTick(uint32_t iters, uint32_t numChanges) {
+  std::unique_ptr<LockedTopology> topology;
+  IgnitionState state;
+  BENCHMARK_SUSPEND {
+    topology = makeTopology();
+    state = makeIgnitionState(*topology->rlock());
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    BENCHMARK_SUSPEND {
+      applyStatusChanges(*topology, numChanges);
+    }
+    auto lockedTopologyW = topology->rlock();
+    auto igCandidates = IgnitionAppUtil::findAllParallelIgnitionCandidates(
+        *lockedTopologyW,
+        state.linkToAttemptTs,
+        state.linkToInitialAttemptTs,
+        state.cnToPossibleIgnitionTs,
+        state.initiatorToAttemptTs,
+        state.radioToLinkUpTs,
+        kBfTimeout,
+        kDampenInterval,
+        kExtendedDampenInterval,
+        kExtendedDampenFailureInterval,
+        kBackupCnLinkInterval,
+        kP2mpAssocDelay,
+        state.linkupIterationIndex);
+    cleanUpByScan(*lockedTopologyW, state);
+    folly::doNotOptimizeAway(igCandidates);
+  }
+}
+
+void
+PlannerTick(uint32_t iters, uint32_t numChanges) {
+  std::unique_ptr<LockedTopology> topology;
+  IgnitionState state;
+  IgnitionPlanner planner;
+  BENCHMARK_SUSPEND {
+    topology = makeTopology();
+    state = makeIgnitionState(*topology->rlock());
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    BENCHMARK_SUSPEND {
+      applyStatusChanges(*topology, numChanges);
+    }
+    auto lockedTopologyW = topology->rlock();
+    planner.update(*lockedTopologyW);
+    auto igCandidates = planner.findAllParallelIgnitionCandidates(
+        *lockedTopologyW,
+        state.linkToAttemptTs,
+        state.linkToInitialAttemptTs,
+        state.cnToPossibleIgnitionTs,
+        state.initiatorToAttemptTs,
+        state.radioToLinkUpTs,
+        kBfTimeout,
+        kDampenInterval,
+        kExtendedDampenInterval,
+        kExtendedDampenFailureInterval,
+        kBackupCnLinkInterval,
+        kP2mpAssocDelay,
+        state.linkupIterationIndex);
+    planner.cleanUpInitialLinkUpAttempts(
+        *lockedTopologyW, state.linkToInitialAttemptTs);
+    planner.cleanUpCnLinkUpAttempts(
+        *lockedTopologyW, state.cnToPossibleIgnitionTs);
+    planner.cleanUpRadioLinkUpRecords(*lockedTopologyW, state.radioToLinkUpTs);
+    folly::doNotOptimizeAway(igCandidates);
+  }
+}
+
+BENCHMARK_PARAM(FullSearchTick, 0)
+BENCHMARK_RELATIVE_PARAM(PlannerTick, 0)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(FullSearchTick, 10)
+BENCHMARK_RELATIVE_PARAM(PlannerTick, 10)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
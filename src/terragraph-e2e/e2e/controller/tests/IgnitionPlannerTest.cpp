@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <folly/init/Init.h>
+
+#include "../IgnitionAppUtil.h"
+#include "../IgnitionPlanner.h"
+
+#include <e2e/common/TestUtils.h>
+
+using namespace facebook::terragraph;
+
+namespace {
+  std::chrono::seconds kBfTimeout{15 + 1};
+  std::chrono::seconds kBackupCnLinkInterval{300};
+  std::chrono::seconds kP2mpAssocDelay{0};
+
+  // Return all ignition candidates (sorted) from IgnitionAppUtil and from the
+  // planner
+  std::pair<
+      std::vector<thrift::IgnitionCandidate>,
+      std::vector<thrift::IgnitionCandidate>>
+  findAllIgnitionCandidates(
+      const TopologyWrapper& topologyW, IgnitionPlanner& planner) {
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+        cnToPossibleIgnitionTs;  // unused here
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+        initiatorToAttemptTs;  // unused here
+    std::unordered_map<
+        std::string,
+        std::pair<std::chrono::steady_clock::time_point, std::string>>
+            radioToLinkUpTs;  // unused here
+    std::unordered_map<std::string, size_t> linkIterationIndex;  // unused here
+    auto expected = IgnitionAppUtil::findAllIgnitionCandidates(
+        topologyW,
+        cnToPossibleIgnitionTs,
+        initiatorToAttemptTs,
+        radioToLinkUpTs,
+        kBfTimeout,
+        kBackupCnLinkInterval,
+        kP2mpAssocDelay,
+        linkIterationIndex);
+    planner.update(topologyW);
+    auto actual = planner.findAllIgnitionCandidates(
+        topologyW,
+        cnToPossibleIgnitionTs,
+        initiatorToAttemptTs,
+        radioToLinkUpTs,
+        kBfTimeout,
+        kBackupCnLinkInterval,
+        kP2mpAssocDelay,
+        linkIterationIndex);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    return std::make_pair(expected, actual);
+  }
+
+  // Bring up the given links and the nodes on the other end
+  void
+  igniteAll(
+      TopologyWrapper& topologyW,
+      const std::vector<thrift::IgnitionCandidate>& igCandidates) {
+    for (const auto& igCandidate : igCandidates) {
+      topologyW.setLinkStatus(igCandidate.linkName, true);
+      auto nbrNode = topologyW.getNbrNode(
+          igCandidate.initiatorNodeName, *topologyW.getLink(
+              igCandidate.linkName));
+      topologyW.setNodeStatus(
+          nbrNode->name,
+          nbrNode->node_type == thrift::NodeType::CN
+              ? thrift::NodeStatusType::ONLINE
+              : thrift::NodeStatusType::ONLINE_INITIATOR);
+    }
+  }
+}
+
+// 7 node topology (node-6 is a CN)
+//
+// node-0 (pop) ----- node-2 ----- node-4 ----- node-6
+//    |                              |
+// node-1 (pop) ----- node-3 ------- |
+//                      |
+//                    node-5
+TEST(IgnitionPlannerTest, MatchesFullSearch) {
+  auto topology = createTopology(
+      7,
+      {0, 1},
+      {{0, 1}, {0, 2}, {1, 3}, {2, 4}, {3, 4}, {3, 5}, {4, 6}},
+      0,
+      {},
+      {6});
+  TopologyWrapper topologyW(topology, "", false);
+  IgnitionPlanner planner;
+
+  // ignite the network one hop at a time
+  size_t numRounds = 0;
+  while (true) {
+    auto result = findAllIgnitionCandidates(topologyW, planner);
+    EXPECT_EQ(result.first, result.second);
+    if (result.second.empty()) {
+      break;
+    }
+    igniteAll(topologyW, result.second);
+    numRounds++;
+  }
+  EXPECT_EQ(3, numRounds);
+  EXPECT_EQ(0, planner.getFrontierSize());
+
+  // take down a node and its links
+  topologyW.setNodeStatus("node-3", thrift::NodeStatusType::OFFLINE);
+  for (const auto& link : topologyW.getLinksByNodeName("node-3")) {
+    topologyW.setLinkStatus(link.name, false);
+  }
+  auto result = findAllIgnitionCandidates(topologyW, planner);
+  EXPECT_EQ(result.first, result.second);
+  EXPECT_EQ(3, planner.getFrontierSize());  // node-1, node-4, node-5
+
+  // take down the CN link
+  topologyW.setLinkStatus("link-node-4-node-6", false);
+  result = findAllIgnitionCandidates(topologyW, planner);
+  EXPECT_EQ(result.first, result.second);
+  EXPECT_EQ(4, result.second.size());
+}
+
+TEST(IgnitionPlannerTest, StructuralChange) {
+  auto topology = createTopology(3, {0}, {{0, 1}, {0, 2}});
+  TopologyWrapper topologyW(topology, "", false);
+  IgnitionPlanner planner;
+
+  auto result = findAllIgnitionCandidates(topologyW, planner);
+  EXPECT_EQ(2, result.second.size());
+  EXPECT_EQ(result.first, result.second);
+
+  // link IDs change after deleting a link, so the frontier must be rebuilt
+  topologyW.delLink("node-0", "node-1", false);
+  result = findAllIgnitionCandidates(topologyW, planner);
+  ASSERT_EQ(1, result.second.size());
+  EXPECT_EQ("link-node-0-node-2", result.second[0].linkName);
+  EXPECT_EQ(result.first, result.second);
+
+  // status change after a structural change
+  topologyW.setLinkStatus("link-node-0-node-2", true);
+  result = findAllIgnitionCandidates(topologyW, planner);
+  EXPECT_TRUE(result.second.empty());
+  EXPECT_EQ(result.first, result.second);
+}
+
+TEST(IgnitionPlannerTest, CleanUp) {
+  auto topology = createTopology(
+      4, {0}, {{0, 1}, {0, 2}, {1, 3}}, 0, {}, {2, 3});
+  TopologyWrapper topologyW(topology, "", false);
+  topologyW.setLinkStatus("link-node-0-node-1", true);
+  topologyW.setNodeStatus("node-1", thrift::NodeStatusType::ONLINE);
+  IgnitionPlanner planner;
+  planner.update(topologyW);
+
+  auto now = std::chrono::steady_clock::now();
+  const auto link01 = *topologyW.getLink("link-node-0-node-1");
+  const auto link02 = *topologyW.getLink("link-node-0-node-2");
+  const auto link13 = *topologyW.getLink("link-node-1-node-3");
+
+  // node-1 and node-3 are both offline
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      linkToInitialAttemptTs = {
+          {link01.name, now}, {link13.name, now}, {"link-x-y", now}};
+  topologyW.setNodeStatus("node-1", thrift::NodeStatusType::OFFLINE);
+  planner.update(topologyW);
+  planner.cleanUpInitialLinkUpAttempts(topologyW, linkToInitialAttemptTs);
+  EXPECT_EQ(1, linkToInitialAttemptTs.size());
+  EXPECT_EQ(1, linkToInitialAttemptTs.count(link01.name));
+
+  // node-3's only initiator (node-1) is offline
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      cnToPossibleIgnitionTs = {{"node-2", now}, {"node-3", now}};
+  planner.cleanUpCnLinkUpAttempts(topologyW, cnToPossibleIgnitionTs);
+  EXPECT_EQ(1, cnToPossibleIgnitionTs.size());
+  EXPECT_EQ(1, cnToPossibleIgnitionTs.count("node-2"));
+
+  // only link-node-0-node-1 is alive
+  std::unordered_map<
+      std::string,
+      std::pair<std::chrono::steady_clock::time_point, std::string>>
+          radioToLinkUpTs = {
+              {link01.a_node_mac, {now, link01.name}},
+              {link02.z_node_mac, {now, link02.name}},
+              {link13.z_node_mac, {now, link13.name}}};
+  planner.cleanUpRadioLinkUpRecords(topologyW, radioToLinkUpTs);
+  EXPECT_EQ(1, radioToLinkUpTs.size());
+  EXPECT_EQ(1, radioToLinkUpTs.count(link01.a_node_mac));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -5,9 +5,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include <folly/Format.h>
 #include <folly/init/Init.h>
 
 #include "../SharedObjects.h"
@@ -204,6 +207,109 @@ TEST_F(CtrlStatusFixture, StatusAppFirstStatusReport) {
   EXPECT_EQ(node1, setNodeParamsReq.nodeMac);
 }
 
+TEST_F(CtrlStatusFixture, StatusAppIncrementalStatusDump) {
+  auto topoAppSock = createAppSock(E2EConsts::kTopologyAppCtrlId);
+  SCOPE_EXIT { topoAppSock.close(); };
+  string querySockId = "querier";
+  auto querySock = createAppSock(querySockId);
+  SCOPE_EXIT { querySock.close(); };
+
+  // query the StatusApp, optionally since a given generation
+  auto getStatusDump = [&](std::optional<int64_t> sinceGeneration) {
+    thrift::GetStatusDump getStatusDump;
+    if (sinceGeneration) {
+      getStatusDump.sinceGeneration_ref() = sinceGeneration.value();
+    }
+    thrift::Message msg;
+    msg.mType = thrift::MessageType::GET_STATUS_DUMP;
+    msg.value = fbzmq::util::writeThriftObjStr(getStatusDump, serializer_);
+    sendInCtrlApp(
+        querySock,
+        "",
+        E2EConsts::kStatusAppCtrlId,
+        querySockId,
+        msg,
+        serializer_);
+    string minion, senderApp;
+    std::tie(minion, senderApp, msg) = recvInCtrlApp(querySock, serializer_);
+    EXPECT_EQ(thrift::MessageType::STATUS_DUMP, msg.mType);
+    return fbzmq::util::readThriftObjStr<thrift::StatusDump>(
+        msg.value, serializer_);
+  };
+
+  // send a status report from a mock minion
+  std::string node1 = "1:1:1:1:1:1";
+  std::string node2 = "2:2:2:2:2:2";
+  auto minionSock1 = createMinionSock(node1);
+  SCOPE_EXIT { minionSock1.close(); };
+  auto minionSock2 = createMinionSock(node2);
+  SCOPE_EXIT { minionSock2.close(); };
+  auto sendStatusReport = [&](auto& minionSock,
+                              const std::string& configMd5,
+                              const std::vector<std::string>& neighbors = {}) {
+    thrift::StatusReport statusReport;
+    statusReport.version = "asdf";
+    statusReport.configMd5 = configMd5;
+    if (!neighbors.empty()) {
+      statusReport.neighborConnectionStatus_ref() =
+          std::unordered_map<std::string, bool>();
+      for (const auto& neighbor : neighbors) {
+        statusReport.neighborConnectionStatus_ref()->emplace(neighbor, true);
+      }
+    }
+    thrift::Message msg;
+    msg.mType = thrift::MessageType::STATUS_REPORT;
+    msg.value = fbzmq::util::writeThriftObjStr(statusReport, serializer_);
+    sendInMinionBroker(
+        minionSock,
+        E2EConsts::kStatusAppCtrlId,
+        E2EConsts::kStatusAppMinionId,
+        msg,
+        serializer_);
+  };
+  std::vector<std::string> neighbors;
+  for (int i = 0; i < 32; i++) {
+    neighbors.push_back(folly::sformat("3:3:3:3:3:{:x}", i));
+  }
+  sendStatusReport(minionSock1, "a", neighbors);
+  sendStatusReport(minionSock2, "a");
+  sleep(1);
+
+  // full dump
+  auto statusDump = getStatusDump(std::nullopt);
+  EXPECT_EQ(2, statusDump.statusReports.size());
+  EXPECT_FALSE(statusDump.incremental_ref().value());
+  ASSERT_TRUE(statusDump.generation_ref().has_value());
+  int64_t generation = statusDump.generation_ref().value();
+
+  // nothing changed (timestamps and map ordering are ignored)
+  std::reverse(neighbors.begin(), neighbors.end());
+  sendStatusReport(minionSock1, "a", neighbors);
+  sleep(1);
+  statusDump = getStatusDump(generation);
+  EXPECT_TRUE(statusDump.incremental_ref().value());
+  EXPECT_EQ(0, statusDump.statusReports.size());
+  EXPECT_EQ(0, statusDump.removedNodes_ref().value().size());
+  EXPECT_EQ(generation, statusDump.generation_ref().value());
+
+  // one node changed, one node removed
+  sendStatusReport(minionSock1, "b");
+  sleep(1);
+  SharedObjects::getStatusReports()->wlock()->erase(node2);
+  statusDump = getStatusDump(generation);
+  EXPECT_TRUE(statusDump.incremental_ref().value());
+  ASSERT_EQ(1, statusDump.statusReports.size());
+  EXPECT_EQ("b", statusDump.statusReports.at(node1).configMd5);
+  EXPECT_EQ(
+      std::vector<std::string>{node2}, statusDump.removedNodes_ref().value());
+  EXPECT_GT(statusDump.generation_ref().value(), generation);
+
+  // unknown generation (e.g. from before a controller restart)
+  statusDump = getStatusDump(1);
+  EXPECT_FALSE(statusDump.incremental_ref().value());
+  EXPECT_EQ(1, statusDump.statusReports.size());
+}
+
 int
 main(int argc, char* argv[]) {
   folly::init(&argc, &argv);
@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TopologyJournal.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+#include <stdio.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <time.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "e2e/common/JsonUtils.h"
+#include "e2e/common/Md5Utils.h"
+
+namespace {
+// suffix of the journal file (appended to the snapshot file name)
+const std::string kJournalFileSuffix{".journal"};
+
+// key of the snapshot MD5 in the journal header
+const std::string kSnapshotMd5Key{"snapshotMd5"};
+
+// suffix of a new journal file that is not yet in place
+const std::string kNewJournalFileSuffix{".new"};
+
+// delay before retrying a failed snapshot
+const std::chrono::seconds kSnapshotRetryInterval{30};
+
+// Replace the entity named 'key', or append it if none exists
+template <class T>
+void
+upsertByName(std::vector<T>& entities, const std::string& key, T entity) {
+  auto it = std::find_if(entities.begin(), entities.end(), [&](const T& e) {
+    return e.name == key;
+  });
+  if (it != entities.end()) {
+    *it = std::move(entity);
+  } else {
+    entities.push_back(std::move(entity));
+  }
+}
+
+// Erase the entity named 'name' (if any)
+template <class T>
+void
+eraseByName(std::vector<T>& entities, const std::string& name) {
+  entities.erase(
+      std::remove_if(
+          entities.begin(),
+          entities.end(),
+          [&](const T& e) { return e.name == name; }),
+      entities.end());
+}
+
+// Deserialize the "value" of a journal record
+template <class T>
+T
+deserializeValue(const folly::dynamic& obj) {
+  apache::thrift::SimpleJSONSerializer jsonSerializer;
+  return jsonSerializer.deserialize<T>(folly::toJson(obj.at("value")));
+}
+
+std::string
+getTimestamp() {
+  time_t currentTime;
+  struct tm localTime;
+  time(&currentTime);
+  localtime_r(&currentTime, &localTime);
+  char buf[50];
+  strftime(buf, sizeof(buf), "%Y%m%d%H%M%S", &localTime);
+  return std::string(buf);
+}
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+
+TopologyJournal::TopologyJournal(
+    const thrift::Topology& topology,
+    const std::string& snapshotFile,
+    const std::string& tsFilePrefix,
+    size_t maxRecords,
+    std::chrono::seconds snapshotInterval)
+    : snapshotFile_(snapshotFile),
+      journalFile_(getJournalFile(snapshotFile)),
+      tsFilePrefix_(tsFilePrefix),
+      maxRecords_(maxRecords),
+      snapshotInterval_(snapshotInterval),
+      topology_(topology) {
+  writeSnapshot();
+  thread_ = std::thread([this]() { run(); });
+}
+
+TopologyJournal::~TopologyJournal() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queueCv_.notify_one();
+  thread_.join();
+}
+
+std::string
+TopologyJournal::getJournalFile(const std::string& snapshotFile) {
+  return snapshotFile + kJournalFileSuffix;
+}
+
+size_t
+TopologyJournal::replay(
+    const std::string& snapshotFile,
+    const std::string& snapshotContents,
+    thrift::Topology& topology) {
+  const std::string journalFile = getJournalFile(snapshotFile);
+  std::string contents;
+  if (!folly::readFile(journalFile.c_str(), contents)) {
+    return 0;  // no journal
+  }
+
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+
+  // Only apply records written on top of this snapshot
+  std::string snapshotMd5;
+  try {
+    snapshotMd5 = folly::parseJson(lines[0]).at(kSnapshotMd5Key).asString();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Invalid topology journal header in " << journalFile << ": "
+               << folly::exceptionStr(ex);
+    return 0;
+  }
+  if (snapshotMd5 != Md5Utils::computeMd5(snapshotContents)) {
+    LOG(WARNING) << "Ignoring topology journal " << journalFile
+                 << " written for a different snapshot of " << snapshotFile;
+    return 0;
+  }
+
+  size_t count = 0;
+  for (size_t i = 1; i < lines.size(); i++) {
+    if (lines[i].empty()) {
+      continue;
+    }
+    try {
+      apply(deserialize(lines[i].str()), topology);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Stopping topology journal replay at line " << (i + 1)
+                 << " of " << journalFile << ": " << folly::exceptionStr(ex);
+      break;
+    }
+    count++;
+  }
+  LOG(INFO) << "Replayed " << count << " topology change(s) from "
+            << journalFile;
+  return count;
+}
+
+void
+TopologyJournal::setName(const std::string& name) {
+  enqueue(Record{Op::SET_NAME, name, {}});
+}
+
+void
+TopologyJournal::setConfig(const thrift::Config& config) {
+  enqueue(Record{Op::SET_CONFIG, "", config});
+}
+
+void
+TopologyJournal::upsertNode(const std::string& key, const thrift::Node& node) {
+  enqueue(Record{Op::UPSERT_NODE, key, node});
+}
+
+void
+TopologyJournal::deleteNode(const std::string& name) {
+  enqueue(Record{Op::DELETE_NODE, name, {}});
+}
+
+void
+TopologyJournal::upsertLink(const std::string& key, const thrift::Link& link) {
+  enqueue(Record{Op::UPSERT_LINK, key, link});
+}
+
+void
+TopologyJournal::deleteLink(const std::string& name) {
+  enqueue(Record{Op::DELETE_LINK, name, {}});
+}
+
+void
+TopologyJournal::upsertSite(const std::string& key, const thrift::Site& site) {
+  enqueue(Record{Op::UPSERT_SITE, key, site});
+}
+
+void
+TopologyJournal::deleteSite(const std::string& name) {
+  enqueue(Record{Op::DELETE_SITE, name, {}});
+}
+
+void
+TopologyJournal::reset(const thrift::Topology& topology) {
+  enqueue(Record{Op::RESET, "", topology});
+}
+
+void
+TopologyJournal::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const uint64_t target = queuedCount_;
+  writtenCv_.wait(lock, [&]() { return writtenCount_ >= target; });
+}
+
+void
+TopologyJournal::apply(const Record& record, thrift::Topology& topology) {
+  switch (record.op) {
+    case Op::SET_NAME:
+      topology.name = record.key;
+      break;
+    case Op::SET_CONFIG:
+      topology.config = std::get<thrift::Config>(record.value);
+      break;
+    case Op::UPSERT_NODE:
+      upsertByName(
+          topology.nodes, record.key, std::get<thrift::Node>(record.value));
+      break;
+    case Op::DELETE_NODE:
+      eraseByName(topology.nodes, record.key);
+      break;
+    case Op::UPSERT_LINK:
+      upsertByName(
+          topology.links, record.key, std::get<thrift::Link>(record.value));
+      break;
+    case Op::DELETE_LINK:
+      eraseByName(topology.links, record.key);
+      break;
+    case Op::UPSERT_SITE:
+      upsertByName(
+          topology.sites, record.key, std::get<thrift::Site>(record.value));
+      break;
+    case Op::DELETE_SITE:
+      eraseByName(topology.sites, record.key);
+      break;
+    case Op::RESET:
+      topology = std::get<thrift::Topology>(record.value);
+      break;
+  }
+}
+
+std::string
+TopologyJournal::serialize(const Record& record) {
+  std::string op;
+  switch (record.op) {
+    case Op::SET_NAME:
+      op = "setName";
+      break;
+    case Op::SET_CONFIG:
+      op = "setConfig";
+      break;
+    case Op::UPSERT_NODE:
+      op = "upsertNode";
+      break;
+    case Op::DELETE_NODE:
+      op = "deleteNode";
+      break;
+    case Op::UPSERT_LINK:
+      op = "upsertLink";
+      break;
+    case Op::DELETE_LINK:
+      op = "deleteLink";
+      break;
+    case Op::UPSERT_SITE:
+      op = "upsertSite";
+      break;
+    case Op::DELETE_SITE:
+      op = "deleteSite";
+      break;
+    case Op::RESET:
+      op = "reset";
+      break;
+  }
+
+  folly::dynamic obj = folly::dynamic::object("op", op)("key", record.key);
+  std::visit(
+      [&obj](const auto& value) {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (!std::is_same_v<T, std::monostate>) {
+          apache::thrift::SimpleJSONSerializer jsonSerializer;
+          std::string contents;
+          jsonSerializer.serialize(value, &contents);
+          obj["value"] = folly::parseJson(contents);
+        }
+      },
+      record.value);
+  return folly::toJson(obj);
+}
+
+TopologyJournal::Record
+TopologyJournal::deserialize(const std::string& line) {
+  static const std::unordered_map<std::string, Op> kOps{
+      {"setName", Op::SET_NAME},
+      {"setConfig", Op::SET_CONFIG},
+      {"upsertNode", Op::UPSERT_NODE},
+      {"deleteNode", Op::DELETE_NODE},
+      {"upsertLink", Op::UPSERT_LINK},
+      {"deleteLink", Op::DELETE_LINK},
+      {"upsertSite", Op::UPSERT_SITE},
+      {"deleteSite", Op::DELETE_SITE},
+      {"reset", Op::RESET},
+  };
+
+  folly::dynamic obj = folly::parseJson(line);
+  const std::string op = obj.at("op").asString();
+  auto iter = kOps.find(op);
+  if (iter == kOps.end()) {
+    throw std::invalid_argument("Unknown record type: " + op);
+  }
+
+  Record record{iter->second, obj.at("key").asString(), {}};
+  switch (record.op) {
+    case Op::SET_CONFIG:
+      record.value = deserializeValue<thrift::Config>(obj);
+      break;
+    case Op::UPSERT_NODE:
+      record.value = deserializeValue<thrift::Node>(obj);
+      break;
+    case Op::UPSERT_LINK:
+      record.value = deserializeValue<thrift::Link>(obj);
+      break;
+    case Op::UPSERT_SITE:
+      record.value = deserializeValue<thrift::Site>(obj);
+      break;
+    case Op::RESET:
+      record.value = deserializeValue<thrift::Topology>(obj);
+      break;
+    default:
+      break;
+  }
+  return record;
+}
+
+void
+TopologyJournal::enqueue(Record&& record) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(record));
+    queuedCount_++;
+  }
+  queueCv_.notify_one();
+}
+
+void
+TopologyJournal::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty() && !stop_) {
+      // Wake up in time to compact the oldest journal record
+      if (journalRecords_ > 0) {
+        queueCv_.wait_until(lock, getSnapshotDeadline());
+      } else {
+        queueCv_.wait(lock);
+      }
+    }
+
+    std::deque<Record> records;
+    records.swap(queue_);
+    const bool stop = stop_;
+    lock.unlock();
+
+    write(records);
+    if (stop && journalRecords_ > 0) {
+      writeSnapshot();
+    }
+
+    lock.lock();
+    writtenCount_ += records.size();
+    writtenCv_.notify_all();
+    if (stop && queue_.empty()) {
+      return;
+    }
+  }
+}
+
+void
+TopologyJournal::write(std::deque<Record>& records) {
+  std::string data;
+  for (auto& record : records) {
+    // A reset supersedes everything before it
+    if (record.op == Op::RESET) {
+      topology_ = std::move(std::get<thrift::Topology>(record.value));
+      if (writeSnapshot()) {
+        data.clear();
+        continue;
+      }
+      // Keep the reset in the current journal instead
+      record.value = topology_;
+    }
+
+    try {
+      data += serialize(record);
+      data += '\n';
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Could not serialize topology journal record: "
+                 << folly::exceptionStr(ex);
+      continue;
+    }
+    apply(record, topology_);
+    if (journalRecords_++ == 0) {
+      journalStartTime_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  if (!data.empty() && journal_ &&
+      folly::writeFull(journal_.fd(), data.data(), data.size()) < 0) {
+    LOG(ERROR) << "Could not write to file " << journalFile_ << ": "
+               << folly::errnoStr(errno);
+  }
+
+  if (journalRecords_ > 0 &&
+      std::chrono::steady_clock::now() >= getSnapshotDeadline()) {
+    writeSnapshot();
+  }
+}
+
+std::chrono::steady_clock::time_point
+TopologyJournal::getSnapshotDeadline() const {
+  auto deadline = journalRecords_ >= maxRecords_
+                      ? std::chrono::steady_clock::time_point()
+                      : journalStartTime_ + snapshotInterval_;
+  return std::max(deadline, snapshotRetryTime_);
+}
+
+bool
+TopologyJournal::writeSnapshot() {
+  // Until this succeeds, keep appending to the current journal
+  snapshotRetryTime_ =
+      std::chrono::steady_clock::now() + kSnapshotRetryInterval;
+
+  std::string contents;
+  apache::thrift::SimpleJSONSerializer jsonSerializer;
+  try {
+    jsonSerializer.serialize(topology_, &contents);
+    contents = JsonUtils::toSortedPrettyJson(contents);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Could not serialize topology " << folly::exceptionStr(ex);
+    return false;
+  }
+
+  if (!tsFilePrefix_.empty()) {
+    const std::string tsFileName =
+        folly::sformat("{}-{}.conf", tsFilePrefix_, getTimestamp());
+    if (!folly::writeFile(contents, tsFileName.c_str())) {
+      LOG(ERROR) << "Could not write to file " << tsFileName;
+    }
+  }
+
+  // Prepare the new journal before replacing the snapshot, so that any
+  // failure leaves the old snapshot and journal in place
+  const std::string newJournalFile = journalFile_ + kNewJournalFileSuffix;
+  const std::string header =
+      folly::toJson(folly::dynamic::object(
+          kSnapshotMd5Key, Md5Utils::computeMd5(contents))) +
+      "\n";
+  if (int err = folly::writeFileAtomicNoThrow(newJournalFile, header)) {
+    LOG(ERROR) << "Could not write to file " << newJournalFile << ": "
+               << folly::errnoStr(err);
+    return false;
+  }
+  folly::File newJournal;
+  try {
+    newJournal = folly::File(newJournalFile, O_WRONLY | O_APPEND);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Could not open " << newJournalFile << ": "
+               << folly::exceptionStr(ex);
+    unlink(newJournalFile.c_str());
+    return false;
+  }
+
+  // Replace the snapshot before the journal: if we stop in between, the old
+  // journal no longer matches the snapshot and is ignored
+  if (int err = folly::writeFileAtomicNoThrow(snapshotFile_, contents)) {
+    LOG(ERROR) << "Could not write to file " << snapshotFile_ << ": "
+               << folly::errnoStr(err);
+    unlink(newJournalFile.c_str());
+    return false;
+  }
+  if (rename(newJournalFile.c_str(), journalFile_.c_str()) != 0) {
+    // The old journal is ignored on replay now, and records appended to the
+    // new one are not replayed until the next snapshot moves it into place
+    PLOG(ERROR) << "Could not rename " << newJournalFile << " to "
+                << journalFile_;
+  }
+  journal_ = std::move(newJournal);
+  journalRecords_ = 0;
+  snapshotRetryTime_ = std::chrono::steady_clock::time_point();
+  return true;
+}
+
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <variant>
+
+#include <folly/File.h>
+
+#include "e2e/if/gen-cpp2/Topology_types.h"
+
+namespace facebook {
+namespace terragraph {
+
+/**
+ * Persists topology changes as an append-only journal of entity-level
+ * records, periodically compacted into a full topology snapshot.
+ *
+ * Records are queued by the caller (copying only the changed node, link, or
+ * site) and written by a background thread, which also applies them to its
+ * own copy of the topology. Once enough records accumulate, or the oldest
+ * record reaches a maximum age, that copy is written as the new snapshot
+ * (plus a timestamped copy) and the journal is truncated.
+ *
+ * The journal file is "<snapshotFile>.journal". Its first line holds the MD5
+ * of the snapshot it applies to, so a journal left behind by a different
+ * snapshot (e.g. if the topology file was replaced) is ignored by replay().
+ *
+ * Upserts are keyed by the entity's name before the change, so renames
+ * replace the entity in place. Node/link status is only persisted as of the
+ * last record touching that entity.
+ */
+class TopologyJournal {
+ public:
+  /**
+   * Start a journal on top of a snapshot of the given topology.
+   *
+   * The snapshot is written to 'snapshotFile' (replacing any existing journal)
+   * before this returns. If 'tsFilePrefix' is non-empty, each snapshot is also
+   * written to "<tsFilePrefix>-<timestamp>.conf".
+   */
+  TopologyJournal(
+      const thrift::Topology& topology,
+      const std::string& snapshotFile,
+      const std::string& tsFilePrefix,
+      size_t maxRecords,
+      std::chrono::seconds snapshotInterval);
+
+  /** Write all queued records and a final snapshot, then stop. */
+  ~TopologyJournal();
+
+  /** \{ */
+  TopologyJournal(const TopologyJournal&) = delete;
+  TopologyJournal& operator=(const TopologyJournal&) = delete;
+  /** \} */
+
+  /** Returns the journal file for the given snapshot file. */
+  static std::string getJournalFile(const std::string& snapshotFile);
+
+  /**
+   * Apply the journal for 'snapshotFile' to 'topology', which must have been
+   * deserialized from 'snapshotContents' (the raw snapshot file contents).
+   *
+   * Stops at the first unreadable record (e.g. one partially written before a
+   * crash). Returns the number of records applied.
+   */
+  static size_t replay(
+      const std::string& snapshotFile,
+      const std::string& snapshotContents,
+      thrift::Topology& topology);
+
+  /** \{ Queue a change to the topology. */
+  void setName(const std::string& name);
+  void setConfig(const thrift::Config& config);
+  void upsertNode(const std::string& key, const thrift::Node& node);
+  void deleteNode(const std::string& name);
+  void upsertLink(const std::string& key, const thrift::Link& link);
+  void deleteLink(const std::string& name);
+  void upsertSite(const std::string& key, const thrift::Site& site);
+  void deleteSite(const std::string& name);
+  /** \} */
+
+  /** Replace the whole topology and write a new snapshot. */
+  void reset(const thrift::Topology& topology);
+
+  /** Block until all records queued so far are written. */
+  void flush();
+
+ private:
+  /** Record types. */
+  enum class Op {
+    SET_NAME,
+    SET_CONFIG,
+    UPSERT_NODE,
+    DELETE_NODE,
+    UPSERT_LINK,
+    DELETE_LINK,
+    UPSERT_SITE,
+    DELETE_SITE,
+    RESET,
+  };
+
+  /** A single topology change. */
+  struct Record {
+    Op op;
+    /** Name of the changed entity (or the new topology name). */
+    std::string key;
+    std::variant<
+        std::monostate,
+        thrift::Config,
+        thrift::Node,
+        thrift::Link,
+        thrift::Site,
+        thrift::Topology>
+        value;
+  };
+
+  /** Apply the given record to 'topology'. */
+  static void apply(const Record& record, thrift::Topology& topology);
+
+  /** Serialize the given record as a single line (without newline). */
+  static std::string serialize(const Record& record);
+
+  /** Deserialize a record written by serialize(). Throws on error. */
+  static Record deserialize(const std::string& line);
+
+  /** Queue a record for the writer thread. */
+  void enqueue(Record&& record);
+
+  /** Writer thread loop. */
+  void run();
+
+  /** Apply and append the given records, then compact if needed. */
+  void write(std::deque<Record>& records);
+
+  /**
+   * Write topology_ as the new snapshot and start a new journal.
+   *
+   * On failure, the previous snapshot and journal are kept (and appended to),
+   * and compaction is not retried for a while.
+   */
+  bool writeSnapshot();
+
+  /** Returns the time at which the journal should next be compacted. */
+  std::chrono::steady_clock::time_point getSnapshotDeadline() const;
+
+  /** Snapshot file. */
+  const std::string snapshotFile_;
+
+  /** Journal file. */
+  const std::string journalFile_;
+
+  /** Prefix for timestamped snapshot files (or empty). */
+  const std::string tsFilePrefix_;
+
+  /** Number of journal records that triggers a snapshot. */
+  const size_t maxRecords_;
+
+  /** Maximum age of a journal record before a snapshot is written. */
+  const std::chrono::seconds snapshotInterval_;
+
+  // -- Writer thread state -- //
+
+  /** The topology as of the last written record. */
+  thrift::Topology topology_;
+
+  /** The open journal file. */
+  folly::File journal_;
+
+  /** Number of records in the journal file. */
+  size_t journalRecords_{0};
+
+  /** Time at which the oldest record in the journal file was written. */
+  std::chrono::steady_clock::time_point journalStartTime_;
+
+  /** Don't retry a failed snapshot before this time. */
+  std::chrono::steady_clock::time_point snapshotRetryTime_;
+
+  // -- Shared state (protected by mutex_) -- //
+
+  /** Protects the fields below. */
+  std::mutex mutex_;
+
+  /** Signaled when records are queued or the journal is stopping. */
+  std::condition_variable queueCv_;
+
+  /** Signaled when records are written. */
+  std::condition_variable writtenCv_;
+
+  /** Records not yet picked up by the writer thread. */
+  std::deque<Record> queue_;
+
+  /** Total number of records queued. */
+  uint64_t queuedCount_{0};
+
+  /** Total number of records written. */
+  uint64_t writtenCount_{0};
+
+  /** Whether the writer thread should exit. */
+  bool stop_{false};
+
+  /** Writer thread (started last). */
+  std::thread thread_;
+};
+
+} // namespace terragraph
+} // namespace facebook
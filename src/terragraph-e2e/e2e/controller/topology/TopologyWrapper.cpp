@@ -12,12 +12,23 @@
 #include <folly/FileUtil.h>
 #include <folly/String.h>
 #include <folly/gen/Base.h>
+#include <gflags/gflags.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
-#include <time.h>
 
 #include "e2e/common/JsonUtils.h"
 #include "e2e/common/MacUtils.h"
 
+DEFINE_int32(
+    topology_journal_max_records,
+    1000,
+    "Number of journaled topology changes after which the topology file is "
+    "rewritten");
+DEFINE_int32(
+    topology_snapshot_interval_s,
+    60,
+    "Maximum time (in seconds) a topology change stays in the journal before "
+    "the topology file is rewritten");
+
 using apache::thrift::detail::TEnumMapFactory;
 using std::invalid_argument;
 using std::string;
@@ -32,6 +43,9 @@ const string kTopoTsFilePrefix{"e2e_topology"};
 const int kMaxEthLenM{50};
 const int kMaxRfLenM{500};
 
+// maximum number of status changes retained for getStatusChangesSince()
+const size_t kMaxStatusChanges{4096};
+
 void
 createDir(const string& dir) {
   if (dir.empty()) {
@@ -123,6 +137,8 @@ TopologyWrapper::TopologyWrapper(
   if (createIntrasiteLinks_) {
     createSiteLinks(validateTopology);
   }
+
+  startJournal();
 }
 
 TopologyWrapper::TopologyWrapper(
@@ -136,6 +152,7 @@ TopologyWrapper::TopologyWrapper(
   // Read topology file from disk
   string contents;
   readTopologyFile(topologyFile, topology_, contents);
+  TopologyJournal::replay(topologyFile, contents, topology_);
   try {
     contents = JsonUtils::toSortedPrettyJson(contents);
   } catch (const std::exception&ex) {
@@ -161,20 +178,88 @@ TopologyWrapper::TopologyWrapper(
   }
 
   // Write a timestamped file immediately
-  writeToTsFile();
+  startJournal();
 }
 
 void
 TopologyWrapper::setTopology(const thrift::Topology& topology) {
+  // The controller republishes the whole topology on every node/link status
+  // change, so apply only the status changes when nothing else changed
+  if (applyStatusChanges(topology)) {
+    return;
+  }
+
+  markStructureChanged();
   topology_ = topology;
   populateMaps(false /* validate */);
+
+  if (journal_) {
+    journal_->reset(topology_);
+  }
 }
 
 void
 TopologyWrapper::setTopologyFromFile(const string& topologyFile) {
+  markStructureChanged();
   string contents;
   readTopologyFile(topologyFile, topology_, contents);
+  TopologyJournal::replay(topologyFile, contents, topology_);
   populateMaps(false /* validate */);
+
+  if (journal_) {
+    journal_->reset(topology_);
+  }
+}
+
+bool
+TopologyWrapper::applyStatusChanges(const thrift::Topology& topology) {
+  if (topology.name != topology_.name ||
+      topology.nodes.size() != topology_.nodes.size() ||
+      topology.links.size() != topology_.links.size() ||
+      topology.sites != topology_.sites) {
+    return false;
+  }
+
+  // Compare everything except the fields modified by the controller
+  for (size_t i = 0; i < topology.nodes.size(); i++) {
+    auto& node = topology_.nodes[i];
+    const auto status = node.status;
+    node.status = topology.nodes[i].status;
+    const bool isSame = node == topology.nodes[i];
+    node.status = status;
+    if (!isSame) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < topology.links.size(); i++) {
+    auto& link = topology_.links[i];
+    const auto isAlive = link.is_alive;
+    const auto linkupAttempts = link.linkup_attempts;
+    link.is_alive = topology.links[i].is_alive;
+    link.linkup_attempts = topology.links[i].linkup_attempts;
+    const bool isSame = link == topology.links[i];
+    link.is_alive = isAlive;
+    link.linkup_attempts = linkupAttempts;
+    if (!isSame) {
+      return false;
+    }
+  }
+
+  markChanged();
+  if (topology_.config != topology.config) {
+    topology_.config = topology.config;
+    if (journal_) {
+      journal_->setConfig(topology_.config);
+    }
+  }
+  for (size_t i = 0; i < topology.nodes.size(); i++) {
+    setNodeStatus(topology_.nodes[i].name, topology.nodes[i].status);
+  }
+  for (size_t i = 0; i < topology.links.size(); i++) {
+    setLinkStatus(topology_.links[i].name, topology.links[i].is_alive);
+    topology_.links[i].linkup_attempts = topology.links[i].linkup_attempts;
+  }
+  return true;
 }
 
 void
@@ -586,7 +671,7 @@ TopologyWrapper::createSiteLinks(
       if (name2Link_.count(link.name)) {
         continue;  // already exists, skip
       }
-      addLink(link, false /* saveToFile */);
+      addLink(link);
       VLOG(1) << "Added intra-site link: " << link.name
               << " on site: " << node.site_name;
     }
@@ -675,6 +760,8 @@ TopologyWrapper::sanitizeState() {
   for (auto& node : topology_.nodes) {
     setNodeStatus(node.name, thrift::NodeStatusType::OFFLINE);
   }
+
+  markChanged();
 }
 
 bool
@@ -697,48 +784,35 @@ TopologyWrapper::writeToFile(const string& outputFile) const {
 
 void
 TopologyWrapper::writeToTsFile() const {
-  if (topologyDir_.empty() && topologyFile_.empty()) {
+  if (!journal_) {
     return;
   }
 
-  string contents;
-  apache::thrift::SimpleJSONSerializer jsonSerializer;
-  try {
-    jsonSerializer.serialize(topology_, &contents);
-    contents = JsonUtils::toSortedPrettyJson(contents);
-  } catch (const std::exception& ex) {
-    LOG(ERROR) << "Could not serialize topology " << folly::exceptionStr(ex);
+  journal_->reset(topology_);
+  journal_->flush();
+}
+
+void
+TopologyWrapper::startJournal() {
+  if (topologyDir_.empty() && topologyFile_.empty()) {
     return;
   }
 
-  time_t currentTime;
-  struct tm localTime;
-  time(&currentTime);
-  localtime_r(&currentTime, &localTime);
-  char buf[50];
-  strftime(buf, sizeof(buf), "%Y%m%d%H%M%S", &localTime);
-
-  const string tsFileName = folly::sformat(
-      "{}/{}-{}.conf",
-      topologyDir_.string(),
-      kTopoTsFilePrefix,
-      std::string(buf));
-
-  const string backupTopologyFile =
+  const string snapshotFile =
       topologyFile_.empty()
           ? folly::sformat(
                 "{}/{}.conf", topologyDir_.string(), kTopoTsFilePrefix)
           : topologyFile_;
-
-  if (!folly::writeFile(contents, tsFileName.c_str())) {
-    LOG(ERROR) << "Could not write to file " << tsFileName;
-    return;
-  }
-
-  if (!folly::writeFile(contents, backupTopologyFile.c_str())) {
-    LOG(ERROR) << "Could not write to file " << topologyFile_;
-    return;
-  }
+  const string tsFilePrefix =
+      topologyDir_.empty()
+          ? ""
+          : folly::sformat("{}/{}", topologyDir_.string(), kTopoTsFilePrefix);
+  journal_ = std::make_unique<TopologyJournal>(
+      topology_,
+      snapshotFile,
+      tsFilePrefix,
+      FLAGS_topology_journal_max_records,
+      std::chrono::seconds(FLAGS_topology_snapshot_interval_s));
 }
 
 thrift::Topology
@@ -1034,10 +1108,13 @@ TopologyWrapper::getTopologyName() const {
 
 void
 TopologyWrapper::setTopologyName(const std::string& name) {
+  markChanged();
   topology_.name = name;
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->setName(name);
+  }
 }
 
 bool
@@ -1046,7 +1123,10 @@ TopologyWrapper::setLinkStatus(const string& linkName, bool alive) {
   if (it == name2Link_.end()) {
     return false;
   }
-  it->second->is_alive = alive;
+  if (it->second->is_alive != alive) {
+    it->second->is_alive = alive;
+    markStatusChanged({it->second->a_node_name, it->second->z_node_name});
+  }
   return true;
 }
 
@@ -1055,6 +1135,7 @@ TopologyWrapper::setNodeMacByName(
     const std::string& nodeName,
     const std::string& macAddr,
     const bool force) {
+  markStructureChanged();
   // standardize MAC addresses
   auto newMac = MacUtils::standardizeMac(macAddr);
 
@@ -1097,7 +1178,9 @@ TopologyWrapper::setNodeMacByName(
   mac2NodeName_[newMac] = nodeName;
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertNode(nodeName, *node);
+  }
 }
 
 void
@@ -1106,6 +1189,7 @@ TopologyWrapper::changeNodeWlanMac(
     const std::string& oldMacAddr,
     const std::string& newMacAddr,
     const bool force) {
+  markStructureChanged();
   // standardize MAC addresses
   auto oldMac = MacUtils::standardizeMac(oldMacAddr);
   auto newMac = MacUtils::standardizeMac(newMacAddr);
@@ -1152,13 +1236,16 @@ TopologyWrapper::changeNodeWlanMac(
   mac2NodeName_[newMac] = nodeName;
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertNode(nodeName, *node);
+  }
 }
 
 void
 TopologyWrapper::addNodeWlanMacs(
     const std::string& nodeName,
     const std::vector<std::string>& wlanMacAddrs) {
+  markStructureChanged();
   // check if node exists
   auto nameIt = name2Node_.find(nodeName);
   if (nameIt == name2Node_.end()) {
@@ -1195,7 +1282,9 @@ TopologyWrapper::addNodeWlanMacs(
   }
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertNode(nodeName, *node);
+  }
 }
 
 void
@@ -1203,6 +1292,7 @@ TopologyWrapper::deleteNodeWlanMacs(
     const std::string& nodeName,
     const std::vector<std::string>& wlanMacAddrs,
     const bool force) {
+  markStructureChanged();
   // check if node exists
   auto nameIt = name2Node_.find(nodeName);
   if (nameIt == name2Node_.end()) {
@@ -1265,8 +1355,10 @@ TopologyWrapper::deleteNodeWlanMacs(
     }
   }
 
-  // save the latest topology
-  writeToTsFile();
+  // save the latest topology (deleted links are saved by delLink())
+  if (journal_) {
+    journal_->upsertNode(nodeName, *node);
+  }
 }
 
 void
@@ -1275,6 +1367,7 @@ TopologyWrapper::updateLinksMacs(
     const std::string& oldMac,
     const std::string& newMac,
     const bool force) {
+  markStructureChanged();
 
   // find all affected links
   std::vector<std::size_t> affectedLinks;
@@ -1304,6 +1397,9 @@ TopologyWrapper::updateLinksMacs(
     } else {
       link.z_node_mac = newMac;
     }
+    if (journal_) {
+      journal_->upsertLink(link.name, link);
+    }
   }
 }
 
@@ -1334,6 +1430,7 @@ TopologyWrapper::plugNodeToSite(
 
 void
 TopologyWrapper::unplugNodeFromSite(const std::string& nodeName) {
+  markStructureChanged();
   auto it = name2Node_.find(nodeName);
   if (it == name2Node_.end()) {
     throw invalid_argument("Unplug node with invalid node name: " + nodeName);
@@ -1346,6 +1443,10 @@ TopologyWrapper::unplugNodeFromSite(const std::string& nodeName) {
 
   // empty site name
   it->second->site_name.clear();
+
+  if (journal_) {
+    journal_->upsertNode(nodeName, *it->second);
+  }
 }
 
 bool
@@ -1355,7 +1456,10 @@ TopologyWrapper::setNodeStatus(
   if (it == name2Node_.end()) {
     return false;
   }
-  it->second->status = status;
+  if (it->second->status != status) {
+    it->second->status = status;
+    markStatusChanged({nodeName});
+  }
   return true;
 }
 
@@ -1366,6 +1470,7 @@ TopologyWrapper::bumpLinkupAttempts(const string& linkName) {
     return false;
   }
   link->second->linkup_attempts++;
+  markChanged();
   return true;
 }
 
@@ -1376,11 +1481,13 @@ TopologyWrapper::resetLinkupAttempts(const string& linkName) {
     return false;
   }
   link->second->linkup_attempts = 0;
+  markChanged();
   return true;
 }
 
 void
 TopologyWrapper::addNode(thrift::Node& newNode) {
+  markStructureChanged();
   standardizeNodeMacs(newNode);
   validateNode(newNode);
   plugNodeToSite(newNode.name, newNode.site_name, true);
@@ -1400,7 +1507,9 @@ TopologyWrapper::addNode(thrift::Node& newNode) {
   }
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertNode(newNode.name, newNode);
+  }
 
   if (createIntrasiteLinks_) {
     createSiteLinks(true /* validate */, {newNode});
@@ -1410,6 +1519,7 @@ TopologyWrapper::addNode(thrift::Node& newNode) {
 void
 TopologyWrapper::delNode(
     const std::string& nodeName, const bool force) {
+  markStructureChanged();
   const auto it = name2Node_.find(nodeName);
   if (it == name2Node_.end()) {
     throw invalid_argument("Node `" + nodeName + "` does not exist");
@@ -1464,13 +1574,16 @@ TopologyWrapper::delNode(
   for (auto& node : topology_.nodes) {
     name2Node_[node.name] = &node;
   }
+
+  // save the latest topology (deleted links are saved by delLink())
+  if (journal_) {
+    journal_->deleteNode(nodeName);
+  }
+
   // delete all links associated with the node
   for (const auto& link : links) {
     delLink(link.a_node_name, link.z_node_name, true);
   }
-
-  // save the latest topology
-  writeToTsFile();
 }
 
 void
@@ -1486,6 +1599,7 @@ TopologyWrapper::updateLink(thrift::Link& link) {
 void
 TopologyWrapper::editNode(
     const std::string& nodeName, const thrift::Node& newNode) {
+  markStructureChanged();
   // check if node exists
   auto nodeIt = name2Node_.find(nodeName);
   if (nodeIt == name2Node_.end()) {
@@ -1588,6 +1702,9 @@ TopologyWrapper::editNode(
       }
       // fix a/z + name
       updateLink(*linkIt->second);
+      if (journal_) {
+        journal_->upsertLink(link.name, *linkIt->second);
+      }
       // update link in mapping
       name2Link_[linkIt->second->name] = linkIt->second;
       name2Link_.erase(linkIt);
@@ -1599,13 +1716,16 @@ TopologyWrapper::editNode(
     name2Node_.erase(nodeIt);
   }
 
-  // save the latest topology
-  writeToTsFile();
+  // save the latest topology (renamed links are saved above)
+  if (journal_) {
+    journal_->upsertNode(
+        nodeName, *name2Node_.at(hasNewName ? newNode.name : nodeName));
+  }
 }
 
 void
-TopologyWrapper::addLink(
-    thrift::Link& newLink, bool saveToFile) {
+TopologyWrapper::addLink(thrift::Link& newLink) {
+  markStructureChanged();
   standardizeLinkMacs(newLink);
   validateLink(newLink);
 
@@ -1617,8 +1737,8 @@ TopologyWrapper::addLink(
   }
 
   // save the latest topology
-  if (saveToFile) {
-    writeToTsFile();
+  if (journal_) {
+    journal_->upsertLink(newLink.name, newLink);
   }
 }
 
@@ -1627,6 +1747,7 @@ TopologyWrapper::delLink(
     const string& aNodeName,
     const string& zNodeName,
     const bool force) {
+  markStructureChanged();
   const auto linkName = buildLinkName(aNodeName, zNodeName);
 
   const auto it = name2Link_.find(linkName);
@@ -1656,11 +1777,14 @@ TopologyWrapper::delLink(
   }
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->deleteLink(linkName);
+  }
 }
 
 void
 TopologyWrapper::addSite(const thrift::Site& newSite) {
+  markStructureChanged();
   validateSite(newSite);
 
   topology_.sites.push_back(newSite);
@@ -1671,11 +1795,14 @@ TopologyWrapper::addSite(const thrift::Site& newSite) {
   }
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertSite(newSite.name, newSite);
+  }
 }
 
 void
 TopologyWrapper::delSite(const std::string& siteName) {
+  markStructureChanged();
   const auto it = name2Site_.find(siteName);
   if (it == name2Site_.end()) {
     throw invalid_argument("Site `" + siteName + "` does not exist");
@@ -1701,12 +1828,15 @@ TopologyWrapper::delSite(const std::string& siteName) {
   }
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->deleteSite(siteName);
+  }
 }
 
 void
 TopologyWrapper::editSite(
     const std::string& siteName, const thrift::Site& newSite) {
+  markStructureChanged();
   // check if site exists
   const auto name2SiteIt = name2Site_.find(siteName);
   if (name2SiteIt == name2Site_.end()) {
@@ -1762,6 +1892,9 @@ TopologyWrapper::editSite(
         if (nodeIt != name2Node_.end()) {
           auto node = nodeIt->second;
           node->site_name = newSite.name;
+          if (journal_) {
+            journal_->upsertNode(nodeName, *node);
+          }
         }
       }
       site2AssocNodes_[newSite.name] = site2AssocNodesIt->second;
@@ -1776,13 +1909,17 @@ TopologyWrapper::editSite(
     name2Site_.erase(name2SiteIt);
   }
 
-  // save the latest topology
-  writeToTsFile();
+  // save the latest topology (renamed nodes are saved above)
+  if (journal_) {
+    journal_->upsertSite(
+        siteName, *name2Site_.at(hasNewName ? newSite.name : siteName));
+  }
 }
 
 bool
 TopologyWrapper::setLocation(
     const std::string& mac, const thrift::Location& location) {
+  markStructureChanged();
   // validate if node exists, as mac is coming from minion
   auto node = getNodeByMac(mac);
   if (!node) {
@@ -1813,7 +1950,9 @@ TopologyWrapper::setLocation(
             << location.accuracy;
 
   // save the latest topology
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertSite(site->name, *site);
+  }
   return true;
 }
 
@@ -1821,6 +1960,7 @@ void
 TopologyWrapper::setNodePrefix(
     const std::string& nodeName,
     const std::optional<folly::CIDRNetwork> prefix) {
+  markStructureChanged();
   auto iter = name2Node_.find(nodeName);
   if (iter == name2Node_.end()) {
     throw std::invalid_argument(
@@ -1833,7 +1973,9 @@ TopologyWrapper::setNodePrefix(
   } else {
     node->prefix_ref().reset();
   }
-  writeToTsFile();
+  if (journal_) {
+    journal_->upsertNode(nodeName, *node);
+  }
 }
 
 std::optional<std::unordered_map<std::string, thrift::Zone>>
@@ -1851,10 +1993,13 @@ TopologyWrapper::getPrefixAllocZones() const {
 void
 TopologyWrapper::setPrefixZones(
     std::unordered_map<std::string, thrift::Zone>& zones) {
+  markChanged();
   thrift::DeterministicPrefixAllocParams dpaParams;
   dpaParams.zones_ref() = zones;
   topology_.config.deterministic_prefix_alloc_params_ref() = dpaParams;
-  writeToTsFile();
+  if (journal_) {
+    journal_->setConfig(topology_.config);
+  }
 }
 
 std::unordered_map<std::string, std::string>
@@ -1878,5 +2023,153 @@ TopologyWrapper::getControllerPrefixAllocScheme() const {
   return controllerPrefixAlloc_;
 }
 
+folly::Range<const thrift::Node*>
+TopologyWrapper::getAllNodesView() const {
+  return folly::range(topology_.nodes);
+}
+
+folly::Range<const thrift::Link*>
+TopologyWrapper::getAllLinksView() const {
+  return folly::range(topology_.links);
+}
+
+folly::Range<const thrift::Site*>
+TopologyWrapper::getAllSitesView() const {
+  return folly::range(topology_.sites);
+}
+
+const thrift::Node*
+TopologyWrapper::getNodePtr(const std::string& nodeName) const {
+  auto it = name2Node_.find(nodeName);
+  return it != name2Node_.end() ? it->second : nullptr;
+}
+
+const thrift::Link*
+TopologyWrapper::getLinkPtr(const std::string& linkName) const {
+  auto it = name2Link_.find(linkName);
+  return it != name2Link_.end() ? it->second : nullptr;
+}
+
+const thrift::Site*
+TopologyWrapper::getSitePtr(const std::string& siteName) const {
+  auto it = name2Site_.find(siteName);
+  return it != name2Site_.end() ? it->second : nullptr;
+}
+
+const thrift::Node*
+TopologyWrapper::getNodePtrByMac(const std::string& nodeMac) const {
+  // MACs are usually already in standard format, so try that first
+  auto it = mac2NodeName_.find(nodeMac);
+  if (it != mac2NodeName_.end()) {
+    return getNodePtr(it->second);
+  }
+  auto nodeName = getNodeNameByMac(nodeMac);
+  return nodeName ? getNodePtr(*nodeName) : nullptr;
+}
+
+const thrift::Node*
+TopologyWrapper::getNbrNodePtr(
+    const std::string& myNodeName, const thrift::Link& link) const {
+  if (link.z_node_name == myNodeName) {
+    return getNodePtr(link.a_node_name);
+  }
+  if (link.a_node_name == myNodeName) {
+    return getNodePtr(link.z_node_name);
+  }
+  return nullptr;
+}
+
+std::optional<TopologyWrapper::NodeId>
+TopologyWrapper::getNodeId(const std::string& nodeName) const {
+  auto it = name2Node_.find(nodeName);
+  if (it == name2Node_.end()) {
+    return std::nullopt;
+  }
+  return it->second - topology_.nodes.data();
+}
+
+std::optional<TopologyWrapper::LinkId>
+TopologyWrapper::getLinkId(const std::string& linkName) const {
+  auto it = name2Link_.find(linkName);
+  if (it == name2Link_.end()) {
+    return std::nullopt;
+  }
+  return it->second - topology_.links.data();
+}
+
+std::optional<TopologyWrapper::SiteId>
+TopologyWrapper::getSiteId(const std::string& siteName) const {
+  auto it = name2Site_.find(siteName);
+  if (it == name2Site_.end()) {
+    return std::nullopt;
+  }
+  return it->second - topology_.sites.data();
+}
+
+const thrift::Node&
+TopologyWrapper::getNodeById(NodeId nodeId) const {
+  return topology_.nodes.at(nodeId);
+}
+
+const thrift::Link&
+TopologyWrapper::getLinkById(LinkId linkId) const {
+  return topology_.links.at(linkId);
+}
+
+const thrift::Site&
+TopologyWrapper::getSiteById(SiteId siteId) const {
+  return topology_.sites.at(siteId);
+}
+
+uint64_t
+TopologyWrapper::getVersion() const {
+  return version_;
+}
+
+uint64_t
+TopologyWrapper::getStructureVersion() const {
+  return structureVersion_;
+}
+
+std::optional<std::unordered_set<std::string>>
+TopologyWrapper::getStatusChangesSince(uint64_t version) const {
+  if (version < structureVersion_ || version < droppedStatusChangeVersion_) {
+    return std::nullopt;
+  }
+
+  std::unordered_set<std::string> nodeNames;
+  for (auto it = statusChanges_.rbegin();
+       it != statusChanges_.rend() && it->first > version;
+       ++it) {
+    nodeNames.insert(it->second);
+  }
+  return nodeNames;
+}
+
+void
+TopologyWrapper::markChanged() {
+  version_++;
+}
+
+void
+TopologyWrapper::markStructureChanged() {
+  version_++;
+  structureVersion_ = version_;
+  statusChanges_.clear();
+}
+
+void
+TopologyWrapper::markStatusChanged(
+    std::initializer_list<std::string> nodeNames) {
+  version_++;
+  for (const auto& nodeName : nodeNames) {
+    statusChanges_.emplace_back(version_, nodeName);
+  }
+  while (statusChanges_.size() > kMaxStatusChanges) {
+    droppedStatusChangeVersion_ = statusChanges_.front().first;
+    statusChanges_.pop_front();
+  }
+}
+
 } // namespace terragraph
 } // namespace facebook
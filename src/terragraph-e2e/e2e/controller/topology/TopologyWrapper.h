@@ -7,12 +7,19 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <optional>
+
 #include <folly/IPAddress.h>
+#include <folly/Range.h>
 #include <folly/experimental/io/FsUtil.h>
 
 #include "e2e/if/gen-cpp2/Controller_types.h"
 #include "e2e/if/gen-cpp2/Topology_types.h"
 
+#include "TopologyJournal.h"
+
 namespace facebook {
 namespace terragraph {
 
@@ -52,7 +59,8 @@ class TopologyWrapper {
   /**
    * Construct TopologyWrapper from the given Thrift topology object.
    *
-   * The topology file will be saved in 'topologyDir'.
+   * If 'topologyDir' is non-empty, the topology will be saved there and all
+   * subsequent changes will be journaled (see writeToTsFile()).
    *
    * If 'validateTopology' is false, the topology will not be validated
    * (which may cause runtime exceptions for invalid topologies).
@@ -64,9 +72,12 @@ class TopologyWrapper {
       const bool createIntrasiteLinks = false);
 
   /**
-   * Construct TopologyWrapper from the given topology file.
+   * Construct TopologyWrapper from the given topology file, applying any
+   * changes journaled since it was last written.
    *
-   * The topology file will be saved in 'topologyDir'.
+   * The topology will be saved back to 'topologyFile' (with timestamped copies
+   * in 'topologyDir'), and all subsequent changes will be journaled (see
+   * writeToTsFile()).
    */
   explicit TopologyWrapper(
       const std::string& topologyFile,
@@ -111,22 +122,27 @@ class TopologyWrapper {
   bool writeToFile(const std::string& outputFile) const;
 
   /**
-   * Write the current topology into a timestamped file under topologyDir_.
+   * Write the current topology to the topology file (and a timestamped copy
+   * under topologyDir_), blocking until it is written.
    *
-   * This is called automatically in all add/delete/update functions.
+   * All add/delete/update functions instead record only the changed entities
+   * in a TopologyJournal, which is written in the background and periodically
+   * compacted into a new topology file. Status changes alone are not saved.
    */
   void writeToTsFile() const;
 
   /**
    * Completely replace the current topology with the given struct.
    *
-   * This will not perform any validation.
+   * This will not perform any validation. If only node/link status changed,
+   * this counts as status changes rather than a structural change (see
+   * getStructureVersion()).
    */
   void setTopology(const thrift::Topology& topology);
 
   /**
    * Completely replace the current topology by reading a new struct from the
-   * given file.
+   * given file, applying any changes journaled since it was last written.
    *
    * This will not perform any validation.
    */
@@ -301,6 +317,156 @@ class TopologyWrapper {
    */
   ControllerPrefixAllocScheme getControllerPrefixAllocScheme() const;
 
+  // --------------------- //
+  //  Reference accessors  //
+  // --------------------- //
+
+  // These return pointers/views into the topology itself instead of copies,
+  // and should be preferred in loops over large topologies (especially while
+  // holding the lock around the shared TopologyWrapper).
+  //
+  // All returned pointers, views, and IDs are only valid while that lock is
+  // held, and are invalidated by any SET method or setTopology*().
+
+  /** Index of a node in getAllNodesView(). */
+  using NodeId = size_t;
+  /** Index of a link in getAllLinksView(). */
+  using LinkId = size_t;
+  /** Index of a site in getAllSitesView(). */
+  using SiteId = size_t;
+
+  /** Returns a view of all nodes in the topology. */
+  folly::Range<const thrift::Node*> getAllNodesView() const;
+
+  /** Returns a view of all links in the topology. */
+  folly::Range<const thrift::Link*> getAllLinksView() const;
+
+  /** Returns a view of all sites in the topology. */
+  folly::Range<const thrift::Site*> getAllSitesView() const;
+
+  /** Returns the node with the given name, or nullptr if it does not exist. */
+  const thrift::Node* getNodePtr(const std::string& nodeName) const;
+
+  /** Returns the link with the given name, or nullptr if it does not exist. */
+  const thrift::Link* getLinkPtr(const std::string& linkName) const;
+
+  /** Returns the site with the given name, or nullptr if it does not exist. */
+  const thrift::Site* getSitePtr(const std::string& siteName) const;
+
+  /**
+   * Returns the node with the given MAC address (node ID or radio MAC, in any
+   * format accepted by folly::MacAddress), or nullptr if it does not exist.
+   */
+  const thrift::Node* getNodePtrByMac(const std::string& nodeMac) const;
+
+  /**
+   * Returns the node on the other end of the given link, or nullptr if the
+   * origin node is not on the link or the neighbor does not exist.
+   */
+  const thrift::Node* getNbrNodePtr(
+      const std::string& myNodeName, const thrift::Link& link) const;
+
+  /** Returns the ID of the given node, or std::nullopt if it does not exist. */
+  std::optional<NodeId> getNodeId(const std::string& nodeName) const;
+
+  /** Returns the ID of the given link, or std::nullopt if it does not exist. */
+  std::optional<LinkId> getLinkId(const std::string& linkName) const;
+
+  /** Returns the ID of the given site, or std::nullopt if it does not exist. */
+  std::optional<SiteId> getSiteId(const std::string& siteName) const;
+
+  /**
+   * Returns the node with the given ID.
+   *
+   * Throws std::out_of_range if the ID is invalid.
+   */
+  const thrift::Node& getNodeById(NodeId nodeId) const;
+
+  /**
+   * Returns the link with the given ID.
+   *
+   * Throws std::out_of_range if the ID is invalid.
+   */
+  const thrift::Link& getLinkById(LinkId linkId) const;
+
+  /**
+   * Returns the site with the given ID.
+   *
+   * Throws std::out_of_range if the ID is invalid.
+   */
+  const thrift::Site& getSiteById(SiteId siteId) const;
+
+  /**
+   * Invoke 'fn' on all links in the topology to or from the given node (in the
+   * same order as getLinksByNodeName()).
+   *
+   * 'fn' takes a `const thrift::Link&` and returns false to stop iterating.
+   */
+  template <typename Fn>
+  void
+  forEachLinkByNodeName(const std::string& nodeName, Fn&& fn) const {
+    for (const auto& link : topology_.links) {
+      if ((link.a_node_name == nodeName || link.z_node_name == nodeName) &&
+          !fn(link)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Invoke 'fn' on all links in the topology to or from the given radio MAC
+   * address (which must be non-empty), in the same order as
+   * getLinksByRadioMac().
+   *
+   * 'fn' takes a `const thrift::Link&` and returns false to stop iterating.
+   */
+  template <typename Fn>
+  void
+  forEachLinkByRadioMac(const std::string& radioMac, Fn&& fn) const {
+    if (radioMac.empty()) {
+      return;
+    }
+    for (const auto& link : topology_.links) {
+      if ((link.a_node_mac == radioMac || link.z_node_mac == radioMac) &&
+          !fn(link)) {
+        return;
+      }
+    }
+  }
+
+  // ----------------- //
+  //  Change tracking  //
+  // ----------------- //
+
+  /**
+   * Returns the topology version, which is incremented by every SET method
+   * and setTopology*() that changes the topology.
+   *
+   * Callers can use this to skip recomputing state derived from the topology.
+   */
+  uint64_t getVersion() const;
+
+  /**
+   * Returns the topology version at the last structural change, i.e. any
+   * change to nodes, links, or sites other than their status and link-up
+   * attempts (e.g. adding, removing, or editing them, or changing MACs).
+   *
+   * As an exception to the rule above, pointers, views, and IDs returned by
+   * the reference accessors stay valid as long as this is unchanged.
+   */
+  uint64_t getStructureVersion() const;
+
+  /**
+   * Returns the names of all nodes whose status changed, or which are an
+   * endpoint of a link whose status changed, after the given version.
+   *
+   * Returns std::nullopt if the topology structure changed after the given
+   * version, or if that change history is no longer retained; the caller
+   * must then rebuild any derived state from scratch.
+   */
+  std::optional<std::unordered_set<std::string>> getStatusChangesSince(
+      uint64_t version) const;
+
   // ------------- //
   //  SET methods  //
   // ------------- //
@@ -308,7 +474,7 @@ class TopologyWrapper {
   /**
    * Set the name of the topology.
    *
-   * This method will invoke writeToTsFile().
+   * Changes are journaled.
    */
   void setTopologyName(const std::string& name);
 
@@ -329,7 +495,7 @@ class TopologyWrapper {
    * MAC address did not change, MAC address belongs to other nodes) or if
    * the node is currently ignited and 'force' is false.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void setNodeMacByName(
       const std::string& nodeName,
@@ -346,7 +512,7 @@ class TopologyWrapper {
    * MAC address did not change, MAC address belongs to other nodes) or if
    * any affected link is currently alive and 'force' is false.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void changeNodeWlanMac(
       const std::string& nodeName,
@@ -360,7 +526,7 @@ class TopologyWrapper {
    * Throws std::invalid_argument if validation fails (e.g. node does not exist,
    * or MAC addresses belong to other nodes).
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void addNodeWlanMacs(
       const std::string& nodeName,
@@ -376,7 +542,7 @@ class TopologyWrapper {
    * MAC address does not belong to node, MAC address is associated with a
    * link).
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void deleteNodeWlanMacs(
       const std::string& nodeName,
@@ -385,9 +551,6 @@ class TopologyWrapper {
 
   /**
    * Update all links to replace one MAC with another.
-   *
-   * The caller of this method should invoke writeToTsFile() to save the
-   * topology.
    */
   void updateLinksMacs(
       const std::string& nodeName,
@@ -430,7 +593,7 @@ class TopologyWrapper {
    *
    * Throws various exceptions if validation fails.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void addNode(thrift::Node& newNode);
 
@@ -443,7 +606,7 @@ class TopologyWrapper {
    * Throws std::invalid_argument if validation fails, or if the node or any
    * associated links are still ignited and 'force' is false.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void delNode(const std::string& nodeName, const bool force);
 
@@ -455,7 +618,7 @@ class TopologyWrapper {
    *
    * Throws std::invalid_argument if validation fails.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void editNode(const std::string& nodeName, const thrift::Node& newNode);
 
@@ -466,9 +629,9 @@ class TopologyWrapper {
    *
    * Throws various exceptions if validation fails.
    *
-   * Will invoke writeToTsFile() if successful and 'saveToFile' is true.
+   * Changes are journaled upon success.
    */
-  void addLink(thrift::Link& newLink, bool saveToFile = true);
+  void addLink(thrift::Link& newLink);
 
   /**
    * Delete the given link from the topology.
@@ -479,7 +642,7 @@ class TopologyWrapper {
    * Throws std::invalid_argument if validation fails, or if the link is still
    * ignited and 'force' is false.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void delLink(
       const std::string& aNodename,
@@ -491,7 +654,7 @@ class TopologyWrapper {
    *
    * Throws std::invalid_argument if validation fails.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void addSite(const thrift::Site& newSite);
 
@@ -501,7 +664,7 @@ class TopologyWrapper {
    * Throws std::invalid_argument if validation fails (e.g. site is still
    * associated with nodes).
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void delSite(const std::string& siteName);
 
@@ -510,7 +673,7 @@ class TopologyWrapper {
    *
    * Throws std::invalid_argument if validation fails.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void editSite(const std::string& siteName, const thrift::Site& newSite);
 
@@ -528,7 +691,7 @@ class TopologyWrapper {
    *
    * Throws std::invalid_argument if nodeName is invalid.
    *
-   * This method will invoke writeToTsFile() upon success.
+   * Changes are journaled upon success.
    */
   void setNodePrefix(
       const std::string& nodeName,
@@ -537,7 +700,7 @@ class TopologyWrapper {
   /**
    * Overwrite the determinisitc_prefix_alloc_params zones.
    *
-   * This method will invoke writeToTsFile().
+   * Changes are journaled.
    */
   void setPrefixZones(std::unordered_map<std::string, thrift::Zone>& zones);
 
@@ -557,6 +720,13 @@ class TopologyWrapper {
       thrift::Topology& topology,
       std::string& contents);
 
+  /**
+   * If the given topology only differs from the current topology in node/link
+   * status and link-up attempts (and config), apply those changes in place and
+   * return true. Otherwise, return false without changing anything.
+   */
+  bool applyStatusChanges(const thrift::Topology& topology);
+
   /** Populate all internal map structures using the current topology. */
   void populateMaps(bool validate);
 
@@ -668,6 +838,18 @@ class TopologyWrapper {
       const std::string& nbrNodeName,
       const thrift::Link& newLink) const;
 
+  /**
+   * Record a change to the topology that does not affect its structure or
+   * any node/link status.
+   */
+  void markChanged();
+
+  /** Record a structural change to the topology (see getStructureVersion()). */
+  void markStructureChanged();
+
+  /** Record a status change of the given nodes (see getStatusChangesSince()). */
+  void markStatusChanged(std::initializer_list<std::string> nodeNames);
+
   /**
    * Create all intrasite ETHERNET links.
    *
@@ -675,6 +857,12 @@ class TopologyWrapper {
    */
   void createSiteLinks(bool validate, std::vector<thrift::Node> nodes = {});
 
+  /**
+   * Write the current topology and start journaling changes to it, if
+   * topologyFile_ or topologyDir_ is set.
+   */
+  void startJournal();
+
   /** The current working topology. */
   thrift::Topology topology_;
 
@@ -697,6 +885,9 @@ class TopologyWrapper {
   /** Directory to save timestamped topology file whenever topology changes. */
   const folly::fs::path topologyDir_;
 
+  /** Journal of changes to the topology (if saving to disk). */
+  std::unique_ptr<TopologyJournal> journal_;
+
   /** Whether any topology validation should be performed. */
   bool validateTopology_;
 
@@ -707,6 +898,21 @@ class TopologyWrapper {
   ControllerPrefixAllocScheme controllerPrefixAlloc_{
       ControllerPrefixAllocScheme::NONE};
 
+  /** Topology version (see getVersion()). */
+  uint64_t version_{0};
+
+  /** Topology version at the last structural change. */
+  uint64_t structureVersion_{0};
+
+  /**
+   * Recent status changes since the last structural change, as pairs of
+   * (topology version, node name) in increasing version order.
+   */
+  std::deque<std::pair<uint64_t, std::string>> statusChanges_;
+
+  /** Latest topology version dropped from the front of statusChanges_. */
+  uint64_t droppedStatusChangeVersion_{0};
+
 };
 
 } // namespace terragraph
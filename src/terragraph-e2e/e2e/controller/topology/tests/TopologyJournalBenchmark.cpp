@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure building a topology by adding its sites, nodes, and links one at a
+// time (as an API client or the topology builder would) when every change
+// rewrites the whole topology file, versus journaling only the changed entity
+// and compacting in the background. Rewriting is reproduced by calling
+// writeToFile() after each change, which is a lower bound on the previous
+// writeToTsFile() (which wrote two files). "Journal" times only the caller,
+// while "JournalDrained" also waits for the writer thread to finish. The
+// parameter is the number of nodes (with about as many links).
+
+#include <functional>
+#include <memory>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/experimental/io/FsUtil.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+#include "../TopologyWrapper.h"
+
+DEFINE_string(
+    topology_dir,
+    "/tmp/topology_journal_benchmark",
+    "Directory to write topology files to");
+
+using namespace facebook::terragraph;
+
+namespace {
+std::string
+getNodeMac(int nodeId) {
+  return MacUtils::standardizeMac(folly::sformat(
+      "0:0:0:{:x}:{:x}:{:x}",
+      nodeId >> 16,
+      (nodeId >> 8) & 0xff,
+      nodeId & 0xff));
+}
+
+// Add a chain of sites with two nodes each, wired within each site and linked
+// wirelessly to the next site, calling 'onChange' after every change
+void
+buildTopology(
+    TopologyWrapper& topologyW,
+    int numNodes,
+    const std::function<void()>& onChange) {
+  thrift::Node prevNode;
+  for (int i = 0; i < numNodes; i++) {
+    std::string siteName = folly::sformat("site-{}", i / 2);
+    if (i % 2 == 0) {
+      topologyW.addSite(
+          createSite(siteName, 37.4 + 0.0018 * (i / 2), -122.1, 10, 1));
+      onChange();
+    }
+    auto node = createNode(
+        folly::sformat("node-{:05d}", i), getNodeMac(i), siteName, i == 0);
+    topologyW.addNode(node);
+    onChange();
+    if (i > 0) {
+      auto link = createLink(prevNode, node);
+      if (i % 2 == 1) {
+        link.link_type = thrift::LinkType::ETHERNET;
+      }
+      topologyW.addLink(link);
+      onChange();
+    }
+    prevNode = node;
+  }
+}
+} // namespace
+
+void
+WriteFilePerChange(uint32_t iters, int numNodes) {
+  const std::string topologyFile = FLAGS_topology_dir + "/e2e_topology.conf";
+  for (uint32_t i = 0; i < iters; i++) {
+    std::unique_ptr<TopologyWrapper> topologyW;
+    BENCHMARK_SUSPEND {
+      folly::fs::create_directories(FLAGS_topology_dir);
+      topologyW =
+          std::make_unique<TopologyWrapper>(createTopology({}, {}, {}));
+    }
+    buildTopology(*topologyW, numNodes, [&]() {
+      topologyW->writeToFile(topologyFile);
+    });
+    BENCHMARK_SUSPEND {
+      topologyW.reset();
+      folly::fs::remove_all(FLAGS_topology_dir);
+    }
+  }
+}
+
+void
+Journal(uint32_t iters, int numNodes) {
+  for (uint32_t i = 0; i < iters; i++) {
+    std::unique_ptr<TopologyWrapper> topologyW;
+    BENCHMARK_SUSPEND {
+      topologyW = std::make_unique<TopologyWrapper>(
+          createTopology({}, {}, {}), FLAGS_topology_dir);
+    }
+    buildTopology(*topologyW, numNodes, []() {});
+    BENCHMARK_SUSPEND {
+      topologyW.reset();
+      folly::fs::remove_all(FLAGS_topology_dir);
+    }
+  }
+}
+
+void
+JournalDrained(uint32_t iters, int numNodes) {
+  for (uint32_t i = 0; i < iters; i++) {
+    std::unique_ptr<TopologyWrapper> topologyW;
+    BENCHMARK_SUSPEND {
+      topologyW = std::make_unique<TopologyWrapper>(
+          createTopology({}, {}, {}), FLAGS_topology_dir);
+    }
+    buildTopology(*topologyW, numNodes, []() {});
+    topologyW.reset();  // writes all records and a final snapshot
+    BENCHMARK_SUSPEND {
+      folly::fs::remove_all(FLAGS_topology_dir);
+    }
+  }
+}
+
+BENCHMARK_PARAM(WriteFilePerChange, 500)
+BENCHMARK_RELATIVE_PARAM(Journal, 500)
+BENCHMARK_RELATIVE_PARAM(JournalDrained, 500)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(WriteFilePerChange, 2000)
+BENCHMARK_RELATIVE_PARAM(Journal, 2000)
+BENCHMARK_RELATIVE_PARAM(JournalDrained, 2000)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "../TopologyJournal.h"
+#include "../TopologyWrapper.h"
+
+#include <folly/FileUtil.h>
+#include <folly/IPAddress.h>
+#include <folly/experimental/io/FsUtil.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <e2e/common/TestUtils.h>
+
+using namespace facebook::terragraph;
+
+namespace {
+const std::string kTopologyDir{"/tmp/topology_journal_test"};
+const std::string kSnapshotFile{kTopologyDir + "/e2e_topology.conf"};
+const std::string kCrashFile{kTopologyDir + "/crash.conf"};
+const std::chrono::seconds kSnapshotInterval{3600};
+
+std::string
+readFile(const std::string& file) {
+  std::string contents;
+  EXPECT_TRUE(folly::readFile(file.c_str(), contents));
+  return contents;
+}
+
+thrift::Topology
+readTopology(const std::string& file) {
+  apache::thrift::SimpleJSONSerializer jsonSerializer;
+  return jsonSerializer.deserialize<thrift::Topology>(readFile(file));
+}
+
+// Copy the snapshot and journal as they are now, as if the controller had
+// stopped without writing a final snapshot
+void
+copyCrashImage() {
+  ASSERT_TRUE(folly::writeFile(readFile(kSnapshotFile), kCrashFile.c_str()));
+  ASSERT_TRUE(folly::writeFile(
+      readFile(TopologyJournal::getJournalFile(kSnapshotFile)),
+      TopologyJournal::getJournalFile(kCrashFile).c_str()));
+}
+} // namespace
+
+class TopologyJournalFixture : public ::testing::Test {
+ public:
+  void
+  SetUp() override {
+    folly::fs::remove_all(kTopologyDir);
+    folly::fs::create_directories(kTopologyDir);
+
+    site1 = createSite("site-1", 37.4, -122.1, 10, 1);
+    site2 = createSite("site-2", 37.4018, -122.1, 10, 1);
+    node1 = createNode("node-1", "00:00:00:00:00:01", "site-1", true);
+    node2 = createNode("node-2", "00:00:00:00:00:02", "site-1");
+    node3 = createNode("node-3", "00:00:00:00:00:03", "site-2");
+  }
+
+  void
+  TearDown() override {
+    folly::fs::remove_all(kTopologyDir);
+  }
+
+  thrift::Site site1;
+  thrift::Site site2;
+  thrift::Node node1;
+  thrift::Node node2;
+  thrift::Node node3;
+};
+
+TEST_F(TopologyJournalFixture, Replay) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1});
+  thrift::Topology expected = base;
+  {
+    TopologyJournal journal(base, kSnapshotFile, "", 1000, kSnapshotInterval);
+    journal.upsertSite(site2.name, site2);
+    journal.upsertNode(node2.name, node2);
+    auto renamedNode = node1;
+    renamedNode.name = "node-0";
+    journal.upsertNode(node1.name, renamedNode);
+    journal.setName("journal_test");
+    journal.deleteSite(site1.name);
+    journal.flush();
+
+    // Renamed entities keep their position
+    expected.name = "journal_test";
+    expected.nodes = {renamedNode, node2};
+    expected.sites = {site2};
+
+    // The snapshot is only rewritten on compaction
+    EXPECT_TRUE(base == readTopology(kSnapshotFile));
+    thrift::Topology topology = base;
+    EXPECT_EQ(
+        5,
+        TopologyJournal::replay(
+            kSnapshotFile, readFile(kSnapshotFile), topology));
+    EXPECT_TRUE(expected == topology);
+  }
+
+  // A final snapshot is written when stopping
+  EXPECT_TRUE(expected == readTopology(kSnapshotFile));
+  thrift::Topology topology = expected;
+  EXPECT_EQ(
+      0,
+      TopologyJournal::replay(
+          kSnapshotFile, readFile(kSnapshotFile), topology));
+  EXPECT_TRUE(expected == topology);
+}
+
+TEST_F(TopologyJournalFixture, Compaction) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1});
+  TopologyJournal journal(
+      base,
+      kSnapshotFile,
+      kTopologyDir + "/e2e_topology",
+      2 /* maxRecords */,
+      kSnapshotInterval);
+  journal.upsertSite(site2.name, site2);
+  journal.flush();
+  EXPECT_TRUE(base == readTopology(kSnapshotFile));
+
+  journal.upsertNode(node3.name, node3);
+  journal.flush();
+  const thrift::Topology expected =
+      createTopology({node1, node3}, {}, {site1, site2});
+  EXPECT_TRUE(expected == readTopology(kSnapshotFile));
+  thrift::Topology topology = expected;
+  EXPECT_EQ(
+      0,
+      TopologyJournal::replay(
+          kSnapshotFile, readFile(kSnapshotFile), topology));
+
+  // reset() writes a snapshot immediately
+  journal.reset(base);
+  journal.flush();
+  EXPECT_TRUE(base == readTopology(kSnapshotFile));
+}
+
+TEST_F(TopologyJournalFixture, FailedCompaction) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1});
+  {
+    TopologyJournal journal(
+        base, kSnapshotFile, "", 2 /* maxRecords */, kSnapshotInterval);
+
+    // Make the new journal unwritable
+    const std::string newJournalFile =
+        TopologyJournal::getJournalFile(kSnapshotFile) + ".new";
+    folly::fs::create_directories(newJournalFile);
+
+    // The old snapshot and journal are kept and still appended to
+    journal.upsertSite(site2.name, site2);
+    journal.upsertNode(node3.name, node3);
+    journal.flush();
+    EXPECT_TRUE(base == readTopology(kSnapshotFile));
+    thrift::Topology topology = base;
+    EXPECT_EQ(
+        2,
+        TopologyJournal::replay(
+            kSnapshotFile, readFile(kSnapshotFile), topology));
+    EXPECT_TRUE(
+        createTopology({node1, node3}, {}, {site1, site2}) == topology);
+
+    // A reset is journaled if its snapshot can't be written
+    journal.reset(base);
+    journal.flush();
+    topology = base;
+    EXPECT_EQ(
+        3,
+        TopologyJournal::replay(
+            kSnapshotFile, readFile(kSnapshotFile), topology));
+    EXPECT_TRUE(base == topology);
+
+    folly::fs::remove_all(newJournalFile);
+  }
+
+  // A final snapshot is written when stopping
+  EXPECT_TRUE(base == readTopology(kSnapshotFile));
+  thrift::Topology topology = base;
+  EXPECT_EQ(
+      0,
+      TopologyJournal::replay(
+          kSnapshotFile, readFile(kSnapshotFile), topology));
+}
+
+TEST_F(TopologyJournalFixture, InvalidJournal) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1});
+  TopologyJournal journal(base, kSnapshotFile, "", 1000, kSnapshotInterval);
+  journal.upsertNode(node2.name, node2);
+  journal.deleteNode(node1.name);
+  journal.flush();
+  copyCrashImage();
+
+  // Partially written record
+  const std::string journalFile = TopologyJournal::getJournalFile(kCrashFile);
+  ASSERT_TRUE(folly::writeFile(
+      readFile(journalFile) + R"({"op":"deleteNode","ke)",
+      journalFile.c_str()));
+  thrift::Topology topology = base;
+  EXPECT_EQ(
+      2, TopologyJournal::replay(kCrashFile, readFile(kCrashFile), topology));
+  EXPECT_TRUE(createTopology({node2}, {}, {site1}) == topology);
+
+  // Journal written for a different snapshot
+  topology = base;
+  EXPECT_EQ(
+      0,
+      TopologyJournal::replay(
+          kCrashFile, readFile(kCrashFile) + "\n", topology));
+  EXPECT_TRUE(base == topology);
+}
+
+TEST_F(TopologyJournalFixture, WrapperChanges) {
+  thrift::Topology expected;
+  {
+    TopologyWrapper topologyW(
+        createTopology({}, {}, {}), kTopologyDir, true /* validate */);
+    topologyW.addSite(site1);
+    topologyW.addSite(site2);
+    topologyW.addNode(node1);
+    topologyW.addNode(node2);
+    topologyW.addNode(node3);
+    auto wirelessLink = createLink(node1, node3);
+    topologyW.addLink(wirelessLink);
+    auto wiredLink = createLink(node1, node2);
+    wiredLink.link_type = thrift::LinkType::ETHERNET;
+    topologyW.addLink(wiredLink);
+    topologyW.setTopologyName("journal_test");
+
+    auto renamedNode = *topologyW.getNode(node3.name);
+    renamedNode.name = "node-4";
+    topologyW.editNode(node3.name, renamedNode);
+    auto renamedSite = site2;
+    renamedSite.name = "site-3";
+    topologyW.editSite(site2.name, renamedSite);
+    topologyW.changeNodeWlanMac(
+        node1.name, node1.mac_addr, "00:00:00:00:01:01", true /* force */);
+    topologyW.setNodePrefix(
+        node1.name, folly::IPAddress::createNetwork("face:b00c::/64"));
+    topologyW.delNode(node2.name, true /* force */);
+
+    expected = topologyW.getTopology();
+    EXPECT_EQ(2, expected.nodes.size());
+    EXPECT_EQ(1, expected.links.size());
+  }
+
+  // The final snapshot is built by replaying the journaled changes
+  EXPECT_TRUE(expected == readTopology(kSnapshotFile));
+}
+
+TEST_F(TopologyJournalFixture, WrapperConfigOnlyChange) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1});
+  thrift::Topology expected = base;
+  std::unordered_map<std::string, thrift::Zone> zones;
+  zones[site1.name].node_names.insert(node1.name);
+  thrift::DeterministicPrefixAllocParams dpaParams;
+  dpaParams.zones_ref() = zones;
+  expected.config.deterministic_prefix_alloc_params_ref() = dpaParams;
+  {
+    TopologyWrapper topologyW(base, kTopologyDir, true /* validate */);
+
+    // Replacing the topology with one that differs only in its config (e.g.
+    // from BinaryStar replication) keeps the fast path, which must still
+    // journal the config
+    topologyW.setTopology(expected);
+    EXPECT_TRUE(expected == topologyW.getTopology());
+  }
+  EXPECT_TRUE(expected == readTopology(kSnapshotFile));
+}
+
+TEST_F(TopologyJournalFixture, WrapperReplay) {
+  const thrift::Topology base = createTopology({node1}, {}, {site1, site2});
+  const auto link = createLink(node1, node3);
+  const thrift::Topology expected =
+      createTopology({node1, node3}, {link}, {site1, site2});
+  {
+    TopologyJournal journal(base, kSnapshotFile, "", 1000, kSnapshotInterval);
+    journal.upsertNode(node3.name, node3);
+    journal.upsertLink(link.name, link);
+    journal.flush();
+    copyCrashImage();
+  }
+
+  // Journaled changes are applied on startup, and compacted right away
+  TopologyWrapper topologyW(kCrashFile);
+  EXPECT_TRUE(expected == topologyW.getTopology());
+  EXPECT_TRUE(expected == readTopology(kCrashFile));
+  thrift::Topology topology = expected;
+  EXPECT_EQ(
+      0, TopologyJournal::replay(kCrashFile, readFile(kCrashFile), topology));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
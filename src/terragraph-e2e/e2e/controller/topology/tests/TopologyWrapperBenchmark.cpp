@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure how long common controller read patterns hold the topology read
+// lock, using the copying TopologyWrapper getters versus the reference
+// accessors, on generated topologies of increasing size. Each iteration takes
+// and releases the (uncontended) lock once, so the time per iteration is the
+// lock hold time.
+
+#include <map>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <e2e/common/MacUtils.h>
+#include <e2e/common/TestUtils.h>
+
+#include "../TopologyWrapper.h"
+
+using namespace facebook::terragraph;
+
+namespace {
+using LockedTopology = folly::Synchronized<TopologyWrapper>;
+
+std::string
+getNodeMac(int nodeId) {
+  return MacUtils::standardizeMac(folly::sformat(
+      "0:0:0:{:x}:{:x}:{:x}",
+      nodeId >> 16,
+      (nodeId >> 8) & 0xff,
+      nodeId & 0xff));
+}
+
+// Build a chain of sites with two nodes each, wired within each site and
+// linked wirelessly to the next site
+LockedTopology&
+getTopology(int numNodes) {
+  static std::map<int, std::unique_ptr<LockedTopology>> topologies;
+  auto& topologyW = topologies[numNodes];
+  if (topologyW) {
+    return *topologyW;
+  }
+
+  std::vector<thrift::Node> nodes;
+  std::vector<thrift::Link> links;
+  std::vector<thrift::Site> sites;
+  for (int i = 0; i < numNodes; i++) {
+    std::string siteName = folly::sformat("site-{}", i / 2);
+    if (i % 2 == 0) {
+      sites.push_back(
+          createSite(siteName, 37.4 + 0.0018 * (i / 2), -122.1, 10, 1));
+    }
+    nodes.push_back(createNode(
+        folly::sformat("node-{}", i),
+        getNodeMac(i),
+        siteName,
+        i == 0 /* popNode */,
+        i % 3 ? thrift::NodeStatusType::ONLINE_INITIATOR
+              : thrift::NodeStatusType::OFFLINE));
+    if (i % 2 == 1) {
+      links.push_back(createLink(nodes[i - 1], nodes[i]));
+      links.back().link_type = thrift::LinkType::ETHERNET;
+    } else if (i > 0) {
+      links.push_back(createLink(nodes[i - 1], nodes[i]));
+    }
+  }
+  topologyW = std::make_unique<LockedTopology>(
+      std::in_place, createTopology(nodes, links, sites), "", false, false);
+  return *topologyW;
+}
+
+// StatusApp::processStatusReport(): find a node and its neighbors' MACs
+size_t
+statusReportCopy(const TopologyWrapper& topologyW, const std::string& mac) {
+  size_t count = 0;
+  auto node = topologyW.getNodeByMac(mac);
+  for (const auto& link : topologyW.getLinksByNodeName(node->name)) {
+    count += (link.a_node_name == node->name ? link.z_node_mac
+                                             : link.a_node_mac).size();
+  }
+  return count;
+}
+
+size_t
+statusReportRef(const TopologyWrapper& topologyW, const std::string& mac) {
+  size_t count = 0;
+  auto node = topologyW.getNodePtrByMac(mac);
+  topologyW.forEachLinkByNodeName(node->name, [&](const thrift::Link& link) {
+    count += (link.a_node_name == node->name ? link.z_node_mac
+                                             : link.a_node_mac).size();
+    return true;
+  });
+  return count;
+}
+
+// IgnitionApp: look up both ends of every link
+size_t
+linkEndsCopy(const TopologyWrapper& topologyW) {
+  size_t count = 0;
+  for (const auto& link : topologyW.getAllLinks()) {
+    auto aNode = topologyW.getNode(link.a_node_name);
+    auto zNode = topologyW.getNode(link.z_node_name);
+    if (aNode->status != thrift::NodeStatusType::OFFLINE &&
+        zNode->status != thrift::NodeStatusType::OFFLINE) {
+      count++;
+    }
+  }
+  return count;
+}
+
+size_t
+linkEndsRef(const TopologyWrapper& topologyW) {
+  size_t count = 0;
+  for (const auto& link : topologyW.getAllLinksView()) {
+    auto aNode = topologyW.getNodePtr(link.a_node_name);
+    auto zNode = topologyW.getNodePtr(link.z_node_name);
+    if (aNode->status != thrift::NodeStatusType::OFFLINE &&
+        zNode->status != thrift::NodeStatusType::OFFLINE) {
+      count++;
+    }
+  }
+  return count;
+}
+} // namespace
+
+void
+StatusReportCopy(uint32_t iters, int numNodes) {
+  LockedTopology* topology;
+  std::vector<std::string> macs;
+  BENCHMARK_SUSPEND {
+    topology = &getTopology(numNodes);
+    for (uint32_t i = 0; i < iters; i++) {
+      macs.push_back(getNodeMac((i * 7919) % numNodes));
+    }
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(statusReportCopy(*topology->rlock(), macs[i]));
+  }
+}
+
+void
+StatusReportRef(uint32_t iters, int numNodes) {
+  LockedTopology* topology;
+  std::vector<std::string> macs;
+  BENCHMARK_SUSPEND {
+    topology = &getTopology(numNodes);
+    for (uint32_t i = 0; i < iters; i++) {
+      macs.push_back(getNodeMac((i * 7919) % numNodes));
+    }
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(statusReportRef(*topology->rlock(), macs[i]));
+  }
+}
+
+void
+LinkEndsCopy(uint32_t iters, int numNodes) {
+  LockedTopology* topology;
+  BENCHMARK_SUSPEND {
+    topology = &getTopology(numNodes);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(linkEndsCopy(*topology->rlock()));
+  }
+}
+
+void
+LinkEndsRef(uint32_t iters, int numNodes) {
+  LockedTopology* topology;
+  BENCHMARK_SUSPEND {
+    topology = &getTopology(numNodes);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(linkEndsRef(*topology->rlock()));
+  }
+}
+
+BENCHMARK_PARAM(StatusReportCopy, 512)
+BENCHMARK_RELATIVE_PARAM(StatusReportRef, 512)
+BENCHMARK_PARAM(LinkEndsCopy, 512)
+BENCHMARK_RELATIVE_PARAM(LinkEndsRef, 512)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(StatusReportCopy, 4096)
+BENCHMARK_RELATIVE_PARAM(StatusReportRef, 4096)
+BENCHMARK_PARAM(LinkEndsCopy, 4096)
+BENCHMARK_RELATIVE_PARAM(LinkEndsRef, 4096)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -784,6 +784,171 @@ TEST_F(TopologyFixture, gettersTest) {
   EXPECT_EQ(-25, foundSite->location.altitude);
 }
 
+TEST_F(TopologyFixture, referenceAccessorsTest) {
+  thrift::Topology topology;
+  topology.name = "test";
+  topology.nodes = nodes;
+  topology.links = links;
+  topology.sites = sites;
+  TopologyWrapper topologyW(topology);
+
+  // views match the copying getters
+  auto allNodes = topologyW.getAllNodes();
+  auto allLinks = topologyW.getAllLinks();
+  auto allSites = topologyW.getAllSites();
+  EXPECT_EQ(
+      allNodes,
+      std::vector<thrift::Node>(
+          topologyW.getAllNodesView().begin(),
+          topologyW.getAllNodesView().end()));
+  EXPECT_EQ(
+      allLinks,
+      std::vector<thrift::Link>(
+          topologyW.getAllLinksView().begin(),
+          topologyW.getAllLinksView().end()));
+  EXPECT_EQ(
+      allSites,
+      std::vector<thrift::Site>(
+          topologyW.getAllSitesView().begin(),
+          topologyW.getAllSitesView().end()));
+
+  // getNodePtr / getLinkPtr / getSitePtr
+  EXPECT_EQ(*topologyW.getNode("1"), *topologyW.getNodePtr("1"));
+  EXPECT_EQ(nullptr, topologyW.getNodePtr("0"));
+  EXPECT_EQ(*topologyW.getLink("link-1-5"), *topologyW.getLinkPtr("link-1-5"));
+  EXPECT_EQ(nullptr, topologyW.getLinkPtr("link-2-5"));
+  EXPECT_EQ(
+      *topologyW.getSite("pole-mpk18"), *topologyW.getSitePtr("pole-mpk18"));
+  EXPECT_EQ(nullptr, topologyW.getSitePtr("1"));
+
+  // getNodePtrByMac (standard and non-standard formats)
+  const thrift::Node* node2 = topologyW.getNodePtr("2");
+  EXPECT_EQ(node2, topologyW.getNodePtrByMac("02:02:02:02:02:02"));
+  EXPECT_EQ(node2, topologyW.getNodePtrByMac("2:2:2:2:2:2"));
+  EXPECT_EQ(nullptr, topologyW.getNodePtrByMac("0:0:0:0:0:0"));
+  EXPECT_EQ(nullptr, topologyW.getNodePtrByMac("k:h:a:l:e:e:s:i"));
+
+  // getNbrNodePtr
+  const thrift::Link* link = topologyW.getLinkPtr("link-1-5");
+  EXPECT_EQ(topologyW.getNodePtr("1"), topologyW.getNbrNodePtr("5", *link));
+  EXPECT_EQ(topologyW.getNodePtr("5"), topologyW.getNbrNodePtr("1", *link));
+  EXPECT_EQ(nullptr, topologyW.getNbrNodePtr("2", *link));
+
+  // IDs
+  for (size_t i = 0; i < allNodes.size(); i++) {
+    EXPECT_EQ(i, *topologyW.getNodeId(allNodes[i].name));
+    EXPECT_EQ(allNodes[i], topologyW.getNodeById(i));
+  }
+  for (size_t i = 0; i < allLinks.size(); i++) {
+    EXPECT_EQ(i, *topologyW.getLinkId(allLinks[i].name));
+    EXPECT_EQ(allLinks[i], topologyW.getLinkById(i));
+  }
+  for (size_t i = 0; i < allSites.size(); i++) {
+    EXPECT_EQ(i, *topologyW.getSiteId(allSites[i].name));
+    EXPECT_EQ(allSites[i], topologyW.getSiteById(i));
+  }
+  EXPECT_FALSE(topologyW.getNodeId("0"));
+  EXPECT_FALSE(topologyW.getLinkId("link-2-5"));
+  EXPECT_FALSE(topologyW.getSiteId("1"));
+  EXPECT_THROW(topologyW.getNodeById(allNodes.size()), std::out_of_range);
+  EXPECT_THROW(topologyW.getLinkById(allLinks.size()), std::out_of_range);
+  EXPECT_THROW(topologyW.getSiteById(allSites.size()), std::out_of_range);
+
+  // forEachLinkByNodeName / forEachLinkByRadioMac
+  for (const auto& nodeName : {"1", "2", "4", "6", "xyz"}) {
+    std::vector<thrift::Link> result;
+    topologyW.forEachLinkByNodeName(nodeName, [&](const thrift::Link& l) {
+      result.push_back(l);
+      return true;
+    });
+    EXPECT_EQ(topologyW.getLinksByNodeName(nodeName), result);
+  }
+  const std::string& radioMac = node2->mac_addr;
+  std::vector<thrift::Link> result;
+  topologyW.forEachLinkByRadioMac(radioMac, [&](const thrift::Link& l) {
+    result.push_back(l);
+    return true;
+  });
+  EXPECT_EQ(topologyW.getLinksByRadioMac(radioMac), result);
+
+  // stop early
+  size_t count = 0;
+  topologyW.forEachLinkByNodeName("2", [&](const thrift::Link& /* l */) {
+    count++;
+    return false;
+  });
+  EXPECT_EQ(1, count);
+
+  // IDs and pointers are refreshed after modifications
+  topologyW.delLink("1", "5", true /* force */);
+  EXPECT_EQ(nullptr, topologyW.getLinkPtr("link-1-5"));
+  for (const auto& l : topologyW.getAllLinksView()) {
+    EXPECT_EQ(l, topologyW.getLinkById(*topologyW.getLinkId(l.name)));
+  }
+}
+
+TEST_F(TopologyFixture, changeTrackingTest) {
+  thrift::Topology topology;
+  topology.name = "test";
+  topology.nodes = nodes;
+  topology.links = links;
+  topology.sites = sites;
+  TopologyWrapper topologyW(topology);
+  const uint64_t version = topologyW.getVersion();
+  EXPECT_EQ(
+      std::unordered_set<std::string>(),
+      *topologyW.getStatusChangesSince(version));
+
+  // setting the same status is not a change
+  topologyW.setLinkStatus("link-1-5", false);
+  topologyW.setNodeStatus("1", topologyW.getNodePtr("1")->status);
+  EXPECT_EQ(version, topologyW.getVersion());
+
+  // status changes are reported by node name
+  EXPECT_TRUE(topologyW.setLinkStatus("link-1-5", true));
+  EXPECT_TRUE(topologyW.setNodeStatus("3", NodeStatusType::ONLINE_INITIATOR));
+  EXPECT_LT(version, topologyW.getVersion());
+  EXPECT_EQ(version, topologyW.getStructureVersion());
+  EXPECT_EQ(
+      std::unordered_set<std::string>({"1", "5", "3"}),
+      *topologyW.getStatusChangesSince(version));
+  const uint64_t statusVersion = topologyW.getVersion();
+  EXPECT_EQ(
+      std::unordered_set<std::string>(),
+      *topologyW.getStatusChangesSince(statusVersion));
+
+  // replacing the topology with only status changes is not structural
+  auto newTopology = topologyW.getTopology();
+  for (auto& link : newTopology.links) {
+    if (link.name == "link-2-6") {
+      link.is_alive = true;
+      link.linkup_attempts = 3;
+    }
+  }
+  const thrift::Link* link26 = topologyW.getLinkPtr("link-2-6");
+  topologyW.setTopology(newTopology);
+  EXPECT_EQ(link26, topologyW.getLinkPtr("link-2-6"));
+  EXPECT_TRUE(link26->is_alive);
+  EXPECT_EQ(3, link26->linkup_attempts);
+  EXPECT_EQ(version, topologyW.getStructureVersion());
+  EXPECT_EQ(
+      std::unordered_set<std::string>({"2", "6"}),
+      *topologyW.getStatusChangesSince(statusVersion));
+
+  // anything else is a structural change
+  newTopology.nodes[0].ant_azimuth += 90;
+  topologyW.setTopology(newTopology);
+  EXPECT_EQ(topologyW.getVersion(), topologyW.getStructureVersion());
+  EXPECT_FALSE(topologyW.getStatusChangesSince(statusVersion));
+  EXPECT_EQ(
+      std::unordered_set<std::string>(),
+      *topologyW.getStatusChangesSince(topologyW.getVersion()));
+
+  const uint64_t structureVersion = topologyW.getStructureVersion();
+  topologyW.delLink("1", "5", true /* force */);
+  EXPECT_LT(structureVersion, topologyW.getStructureVersion());
+}
+
 TEST_F(TopologyFixture, settersTest) {
   thrift::Topology topology;
   topology.name = "test";
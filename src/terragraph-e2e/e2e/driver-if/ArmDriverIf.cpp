@@ -350,20 +350,12 @@ void
 ArmDriverIf::processFwStatsMessage(
     const std::string& radioMac,
     const thrift::DriverFwStatsReport& report) const {
-  const auto& statsSamples = report.stats.statsSamples;
-  for (uint32_t i = 0; i < statsSamples.size(); i++) {
-    // fbzmq's Counter has no "entity" concept (each radioMac should be an
-    // entity). Add the entity as part of the key, then split it out on all
-    // consumers.
-    // key format: [key_name]\0[entity]
-    std::string key = statsSamples[i].key + '\0' + radioMac;
-
-    // use firmware time in tsf (us) as timestamp, may not be from epoch
-    setCounter(
-        key,
-        statsSamples[i].value,
-        fbzmq::thrift::CounterValueType::GAUGE,
-        statsSamples[i].tsf);
+  // Publish the report in as few ZmqMonitor messages as possible (one unless
+  // keys repeat within the report)
+  std::vector<fbzmq::CounterMap> batches;
+  addFwStatsCounters(radioMac, report.stats, fwStatsKeyCache_, batches);
+  for (const fbzmq::CounterMap& counters : batches) {
+    setCounters(counters);
   }
 }
 
@@ -248,6 +248,9 @@ class ArmDriverIf final : public BaseDriverIf {
       std::pair<RadioProperties, std::vector<thrift::PhyTpcAdjTblCfg>>>
           tpcAdjTables_;
 
+  /** Interned counter keys for firmware stats. */
+  mutable FwStatsKeyCache fwStatsKeyCache_;
+
   /** Netlink socket instance used to talk to the driver. */
   std::unique_ptr<BaseNetlinkSocket> netlinkSocket_;
 
@@ -751,6 +751,13 @@ BaseDriverIf::setCounter(
   zmqMonitorClient_->setCounter(key, counter);
 }
 
+void
+BaseDriverIf::setCounters(const fbzmq::CounterMap& counters) const {
+  if (!counters.empty()) {
+    zmqMonitorClient_->setCounters(counters);
+  }
+}
+
 void
 BaseDriverIf::bumpCounter(const std::string& key) const {
   zmqMonitorClient_->bumpCounter(key);
@@ -760,13 +767,15 @@ void
 BaseDriverIf::processDrvrStats(const thrift::DrvrStatsList& report) const {
   const auto& statsSamples = report.samples;
   const auto& gpsTimeUs = report.gpsTimeUs;
+  fbzmq::CounterMap counters;
+  counters.reserve(statsSamples.size());
   for (const thrift::DrvrStatsSample& sample : statsSamples) {
-    setCounter(
-        sample.key,
-        sample.value,
-        fbzmq::thrift::CounterValueType::GAUGE,
-        gpsTimeUs);
+    fbzmq::thrift::Counter& counter = counters[sample.key];
+    counter.value_ref() = sample.value;
+    counter.valueType_ref() = fbzmq::thrift::CounterValueType::GAUGE;
+    counter.timestamp_ref() = gpsTimeUs;
   }
+  setCounters(counters);
 }
 
 bool
@@ -73,6 +73,9 @@ class BaseDriverIf : public fbzmq::ZmqEventLoop {
       const fbzmq::thrift::CounterValueType valueType,
       int64_t timestamp) const;
 
+  /** Set a batch of counters using zmqMonitorClient_ (in one message). */
+  void setCounters(const fbzmq::CounterMap& counters) const;
+
   /** Bump a counter using zmqMonitorClient_. */
   void bumpCounter(const std::string& key) const;
 
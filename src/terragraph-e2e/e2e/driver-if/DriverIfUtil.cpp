@@ -34,6 +34,9 @@ const int kSnrThreshold = 30;
 // Quality = 5, 6, 7: code and carrier locked and time synchronized
 const int kQualityThreshold = 5;
 
+// Max interned firmware stats keys per radio (see FwStatsKeyCache)
+const size_t kMaxFwStatsKeysPerRadio = 50000;
+
 // Build a thrift::Message that wraps a thrift::DriverMessage.
 template <class T>
 thrift::Message
@@ -1064,6 +1067,45 @@ driverNl2IfMessage(const DriverNlMessage& drNlMsg) {
   }
 }
 
+const std::string&
+FwStatsKeyCache::getCounterKey(
+    const std::string& radioMac, const std::string& statKey) {
+  auto& radioKeys = keys_[radioMac];
+  auto iter = radioKeys.find(statKey);
+  if (iter == radioKeys.end()) {
+    // Stat keys embed peer MACs, so start over if peers have churned a lot
+    if (radioKeys.size() >= kMaxFwStatsKeysPerRadio) {
+      radioKeys.clear();
+    }
+    iter = radioKeys.emplace(statKey, statKey + '\0' + radioMac).first;
+  }
+  return iter->second;
+}
+
+void
+addFwStatsCounters(
+    const std::string& radioMac,
+    const thrift::Stats& stats,
+    FwStatsKeyCache& keyCache,
+    std::vector<fbzmq::CounterMap>& batches) {
+  fbzmq::CounterMap* counters = nullptr;
+  for (const thrift::StatsSample& sample : stats.statsSamples) {
+    const std::string& key = keyCache.getCounterKey(radioMac, sample.key);
+    if (!counters || counters->count(key)) {
+      // Repeated key (e.g. high-frequency stats), so start a new batch
+      batches.emplace_back();
+      counters = &batches.back();
+      counters->reserve(stats.statsSamples.size());
+    }
+
+    // use firmware time in tsf (us) as timestamp, may not be from epoch
+    fbzmq::thrift::Counter& counter = (*counters)[key];
+    counter.value_ref() = sample.value;
+    counter.valueType_ref() = fbzmq::thrift::CounterValueType::GAUGE;
+    counter.timestamp_ref() = sample.tsf;
+  }
+}
+
 void
 convertEcefToGeodetic(
     double ecefX,
@@ -7,6 +7,12 @@
 
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fbzmq/service/monitor/ZmqMonitorClient.h>
+
 #include "DriverNlMessage.h"
 #include "e2e/if/gen-cpp2/Controller_types.h"
 #include "e2e/if/gen-cpp2/DriverMessage_types.h"
@@ -39,6 +45,42 @@ struct RadioState {
   bool positionSent;
 };
 
+/**
+ * Interned ZmqMonitor counter keys for firmware stats.
+ *
+ * fbzmq's Counter has no "entity" concept (each radioMac should be an entity),
+ * so firmware stats are published with the entity as part of the key, i.e.
+ * "[key_name]\0[entity]". The set of keys per radio is small and stable, so
+ * each composed key is built once and reused for every later report.
+ */
+class FwStatsKeyCache {
+ public:
+  /** Return the counter key for the given firmware stat on a radio. */
+  const std::string& getCounterKey(
+      const std::string& radioMac, const std::string& statKey);
+
+ private:
+  /** Composed counter keys, per radio. */
+  std::unordered_map<
+      std::string /* radioMac */,
+      std::unordered_map<std::string /* statKey */, std::string>>
+      keys_;
+};
+
+/**
+ * Convert a firmware stats report from one radio into batches of ZmqMonitor
+ * counters, using the firmware TSF as the timestamp.
+ *
+ * A CounterMap holds one sample per key, but high-frequency stats repeat keys
+ * within a report (one sample per TSF), so a new batch is started whenever a
+ * key repeats. Batches are appended to 'batches' in report order.
+ */
+void addFwStatsCounters(
+    const std::string& radioMac,
+    const thrift::Stats& stats,
+    FwStatsKeyCache& keyCache,
+    std::vector<fbzmq::CounterMap>& batches);
+
 /** Convert a DriverNlMessage to a corresponding thrift::Message. */
 thrift::Message driverNl2IfMessage(const DriverNlMessage& drNlMsg);
 
@@ -12,16 +12,137 @@
 #include <folly/Format.h>
 #include <folly/MacAddress.h>
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
 #include <nl-driver-if/fb_tg_fw_driver_if.h>
 #include <optional>
 #include <stddef.h>
 #include <string.h>
+#include <unordered_map>
 
 using apache::thrift::detail::TEnumMapFactory;
 
 namespace {
 constexpr folly::StringPiece kSamplePrefix = "tgf.";
 
+// Max peers to keep interned stats keys for (see StatsKeyCache)
+const size_t kMaxStatsKeyCachePeers = 256;
+
+// A stat name (or name prefix) as passed to StatsKeyCache.
+//
+// Only constructible from a string literal (or other static char array), so
+// StatsKeyCache can hold on to it, and hashed on construction (folded at
+// compile time for literals) so lookups don't rehash the name.
+class StatName {
+ public:
+  template <size_t N>
+  /* implicit */ constexpr StatName(const char (&name)[N])
+      : data_(name), size_(N - 1), hash_(hashName(name, N - 1)) {}
+
+  folly::StringPiece
+  str() const {
+    return folly::StringPiece(data_, size_);
+  }
+
+  uint64_t
+  hash() const {
+    return hash_;
+  }
+
+  bool
+  operator==(const StatName& other) const {
+    return hash_ == other.hash_ && str() == other.str();
+  }
+
+ private:
+  // 64-bit FNV-1a
+  static constexpr uint64_t
+  hashName(const char* name, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ static_cast<uint8_t>(name[i])) * 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  const char* data_;
+  size_t size_;
+  uint64_t hash_;
+};
+
+// Interned stats sample keys ("tgf.<mac>.<prefix><name>[<index>]"), keyed by
+// (binary MAC, prefix, name, index). Names carry a precomputed hash, so looking
+// up a key hashes a few integers, and each key is only formatted once per peer.
+class StatsKeyCache {
+ public:
+  const std::string&
+  getKey(
+      const uint8_t macAddr[6],
+      const StatName& namePrefix,
+      const StatName& name,
+      int index) {
+    uint64_t mac = 0;
+    for (int i = 0; i < 6; i++) {
+      mac = (mac << 8) | macAddr[i];
+    }
+    auto peerIter = keys_.find(mac);
+    if (peerIter == keys_.end()) {
+      // Peers churn slowly, but don't grow without bound
+      if (keys_.size() >= kMaxStatsKeyCachePeers) {
+        keys_.clear();
+      }
+      peerIter = keys_.emplace(mac, PeerKeys()).first;
+    }
+
+    auto& peerKeys = peerIter->second;
+    NameId nameId{namePrefix, name, index};
+    auto iter = peerKeys.find(nameId);
+    if (iter == peerKeys.end()) {
+      std::string key = folly::to<std::string>(
+          kSamplePrefix,
+          folly::MacAddress::fromBinary(folly::ByteRange(macAddr, 6)),
+          ".",
+          namePrefix.str(),
+          name.str());
+      if (index >= 0) {
+        folly::toAppend("[", index, "]", &key);
+      }
+      iter = peerKeys.emplace(nameId, std::move(key)).first;
+    }
+    return iter->second;
+  }
+
+ private:
+  // Identifies a stat by its name, name prefix, and array index (or -1)
+  struct NameId {
+    StatName namePrefix;
+    StatName name;
+    int index;
+
+    bool
+    operator==(const NameId& other) const {
+      return index == other.index && name == other.name &&
+             namePrefix == other.namePrefix;
+    }
+  };
+
+  struct NameIdHash {
+    size_t
+    operator()(const NameId& nameId) const {
+      return folly::hash::hash_combine(
+          nameId.namePrefix.hash(), nameId.name.hash(), nameId.index);
+    }
+  };
+
+  using PeerKeys =
+      std::unordered_map<NameId, std::string /* key */, NameIdHash>;
+
+  // Interned keys per peer
+  std::unordered_map<uint64_t /* mac */, PeerKeys> keys_;
+};
+
+// Stats are decoded on the netlink threads, so keep one cache per thread
+thread_local StatsKeyCache statsKeyCache;
+
 // Try to parse a MAC address, returning std::nullopt on failure
 std::optional<folly::MacAddress>
 parseMacAddress(const std::string& mac) {
@@ -37,8 +158,6 @@ parseMacAddress(const std::string& mac) {
 namespace facebook {
 namespace terragraph {
 
-thrift::Stats getStats(const tgfStatsMsgHdr* buffStats, size_t len);
-
 /* round x/y */
 #define TGF_ROUND(x, y) (((x) + ((y) / 2)) / (y))
 
@@ -1453,18 +1572,36 @@ getPtThrift(const uint8_t* buff, size_t len, const std::string& radioMac) {
 thrift::StatsSample
 createSample(
     const uint8_t macAddr[6],
-    const std::string& name,
+    const StatName& namePrefix,
+    const StatName& name,
     int64_t value,
     int64_t tsf) {
+  thrift::StatsSample statsSample;
+  statsSample.key = statsKeyCache.getKey(macAddr, namePrefix, name, -1);
+  statsSample.value = value;
+  statsSample.tsf = tsf;
+  return statsSample;
+}
 
-  const std::string& key = folly::to<std::string>(
-      kSamplePrefix,
-      folly::MacAddress::fromBinary(folly::ByteRange(macAddr, 6)),
-      ".",
-      name);
+thrift::StatsSample
+createSample(
+    const uint8_t macAddr[6],
+    const StatName& name,
+    int64_t value,
+    int64_t tsf) {
+  return createSample(macAddr, "", name, value, tsf);
+}
 
+// Create a sample for an array element, named "<name>[<index>]"
+thrift::StatsSample
+createIndexedSample(
+    const uint8_t macAddr[6],
+    const StatName& name,
+    int index,
+    int64_t value,
+    int64_t tsf) {
   thrift::StatsSample statsSample;
-  statsSample.key = key;
+  statsSample.key = statsKeyCache.getKey(macAddr, "", name, index);
   statsSample.value = value;
   statsSample.tsf = tsf;
   return statsSample;
@@ -1474,13 +1611,16 @@ createSample(
   samps.push_back(    \
       createSample(buffSample->addr, #NAME, buffSample->data.NAME, tsf));
 
-#define PUSH_KV_VEC(VAR, NAME) \
-  samps.push_back(             \
-      createSample(buffSample->addr, NAME, buffSample->data.VAR, tsf));
-
 #define PUSH_KV_STATS(VAR, NAME) \
   samps.push_back(createSample(buffSample->addr, NAME, VAR, tsf));
 
+#define PUSH_KV_STATS_PREFIX(VAR, PREFIX, NAME) \
+  samps.push_back(createSample(buffSample->addr, PREFIX, NAME, VAR, tsf));
+
+#define PUSH_KV_VEC_INDEX(VAR, NAME, INDEX) \
+  samps.push_back(createIndexedSample(      \
+      buffSample->addr, NAME, INDEX, buffSample->data.VAR, tsf));
+
 thrift::Stats
 getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
   thrift::Stats thriftStats;
@@ -1618,52 +1758,37 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
         } else {
           len -= sampDataLen;
           const tgfStatsPhystatus* phystatus = &buffSample->data.phystatus;
-          std::string key;
+          StatName key = "";
           if (phystatus->type == STATS_TYPE_DATA) {
             key = "phystatusdata.";
           } else if (phystatus->type == STATS_TYPE_MGMT) {
             // for historical reasons, just call it phystatus
             key = "phystatus.";
           }
-          samps.push_back(createSample(
-              buffSample->addr, folly::to<std::string>(key, "tsf"), tsf, tsf));
-          PUSH_KV_STATS(
-              TGF_ROUND(phystatus->snrEstQ8, Q(8)),
-              folly::to<std::string>(key, "ssnrEst"));
-          PUSH_KV_STATS(
-              TGF_ROUND(phystatus->postSNRdBQ1, Q(1)),
-              folly::to<std::string>(key, "spostSNRdB"));
-          PUSH_KV_STATS(phystatus->srssi, folly::to<std::string>(key, "srssi"));
-          PUSH_KV_STATS(
-              phystatus->gainIndexIf,
-              folly::to<std::string>(key, "gainIndexIf"));
-          PUSH_KV_STATS(
-              phystatus->gainIndexRf,
-              folly::to<std::string>(key, "gainIndexRf"));
-          PUSH_KV_STATS(
-              phystatus->rawAdcRssi, folly::to<std::string>(key, "rawAdcRssi"));
-          PUSH_KV_STATS(
-              phystatus->rxStartNormalized,
-              folly::to<std::string>(key, "rxStartNormalized"));
-          PUSH_KV_STATS(
-              phystatus->maxGainIndexIf,
-              folly::to<std::string>(key, "maxGainIndexIf"));
-          PUSH_KV_STATS(
-              phystatus->maxGainIndexRf,
-              folly::to<std::string>(key, "maxGainIndexRf"));
-          PUSH_KV_STATS(
-              phystatus->numTotalSyndromes,
-              folly::to<std::string>(key, "numTotalSyndromes"));
-          PUSH_KV_STATS(
-              phystatus->numTotalCodewords,
-              folly::to<std::string>(key, "numTotalCodewords"));
-          PUSH_KV_STATS(
-              phystatus->plcpLength, folly::to<std::string>(key, "plcpLength"));
-          PUSH_KV_STATS(
-              phystatus->ldpcIterations,
-              folly::to<std::string>(key, "ldpcIterations"));
-          PUSH_KV_STATS(phystatus->rxMcs, folly::to<std::string>(key, "rxMcs"));
-          PUSH_KV_STATS(phystatus->dbg16, folly::to<std::string>(key, "dbg16"));
+          samps.push_back(createSample(buffSample->addr, key, "tsf", tsf, tsf));
+          PUSH_KV_STATS_PREFIX(
+              TGF_ROUND(phystatus->snrEstQ8, Q(8)), key, "ssnrEst");
+          PUSH_KV_STATS_PREFIX(
+              TGF_ROUND(phystatus->postSNRdBQ1, Q(1)), key, "spostSNRdB");
+          PUSH_KV_STATS_PREFIX(phystatus->srssi, key, "srssi");
+          PUSH_KV_STATS_PREFIX(phystatus->gainIndexIf, key, "gainIndexIf");
+          PUSH_KV_STATS_PREFIX(phystatus->gainIndexRf, key, "gainIndexRf");
+          PUSH_KV_STATS_PREFIX(phystatus->rawAdcRssi, key, "rawAdcRssi");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->rxStartNormalized, key, "rxStartNormalized");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->maxGainIndexIf, key, "maxGainIndexIf");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->maxGainIndexRf, key, "maxGainIndexRf");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->numTotalSyndromes, key, "numTotalSyndromes");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->numTotalCodewords, key, "numTotalCodewords");
+          PUSH_KV_STATS_PREFIX(phystatus->plcpLength, key, "plcpLength");
+          PUSH_KV_STATS_PREFIX(
+              phystatus->ldpcIterations, key, "ldpcIterations");
+          PUSH_KV_STATS_PREFIX(phystatus->rxMcs, key, "rxMcs");
+          PUSH_KV_STATS_PREFIX(phystatus->dbg16, key, "dbg16");
         }
         break;
 
@@ -1926,16 +2051,18 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
 
           for (int rssiIdx = 0; rssiIdx < AGC_RSSI_HIST_SIZE; rssiIdx++) {
             if (buffSample->data.maxAgcStats.rssiHistMgmt[rssiIdx]) {
-              const std::string& key = folly::to<std::string>(
-                  "maxAgcHistStats.rssiHistMgmt[", rssiIdx, "]");
-              PUSH_KV_VEC(maxAgcStats.rssiHistMgmt[rssiIdx], key);
+              PUSH_KV_VEC_INDEX(
+                  maxAgcStats.rssiHistMgmt[rssiIdx],
+                  "maxAgcHistStats.rssiHistMgmt",
+                  rssiIdx);
             }
           }
           for (int rssiIdx = 0; rssiIdx < AGC_RSSI_HIST_SIZE; rssiIdx++) {
             if (buffSample->data.maxAgcStats.rssiHistData[rssiIdx]) {
-              const std::string& key = folly::to<std::string>(
-                  "maxAgcHistStats.rssiHistData[", rssiIdx, "]");
-              PUSH_KV_VEC(maxAgcStats.rssiHistData[rssiIdx], key);
+              PUSH_KV_VEC_INDEX(
+                  maxAgcStats.rssiHistData[rssiIdx],
+                  "maxAgcHistStats.rssiHistData",
+                  rssiIdx);
             }
           }
         }
@@ -1980,23 +2107,26 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
 
           for (uint32_t phaseIdx = 0; phaseIdx < TGF_MAX_NUM_MTPO_PHASES;
                phaseIdx++) {
-            const std::string& key = folly::to<std::string>(
-                    "mtpoStats.mtpoPhases[", phaseIdx, "]");
-            PUSH_KV_STATS(mtpoStats->mtpoPhases[phaseIdx], key);
+            PUSH_KV_VEC_INDEX(
+                mtpoStats.mtpoPhases[phaseIdx],
+                "mtpoStats.mtpoPhases",
+                phaseIdx);
           }
 
           for (uint32_t sectorIdx = 0; sectorIdx < TGF_MTPO_SWEEP_SECTORS;
                sectorIdx++) {
-            const std::string& key = folly::to<std::string>(
-                    "mtpoStats.mtpoSingleTileSectorGolayPeak[", sectorIdx, "]");
-            PUSH_KV_STATS(mtpoStats->mtpoSectorSweepGolayPeak[sectorIdx], key);
+            PUSH_KV_VEC_INDEX(
+                mtpoStats.mtpoSectorSweepGolayPeak[sectorIdx],
+                "mtpoStats.mtpoSingleTileSectorGolayPeak",
+                sectorIdx);
           }
 
           for (uint32_t phaseIdx = 0; phaseIdx < TGF_MTPO_SWEEP_PHASES;
                phaseIdx++) {
-            const std::string& key = folly::to<std::string>(
-                    "mtpoStats.mtpoMultiTilePhaseGolayPeak[", phaseIdx, "]");
-            PUSH_KV_STATS(mtpoStats->mtpoPhaseSweepGolayPeak[phaseIdx], key);
+            PUSH_KV_VEC_INDEX(
+                mtpoStats.mtpoPhaseSweepGolayPeak[phaseIdx],
+                "mtpoStats.mtpoMultiTilePhaseGolayPeak",
+                phaseIdx);
           }
         }
         break;
@@ -2063,9 +2193,7 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
 
           // push this array as mgmtData.w[n] as n key/value/tsf
           for (uint32_t wIdx = 0; wIdx < TGF_STATS_MGMT_DATA_W_LEN; wIdx++) {
-            std::string key = folly::sformat("mgmtData.w[{}]", wIdx);
-            samps.push_back(createSample(
-                buffSample->addr, key, buffSample->data.mgmtData.w[wIdx], tsf));
+            PUSH_KV_VEC_INDEX(mgmtData.w[wIdx], "mgmtData.w", wIdx);
           }
         }
         break;
@@ -2170,10 +2298,8 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
               createSample(buffSample->addr, "lifetimeExpired.tsf", tsf, tsf));
           for (int action = 0; action < TGF_NUM_MESSAGE_ACTIONS; action++) {
             if (buffSample->data.lifetime.counter[action] != 0) {
-              const std::string& key =
-                  folly::to<std::string>("lifetime.expired[", action, "]");
-
-              PUSH_KV_VEC(lifetime.counter[action], key);
+              PUSH_KV_VEC_INDEX(
+                  lifetime.counter[action], "lifetime.expired", action);
             }
           }
         }
@@ -2189,10 +2315,8 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
               createSample(buffSample->addr, "lifetimeOk.tsf", tsf, tsf));
           for (int action = 0; action < TGF_NUM_MESSAGE_ACTIONS; action++) {
             if (buffSample->data.lifetime.counter[action] != 0) {
-              const std::string& key =
-                  folly::to<std::string>("lifetime.ok[", action, "]");
-
-              PUSH_KV_VEC(lifetime.counter[action], key);
+              PUSH_KV_VEC_INDEX(
+                  lifetime.counter[action], "lifetime.ok", action);
             }
           }
         }
@@ -2207,9 +2331,7 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
           samps.push_back(
               createSample(buffSample->addr, "calibrate.tsf", tsf, tsf));
           for (int idx = 0; idx < TGF_STATS_CALIB_NUM; idx++) {
-            const std::string& key =
-                folly::to<std::string>("calibrate.idx[", idx, "]");
-            PUSH_KV_VEC(calibrate.idx[idx], key);
+            PUSH_KV_VEC_INDEX(calibrate.idx[idx], "calibrate.idx", idx);
           }
         }
         break;
@@ -2265,12 +2387,14 @@ getStats(const tgfStatsMsgHdr* buffStats, size_t len) {
           samps.push_back(
               createSample(buffSample->addr, "radio.tsf", tsf, tsf));
           for (int idx = 0; idx < TGF_STATS_NUM_RADIO; idx++) {
-            const std::string& key = folly::to<std::string>(
-                "radioStats.radioTestReadErr[", idx, "]");
-            PUSH_KV_VEC(radioStats.radioTestReadErr[idx], key);
-            const std::string& key2 = folly::to<std::string>(
-                "radioStats.radioTestWriteErr[", idx, "]");
-            PUSH_KV_VEC(radioStats.radioTestWriteErr[idx], key2);
+            PUSH_KV_VEC_INDEX(
+                radioStats.radioTestReadErr[idx],
+                "radioStats.radioTestReadErr",
+                idx);
+            PUSH_KV_VEC_INDEX(
+                radioStats.radioTestWriteErr[idx],
+                "radioStats.radioTestWriteErr",
+                idx);
           }
           PUSH_KV(radioStats.radioTestTotalRuns);
           PUSH_KV(radioStats.radioCalibrationRuns);
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <fb-fw-if/fb_tg_fw_pt_if.h>
+
 #include "e2e/if/gen-cpp2/PassThru_types.h"
 
 namespace facebook {
@@ -48,6 +50,16 @@ size_t getPtBuff(const thrift::PassThruMsg& thriftMsg, uint8_t* buff);
  */
 thrift::PassThruMsg getPtThrift(
     const uint8_t* buff, size_t len, const std::string& radioMac = "");
+
+/*
+ * decodes the firmware stats samples in a stats buffer
+ *
+ * @param [in]  buffStats ptr to stats buffer header sent by wireless-fw
+ * @param [in]  len       number of bytes in buffStats (including header)
+ *
+ * @return                decoded stats samples
+ */
+thrift::Stats getStats(const tgfStatsMsgHdr* buffStats, size_t len);
 } // namespace terragraph
 
 } // namespace facebook
@@ -122,6 +122,33 @@ TEST_F(DriverIfFixture, ECEFConversion) {
   }
 }
 
+TEST(DriverIfUtilTest, FwStatsRepeatedKeys) {
+  // High-frequency stats repeat keys within one report, one sample per TSF
+  thrift::Stats stats;
+  for (int64_t tsf : {100, 200}) {
+    for (const std::string& key : {"hf.a", "hf.b"}) {
+      thrift::StatsSample sample;
+      sample.key = key;
+      sample.value = tsf + key.size();
+      sample.tsf = tsf;
+      stats.statsSamples.push_back(sample);
+    }
+  }
+
+  FwStatsKeyCache keyCache;
+  std::vector<fbzmq::CounterMap> batches;
+  addFwStatsCounters(kMacAddr, stats, keyCache, batches);
+
+  // Every sample is kept, in report order
+  ASSERT_EQ(2, batches.size());
+  const std::string& key = keyCache.getCounterKey(kMacAddr, "hf.a");
+  for (size_t i = 0; i < batches.size(); i++) {
+    EXPECT_EQ(2, batches[i].size());
+    ASSERT_TRUE(batches[i].count(key));
+    EXPECT_EQ(100 * (i + 1), batches[i].at(key).timestamp_ref().value());
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   folly::init(&argc, &argv);
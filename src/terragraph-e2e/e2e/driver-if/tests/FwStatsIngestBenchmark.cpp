@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare publishing firmware stats to ZmqMonitor one counter at a time
+// against one batched message per report.
+//
+// Stats buffers (tgfStatsMsgHdr + samples) are replayed from
+// --fw_stats_capture_file if given (records of [uint32 length][buffer]),
+// otherwise synthetic TGF_STATS_TEST_B reports are generated.
+
+#include <fstream>
+#include <thread>
+
+#include <fb-fw-if/fb_tg_fw_pt_if.h>
+#include <fbzmq/service/monitor/ZmqMonitor.h>
+#include <fbzmq/service/monitor/ZmqMonitorClient.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../DriverIfUtil.h"
+
+DEFINE_string(
+    fw_stats_capture_file,
+    "",
+    "Captured firmware stats buffers to replay (synthetic if empty)");
+DEFINE_int32(num_radios, 4, "Number of radios to publish stats for");
+DEFINE_int32(
+    num_synthetic_samples, 100, "Samples per synthetic stats report");
+
+using namespace facebook::terragraph;
+
+namespace facebook {
+namespace terragraph {
+thrift::Stats getStats(const tgfStatsMsgHdr* buffStats, size_t len);
+}
+} // namespace facebook
+
+namespace {
+const std::string kMonitorSubmitUrl{"inproc://fw-stats-bench-monitor-submit"};
+const std::string kMonitorPubUrl{"inproc://fw-stats-bench-monitor-pub"};
+
+// Read captured stats buffers
+std::vector<std::string>
+readCapturedBuffers(const std::string& path) {
+  std::vector<std::string> buffers;
+  std::ifstream in(path, std::ios::binary);
+  uint32_t len;
+  while (in.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+    std::string buf(len, '\0');
+    if (!in.read(&buf[0], len)) {
+      break;
+    }
+    buffers.push_back(std::move(buf));
+  }
+  return buffers;
+}
+
+// Build a synthetic stats buffer with one TGF_STATS_TEST_B sample per peer
+std::string
+makeSyntheticBuffer(int numSamples) {
+  std::string buf(
+      sizeof(tgfStatsMsgHdr) + numSamples * sizeof(tgfStatsSample), '\0');
+  tgfStatsMsgHdr* hdr = reinterpret_cast<tgfStatsMsgHdr*>(&buf[0]);
+  hdr->numSamples = numSamples;
+  tgfStatsSample* samples = reinterpret_cast<tgfStatsSample*>(hdr + 1);
+  for (int i = 0; i < numSamples; i++) {
+    tgfStatsSample* sample = &samples[i];
+    sample->type = TGF_STATS_TEST_B;
+    sample->addr[0] = 0x02;
+    sample->addr[4] = (i >> 8) & 0xff;
+    sample->addr[5] = i & 0xff;
+    sample->tsfL = i;
+    sample->data.testB.txOk = i;
+    sample->data.testB.txFail = i + 1;
+    sample->data.testB.rxOk = i + 2;
+    sample->data.testB.rxFail = i + 3;
+    sample->data.testB.rxPlcpFil = i + 4;
+  }
+  return buf;
+}
+
+// Decoded reports, per radio
+struct Reports {
+  std::vector<std::string> radioMacs;
+  std::vector<thrift::Stats> stats;
+};
+
+const Reports&
+getReports() {
+  static const Reports reports = [] {
+    std::vector<std::string> buffers;
+    if (!FLAGS_fw_stats_capture_file.empty()) {
+      buffers = readCapturedBuffers(FLAGS_fw_stats_capture_file);
+      CHECK(!buffers.empty())
+          << "No buffers read from " << FLAGS_fw_stats_capture_file;
+    } else {
+      buffers.push_back(makeSyntheticBuffer(FLAGS_num_synthetic_samples));
+    }
+    Reports r;
+    for (int i = 0; i < FLAGS_num_radios; i++) {
+      r.radioMacs.push_back(folly::sformat("00:00:00:10:0d:{:02x}", i));
+    }
+    for (const std::string& buf : buffers) {
+      r.stats.push_back(getStats(
+          reinterpret_cast<const tgfStatsMsgHdr*>(buf.data()), buf.size()));
+    }
+    return r;
+  }();
+  return reports;
+}
+
+// In-process ZmqMonitor with a client attached
+class MonitorHarness {
+ public:
+  MonitorHarness()
+      : monitor_(kMonitorSubmitUrl, kMonitorPubUrl, context_),
+        monitorThread_([this]() noexcept { monitor_.run(); }) {
+    monitor_.waitUntilRunning();
+    client_ = std::make_unique<fbzmq::ZmqMonitorClient>(
+        context_, kMonitorSubmitUrl, "DriverIfBenchmark");
+  }
+
+  ~MonitorHarness() {
+    client_.reset();
+    monitor_.stop();
+    monitor_.waitUntilStopped();
+    monitorThread_.join();
+  }
+
+  fbzmq::ZmqMonitorClient&
+  client() {
+    return *client_;
+  }
+
+ private:
+  fbzmq::Context context_;
+  fbzmq::ZmqMonitor monitor_;
+  std::thread monitorThread_;
+  std::unique_ptr<fbzmq::ZmqMonitorClient> client_;
+};
+
+// Wait until the monitor has processed everything sent so far
+void
+syncMonitor(fbzmq::ZmqMonitorClient& client, const std::string& key) {
+  folly::doNotOptimizeAway(client.getCounter(key));
+}
+} // namespace
+
+BENCHMARK(PerSampleSetCounter, iters) {
+  const Reports* reports;
+  std::unique_ptr<MonitorHarness> harness;
+  BENCHMARK_SUSPEND {
+    reports = &getReports();
+    harness = std::make_unique<MonitorHarness>();
+  }
+  std::string lastKey;
+  for (size_t i = 0; i < iters; i++) {
+    const auto& stats = reports->stats[i % reports->stats.size()];
+    for (const std::string& radioMac : reports->radioMacs) {
+      for (const thrift::StatsSample& sample : stats.statsSamples) {
+        lastKey = sample.key + '\0' + radioMac;
+        fbzmq::thrift::Counter counter;
+        counter.value_ref() = sample.value;
+        counter.valueType_ref() = fbzmq::thrift::CounterValueType::GAUGE;
+        counter.timestamp_ref() = sample.tsf;
+        harness->client().setCounter(lastKey, counter);
+      }
+    }
+  }
+  syncMonitor(harness->client(), lastKey);
+  BENCHMARK_SUSPEND {
+    harness.reset();
+  }
+}
+
+BENCHMARK_RELATIVE(BatchedSetCounters, iters) {
+  const Reports* reports;
+  std::unique_ptr<MonitorHarness> harness;
+  BENCHMARK_SUSPEND {
+    reports = &getReports();
+    harness = std::make_unique<MonitorHarness>();
+  }
+  FwStatsKeyCache keyCache;
+  std::string lastKey;
+  for (size_t i = 0; i < iters; i++) {
+    const auto& stats = reports->stats[i % reports->stats.size()];
+    for (const std::string& radioMac : reports->radioMacs) {
+      std::vector<fbzmq::CounterMap> batches;
+      addFwStatsCounters(radioMac, stats, keyCache, batches);
+      for (const fbzmq::CounterMap& counters : batches) {
+        lastKey = counters.begin()->first;
+        harness->client().setCounters(counters);
+      }
+    }
+  }
+  syncMonitor(harness->client(), lastKey);
+  BENCHMARK_SUSPEND {
+    harness.reset();
+  }
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Measure firmware stats decoding (getStats()) over a representative mix of
+// TGF_STATS_* samples from several peers, reported per decoded key-value
+// sample. Heap allocations per sample are printed after the benchmarks run.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <fb-fw-if/fb_tg_fw_pt_if.h>
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "../PassThru.h"
+
+DEFINE_int32(num_peers, 8, "Number of peers to generate stats for");
+
+using namespace facebook::terragraph;
+
+namespace {
+// Heap allocations made by this process
+std::atomic<size_t> numAllocations{0};
+
+// Sample types (and data sizes) sent periodically per peer
+const std::vector<std::pair<uint16_t, size_t>> kStatsMix = {
+    {TGF_STATS_STA_PKT, sizeof(tgfStatsStaPkt)},
+    {TGF_STATS_PHYSTATUS, sizeof(tgfStatsPhystatus)},
+    {TGF_STATS_MGMT_TX, sizeof(tgfStatsMgmt)},
+    {TGF_STATS_MGMT_RX, sizeof(tgfStatsMgmt)},
+    {TGF_STATS_BWHAN_LINK, sizeof(tgfStatsBwhanLink)},
+    {TGF_STATS_BF, sizeof(tgfStatsBf)},
+    {TGF_STATS_TPC, sizeof(tgfStatsTpc)},
+    {TGF_STATS_LA_TPC, sizeof(tgfStatsLaTpc)},
+    {TGF_STATS_MAX_AGC, sizeof(tgfStatsAgc)},
+    {TGF_STATS_MISC_LINK, sizeof(tgfStatsMiscLink)},
+};
+
+// Build one stats buffer containing the mix for every peer
+std::string
+makeStatsBuffer(int numPeers) {
+  std::string buf(sizeof(tgfStatsMsgHdr), '\0');
+  uint16_t numSamples = 0;
+  for (int peer = 0; peer < numPeers; peer++) {
+    for (const auto& [type, dataLen] : kStatsMix) {
+      std::string sampleBuf(offsetof(tgfStatsSample, data) + dataLen, '\0');
+      tgfStatsSample* sample = reinterpret_cast<tgfStatsSample*>(&sampleBuf[0]);
+      sample->type = type;
+      sample->addr[0] = 0x02;
+      sample->addr[5] = peer;
+      sample->tsfL = peer;
+      buf += sampleBuf;
+      numSamples++;
+    }
+  }
+  tgfStatsMsgHdr* hdr = reinterpret_cast<tgfStatsMsgHdr*>(&buf[0]);
+  hdr->numSamples = numSamples;
+  return buf;
+}
+
+const std::string&
+getStatsBuffer() {
+  static const std::string buf = makeStatsBuffer(FLAGS_num_peers);
+  return buf;
+}
+
+size_t
+decode(const std::string& buf) {
+  return getStats(
+             reinterpret_cast<const tgfStatsMsgHdr*>(buf.data()), buf.size())
+      .statsSamples.size();
+}
+} // namespace
+
+void*
+operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+// Reports time per decoded key-value sample
+BENCHMARK_MULTI(DecodeStatsMix, iters) {
+  const std::string* buf;
+  BENCHMARK_SUSPEND {
+    buf = &getStatsBuffer();
+  }
+  size_t numSamples = 0;
+  for (size_t i = 0; i < iters; i++) {
+    numSamples += decode(*buf);
+  }
+  return numSamples;
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+
+  // Count allocations for one warm decode
+  const std::string& buf = getStatsBuffer();
+  decode(buf);
+  size_t allocsBefore = numAllocations.load();
+  size_t numSamples = decode(buf);
+  size_t allocs = numAllocations.load() - allocsBefore;
+  LOG(INFO) << "Decoded " << numSamples << " samples with " << allocs
+            << " allocations (" << (double)allocs / numSamples
+            << " per sample)";
+  return 0;
+}
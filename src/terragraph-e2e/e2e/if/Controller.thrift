@@ -150,6 +150,7 @@ enum MessageType {
   GET_MINION_BASE_CONFIG = 727,
 
   // Requests handled (by ctrl ConfigApp)
+  MINION_CONFIG_RESEND_REQ = 728,
   GET_CTRL_CONFIG_REQ = 731,
   GET_CTRL_CONFIG_RESP = 732,
   GET_CTRL_CONFIG_NODE_OVERRIDES_REQ = 733,
@@ -339,6 +340,8 @@ enum MessageType {
   // Status Change Events
   EVENT_NODE_STATUS = 1209,
   EVENT_LINK_STATUS = 1210,
+  // Status Report Events
+  EVENT_STATUS_DELTA = 1211,
 
   // Miscellaneous (common)
   NONE = 1001,
@@ -726,14 +729,30 @@ struct MinionBaseConfig {
   3: optional map<string /*version */, string /* config json */> baseConfigs;
 }
 
+// JSON merge patch (RFC 7396) to a node config, sent instead of the full config
+struct MinionConfigPatch {
+  1: string patch; // JSON merge patch
+  2: string baseConfigHash; // structural hash of the config to patch
+  3: string configHash; // structural hash of the patched config
+}
+
 struct SetMinionConfigReq {
-  1: string config; // node config json string
+  1: string config; // node config json string (empty if configPatch is set)
   2: i64 bwgdIdx; // BWGD index at which to apply firmware changes (if needed)
+  3: optional MinionConfigPatch configPatch;
 }
 
 struct GetMinionConfigActionsReq {
-  1: string config; // node config json string
+  1: string config; // node config json string (empty if configPatch is set)
   2: string id;
+  3: optional MinionConfigPatch configPatch;
+}
+
+// Sent by a minion that could not apply a MinionConfigPatch
+struct MinionConfigResendReq {
+  1: string configHash; // from MinionConfigPatch
+  2: i64 bwgdIdx; // from SetMinionConfigReq
+  3: optional string id; // from GetMinionConfigActionsReq
 }
 
 struct GetMinionConfigActionsResp {
@@ -1271,6 +1290,8 @@ struct RadioStatus {
  *                             Map of radio MAC addresses to status information
  * @apiSuccess (:StatusReport) {String} firmwareVersion
  *                             The wireless firmware version
+ * @apiSuccess (:StatusReport) {String} [configHash]
+ *                             The structural hash of the node config
  */
  // NOTE: Some fields will be omitted after the controller initially learns
  // them, to save bandwidth. This list includes:
@@ -1304,6 +1325,8 @@ struct StatusReport {
   18: map<string /* radioMac */, RadioStatus>
       (cpp.template = "std::unordered_map") radioStatus;
   19: string firmwareVersion;
+  // structural hash of the node config (replacing the legacy configMd5)
+  20: optional string configHash;
 } (no_default_comparators)
 
 struct StatusReportAck {
@@ -1315,8 +1338,14 @@ struct GetStatusReport {}
 
 /**
  * @apiDefine GetStatusDump
+ * @apiParam {Int64} [sinceGeneration]
+ *           Only return status reports that changed after this generation
+ *           (i.e. the "generation" of a previous response), ignoring
+ *           timestamps. If this is too old, a full dump is returned instead.
  */
-struct GetStatusDump {}
+struct GetStatusDump {
+  1: optional i64 sinceGeneration;
+}
 
 /**
  * @apiDefine StatusDump_SUCCESS
@@ -1326,12 +1355,24 @@ struct GetStatusDump {}
  *             The per-node status reports
  * @apiSuccess {String} [version]
  *             The controller version sourced from "/etc/tgversion"
+ * @apiSuccess {Int64} [generation]
+ *             The status generation of this response, to pass as
+ *             "sinceGeneration" in the next request
+ * @apiSuccess {String[]} [removedNodes]
+ *             The nodes whose status reports were removed since the requested
+ *             generation (apply before "statusReports")
+ * @apiSuccess {Boolean} [incremental]
+ *             Whether "statusReports" only contains changes since the
+ *             requested generation (otherwise, it contains all nodes)
  */
 struct StatusDump {
   1: i64 timeStamp;  // timestamp at which this response was generated
   2: map<string /* node id */, StatusReport>
      (cpp.template = "std::unordered_map") statusReports;
   3: optional string version;
+  4: optional i64 generation;
+  5: optional list<string> removedNodes;
+  6: optional bool incremental;
 } (no_default_comparators)
 
 struct GetCtrlNeighborsReq {
@@ -3064,12 +3105,40 @@ struct BinaryStarAppData {
   5: optional string configController;
 }
 
+// One change to BinaryStarAppData in the replication log
+struct BinaryStarDelta {
+  1: i32 seqNum;
+  // Topology: nodes/links/sites added or changed, and names of those removed
+  2: list<Topology.Node> nodesChanged;
+  3: list<string> nodesRemoved;
+  4: list<Topology.Link> linksChanged;
+  5: list<string> linksRemoved;
+  6: list<Topology.Site> sitesChanged;
+  7: list<string> sitesRemoved;
+  8: optional string topologyName;
+  9: optional Topology.Config topologyConfig;
+  // Config overrides: top-level JSON keys (e.g. node names) to their new JSON
+  // values, or to empty strings if removed
+  10: map<string, string> configNetworkOverrides;
+  11: map<string, string> configNodeOverrides;
+  12: map<string, string> configAutoNodeOverrides;
+  13: optional string configController;
+}
+
 // Heartbeat struct
 struct BinaryStarSync {
   1: BinaryStarFsmState state;
   2: i32 seqNum;
+  // Full app data (if the peer could not be synced using "deltas")
   3: BinaryStarAppData data;
   4: string version;
+  // Changes following the peer's sequence number
+  5: list<BinaryStarDelta> deltas;
+  // Identifies the ACTIVE session that assigned the sequence numbers
+  6: i64 epoch;
+  // Checkpoint: the ACTIVE's content hash (after applying all changes up to
+  // "seqNum")
+  7: optional i64 checksum;
 }
 
 struct BinaryStarSwitchController {}
@@ -181,10 +181,19 @@ struct KafkaTopics {
   6: string pingResultsTopic;
 }
 
+// Stats payload encoding per Kafka topic:
+// - "json": one JSON-serialized AggrStat per message
+// - "thrift_compact": one Compact-serialized AggrStatsBatch per push interval
+struct KafkaStatsFormats {
+  1: string statsTopic = "json";
+  2: string hfStatsTopic = "json";
+}
+
 struct KafkaParams {
   1: bool enabled;
   2: KafkaConfig config;
   3: KafkaTopics topics;
+  4: KafkaStatsFormats statsFormats;
 }
 
 struct NmsPublisherParams {
@@ -216,6 +216,21 @@ ConfigApp::processConfigSetReq(
 
   auto lockedNodeConfigWrapper = SharedObjects::getNodeConfigWrapper()->wlock();
 
+  // Apply the config patch (if any)
+  std::string configJson = request->config;
+  if (request->configPatch_ref().has_value()) {
+    const auto& configPatch = request->configPatch_ref().value();
+    auto maybeConfigJson = lockedNodeConfigWrapper->applyConfigPatch(
+        configPatch.patch, configPatch.baseConfigHash, configPatch.configHash);
+    if (!maybeConfigJson) {
+      lockedNodeConfigWrapper.unlock();  // lockedNodeConfigWrapper -> NULL
+      sendConfigResendReq(
+          senderApp, configPatch, request->bwgdIdx, std::nullopt);
+      return;
+    }
+    configJson = std::move(maybeConfigJson.value());
+  }
+
   // Copy the old config
   folly::dynamic oldNodeConfig = folly::dynamic::object;
   try {
@@ -225,7 +240,7 @@ ConfigApp::processConfigSetReq(
   } catch (const std::exception& ex) {/* shouldn't happen */}
 
   // Write the new node config
-  bool success = lockedNodeConfigWrapper->setNodeConfig(request->config);
+  bool success = lockedNodeConfigWrapper->setNodeConfig(configJson);
   if (!success) {
     auto err = "Unable to set node config";
     LOG(ERROR) << err;
@@ -299,10 +314,26 @@ ConfigApp::processGetMinionConfigActionsReq(
     return;
   }
 
+  // Apply the config patch (if any)
+  std::string configJson = request->config;
+  if (request->configPatch_ref().has_value()) {
+    const auto& configPatch = request->configPatch_ref().value();
+    auto maybeConfigJson =
+        SharedObjects::getNodeConfigWrapper()->rlock()->applyConfigPatch(
+            configPatch.patch,
+            configPatch.baseConfigHash,
+            configPatch.configHash);
+    if (!maybeConfigJson) {
+      sendConfigResendReq(senderApp, configPatch, 0, request->id);
+      return;
+    }
+    configJson = std::move(maybeConfigJson.value());
+  }
+
   // Parse the new node config
   folly::dynamic newNodeConfig = folly::dynamic::object;
   try {
-    newNodeConfig = folly::parseJson(request->config);
+    newNodeConfig = folly::parseJson(configJson);
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Unable to parse new node config";
     return;
@@ -333,6 +364,25 @@ ConfigApp::processGetMinionConfigActionsReq(
       getMinionConfigActionsResp);
 }
 
+void
+ConfigApp::sendConfigResendReq(
+    const std::string& senderApp,
+    const thrift::MinionConfigPatch& configPatch,
+    int64_t bwgdIdx,
+    std::optional<std::string> id) {
+  LOG(ERROR) << "Unable to apply config patch, requesting full config";
+  thrift::MinionConfigResendReq minionConfigResendReq;
+  minionConfigResendReq.configHash = configPatch.configHash;
+  minionConfigResendReq.bwgdIdx = bwgdIdx;
+  if (id) {
+    minionConfigResendReq.id_ref() = id.value();
+  }
+  sendToCtrlApp(
+      senderApp,
+      thrift::MessageType::MINION_CONFIG_RESEND_REQ,
+      minionConfigResendReq);
+}
+
 void
 ConfigApp::performNodeActions(
     const std::unordered_map<thrift::CfgAction, std::vector<std::string>>&
@@ -650,7 +700,8 @@ ConfigApp::getFwParamsForConfig(
     if (cfg == "radioParamsBase") {
       // Set config on all radios (since base changed)
       for (const auto& kv : radioFwParamMap) {
-        auto fwParams = lockedNodeConfig->getRadioParams(kv.first).fwParams;
+        const auto& fwParams =
+            lockedNodeConfig->getRadioParams(kv.first).fwParams;
         if (auto val = getFwParam(key, fwParams)) {
           radioFwParamMap[kv.first][key] = *val;
         }
@@ -661,14 +712,15 @@ ConfigApp::getFwParamsForConfig(
         LOG(ERROR) << "Ignoring radioParamsOverride for unknown MAC " << mac;
         continue;
       }
-      auto fwParams = lockedNodeConfig->getRadioParams(mac).fwParams;
+      const auto& fwParams = lockedNodeConfig->getRadioParams(mac).fwParams;
       if (auto val = getFwParam(key, fwParams)) {
         radioFwParamMap[mac][key] = *val;
       }
     } else if (cfg == "linkParamsBase") {
       // Set config on all links (since base changed)
       for (const auto& kv : peerNodeTypeMap) {
-        auto fwParams = lockedNodeConfig->getLinkParams(kv.first).fwParams;
+        const auto& fwParams =
+            lockedNodeConfig->getLinkParams(kv.first).fwParams;
         if (auto val = getFwParam(key, fwParams)) {
           if (!linkFwParamMap.count(kv.first)) {
             linkFwParamMap[kv.first] = folly::dynamic::object;
@@ -678,7 +730,7 @@ ConfigApp::getFwParamsForConfig(
       }
     } else if (cfg == "linkParamsOverride") {
       // Set config on specific link
-      auto fwParams = lockedNodeConfig->getLinkParams(mac).fwParams;
+      const auto& fwParams = lockedNodeConfig->getLinkParams(mac).fwParams;
       if (auto val = getFwParam(key, fwParams)) {
         if (!linkFwParamMap.count(mac)) {
           linkFwParamMap[mac] = folly::dynamic::object;
@@ -66,6 +66,16 @@ class ConfigApp final : public MinionApp {
   void processGetMinionBaseConfig(
       const std::string& senderApp, const thrift::Message& message) noexcept;
 
+  /**
+   * Ask the controller to resend the full config for a config patch that could
+   * not be applied.
+   */
+  void sendConfigResendReq(
+      const std::string& senderApp,
+      const thrift::MinionConfigPatch& configPatch,
+      int64_t bwgdIdx,
+      std::optional<std::string> id);
+
   /**
    * Look up the hardware config type associated with a hardware board ID in the
    * given file.
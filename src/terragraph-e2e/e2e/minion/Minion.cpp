@@ -125,6 +125,12 @@ DEFINE_bool(
     disable_driver_if,
     false,
     "We disable driver if in X86 emulation and run a separate driver daemon");
+DEFINE_bool(
+    report_legacy_config_md5,
+    true,
+    "Compute and report the legacy MD5 hash of the node config JSON in addition "
+    "to the structural config hash (only disable this if the controller does "
+    "not use the legacy MD5 hash)");
 // Broker
 DEFINE_int32(
     ctrl_socket_timeout_s,
@@ -171,6 +177,8 @@ main(int argc, char** argv) {
   // initialize node config
   auto lockedNodeConfigWrapper =
       minion::SharedObjects::getNodeConfigWrapper()->wlock();
+  lockedNodeConfigWrapper->setLegacyConfigMd5Enabled(
+      FLAGS_report_legacy_config_md5);
   lockedNodeConfigWrapper->setNodeConfigFile(FLAGS_node_config_file);
   int64_t wsecEnable =
       lockedNodeConfigWrapper->getRadioParams().fwParams.wsecEnable_ref()
@@ -838,7 +838,7 @@ OpenrClientApp::linkMonitorSync() {
 
     // Get link params
     // "softDisable" takes precedence over "fixedMetric"
-    auto openrLinkParams =
+    const auto& openrLinkParams =
         lockedNodeConfigW->getLinkParams(macIter->second).openrLinkParams;
     if (openrLinkParams.softDisable_ref().has_value() &&
         openrLinkParams.softDisable_ref().value()) {
@@ -418,7 +418,7 @@ StatusApp::initializeNodeParams(const std::string& radioMac) {
   // Populate NodeParams from config...
   thrift::NodeParams nodeParams;
   nodeParams.type = thrift::NodeParamsType::INIT;
-  auto radioParams = lockedNodeConfig->getRadioParams(radioMac);
+  const auto& radioParams = lockedNodeConfig->getRadioParams(radioMac);
   if (radioParams.fwParams.polarity_ref().has_value()) {
     nodeParams.polarity_ref() =
         static_cast<thrift::PolarityType>(radioParams.fwParams.polarity_ref()
@@ -1391,8 +1391,13 @@ StatusApp::buildStatusReport(bool fullReport) const {
   statusReport.ubootVersion = fullReport ? ubootVersion_ : "";
   statusReport.status = myStatus_;
   statusReport.upgradeStatus = upgradeStatus_;
-  statusReport.configMd5 =
-      SharedObjects::getNodeConfigWrapper()->rlock()->getConfigMd5();
+  auto lockedNodeConfigW = SharedObjects::getNodeConfigWrapper()->rlock();
+  statusReport.configMd5 = lockedNodeConfigW->getConfigMd5();
+  std::string configHash = lockedNodeConfigW->getConfigHash();
+  if (!configHash.empty()) {
+    statusReport.configHash_ref() = configHash;
+  }
+  lockedNodeConfigW.unlock();  // lockedNodeConfigW -> NULL
   statusReport.hardwareModel = fullReport ? hardwareModel_ : "";
   statusReport.hardwareBoardId = fullReport ? hardwareBoardId_ : "";
 
@@ -202,6 +202,8 @@ UpgradeApp::startPrepareUpgrade(const thrift::UpgradeReq& upgradeReq) {
   upgradeStatus_.nextImage.md5 = upgradeReq.md5;
   upgradeStatus_.nextImage.version = "";
   upgradeStatus_.upgradeReqId = upgradeReq.upgradeReqId;
+  downloadedImageMd5_.reset();
+  torrentPiecesVerified_ = false;
 
   sendUpgradeStatus();
   eventClient_->logEventThrift(
@@ -387,9 +389,22 @@ UpgradeApp::downloadHttp(
   for (int i = 0; i < downloadAttempts; i++) {
     LOG(INFO) << "Start downloading " << upgradeReq.imageUrl;
     err = "";
-    if (CurlUtil::download(upgradeReq.imageUrl, minionImageLocalPath_, err)) {
+    StreamingImageMd5 imageMd5(minionImageLocalPath_);
+    if (CurlUtil::download(
+            upgradeReq.imageUrl,
+            minionImageLocalPath_,
+            err,
+            [&imageMd5](const char* data, size_t size) {
+              imageMd5.update(data, size);
+            })) {
       LOG(INFO) << "Successfully downloaded " << upgradeReq.imageUrl << " to "
                 << minionImageLocalPath_;
+      try {
+        downloadedImageMd5_ = imageMd5.finalize();
+      } catch (std::exception& e) {
+        // Let getMetaInfo() read the image back instead
+        LOG(ERROR) << folly::exceptionStr(e);
+      }
       prepareProcessImage();
       return true;
     } else {
@@ -661,6 +676,11 @@ UpgradeApp::downloadTorrentUpdate() {
       std::string fileName(fileStorage.file_name(0));
       minionImageLocalPath_ = prepareTorrentState_->localDir + fileName;
     }
+
+    // libtorrent only counts pieces that passed their hash check, so if we
+    // have all of them, there is no need to read the image back to verify it
+    torrentPiecesVerified_ =
+        status.num_pieces > 0 && status.num_pieces == info->num_pieces();
   } else {
     sendPrepareDownloadFailure("Torrent download failed");
     resetPrepareTorrentState();
@@ -708,12 +728,23 @@ UpgradeApp::getMetaInfo() {
     return std::nullopt;
   }
 
-  // Verify the image
-  try {
-    UpgradeUtils::verifyImage(minionImageLocalPath_, downloadedMeta.md5);
-  } catch (std::exception& e) {
-    LOG(ERROR) << folly::exceptionStr(e);
-    return std::nullopt;
+  // Verify the image (unless already done during the download)
+  if (torrentPiecesVerified_) {
+    VLOG(2) << "Image was verified using torrent piece hashes";
+  } else if (downloadedImageMd5_.has_value()) {
+    if (downloadedImageMd5_.value() != downloadedMeta.md5) {
+      LOG(ERROR) << "Bad MD5 in " << minionImageLocalPath_
+                 << ". expected=" << downloadedMeta.md5
+                 << " computed=" << downloadedImageMd5_.value();
+      return std::nullopt;
+    }
+  } else {
+    try {
+      UpgradeUtils::verifyImage(minionImageLocalPath_, downloadedMeta.md5);
+    } catch (std::exception& e) {
+      LOG(ERROR) << folly::exceptionStr(e);
+      return std::nullopt;
+    }
   }
 
   return downloadedMeta;
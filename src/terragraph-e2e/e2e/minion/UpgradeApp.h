@@ -138,7 +138,8 @@ class UpgradeApp final : public MinionApp {
   /**
    * Read and parse meta information from the downloaded image.
    *
-   * This also performs basic validity checks by locally computing the MD5 hash.
+   * This also performs basic validity checks by locally computing the MD5 hash
+   * (unless the image was already verified during the download).
    *
    * Returns std::nullopt upon any failures.
    */
@@ -160,6 +161,19 @@ class UpgradeApp final : public MinionApp {
   /** Full path of the downloaded software image (during the PREPARE phase). */
   std::string minionImageLocalPath_{};
 
+  /**
+   * The MD5 hash of the downloaded software image (excluding the header),
+   * if computed while downloading it over HTTP.
+   */
+  std::optional<std::string> downloadedImageMd5_{};
+
+  /**
+   * Whether all pieces of the downloaded software image were verified against
+   * the torrent's piece hashes (which the controller created from a verified
+   * image).
+   */
+  bool torrentPiecesVerified_{false};
+
   /**
    * Whether to use (and only allow) HTTPS sessions to download new software
    * images.
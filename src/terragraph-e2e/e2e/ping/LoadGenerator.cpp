@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Load generator for the UDP ping server.
+//
+// Each thread keeps a window of probes outstanding to the target on its own
+// socket, and records the round-trip time of every echoed probe along with
+// the latency added by the target (from the target's receive and response
+// timestamps). The throughput and latency percentiles are reported at the end.
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "Probe.h"
+
+DEFINE_string(target, "::1", "IPv6 address of the UDP ping server");
+DEFINE_int32(port, 31338, "UDP port of the UDP ping server");
+DEFINE_int32(duration_s, 10, "Duration of the test, in seconds");
+DEFINE_int32(num_threads, 2, "Number of sending threads (one socket each)");
+DEFINE_int32(window, 64, "Number of outstanding probes per thread");
+DEFINE_int32(tclass, 0, "Traffic class of the probes");
+DEFINE_int32(
+    timeout_ms,
+    1000,
+    "Time (in ms) after which outstanding probes are considered lost");
+
+using namespace facebook::terragraph;
+
+namespace {
+// Results of a single thread
+struct Results {
+  uint64_t sent{0};
+  uint64_t received{0};
+  // Round-trip time of each echoed probe (usec)
+  std::vector<uint32_t> rttUs;
+  // Latency added by the target for each echoed probe (usec)
+  std::vector<uint32_t> targetUs;
+};
+
+uint32_t
+getNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void
+runThread(const struct sockaddr_in6& target, uint32_t signature, Results& r) {
+  int sockFd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  if (sockFd < 0) {
+    LOG(ERROR) << "socket() failed: " << std::strerror(errno);
+    return;
+  }
+  if (connect(sockFd, (const struct sockaddr*)&target, sizeof(target)) < 0) {
+    LOG(ERROR) << "connect() failed: " << std::strerror(errno);
+    close(sockFd);
+    return;
+  }
+
+  size_t window = std::max(FLAGS_window, 1);
+  std::vector<ProbeBody> probes(window);
+  std::vector<struct iovec> iovecs(window);
+  std::vector<struct mmsghdr> msgs(window);
+  for (size_t i = 0; i < window; i++) {
+    iovecs[i].iov_base = &probes[i];
+    iovecs[i].iov_len = kProbeDataLen;
+    memset(&msgs[i], 0, sizeof(msgs[i]));
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(FLAGS_duration_s);
+  size_t outstanding = 0;
+  while (std::chrono::steady_clock::now() < deadline) {
+    // Fill the window
+    size_t toSend = window - outstanding;
+    if (toSend > 0) {
+      uint32_t now = getNowUs();
+      for (size_t i = 0; i < toSend; i++) {
+        memset(&probes[i], 0, sizeof(ProbeBody));
+        probes[i].signature = htonl(signature);
+        probes[i].pingerSentTime = htonl(now);
+        probes[i].tclass = FLAGS_tclass;
+      }
+      int sent = sendmmsg(sockFd, msgs.data(), toSend, 0);
+      if (sent < 0) {
+        LOG(ERROR) << "sendmmsg() failed: " << std::strerror(errno);
+        break;
+      }
+      outstanding += sent;
+      r.sent += sent;
+    }
+
+    // Collect echoes
+    struct pollfd pfd = {sockFd, POLLIN, 0};
+    int ready = poll(&pfd, 1, FLAGS_timeout_ms);
+    if (ready == 0) {
+      outstanding = 0; // lost
+      continue;
+    }
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(ERROR) << "poll() failed: " << std::strerror(errno);
+      break;
+    }
+    int received = recvmmsg(sockFd, msgs.data(), window, MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED) {
+        continue;
+      }
+      LOG(ERROR) << "recvmmsg() failed: " << std::strerror(errno);
+      break;
+    }
+    uint32_t now = getNowUs();
+    for (int i = 0; i < received; i++) {
+      const ProbeBody& probe = probes[i];
+      if (msgs[i].msg_len < (unsigned int)kProbeDataLen ||
+          ntohl(probe.signature) != signature) {
+        continue;
+      }
+      r.received++;
+      r.rttUs.push_back(now - ntohl(probe.pingerSentTime));
+      r.targetUs.push_back(
+          ntohl(probe.targetRespTime) - ntohl(probe.targetRcvdTime));
+    }
+    outstanding -= std::min(outstanding, (size_t)received);
+  }
+
+  close(sockFd);
+}
+
+void
+printPercentiles(const std::string& name, std::vector<uint32_t>& values) {
+  if (values.empty()) {
+    return;
+  }
+  std::sort(values.begin(), values.end());
+  auto percentile = [&values](double p) {
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+  };
+  std::cout << folly::format(
+                   "{:<16} p50={}us p90={}us p99={}us p99.9={}us max={}us",
+                   name,
+                   percentile(0.5),
+                   percentile(0.9),
+                   percentile(0.99),
+                   percentile(0.999),
+                   values.back())
+            << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+
+  struct sockaddr_in6 target;
+  memset(&target, 0, sizeof(target));
+  target.sin6_family = AF_INET6;
+  target.sin6_port = htons(FLAGS_port);
+  if (inet_pton(AF_INET6, FLAGS_target.c_str(), &target.sin6_addr) != 1) {
+    LOG(ERROR) << "Invalid target address: " << FLAGS_target;
+    return 1;
+  }
+
+  uint32_t signature = folly::Random::rand32();
+  std::vector<Results> results(std::max(FLAGS_num_threads, 1));
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& r : results) {
+    threads.emplace_back([&target, signature, &r]() {
+      runThread(target, signature, r);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  Results total;
+  for (auto& r : results) {
+    total.sent += r.sent;
+    total.received += r.received;
+    total.rttUs.insert(total.rttUs.end(), r.rttUs.begin(), r.rttUs.end());
+    total.targetUs.insert(
+        total.targetUs.end(), r.targetUs.begin(), r.targetUs.end());
+  }
+
+  std::cout << folly::format(
+                   "Sent {} probes, received {} ({:.2f}% lost) in {:.1f}s: "
+                   "{:.0f} probes/sec",
+                   total.sent,
+                   total.received,
+                   total.sent ? 100.0 * (total.sent - total.received) /
+                                    total.sent
+                              : 0.0,
+                   elapsed,
+                   total.received / elapsed)
+            << std::endl;
+  printPercentiles("RTT", total.rttUs);
+  printPercentiles("Target latency", total.targetUs);
+  return 0;
+}
@@ -26,6 +26,12 @@
 using namespace facebook::terragraph;
 
 DEFINE_int32(num_ping_threads, 2, "Number of ping thread pairs to start");
+DEFINE_int32(
+    ping_batch_size,
+    0,
+    "If positive, start one thread per socket instead of a thread pair, which "
+    "receives and echoes probes in batches of up to this many probes "
+    "(recvmmsg/sendmmsg)");
 DEFINE_int32(ping_port, 31338, "UDP port to listen for ping agent probes");
 DEFINE_int32(ping_queue_cap, 64000, "Capacity of ping shared queue");
 DEFINE_int32(
@@ -120,6 +126,17 @@ main(int argc, char* argv[]) {
               << "[" << *host << "]"
               << ":" << FLAGS_ping_port;
 
+    if (FLAGS_ping_batch_size > 0) {
+      receiverThreads.emplace_back(std::thread([socket, i]() {
+        auto target =
+            std::make_shared<TargetBatchThread>(socket, FLAGS_ping_batch_size);
+        folly::setThreadName(
+            pthread_self(), folly::sformat("Ping Target {}", i));
+        target->run();
+      }));
+      continue;
+    }
+
     auto queue = std::make_shared<folly::MPMCQueue<std::unique_ptr<Probe>>>(
         FLAGS_ping_queue_cap);
 
@@ -10,6 +10,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <exception>
@@ -61,6 +62,91 @@ getIpPortStr(const Probe* probe) {
   return folly::sformat("{}:{}", host, port);
 }
 
+/**
+ * Returns the current system time in usecs, truncated to 32 bits.
+ */
+static uint32_t
+getNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Sets the time at which the probe was received, from the kernel timestamp in
+ * the control data of the received message (if any).
+ */
+static void
+setProbeRcvdTime(Probe* probe, struct msghdr* msg) {
+  struct cmsghdr* cmsg{nullptr};
+  struct timespec* stamp{nullptr};
+
+  for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    switch (cmsg->cmsg_level) {
+      case SOL_SOCKET:
+        switch (cmsg->cmsg_type) {
+          case SO_TIMESTAMPNS: {
+            stamp = (struct timespec*)CMSG_DATA(cmsg);
+            break;
+          }
+        }
+        break;
+    }
+  }
+
+  // Kernel returned the timestamp
+  if (stamp) {
+    probe->probeBody.targetRcvdTime =
+        htonl(stamp->tv_sec * 1000000 + stamp->tv_nsec / 1000);
+  } else {
+    FB_LOG_EVERY_MS(INFO, 1000) << "Kernel timestamp not available";
+
+    // Use system time to approximate
+    probe->probeBody.targetRcvdTime = htonl(getNowUs());
+  }
+}
+
+/**
+ * Stamps the probe with the response time 'now', and prepares the message
+ * echoing it back to the pinging agent (using the probe's traffic class).
+ *
+ * @param cbuf Control data buffer of at least kProbeCmsgLen bytes.
+ */
+static void
+prepareEcho(Probe* probe, uint32_t now, struct msghdr* msg, char* cbuf) {
+  probe->probeBody.targetRespTime = htonl(now);
+
+  FB_LOG_EVERY_MS(INFO, 1000) << folly::sformat(
+      "Probe originated at {}, received at {} responded at {}, adjusted by {}",
+      ntohl(probe->probeBody.pingerSentTime),
+      ntohl(probe->probeBody.targetRcvdTime),
+      ntohl(probe->probeBody.targetRespTime),
+      ntohl(probe->probeBody.targetRespTime) -
+          ntohl(probe->probeBody.targetRcvdTime));
+
+  struct cmsghdr* cmsg;
+
+  memset(cbuf, 0, kProbeCmsgLen);
+  cmsg = (struct cmsghdr*)cbuf;
+
+  msg->msg_iov->iov_base = probe->data;
+  msg->msg_iov->iov_len = kProbeDataLen;
+
+  // Set the ancilliary data (tclass in this case)
+  int tclass = probe->probeBody.tclass;
+  msg->msg_control = cmsg;
+  msg->msg_controllen = CMSG_SPACE(sizeof(tclass));
+
+  cmsg->cmsg_len = CMSG_LEN(sizeof(tclass));
+  cmsg->cmsg_level = IPPROTO_IPV6;
+  cmsg->cmsg_type = IPV6_TCLASS;
+
+  ::memcpy(CMSG_DATA(cmsg), &tclass, sizeof(tclass));
+
+  msg->msg_name = &probe->clientAddr;
+  msg->msg_namelen = probe->clientAddrLen;
+}
+
 /*
  * Binds a socket to host/port. Since socket option IPV6_V6ONLY is false by
  * default, an IPv6 socket can handle IPv4 probes as well on a dual-stack host.
@@ -190,35 +276,8 @@ TargetReceiverThread::receiveProbe(Probe* probe) {
     throw std::runtime_error("recvmsg() truncated probe (unexpected)");
   }
 
-  struct cmsghdr* cmsg{nullptr};
-  struct timespec* stamp{nullptr};
-
-  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-    switch (cmsg->cmsg_level) {
-      case SOL_SOCKET:
-        switch (cmsg->cmsg_type) {
-          case SO_TIMESTAMPNS: {
-            stamp = (struct timespec*)CMSG_DATA(cmsg);
-            break;
-          }
-        }
-        break;
-    }
-  }
-
-  // Kernel returned the timestamp
-  if (stamp) {
-    probe->probeBody.targetRcvdTime =
-        htonl(stamp->tv_sec * 1000000 + stamp->tv_nsec / 1000);
-  } else {
-    FB_LOG_EVERY_MS(INFO, 1000) << "Kernel timestamp not available";
-
-    // Use system time to approximate
-    probe->probeBody.targetRcvdTime =
-        std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count();
-  }
+  probe->clientAddrLen = msg.msg_namelen;
+  setProbeRcvdTime(probe, &msg);
 
   return true;
 }
@@ -281,51 +340,17 @@ TargetSenderThread::dequeueProbe(std::optional<int32_t> timeout_m) {
 
 void
 TargetSenderThread::echoProbe(Probe* probe) {
-  uint32_t now = std::chrono::duration_cast<std::chrono::microseconds>(
-                     std::chrono::system_clock::now().time_since_epoch())
-                     .count();
-
-  probe->probeBody.targetRespTime = htonl(now);
-
-  FB_LOG_EVERY_MS(INFO, 1000) << folly::sformat(
-      "Probe originated at {}, received at {} responded at {}, adjusted by {}",
-      ntohl(probe->probeBody.pingerSentTime),
-      ntohl(probe->probeBody.targetRcvdTime),
-      ntohl(probe->probeBody.targetRespTime),
-      ntohl(probe->probeBody.targetRespTime) -
-          ntohl(probe->probeBody.targetRcvdTime));
-
   // prepare the message for sending
   struct msghdr msg;
-  struct cmsghdr* cmsg;
   struct iovec entry;
 
   // control data buffer, hardcoded - we only store tclass there
-  char cbuf[256];
+  alignas(struct cmsghdr) char cbuf[kProbeCmsgLen];
 
   memset(&msg, 0, sizeof(msg));
-  memset(cbuf, 0, sizeof(cbuf));
-  cmsg = (struct cmsghdr*)cbuf;
-
   msg.msg_iov = &entry;
   msg.msg_iovlen = 1;
-
-  entry.iov_base = probe->data;
-  entry.iov_len = kProbeDataLen;
-
-  // Set the ancilliary data (tclass in this case)
-  int tclass = probe->probeBody.tclass;
-  msg.msg_control = cmsg;
-  msg.msg_controllen = CMSG_SPACE(sizeof(tclass));
-
-  cmsg->cmsg_len = CMSG_LEN(sizeof(tclass));
-  cmsg->cmsg_level = IPPROTO_IPV6;
-  cmsg->cmsg_type = IPV6_TCLASS;
-
-  ::memcpy(CMSG_DATA(cmsg), &tclass, sizeof(tclass));
-
-  msg.msg_name = &probe->clientAddr;
-  msg.msg_namelen = sizeof(probe->clientAddr);
+  prepareEcho(probe, getNowUs(), &msg, cbuf);
 
   // this is a blocking call
   int sendLen = sendmsg(sockFd_, &msg, 0);
@@ -367,5 +392,128 @@ TargetSenderThread::run(std::optional<int32_t> timeout_m) {
   LOG(INFO) << "Finished run()";
 }
 
+TargetBatchThread::TargetBatchThread(int sockFd, size_t batchSize)
+    : sockFd_(sockFd),
+      batchSize_(std::max<size_t>(batchSize, 1)),
+      probes_(batchSize_),
+      msgs_(batchSize_),
+      iovecs_(batchSize_),
+      cbufs_(batchSize_),
+      echoedProbes_(batchSize_) {}
+
+size_t
+TargetBatchThread::receiveProbes() {
+  for (size_t i = 0; i < batchSize_; i++) {
+    Probe& probe = probes_[i];
+    struct msghdr& msg = msgs_[i].msg_hdr;
+
+    memset(&msg, 0, sizeof(msg));
+    msgs_[i].msg_len = 0;
+
+    msg.msg_iov = &iovecs_[i];
+    msg.msg_iovlen = 1;
+
+    iovecs_[i].iov_base = probe.data;
+    iovecs_[i].iov_len = kProbeDataLen;
+
+    msg.msg_control = cbufs_[i].data;
+    msg.msg_controllen = kProbeCmsgLen;
+
+    // Prepare to receive either v4 or v6 addresses
+    ::memset(&probe.clientAddr, 0, sizeof(probe.clientAddr));
+    msg.msg_name = &probe.clientAddr;
+    msg.msg_namelen = sizeof(probe.clientAddr);
+  }
+
+  // Block until a probe arrives, then also take any probes already queued
+  int count =
+      ::recvmmsg(sockFd_, msgs_.data(), batchSize_, MSG_WAITFORONE, nullptr);
+  if (count == -1) {
+    if (errno == EWOULDBLOCK || errno == EAGAIN) {
+      LOG(ERROR) << "recvmmsg() timed out: " << std::strerror(errno);
+      return 0;
+    }
+
+    throw std::runtime_error(
+        folly::sformat("recvmmsg() failed: {}", std::strerror(errno)));
+  }
+
+  return count;
+}
+
+void
+TargetBatchThread::echoProbes(size_t count) {
+  uint32_t now = getNowUs();
+
+  // Turn the received messages into echoes in place, skipping bad probes
+  size_t numEchoes = 0;
+  for (size_t i = 0; i < count; i++) {
+    Probe& probe = probes_[i];
+    probe.clientAddrLen = msgs_[i].msg_hdr.msg_namelen;
+    if (msgs_[i].msg_len < (unsigned int)kProbeDataLen) {
+      FB_LOG_EVERY_MS(ERROR, 1000) << "Received " << msgs_[i].msg_len
+                                   << " bytes expected " << kProbeDataLen;
+      continue;
+    }
+    setProbeRcvdTime(&probe, &msgs_[i].msg_hdr);
+
+    struct msghdr& msg = msgs_[numEchoes].msg_hdr;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iovecs_[numEchoes];
+    msg.msg_iovlen = 1;
+    prepareEcho(&probe, now, &msg, cbufs_[numEchoes].data);
+    echoedProbes_[numEchoes++] = &probe;
+  }
+
+  // this is a blocking call
+  size_t sent = 0;
+  while (sent < numEchoes) {
+    int res = ::sendmmsg(sockFd_, msgs_.data() + sent, numEchoes - sent, 0);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      // The first remaining echo failed, so skip it
+      string clientIpPort;
+      try {
+        clientIpPort = getIpPortStr(echoedProbes_[sent]);
+      } catch (const std::runtime_error& e) {
+        clientIpPort = "unknown client";
+      }
+      LOG(ERROR) << "sendmmsg() to " << clientIpPort
+                 << " failed: " << std::strerror(errno);
+      sent++;
+      continue;
+    }
+    sent += res;
+  }
+}
+
+void
+TargetBatchThread::run() {
+  while (1) {
+    size_t count;
+    try {
+      count = receiveProbes();
+    } catch (const std::runtime_error& e) {
+      LOG(ERROR) << "receiveProbes() failed: " << folly::exceptionStr(e);
+      if (FLAGS_err_sleep_ms > 0) {
+        /* sleep override */ std::this_thread::sleep_for(
+            std::chrono::milliseconds(FLAGS_err_sleep_ms));
+      }
+      continue;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    echoProbes(count);
+  }
+
+  shutdown(sockFd_, SHUT_RDWR);
+  LOG(INFO) << "Finished run()";
+}
+
 } // namespace terragraph
 } // namespace facebook
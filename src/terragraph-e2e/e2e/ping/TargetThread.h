@@ -12,6 +12,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <folly/MPMCQueue.h>
 
@@ -22,6 +23,10 @@ namespace terragraph {
 
 const int kSockFdInvalid = -1;
 
+// The size of the control data buffer for each probe message. This should be
+// enough to hold either a receive timestamp or a traffic class.
+const size_t kProbeCmsgLen = 64;
+
 /**
  * Contents/metadata of a probe message from the pinging agent.
  */
@@ -118,5 +123,58 @@ class TargetSenderThread {
   std::shared_ptr<folly::MPMCQueue<std::unique_ptr<Probe>>> probeQueue_;
 };
 
+/**
+ * A thread that receives UDP probes from pinging agents and echoes them back
+ * itself, in batches of preallocated probes (using recvmmsg() and sendmmsg()).
+ *
+ * Unlike the receiver/sender thread pair, probes are never handed off to
+ * another thread. Each thread should use its own socket bound with
+ * SO_REUSEPORT, so the kernel spreads incoming probes across threads.
+ */
+class TargetBatchThread {
+ public:
+  TargetBatchThread(int sockFd, size_t batchSize);
+
+  /**
+   * Receives and echoes probes on socket 'sockFd_' until the socket read
+   * times out.
+   */
+  void run();
+
+ private:
+  /**
+   * Receives up to batchSize_ probes on sockFd_. Blocks until at least one
+   * probe is received or recvmmsg() fails.
+   *
+   * @return the number of probes received, or 0 if the socket read timed out.
+   *
+   * @throw std::runtime_error if recvmmsg() fails.
+   */
+  size_t receiveProbes();
+
+  /**
+   * Echoes the first 'count' probes back to their pinging agents. Blocks until
+   * able to write to socket's send buffer.
+   */
+  void echoProbes(size_t count);
+
+  int sockFd_ = kSockFdInvalid;
+  size_t batchSize_;
+
+  // Control data buffer for a single message
+  struct CmsgBuffer {
+    alignas(struct cmsghdr) char data[kProbeCmsgLen];
+  };
+
+  // Preallocated probes, and the messages/buffers used to receive and send them
+  std::vector<Probe> probes_;
+  std::vector<struct mmsghdr> msgs_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<CmsgBuffer> cbufs_;
+
+  // The probe echoed by each message in msgs_ (after echoProbes() compacts it)
+  std::vector<Probe*> echoedProbes_;
+};
+
 } // namespace terragraph
 } // namespace facebook
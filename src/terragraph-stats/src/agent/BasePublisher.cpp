@@ -34,7 +34,12 @@ BasePublisher::BasePublisher(
       convertToRate_{statsAgentParams.publisherParams.convertToRate},
       publishValueWithRate_{
           statsAgentParams.publisherParams.publishValueWithRate},
-      className_(className) {
+      className_(className),
+      statsBlacklist_(
+          statsAgentParams.publisherParams.statsBlacklist, "stats blacklist"),
+      highFrequencyStatsWhitelist_(
+          statsAgentParams.publisherParams.highFrequencyStatsWhitelist,
+          "high-frequency stats whitelist") {
   // Load configs
   auto lockedNodeConfig = SharedObjects::getNodeConfigWrapper()->rlock();
   topologyName_ = lockedNodeConfig->getTopologyInfo()->topologyName;
@@ -43,32 +48,6 @@ BasePublisher::BasePublisher(
 
   // Initialize ZMQ sockets
   prepare(statsAgentParams);
-
-  // Initialize stats blacklist
-  for (const auto& kv : statsAgentParams.publisherParams.statsBlacklist) {
-    try {
-      statsBlacklist_.push_back(std::regex(kv.second));
-      VLOG(3) << "Blacklisting stats under group '" << kv.first << "': "
-              << kv.second;
-    } catch (const std::regex_error& ex) {
-      LOG(ERROR) << "Ignoring malformed regex for stats blacklist group "
-                 << kv.first << ": " << kv.second << " (" << ex.what() << ")";
-    }
-  }
-
-  // Initialize high-frequency stats whitelist
-  for (const auto& kv :
-       statsAgentParams.publisherParams.highFrequencyStatsWhitelist) {
-    try {
-      highFrequencyStatsWhitelist_.push_back(std::regex(kv.second));
-      VLOG(3) << "Whitelisting high-frequency stats under group '" << kv.first
-               << "': " << kv.second;
-    } catch (const std::regex_error& ex) {
-      LOG(ERROR) << "Ignoring malformed regex for high-frequency stats "
-                    "whitelist group " << kv.first << ": " << kv.second << " ("
-                 << ex.what() << ")";
-    }
-  }
 }
 
 void
@@ -139,25 +118,14 @@ BasePublisher::prepare(
   }
 }
 
-bool
-BasePublisher::regexMatches(
-    const std::string& key, const std::vector<std::regex>& regexes) {
-  for (const auto& regex : regexes) {
-    if (std::regex_match(key, regex)) {
-      return true;
-    }
-  }
-  return false;
-}
-
 bool
 BasePublisher::isBlacklisted(const std::string& key) {
-  return regexMatches(key, statsBlacklist_);
+  return statsBlacklist_.matches(key);
 }
 
 bool
 BasePublisher::isWhitelisted(const std::string& key) {
-  return regexMatches(key, highFrequencyStatsWhitelist_);
+  return highFrequencyStatsWhitelist_.matches(key);
 }
 
 std::optional<thrift::Event>
@@ -7,8 +7,6 @@
 
 #pragma once
 
-#include <regex>
-
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <fbzmq/service/if/gen-cpp2/Monitor_types.h>
 #include <fbzmq/zmq/Zmq.h>
@@ -17,6 +15,7 @@
 #include "e2e/if/gen-cpp2/Event_types.h"
 #include "e2e/if/gen-cpp2/NodeConfig_types.h"
 #include "stats/if/gen-cpp2/Aggregator_types.h"
+#include "StatsKeyFilter.h"
 
 namespace facebook {
 namespace terragraph {
@@ -93,10 +92,6 @@ class BasePublisher : public fbzmq::ZmqEventLoop {
   // Initializes ZMQ sockets
   void prepare(const thrift::StatsAgentParams& statsAgentParams) noexcept;
 
-  // Check if the key matches any regex in the given list.
-  bool regexMatches(
-      const std::string& key, const std::vector<std::regex>& regexes);
-
   // The subclass name (for internal use)
   std::string className_;
 
@@ -104,10 +99,10 @@ class BasePublisher : public fbzmq::ZmqEventLoop {
   std::vector<fbzmq::Socket<ZMQ_SUB, fbzmq::ZMQ_CLIENT>> csSubSockList_;
 
   // Stats blacklisted regular expressions
-  std::vector<std::regex> statsBlacklist_;
+  StatsKeyFilter statsBlacklist_;
 
   // High-frequency stats whitelisted regular expressions
-  std::vector<std::regex> highFrequencyStatsWhitelist_;
+  StatsKeyFilter highFrequencyStatsWhitelist_;
 };
 
 } // namespace stats
@@ -26,6 +26,11 @@ DEFINE_int32(
     30,
     "Retransmit dropped events to Kafka at this interval (in seconds)");
 
+DEFINE_int32(
+    kafka_stats_batch_max_size,
+    5000,
+    "Maximum number of stats in one batched Kafka stats message");
+
 using apache::thrift::detail::TEnumMapFactory;
 using cppkafka::Configuration;
 using cppkafka::Topic;
@@ -34,6 +39,10 @@ using cppkafka::MessageBuilder;
 namespace {
 // microseconds per second
 const int kUsPerS{1000000};
+
+// Kafka stats formats (see thrift::KafkaStatsFormats)
+const std::string kKafkaStatsFormatJson{"json"};
+const std::string kKafkaStatsFormatThriftCompact{"thrift_compact"};
 } // namespace
 
 namespace facebook {
@@ -58,12 +67,14 @@ KafkaPublisher::KafkaPublisher(
   // Create timers for periodically pushing stats/events to Kafka
   const bool makePeriodic = true;
   nmsDefaultReportTimer_ = fbzmq::ZmqTimeout::make(this, [&]() noexcept {
-    pushQueuedStats(curValuesLF_, prevValuesLF_, kafkaTopics_.statsTopic);
+    pushQueuedStats(
+        curValuesLF_, prevValuesLF_, kafkaTopics_.statsTopic, batchStats_);
   });
   nmsDefaultReportTimer_->scheduleTimeout(
       nmsDefaultReportInterval_, makePeriodic);
   nmsHighFrequencyReportTimer_ = fbzmq::ZmqTimeout::make(this, [&]() noexcept {
-    pushQueuedStats(curValuesHF_, prevValuesHF_, kafkaTopics_.hfStatsTopic);
+    pushQueuedStats(
+        curValuesHF_, prevValuesHF_, kafkaTopics_.hfStatsTopic, batchHfStats_);
   });
   nmsHighFrequencyReportTimer_->scheduleTimeout(
       nmsHighFrequencyReportInterval_, makePeriodic);
@@ -105,6 +116,8 @@ KafkaPublisher::kafkaInit(const thrift::KafkaParams& kafkaParams) {
       {"message.timeout.ms", kafkaParams.config.messageTimeoutMs},
   };
   kafkaTopics_ = kafkaParams.topics;
+  batchStats_ = isBatchedStatsFormat(kafkaParams.statsFormats.statsTopic);
+  batchHfStats_ = isBatchedStatsFormat(kafkaParams.statsFormats.hfStatsTopic);
   kafkaMaxBufferSize_ =
       (size_t)std::max(0, kafkaParams.config.queueBufferingMaxMessages);
 
@@ -189,6 +202,18 @@ KafkaPublisher::kafkaInit(const thrift::KafkaParams& kafkaParams) {
   });
 }
 
+bool
+KafkaPublisher::isBatchedStatsFormat(const std::string& format) {
+  if (format == kKafkaStatsFormatThriftCompact) {
+    return true;
+  }
+  if (format != kKafkaStatsFormatJson) {
+    LOG(ERROR) << "Unknown Kafka stats format '" << format << "', using '"
+               << kKafkaStatsFormatJson << "'";
+  }
+  return false;
+}
+
 void
 KafkaPublisher::processCountersMessage(
     const fbzmq::thrift::CounterValuesResponse& counters) noexcept {
@@ -355,7 +380,8 @@ void
 KafkaPublisher::pushQueuedStats(
     KafkaPublisher::StatsMap& curValues,
     KafkaPublisher::StatsMap& prevValues,
-    const std::string& statsTopic) {
+    const std::string& statsTopic,
+    bool batched) {
   // Skip empty stats queue
   if (curValues.empty()) {
     return;
@@ -367,6 +393,13 @@ KafkaPublisher::pushQueuedStats(
                << kafkaMaxBufferSize_ << " messages), dropping "
                << curValues.size() << " new stat(s)";
   } else {
+    std::optional<KafkaStatsBatch> batch;
+    if (batched) {
+      batch.emplace();
+    }
+    KafkaStatsBatch* batchPtr = batch ? &batch.value() : nullptr;
+    statsMessageCount_ = 0;
+
     size_t produceCount = 0;
     for (const auto& counterKv : curValues) {
       int64_t ts = counterKv.second.timestamp_ref().value();
@@ -382,17 +415,19 @@ KafkaPublisher::pushQueuedStats(
           // Publish raw value and rate as separate keys
           publishStat(
               statsTopic, counterKv.first, ts,
-              counterKv.second.value_ref().value(), true);
+              counterKv.second.value_ref().value(), true, batchPtr);
           produceCount++;
           if (maybeRate) {
             publishStat(
-                statsTopic, counterKv.first + ".rate", ts, *maybeRate, false);
+                statsTopic, counterKv.first + ".rate", ts, *maybeRate, false,
+                batchPtr);
             produceCount++;
           }
         } else {
           // Publish rate only (if valid)
           if (maybeRate) {
-            publishStat(statsTopic, counterKv.first, ts, *maybeRate, true);
+            publishStat(
+                statsTopic, counterKv.first, ts, *maybeRate, true, batchPtr);
             produceCount++;
           }
         }
@@ -400,12 +435,16 @@ KafkaPublisher::pushQueuedStats(
         // Push raw value
         publishStat(
             statsTopic, counterKv.first, ts,
-            counterKv.second.value_ref().value(), isCounter);
+            counterKv.second.value_ref().value(), isCounter, batchPtr);
         produceCount++;
       }
     }
+    if (batch && !batch->empty()) {
+      publishStatsBatch(statsTopic, batch.value());
+    }
 
-    VLOG(2) << "Produced " << produceCount << " stat(s) to Kafka topic '"
+    VLOG(2) << "Produced " << produceCount << " stat(s) in "
+            << statsMessageCount_ << " message(s) to Kafka topic '"
             << statsTopic << "'";
   }
 
@@ -421,9 +460,20 @@ KafkaPublisher::publishStat(
     const std::string& key,
     int64_t timestamp,
     double val,
-    bool isCounter) {
+    bool isCounter,
+    KafkaStatsBatch* batch) {
   // Create stat key
   const StatInfo info(key, macAddr_);
+
+  // Append to batch (if batching)
+  if (batch) {
+    batch->add(info.key, info.entity, timestamp, val, isCounter);
+    if (batch->size() >= (size_t)FLAGS_kafka_stats_batch_max_size) {
+      publishStatsBatch(statsTopic, *batch);
+    }
+    return;
+  }
+
   thrift::AggrStat stat;
   stat.timestamp = timestamp;
   stat.key = info.key;
@@ -436,9 +486,22 @@ KafkaPublisher::publishStat(
       JsonUtils::serializeToJson<thrift::AggrStat>(stat);
   kafkaProducer_->add_message(
       MessageBuilder(statsTopic).key(stat.key).payload(statJson));
+  statsMessageCount_++;
   VLOG(6) << "Produced to '" << statsTopic << "': " << statJson;
 }
 
+void
+KafkaPublisher::publishStatsBatch(
+    const std::string& statsTopic, KafkaStatsBatch& batch) {
+  size_t batchSize = batch.size();
+  const std::string payload = batch.serializeAndClear();
+  kafkaProducer_->add_message(
+      MessageBuilder(statsTopic).key(macAddr_).payload(payload));
+  statsMessageCount_++;
+  VLOG(4) << "Produced batch of " << batchSize << " stat(s) ("
+          << payload.size() << " bytes) to '" << statsTopic << "'";
+}
+
 void
 KafkaPublisher::cacheEvents() {
   // Copy event queues to a single EventLog
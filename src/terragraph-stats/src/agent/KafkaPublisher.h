@@ -16,6 +16,7 @@
 #include <fbzmq/async/ZmqTimeout.h>
 
 #include "BasePublisher.h"
+#include "KafkaStatsBatch.h"
 #include "e2e/if/gen-cpp2/NodeConfig_types.h"
 #include "stats/if/gen-cpp2/Aggregator_types.h"
 
@@ -54,17 +55,30 @@ class KafkaPublisher final : public BasePublisher {
   // Initializes Kafka-related structures
   void kafkaInit(const thrift::KafkaParams& kafkaParams);
 
+  // Return whether stats for the given format should be batched
+  static bool isBatchedStatsFormat(const std::string& format);
+
   // Push queued stats to Kafka.
+  //
+  // If "batched" is set, all stats are packed into AggrStatsBatch messages
+  // instead of one JSON message per stat.
   void pushQueuedStats(
-      StatsMap& curValues, StatsMap& prevValues, const std::string& statsTopic);
+      StatsMap& curValues,
+      StatsMap& prevValues,
+      const std::string& statsTopic,
+      bool batched);
 
-  // Push a single stat to Kafka.
+  // Push a single stat to Kafka, or append it to the batch (if non-null).
   void publishStat(
       const std::string& statsTopic,
       const std::string& key,
       int64_t timestamp,
       double val,
-      bool isCounter);
+      bool isCounter,
+      KafkaStatsBatch* batch);
+
+  // Push a batch of stats to Kafka as one message.
+  void publishStatsBatch(const std::string& statsTopic, KafkaStatsBatch& batch);
 
   // Push eventsDropped_ to Kafka.
   void pushDroppedEvents();
@@ -107,6 +121,12 @@ class KafkaPublisher final : public BasePublisher {
   std::unique_ptr<cppkafka::BufferedProducer<std::string>> kafkaProducer_;
   // Kafka topics
   thrift::KafkaTopics kafkaTopics_;
+  // Whether to batch stats on statsTopic
+  bool batchStats_{false};
+  // Whether to batch stats on hfStatsTopic
+  bool batchHfStats_{false};
+  // Number of Kafka messages produced by the current pushQueuedStats() call
+  size_t statsMessageCount_{0};
   // Max Kafka buffer size
   size_t kafkaMaxBufferSize_ = 0;
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "KafkaStatsBatch.h"
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+void
+KafkaStatsBatch::add(
+    const std::string& key,
+    const std::string& entity,
+    int64_t timestamp,
+    double value,
+    bool isCounter) {
+  batch_.keyIdx.push_back(getIndex(key, batch_.keys, keyIndex_));
+  batch_.entityIdx.push_back(getIndex(entity, batch_.entities, entityIndex_));
+  batch_.timestamps.push_back(timestamp);
+  batch_.values.push_back(value);
+  batch_.isCounter.push_back(isCounter);
+}
+
+size_t
+KafkaStatsBatch::size() const {
+  return batch_.values.size();
+}
+
+bool
+KafkaStatsBatch::empty() const {
+  return batch_.values.empty();
+}
+
+std::string
+KafkaStatsBatch::serializeAndClear() {
+  std::string payload =
+      apache::thrift::CompactSerializer::serialize<std::string>(batch_);
+  batch_ = thrift::AggrStatsBatch();
+  keyIndex_.clear();
+  entityIndex_.clear();
+  return payload;
+}
+
+int32_t
+KafkaStatsBatch::getIndex(
+    const std::string& s,
+    std::vector<std::string>& dict,
+    std::unordered_map<std::string, int32_t>& dictIndex) {
+  auto iter = dictIndex.find(s);
+  if (iter != dictIndex.end()) {
+    return iter->second;
+  }
+  int32_t idx = dict.size();
+  dict.push_back(s);
+  dictIndex.emplace(s, idx);
+  return idx;
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "stats/if/gen-cpp2/Aggregator_types.h"
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/*
+ * Accumulates stats into a single thrift::AggrStatsBatch, which is published
+ * to Kafka as one Compact-serialized message instead of one JSON message per
+ * stat. Keys and entities are stored once per batch in dictionaries.
+ */
+class KafkaStatsBatch {
+ public:
+  // Append a stat
+  void add(
+      const std::string& key,
+      const std::string& entity,
+      int64_t timestamp,
+      double value,
+      bool isCounter);
+
+  // Return the number of stats in the batch
+  size_t size() const;
+
+  // Return whether the batch is empty
+  bool empty() const;
+
+  // Serialize the batch and reset it
+  std::string serializeAndClear();
+
+ private:
+  // Return the index of the given string in a dictionary, adding it if needed
+  static int32_t getIndex(
+      const std::string& s,
+      std::vector<std::string>& dict,
+      std::unordered_map<std::string, int32_t>& dictIndex);
+
+  // The batch being built
+  thrift::AggrStatsBatch batch_;
+
+  // Index into batch_.keys for each key
+  std::unordered_map<std::string, int32_t> keyIndex_;
+
+  // Index into batch_.entities for each entity
+  std::unordered_map<std::string, int32_t> entityIndex_;
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "StatsKeyFilter.h"
+
+#include <glog/logging.h>
+
+#include "stats/common/RegexUtil.h"
+
+namespace {
+// Max number of memoized keys (stat keys embed peer MACs, so bound the memo)
+const size_t kMaxMemoizedKeys{100000};
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+StatsKeyFilter::StatsKeyFilter(
+    const std::unordered_map<std::string, std::string>& patterns,
+    const std::string& name) {
+  for (const auto& kv : patterns) {
+    try {
+      patterns_.push_back(
+          Pattern{std::regex(kv.second), getRequiredLiteral(kv.second)});
+      VLOG(3) << "Added " << name << " pattern under group '" << kv.first
+              << "': " << kv.second << " (required literal: '"
+              << patterns_.back().requiredLiteral << "')";
+    } catch (const std::regex_error& ex) {
+      LOG(ERROR) << "Ignoring malformed regex for " << name << " group "
+                 << kv.first << ": " << kv.second << " (" << ex.what() << ")";
+    }
+  }
+}
+
+bool
+StatsKeyFilter::matches(const std::string& key) {
+  if (patterns_.empty()) {
+    return false;
+  }
+
+  auto iter = memo_.find(key);
+  if (iter != memo_.end()) {
+    return iter->second;
+  }
+  if (memo_.size() >= kMaxMemoizedKeys) {
+    memo_.clear();
+  }
+  bool result = evaluate(key);
+  memo_.emplace(key, result);
+  return result;
+}
+
+size_t
+StatsKeyFilter::size() const {
+  return patterns_.size();
+}
+
+bool
+StatsKeyFilter::evaluate(const std::string& key) const {
+  for (const Pattern& pattern : patterns_) {
+    if (!pattern.requiredLiteral.empty() &&
+        key.find(pattern.requiredLiteral) == std::string::npos) {
+      continue;
+    }
+    if (std::regex_match(key, pattern.regex)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string
+StatsKeyFilter::getRequiredLiteral(const std::string& pattern) {
+  return RegexUtil::getRequiredLiteral(pattern);
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/**
+ * Matches stat keys against a set of configured regular expressions (e.g. the
+ * stats blacklist or high-frequency stats whitelist).
+ *
+ * The patterns are compiled once. Each pattern also gets a literal substring
+ * that every match must contain (if one can be found), so most patterns are
+ * rejected with a substring search instead of running the regex engine.
+ *
+ * The same stat keys are published every interval, so results are memoized
+ * per key. The memo belongs to this filter instance and is dropped together
+ * with the patterns, i.e. whenever the filter is rebuilt from new
+ * StatsAgentParams.
+ */
+class StatsKeyFilter {
+ public:
+  /**
+   * Compile the given patterns, keyed by group name (malformed patterns are
+   * logged and ignored). The filter name is only used for logging.
+   */
+  StatsKeyFilter(
+      const std::unordered_map<std::string, std::string>& patterns,
+      const std::string& name);
+
+  /** Return whether the key fully matches any pattern. */
+  bool matches(const std::string& key);
+
+  /** Return the number of compiled patterns. */
+  size_t size() const;
+
+  /**
+   * Return a literal substring that any full match of the given regex must
+   * contain, or an empty string if none could be determined.
+   */
+  static std::string getRequiredLiteral(const std::string& pattern);
+
+ private:
+  // A compiled pattern
+  struct Pattern {
+    // The compiled regex
+    std::regex regex;
+
+    // A literal substring required for any match (may be empty)
+    std::string requiredLiteral;
+  };
+
+  // Evaluate the key against all patterns (without memoization)
+  bool evaluate(const std::string& key) const;
+
+  // The compiled patterns
+  std::vector<Pattern> patterns_;
+
+  // Memoized results per key
+  std::unordered_map<std::string, bool> memo_;
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
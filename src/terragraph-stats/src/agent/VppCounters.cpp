@@ -24,6 +24,17 @@ DEFINE_string(
     vpp_get_stats_path,
     "/usr/bin/vpp_get_stats",
     "Path to 'vpp_get_stats' VPP binary");
+#ifdef WITH_VPP_STATS
+DEFINE_bool(
+    vpp_stats_segment,
+    true,
+    "Read VPP counters directly from the stats shared-memory segment instead "
+    "of forking 'vpp_get_stats' (falls back to 'vpp_get_stats' on failure)");
+DEFINE_string(
+    vpp_stats_socket_path,
+    "/run/vpp/stats.sock",
+    "Path to the VPP stats segment socket");
+#endif
 
 namespace {
 // Prefix for all key names from this module
@@ -104,6 +115,69 @@ VppCounters::reformatKey(const std::string& key) {
   return s;
 }
 
+void
+VppCounters::addIfaceCounter(
+    const std::unordered_map<uint32_t, std::string>& interfaceMap,
+    uint32_t swIfIndex,
+    const std::string& key,
+    double pktCount,
+    std::optional<double> byteCount,
+    const std::unordered_map<
+        std::string,
+        std::pair<std::string, std::string>>& terraIfaceMap,
+    std::vector<std::pair<std::string, fbzmq::thrift::Counter>>& ret) {
+  if (kVppDumpStatsSkipIfStats.count(key)) {
+    return;  // Dropped
+  }
+
+  // Look up sw_if_index
+  auto iter = interfaceMap.find(swIfIndex);
+  if (iter == interfaceMap.end()) {
+    VLOG(4) << "Unknown VPP sw_if_index " << swIfIndex;
+    return;
+  }
+
+  // Merged key name:
+  //   <mac_or_ifname>/<name>/<pkts|bytes>
+  //
+  // We're dropping the core index and summing counters on each core.
+  std::string macOrIfname = iter->second;
+  std::string radioMacKeySuffix;
+  if (iter->second.rfind(kVppTerraIfacePrefix, 0) == 0) {
+    auto macIter =
+        terraIfaceMap.find(iter->second.substr(kVppTerraIfaceOffset));
+    if (macIter == terraIfaceMap.end()) {
+      VLOG(5) << "Skipping inactive terraX interface '" << iter->second
+              << "' for key " << key;
+      return;
+    }
+    macOrIfname = macIter->second.second;
+    radioMacKeySuffix = '\0' + macIter->second.first;
+  }
+  ret.push_back(std::make_pair(
+      reformatKey(kVppStatPrefix + "." + macOrIfname + key + "/pkts") +
+          radioMacKeySuffix,
+      createCounter(pktCount)));
+  if (byteCount) {
+    ret.push_back(std::make_pair(
+        reformatKey(kVppStatPrefix + "." + macOrIfname + key + "/bytes") +
+            radioMacKeySuffix,
+        createCounter(byteCount.value())));
+  }
+}
+
+void
+VppCounters::addNormalCounter(
+    const std::string& key,
+    double value,
+    std::vector<std::pair<std::string, fbzmq::thrift::Counter>>& ret) {
+  if (!kVppDumpStatsKeepNormalStats.count(key)) {
+    return;  // Dropped
+  }
+  ret.push_back(
+      std::make_pair(reformatKey(kVppStatPrefix + key), createGauge(value)));
+}
+
 std::vector<std::pair<std::string, fbzmq::thrift::Counter>>
 VppCounters::parseVppStat(
     const std::string& line,
@@ -142,52 +216,18 @@ VppCounters::parseVppStat(
       uint32_t swIfIndex = folly::to<uint32_t>(m.str(1));
       // int coreIndex = folly::to<int>(m.str(2));
       double pktCount = folly::to<double>(m.str(3));
-      double byteCount = isCombinedCounter ? folly::to<double>(m.str(5)) : 0;
-      std::string key = m.str(6);
-
-      if (kVppDumpStatsSkipIfStats.count(key)) {
-        // Dropped
-      } else {
-        // Look up sw_if_index
-        auto iter = vppInterfaceMap_.find(swIfIndex);
-        if (iter == vppInterfaceMap_.end()) {
-          VLOG(4) << "Unknown VPP sw_if_index " << swIfIndex;
-        } else {
-          // Merged key name:
-          //   <mac_or_ifname>/<name>/<pkts|bytes>
-          //
-          // We're dropping the core index and summing counters on each core.
-          std::string macOrIfname = iter->second;
-          std::string radioMacKeySuffix;
-          bool skip = false;
-          if (iter->second.rfind(kVppTerraIfacePrefix, 0) == 0) {
-            auto macIter = terraIfaceMap.find(
-                iter->second.substr(kVppTerraIfaceOffset));
-            if (macIter != terraIfaceMap.end()) {
-              macOrIfname = macIter->second.second;
-              radioMacKeySuffix = '\0' + macIter->second.first;
-            } else {
-              VLOG(5) << "Skipping inactive terraX interface '" << iter->second
-                      << "' for key " << key;
-              skip = true;
-            }
-          }
-          if (!skip) {
-            ret.push_back(std::make_pair(
-                reformatKey(
-                    kVppStatPrefix + "." + macOrIfname + key + "/pkts") +
-                    radioMacKeySuffix,
-                createCounter(pktCount)));
-            if (isCombinedCounter) {
-              ret.push_back(std::make_pair(
-                  reformatKey(
-                      kVppStatPrefix + "." + macOrIfname + key + "/bytes") +
-                      radioMacKeySuffix,
-                  createCounter(byteCount)));
-            }
-          }
-        }
+      std::optional<double> byteCount;
+      if (isCombinedCounter) {
+        byteCount = folly::to<double>(m.str(5));
       }
+      addIfaceCounter(
+          vppInterfaceMap_,
+          swIfIndex,
+          m.str(6),
+          pktCount,
+          byteCount,
+          terraIfaceMap,
+          ret);
     } else {
       VLOG(4) << "Unknown counter format: " << input;
     }
@@ -197,13 +237,8 @@ VppCounters::parseVppStat(
     size_t spaceIdx = input.find(' ');
     if (spaceIdx != std::string::npos) {
       auto value = folly::tryTo<double>(input.substr(0, spaceIdx));
-      std::string key = input.substr(spaceIdx + 1);
-      if (!kVppDumpStatsKeepNormalStats.count(key)) {
-        // Dropped
-      } else if (value.hasValue()) {
-        ret.push_back(std::make_pair(
-            reformatKey(kVppStatPrefix + key),
-            createGauge(*value)));
+      if (value.hasValue()) {
+        addNormalCounter(input.substr(spaceIdx + 1), *value, ret);
       }
     }
   }
@@ -237,11 +272,44 @@ VppCounters::vppGetInterfaceMap(std::vector<std::string>& lines) {
   return ret;
 }
 
+void
+VppCounters::mergeStats(
+    const std::vector<std::pair<std::string, fbzmq::thrift::Counter>>& entries,
+    std::unordered_map<std::string, fbzmq::thrift::Counter>& ret) {
+  for (const auto& pair : entries) {
+    // Sum existing counters (i.e. interface counters across cores)
+    auto iter = ret.find(pair.first);
+    if (iter == ret.end()) {
+      ret.insert(pair);
+    } else {
+      iter->second.value_ref().value() += pair.second.value_ref().value();
+    }
+  }
+}
+
 std::unordered_map<std::string, fbzmq::thrift::Counter>
 VppCounters::vppDumpStats(
     const std::unordered_map<
         std::string,
         std::pair<std::string, std::string>>& terraIfaceMap) {
+#ifdef WITH_VPP_STATS
+  if (FLAGS_vpp_stats_segment) {
+    auto ret = vppDumpStatSegment(terraIfaceMap);
+    if (ret) {
+      return std::move(ret.value());
+    }
+    VLOG(2) << "Falling back to '" << FLAGS_vpp_get_stats_path << "'";
+  }
+#endif
+
+  return vppDumpStatsCommand(terraIfaceMap);
+}
+
+std::unordered_map<std::string, fbzmq::thrift::Counter>
+VppCounters::vppDumpStatsCommand(
+    const std::unordered_map<
+        std::string,
+        std::pair<std::string, std::string>>& terraIfaceMap) {
   std::unordered_map<std::string, fbzmq::thrift::Counter> ret;
 
   // Run vpp_get_stats command and parse output
@@ -267,15 +335,7 @@ VppCounters::vppDumpStats(
       if (entries.empty()) {
         VLOG(5) << "Not publishing any stats for VPP line: " << line;
       } else {
-        for (const auto& pair : entries) {
-          // Sum existing counters (i.e. interface counters across cores)
-          auto iter = ret.find(pair.first);
-          if (iter == ret.end()) {
-            ret.insert(pair);
-          } else {
-            iter->second.value_ref().value() += pair.second.value_ref().value();
-          }
-        }
+        mergeStats(entries, ret);
       }
     }
   } else {
@@ -287,6 +347,52 @@ VppCounters::vppDumpStats(
   return ret;
 }
 
+#ifdef WITH_VPP_STATS
+std::optional<std::unordered_map<std::string, fbzmq::thrift::Counter>>
+VppCounters::vppDumpStatSegment(
+    const std::unordered_map<
+        std::string,
+        std::pair<std::string, std::string>>& terraIfaceMap) {
+  if (!vppStatSegment_) {
+    std::vector<std::string> patterns(
+        std::begin(kVppDumpStatsPatterns), std::end(kVppDumpStatsPatterns));
+    vppStatSegment_ = std::make_unique<VppStatSegment>(
+        FLAGS_vpp_stats_socket_path, patterns);
+  }
+
+  std::unordered_map<std::string, fbzmq::thrift::Counter> ret;
+  std::vector<std::pair<std::string, fbzmq::thrift::Counter>> entries;
+  bool success = vppStatSegment_->dump(
+      [&](uint32_t swIfIndex,
+          const std::string& key,
+          double pktCount,
+          std::optional<double> byteCount) {
+        entries.clear();
+        addIfaceCounter(
+            vppStatSegment_->getInterfaceMap(),
+            swIfIndex,
+            key,
+            pktCount,
+            byteCount,
+            terraIfaceMap,
+            entries);
+        mergeStats(entries, ret);
+      },
+      [&](const std::string& key, double value) {
+        entries.clear();
+        addNormalCounter(key, value, entries);
+        mergeStats(entries, ret);
+      });
+  if (!success) {
+    return std::nullopt;
+  }
+  vppInterfaceMap_ = vppStatSegment_->getInterfaceMap();
+
+  VLOG(4) << "Recorded " << ret.size() << " stat(s) from VPP stats segment";
+  return ret;
+}
+#endif
+
 std::unordered_map<std::string, fbzmq::thrift::Counter>
 VppCounters::fetchStats() {
   std::unordered_map<std::string, std::pair<std::string, std::string>>
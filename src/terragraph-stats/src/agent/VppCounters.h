@@ -9,11 +9,16 @@
 
 #include "BaseCounters.h"
 
+#include <optional>
 #include <vector>
 
 #include <folly/Expected.h>
 #include <folly/Subprocess.h>
 
+#ifdef WITH_VPP_STATS
+#include "VppStatSegment.h"
+#endif
+
 namespace facebook {
 namespace terragraph {
 namespace stats {
@@ -21,8 +26,10 @@ namespace stats {
 /**
  * Stats collector for VPP interface counters.
  *
- * This class will fork VPP CLIs (`vpp_get_stats` and `vppctl`) and parse their
- * output; it does not use the VPP API and stats libraries.
+ * When built with the VPP stat client library (WITH_VPP_STATS), interface and
+ * error counters are read directly from the VPP stats segment. Otherwise (or
+ * if the segment can't be read), this class will fork `vpp_get_stats` and
+ * parse its output. HQoS stats are always read by forking `vppctl`.
  */
 class VppCounters : public BaseCounters {
  public:
@@ -71,6 +78,39 @@ class VppCounters : public BaseCounters {
           std::string,
           std::pair<std::string, std::string>>& terraIfaceMap);
 
+  /**
+   * Append the stat entries for a VPP interface counter to `ret`, unless the
+   * counter is filtered out, has an unknown sw_if_index in `interfaceMap`, or
+   * represents a "vpp-terraX" interface not present in `terraIfaceMap`.
+   *
+   * `byteCount` is only set for combined counters.
+   */
+  void addIfaceCounter(
+      const std::unordered_map<uint32_t, std::string>& interfaceMap,
+      uint32_t swIfIndex,
+      const std::string& key,
+      double pktCount,
+      std::optional<double> byteCount,
+      const std::unordered_map<
+          std::string,
+          std::pair<std::string, std::string>>& terraIfaceMap,
+      std::vector<std::pair<std::string, fbzmq::thrift::Counter>>& ret);
+
+  /**
+   * Append the stat entry for a normal VPP counter (e.g. error counter) to
+   * `ret`, unless the counter is filtered out.
+   */
+  void addNormalCounter(
+      const std::string& key,
+      double value,
+      std::vector<std::pair<std::string, fbzmq::thrift::Counter>>& ret);
+
+  /** Merge stat entries into `ret`, summing values for duplicate keys. */
+  void mergeStats(
+      const std::vector<std::pair<std::string, fbzmq::thrift::Counter>>&
+          entries,
+      std::unordered_map<std::string, fbzmq::thrift::Counter>& ret);
+
   /**
    * Dump the current VPP counters.
    *
@@ -82,6 +122,25 @@ class VppCounters : public BaseCounters {
           std::string,
           std::pair<std::string, std::string>>& terraIfaceMap);
 
+  /** Dump the current VPP counters by running `vpp_get_stats`. */
+  std::unordered_map<std::string, fbzmq::thrift::Counter> vppDumpStatsCommand(
+      const std::unordered_map<
+          std::string,
+          std::pair<std::string, std::string>>& terraIfaceMap);
+
+#ifdef WITH_VPP_STATS
+  /**
+   * Dump the current VPP counters from the stats segment.
+   *
+   * Returns std::nullopt if the segment could not be read.
+   */
+  std::optional<std::unordered_map<std::string, fbzmq::thrift::Counter>>
+  vppDumpStatSegment(
+      const std::unordered_map<
+          std::string,
+          std::pair<std::string, std::string>>& terraIfaceMap);
+#endif
+
   /**
    * Get the mapping from VPP software interface index to interface name using
    * the given raw output lines from `vpp_get_stats`, and remove these lines
@@ -118,6 +177,11 @@ class VppCounters : public BaseCounters {
   /** Map from VPP software interface index to interface name. */
   std::unordered_map<uint32_t /* sw_if_index */, std::string /* ifname */>
       vppInterfaceMap_{};
+
+#ifdef WITH_VPP_STATS
+  /** The VPP stats segment reader (created on first use). */
+  std::unique_ptr<VppStatSegment> vppStatSegment_;
+#endif
 };
 
 } // namespace stats
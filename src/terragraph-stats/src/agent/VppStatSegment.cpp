@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "VppStatSegment.h"
+
+#include <glog/logging.h>
+
+namespace {
+// Directory pattern for the sw_if_index-to-name table
+const std::string kVppIfaceNamesPattern{"^/if/names$"};
+
+// Resolve directory indexes for the given patterns (returns a VPP vector)
+uint32_t*
+lsPatterns(
+    const std::vector<std::string>& patterns, stat_client_main_t* sm) {
+  uint8_t** patternVec = nullptr;
+  for (const std::string& pattern : patterns) {
+    patternVec = stat_segment_string_vector(patternVec, pattern.c_str());
+  }
+  uint32_t* indexes = stat_segment_ls_r(patternVec, sm);
+  for (int i = 0; i < stat_segment_vec_len(patternVec); i++) {
+    stat_segment_vec_free(patternVec[i]);
+  }
+  stat_segment_vec_free(patternVec);
+  return indexes;
+}
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+VppStatSegment::VppStatSegment(
+    const std::string& socketPath, const std::vector<std::string>& patterns)
+    : socketPath_(socketPath), patterns_(patterns) {
+  sm_ = stat_client_get();
+}
+
+VppStatSegment::~VppStatSegment() {
+  disconnect();
+  stat_client_free(sm_);
+}
+
+bool
+VppStatSegment::connect() {
+  if (connected_) {
+    return true;
+  }
+  if (stat_segment_connect_r(socketPath_.c_str(), sm_) != 0) {
+    VLOG(2) << "Unable to connect to VPP stats segment at " << socketPath_;
+    return false;
+  }
+  connected_ = true;
+  return true;
+}
+
+void
+VppStatSegment::disconnect() {
+  stat_segment_vec_free(dirIndexes_);
+  dirIndexes_ = nullptr;
+  stat_segment_vec_free(nameIndexes_);
+  nameIndexes_ = nullptr;
+  epoch_.reset();
+  interfaceMap_.clear();
+  if (connected_) {
+    stat_segment_disconnect_r(sm_);
+    connected_ = false;
+  }
+}
+
+bool
+VppStatSegment::refreshDirectory() {
+  uint64_t epoch = sm_->shared_header->epoch;
+  if (epoch_ && epoch_.value() == epoch) {
+    return true;
+  }
+
+  // Re-resolve the directory indexes
+  stat_segment_vec_free(dirIndexes_);
+  dirIndexes_ = lsPatterns(patterns_, sm_);
+  stat_segment_vec_free(nameIndexes_);
+  nameIndexes_ = lsPatterns({kVppIfaceNamesPattern}, sm_);
+  if (!dirIndexes_ || !nameIndexes_) {
+    return false;
+  }
+
+  // Re-read the sw_if_index table
+  stat_segment_data_t* res = stat_segment_dump_r(nameIndexes_, sm_);
+  if (!res) {
+    return false;  // directory changed under us
+  }
+  interfaceMap_.clear();
+  for (int i = 0; i < stat_segment_vec_len(res); i++) {
+    if (res[i].type != STAT_DIR_TYPE_NAME_VECTOR) {
+      continue;
+    }
+    for (int k = 0; k < stat_segment_vec_len(res[i].name_vector); k++) {
+      if (res[i].name_vector[k]) {
+        interfaceMap_[k] =
+            std::string(reinterpret_cast<char*>(res[i].name_vector[k]));
+      }
+    }
+  }
+  stat_segment_data_free(res);
+
+  VLOG(4) << "VPP interface map has " << interfaceMap_.size()
+          << " entries (epoch " << epoch << ")";
+  epoch_ = epoch;
+  return true;
+}
+
+bool
+VppStatSegment::dump(
+    const IfaceCounterCallback& ifaceCounterCb,
+    const ErrorCounterCallback& errorCounterCb) {
+  if (!connect()) {
+    return false;
+  }
+
+  // Retry once if the directory changes between resolving and reading it
+  stat_segment_data_t* res = nullptr;
+  for (int attempt = 0; attempt < 2 && !res; attempt++) {
+    if (!refreshDirectory()) {
+      epoch_.reset();
+      continue;
+    }
+    res = stat_segment_dump_r(dirIndexes_, sm_);
+    if (!res) {
+      epoch_.reset();
+    }
+  }
+  if (!res) {
+    // Possibly a VPP restart, so remap the segment next time
+    LOG(ERROR) << "Failed to read VPP stats segment";
+    disconnect();
+    return false;
+  }
+
+  for (int i = 0; i < stat_segment_vec_len(res); i++) {
+    const std::string name(res[i].name);
+    switch (res[i].type) {
+      case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE: {
+        // Sum across threads
+        std::vector<double> pkts;
+        for (int t = 0; t < stat_segment_vec_len(res[i].simple_counter_vec);
+             t++) {
+          const counter_t* counters = res[i].simple_counter_vec[t];
+          int len = stat_segment_vec_len((void*)counters);
+          if ((int)pkts.size() < len) {
+            pkts.resize(len, 0);
+          }
+          for (int k = 0; k < len; k++) {
+            pkts[k] += counters[k];
+          }
+        }
+        for (size_t k = 0; k < pkts.size(); k++) {
+          ifaceCounterCb(k, name, pkts[k], std::nullopt);
+        }
+        break;
+      }
+      case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED: {
+        // Sum across threads
+        std::vector<std::pair<double, double>> pktsAndBytes;
+        for (int t = 0;
+             t < stat_segment_vec_len(res[i].combined_counter_vec);
+             t++) {
+          const vlib_counter_t* counters = res[i].combined_counter_vec[t];
+          int len = stat_segment_vec_len((void*)counters);
+          if ((int)pktsAndBytes.size() < len) {
+            pktsAndBytes.resize(len, {0, 0});
+          }
+          for (int k = 0; k < len; k++) {
+            pktsAndBytes[k].first += counters[k].packets;
+            pktsAndBytes[k].second += counters[k].bytes;
+          }
+        }
+        for (size_t k = 0; k < pktsAndBytes.size(); k++) {
+          ifaceCounterCb(
+              k, name, pktsAndBytes[k].first, pktsAndBytes[k].second);
+        }
+        break;
+      }
+      case STAT_DIR_TYPE_ERROR_INDEX: {
+        // Sum across threads
+        double value = 0;
+        for (int t = 0; t < stat_segment_vec_len(res[i].error_vector); t++) {
+          value += res[i].error_vector[t];
+        }
+        errorCounterCb(name, value);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  stat_segment_data_free(res);
+  return true;
+}
+
+const std::unordered_map<uint32_t, std::string>&
+VppStatSegment::getInterfaceMap() const {
+  return interfaceMap_;
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
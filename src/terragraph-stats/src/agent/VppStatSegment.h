@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+extern "C" {
+#include <vpp-api/client/stat_client.h>
+}
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/**
+ * Reader for the VPP stats shared-memory segment.
+ *
+ * This maps the stats segment directly (via the VPP stat client library)
+ * instead of forking `vpp_get_stats`. The directory indexes matching the
+ * requested patterns are resolved once and reused until VPP bumps the
+ * directory epoch (e.g. when interfaces are added or removed), at which point
+ * the indexes and the sw_if_index-to-name table ("/if/names") are re-read.
+ *
+ * All counters are summed across VPP worker threads.
+ */
+class VppStatSegment : public boost::noncopyable {
+ public:
+  // Callback for interface counters:
+  //   (sw_if_index, counter name, packets, bytes if a combined counter)
+  using IfaceCounterCallback = std::function<void(
+      uint32_t, const std::string&, double, std::optional<double>)>;
+
+  // Callback for error counters: (counter name, value)
+  using ErrorCounterCallback =
+      std::function<void(const std::string&, double)>;
+
+  /**
+   * Construct the reader for the given stats socket and directory patterns
+   * (regular expressions, as with `vpp_get_stats dump`).
+   */
+  VppStatSegment(
+      const std::string& socketPath, const std::vector<std::string>& patterns);
+
+  ~VppStatSegment();
+
+  /**
+   * Read all counters matching the configured patterns, invoking the given
+   * callbacks for each entry.
+   *
+   * Returns false if the segment could not be read.
+   */
+  bool dump(
+      const IfaceCounterCallback& ifaceCounterCb,
+      const ErrorCounterCallback& errorCounterCb);
+
+  /** Return the cached map from VPP software interface index to name. */
+  const std::unordered_map<uint32_t, std::string>& getInterfaceMap() const;
+
+ private:
+  // Connect to the stats segment (if needed)
+  bool connect();
+
+  // Disconnect from the stats segment and drop all cached state
+  void disconnect();
+
+  // Resolve directory indexes and the interface name table for the current
+  // epoch
+  bool refreshDirectory();
+
+  // The stats socket path
+  const std::string socketPath_;
+
+  // The directory patterns
+  const std::vector<std::string> patterns_;
+
+  // The stat client state (owned)
+  stat_client_main_t* sm_{nullptr};
+
+  // Whether the stats segment is currently mapped
+  bool connected_{false};
+
+  // The directory epoch that the cached indexes belong to
+  std::optional<uint64_t> epoch_;
+
+  // Directory indexes matching patterns_ (VPP vector)
+  uint32_t* dirIndexes_{nullptr};
+
+  // Directory index of "/if/names" (VPP vector)
+  uint32_t* nameIndexes_{nullptr};
+
+  // Map from VPP software interface index to interface name
+  std::unordered_map<uint32_t /* sw_if_index */, std::string /* ifname */>
+      interfaceMap_;
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
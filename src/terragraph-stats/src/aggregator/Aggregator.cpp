@@ -11,6 +11,7 @@
 #include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <curl/curl.h>
 #include <fbzmq/async/StopEventLoopSignalHandler.h>
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <fbzmq/zmq/Zmq.h>
@@ -59,6 +60,9 @@ main(int argc, char** argv) {
   FLAGS_logtostderr = true;
   ExceptionHandler::install();
 
+  // init curl once, before StatsApp starts its HTTP publisher thread
+  curl_global_init(CURL_GLOBAL_ALL);
+
   fbzmq::Context context;
 
   // Initialize shared objects
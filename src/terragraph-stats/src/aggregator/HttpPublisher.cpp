@@ -0,0 +1,776 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "HttpPublisher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+DEFINE_int32(curl_timeout_s, 10, "cURL timeout for the entire request");
+DEFINE_string(proxy_url, "", "IPv6 to IPv4 proxy URL (ex. 'http://[2001::1]')");
+DEFINE_int32(proxy_port, 8080, "IPv6 to IPv4 proxy port");
+DEFINE_int32(
+    http_publisher_queue_size,
+    8,
+    "Max number of pending POST requests per data endpoint");
+DEFINE_int32(
+    http_publisher_max_retries,
+    3,
+    "Max number of retries for a failed POST request before spooling it");
+DEFINE_int32(
+    http_publisher_retry_backoff_ms,
+    1000,
+    "Initial backoff before retrying a failed POST request (doubles on each "
+    "retry)");
+DEFINE_string(
+    http_publisher_spool_dir,
+    "",
+    "Directory to spool undeliverable POST requests to (disabled if empty)");
+DEFINE_int32(
+    http_publisher_spool_max_mb,
+    64,
+    "Max size of spooled POST requests per data endpoint, in megabytes");
+DEFINE_int32(
+    http_publisher_stream_buffer_kb,
+    1024,
+    "Max size of a streamed POST body buffered for the slowest endpoint, in "
+    "kilobytes");
+
+extern "C" {
+// Discard response bodies
+static size_t
+curlDiscardCb(void* /* content */, size_t size, size_t nmemb, void* /* p */) {
+  return size * nmemb;
+}
+}
+
+namespace {
+// Max time to wait for socket activity before servicing queues again
+const int kPollTimeoutMs{100};
+
+// Max backoff between retries
+const std::chrono::milliseconds kMaxRetryBackoff{60000};
+
+// Spool file extension
+const std::string kSpoolFileExtension{".body"};
+
+// Extension for spool files that are still being written
+const std::string kSpoolTmpFileExtension{".tmp"};
+
+// Return whether a failed request with the given HTTP status should be retried
+bool
+isRetryableHttpStatus(long status) {
+  return status >= 500 || status == 408 || status == 429;
+}
+
+// Return the spool files in the given directory, oldest first
+std::vector<boost::filesystem::path>
+getSpoolFiles(const std::string& dir) {
+  std::vector<boost::filesystem::path> files;
+  boost::system::error_code ec;
+  for (boost::filesystem::directory_iterator it(dir, ec), end;
+       !ec && it != end;
+       it.increment(ec)) {
+    if (it->path().extension() == kSpoolFileExtension) {
+      files.push_back(it->path());
+    }
+  }
+  // File names are zero-padded sequence numbers
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Remove spool files that a previous run didn't finish writing
+void
+removeSpoolTmpFiles(const std::string& dir) {
+  boost::system::error_code ec;
+  std::vector<boost::filesystem::path> files;
+  for (boost::filesystem::directory_iterator it(dir, ec), end;
+       !ec && it != end;
+       it.increment(ec)) {
+    if (it->path().extension() == kSpoolTmpFileExtension) {
+      files.push_back(it->path());
+    }
+  }
+  for (const auto& path : files) {
+    boost::filesystem::remove(path, ec);
+  }
+}
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+HttpStreamBody::HttpStreamBody(
+    size_t numReaders,
+    size_t maxBufferedBytes,
+    std::chrono::milliseconds writeTimeout,
+    std::function<void()> onData)
+    : readerOffsets_(numReaders, size_t(0)),
+      maxBufferedBytes_(maxBufferedBytes),
+      writeTimeout_(writeTimeout),
+      onData_(std::move(onData)) {}
+
+HttpStreamBody::~HttpStreamBody() {
+  for (auto& spoolFile : spoolFiles_) {
+    if (spoolFile.file) {
+      abandonSpoolFile(spoolFile);
+    }
+  }
+}
+
+bool
+HttpStreamBody::addSpoolFile(
+    const std::string& path,
+    size_t maxBytes,
+    std::function<void(size_t)> onSpooled) {
+  SpoolFile spoolFile;
+  spoolFile.path = path;
+  spoolFile.tmpPath = path + kSpoolTmpFileExtension;
+  spoolFile.maxBytes = maxBytes;
+  spoolFile.onSpooled = std::move(onSpooled);
+  try {
+    spoolFile.file =
+        folly::File(spoolFile.tmpPath, O_WRONLY | O_CREAT | O_TRUNC);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Unable to create spool file " << spoolFile.tmpPath << ": "
+               << ex.what();
+    return false;
+  }
+  spoolFiles_.push_back(std::move(spoolFile));
+  return true;
+}
+
+bool
+HttpStreamBody::writeSpoolFiles(folly::StringPiece data) {
+  bool spooling = false;
+  for (auto& spoolFile : spoolFiles_) {
+    if (!spoolFile.file) {
+      continue;
+    }
+    if (spoolFile.bytes + data.size() > spoolFile.maxBytes) {
+      LOG(ERROR) << "Spool is full, abandoning spool file " << spoolFile.path;
+      abandonSpoolFile(spoolFile);
+      continue;
+    }
+    if (folly::writeFull(spoolFile.file.fd(), data.data(), data.size()) < 0) {
+      PLOG(ERROR) << "Unable to write spool file " << spoolFile.tmpPath;
+      abandonSpoolFile(spoolFile);
+      continue;
+    }
+    spoolFile.bytes += data.size();
+    spooling = true;
+  }
+  return spooling;
+}
+
+void
+HttpStreamBody::abandonSpoolFile(SpoolFile& spoolFile) {
+  spoolFile.file.close();
+  boost::system::error_code ec;
+  boost::filesystem::remove(spoolFile.tmpPath, ec);
+}
+
+bool
+HttpStreamBody::write(folly::StringPiece data) {
+  bool spooling = writeSpoolFiles(data);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto hasReaders = [this]() {
+      return std::any_of(
+          readerOffsets_.begin(),
+          readerOffsets_.end(),
+          [](const std::optional<size_t>& offset) {
+            return offset.has_value();
+          });
+    };
+    auto canWrite = [&]() {
+      return !hasReaders() || data_.size() < maxBufferedBytes_;
+    };
+    while (!canWrite()) {
+      if (!readerCv_.wait_for(lock, writeTimeout_, canWrite)) {
+        // Detach the readers holding back the buffer
+        size_t minOffset = base_ + data_.size();
+        for (const auto& offset : readerOffsets_) {
+          if (offset) {
+            minOffset = std::min(minOffset, *offset);
+          }
+        }
+        for (size_t i = 0; i < readerOffsets_.size(); i++) {
+          if (readerOffsets_[i] && *readerOffsets_[i] == minOffset) {
+            LOG(WARNING) << "Streamed request body reader " << i
+                         << " made no progress, detaching it";
+            readerOffsets_[i].reset();
+          }
+        }
+        trim();
+      }
+    }
+    if (!hasReaders()) {
+      return spooling;
+    }
+    data_.append(data.data(), data.size());
+  }
+  onData_();
+  return true;
+}
+
+void
+HttpStreamBody::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  onData_();
+
+  for (auto& spoolFile : spoolFiles_) {
+    if (!spoolFile.file) {
+      continue;
+    }
+    if (folly::fsyncNoInt(spoolFile.file.fd()) != 0) {
+      PLOG(ERROR) << "Unable to sync spool file " << spoolFile.tmpPath;
+      abandonSpoolFile(spoolFile);
+      continue;
+    }
+    spoolFile.file.close();
+    boost::system::error_code ec;
+    boost::filesystem::rename(spoolFile.tmpPath, spoolFile.path, ec);
+    if (ec) {
+      LOG(ERROR) << "Unable to rename spool file " << spoolFile.tmpPath << ": "
+                 << ec.message();
+      boost::filesystem::remove(spoolFile.tmpPath, ec);
+      continue;
+    }
+    spoolFile.onSpooled(spoolFile.bytes);
+  }
+}
+
+size_t
+HttpStreamBody::read(size_t reader, char* buf, size_t len) {
+  size_t n;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& offset = readerOffsets_[reader];
+    if (!offset) {
+      return CURL_READFUNC_ABORT;
+    }
+    size_t avail = base_ + data_.size() - *offset;
+    if (avail == 0) {
+      return closed_ ? 0 : CURL_READFUNC_PAUSE;
+    }
+    n = std::min(avail, len);
+    std::memcpy(buf, data_.data() + (*offset - base_), n);
+    *offset += n;
+    trim();
+  }
+  readerCv_.notify_all();
+  return n;
+}
+
+bool
+HttpStreamBody::isReadable(size_t reader) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto& offset = readerOffsets_[reader];
+  return !offset || closed_ || *offset < base_ + data_.size();
+}
+
+bool
+HttpStreamBody::isAttached(size_t reader) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return readerOffsets_[reader].has_value();
+}
+
+void
+HttpStreamBody::detach(size_t reader) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readerOffsets_[reader].reset();
+    trim();
+  }
+  readerCv_.notify_all();
+}
+
+void
+HttpStreamBody::trim() {
+  size_t end = base_ + data_.size();
+  size_t minOffset = end;
+  for (const auto& offset : readerOffsets_) {
+    if (offset) {
+      minOffset = std::min(minOffset, *offset);
+    }
+  }
+  size_t consumed = minOffset - base_;
+  if (consumed == data_.size()) {
+    data_.clear();
+  } else if (consumed > 0 && consumed >= data_.size() / 2) {
+    // Only shift the buffer once at least half of it was consumed
+    data_.erase(0, consumed);
+  } else {
+    return;
+  }
+  base_ = minOffset;
+}
+
+HttpPublisher::HttpPublisher() {
+  multi_ = curl_multi_init();
+  if (!multi_) {
+    throw std::runtime_error("Unable to initialize CURL multi handle");
+  }
+  thread_ = std::thread([this]() {
+    LOG(INFO) << "Starting HTTP publisher thread...";
+    run();
+    LOG(INFO) << "HTTP publisher thread terminating...";
+  });
+}
+
+HttpPublisher::~HttpPublisher() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  shutdown();
+  curl_multi_cleanup(multi_);
+}
+
+bool
+HttpPublisher::post(
+    const std::string& url,
+    std::shared_ptr<const std::string> body,
+    const Options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Endpoint& endpoint = getEndpoint(url, options);
+  if (endpoint.queue.size() >= (size_t)FLAGS_http_publisher_queue_size) {
+    // Backpressure: the endpoint isn't keeping up
+    if (spool(endpoint, *body)) {
+      LOG(WARNING) << "Queue full for endpoint " << url
+                   << ", spooled request";
+    } else {
+      LOG(ERROR) << "Queue full for endpoint " << url << ", dropped request";
+    }
+    return false;
+  }
+  Request request;
+  request.body = std::move(body);
+  endpoint.queue.push_back(std::move(request));
+  wakeup();
+  return true;
+}
+
+std::shared_ptr<HttpStreamBody>
+HttpPublisher::postStream(
+    const std::vector<std::string>& urls, const Options& options) {
+  auto body = std::make_shared<HttpStreamBody>(
+      urls.size(),
+      (size_t)FLAGS_http_publisher_stream_buffer_kb << 10,
+      std::chrono::seconds(FLAGS_curl_timeout_s),
+      [this]() { wakeup(); });
+
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < urls.size(); i++) {
+    Endpoint& endpoint = getEndpoint(urls[i], options);
+    if (now < endpoint.retryAt || !endpoint.queue.empty()) {
+      // Don't hold up the writer (and other endpoints) on an endpoint that
+      // is failing or behind, and keep the body for a later retry
+      body->detach(i);
+      if (spoolStream(endpoint, *body)) {
+        LOG(WARNING) << "Endpoint " << urls[i]
+                     << " is backing off or busy, spooling streamed request";
+      } else {
+        LOG(ERROR) << "Endpoint " << urls[i]
+                   << " is backing off or busy, dropped streamed request";
+      }
+      continue;
+    }
+    Request request;
+    request.stream = body;
+    request.streamReader = i;
+    endpoint.queue.push_back(std::move(request));
+  }
+  wakeup();
+  return body;
+}
+
+void
+HttpPublisher::wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400
+  curl_multi_wakeup(multi_);
+#endif
+}
+
+HttpPublisher::Endpoint&
+HttpPublisher::getEndpoint(const std::string& url, const Options& options) {
+  std::string key = folly::sformat(
+      "{}|{}|{}", url, (int)options.useProxy, (int)options.jsonType);
+  auto iter = endpoints_.find(key);
+  if (iter != endpoints_.end()) {
+    return *iter->second;
+  }
+
+  auto endpoint = std::make_unique<Endpoint>();
+  endpoint->url = url;
+  endpoint->options = options;
+  if (!FLAGS_http_publisher_spool_dir.empty()) {
+    endpoint->spoolDir = folly::sformat(
+        "{}/{:016x}",
+        FLAGS_http_publisher_spool_dir,
+        std::hash<std::string>()(key));
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(endpoint->spoolDir, ec);
+    if (ec) {
+      LOG(ERROR) << "Unable to create spool directory " << endpoint->spoolDir
+                 << ": " << ec.message();
+      endpoint->spoolDir.clear();
+    } else {
+      // Pick up requests spooled by a previous run
+      removeSpoolTmpFiles(endpoint->spoolDir);
+      for (const auto& path : getSpoolFiles(endpoint->spoolDir)) {
+        endpoint->spoolBytes += boost::filesystem::file_size(path, ec);
+        auto seq = folly::tryTo<uint64_t>(path.stem().string());
+        if (seq.hasValue()) {
+          endpoint->spoolSeq = std::max(endpoint->spoolSeq, seq.value() + 1);
+        }
+      }
+    }
+  }
+  return *endpoints_.emplace(key, std::move(endpoint)).first->second;
+}
+
+void
+HttpPublisher::run() {
+  while (!stop_) {
+    startRequests();
+    resumeStreams();
+
+    int runningHandles = 0;
+    CURLMcode mc = curl_multi_perform(multi_, &runningHandles);
+    if (mc != CURLM_OK) {
+      LOG(ERROR) << "curl_multi_perform() failed: " << curl_multi_strerror(mc);
+    }
+    processCompletedTransfers();
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    // Woken up early by curl_multi_wakeup() when there is new data to send
+    mc = curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+    if (mc != CURLM_OK) {
+      LOG(ERROR) << "curl_multi_poll() failed: " << curl_multi_strerror(mc);
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollTimeoutMs));
+    }
+#else
+    // curl_multi_poll() and curl_multi_wakeup() need libcurl 7.68.0, so new
+    // data waits for socket activity or the poll timeout. curl_multi_wait()
+    // returns immediately if there is nothing to wait on, so sleep instead.
+    int numFds = 0;
+    mc = curl_multi_wait(multi_, nullptr, 0, kPollTimeoutMs, &numFds);
+    if (mc != CURLM_OK) {
+      LOG(ERROR) << "curl_multi_wait() failed: " << curl_multi_strerror(mc);
+    }
+    if (mc != CURLM_OK || numFds == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollTimeoutMs));
+    }
+#endif
+  }
+}
+
+void
+HttpPublisher::startRequests() {
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& kv : endpoints_) {
+    Endpoint& endpoint = *kv.second;
+    if (endpoint.inFlight || endpoint.queue.empty() ||
+        now < endpoint.retryAt) {
+      continue;
+    }
+
+    if (!endpoint.easy) {
+      endpoint.easy = curl_easy_init();
+      if (!endpoint.easy) {
+        LOG(ERROR) << "Unable to initialize CURL for endpoint "
+                   << endpoint.url;
+        continue;
+      }
+      CURL* curl = endpoint.easy;
+      curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+      // we can't verify the peer with our current image/lack of certs
+      curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
+      curl_easy_setopt(curl, CURLOPT_URL, endpoint.url.c_str());
+      curl_easy_setopt(curl, CURLOPT_POST, 1);
+      curl_easy_setopt(curl, CURLOPT_VERBOSE, 0);
+      curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
+      curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
+      curl_easy_setopt(curl, CURLOPT_TIMEOUT, FLAGS_curl_timeout_s);
+      curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1);
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curlDiscardCb);
+      curl_easy_setopt(curl, CURLOPT_PRIVATE, &endpoint);
+
+      if (endpoint.options.jsonType) {
+        endpoint.headers = curl_slist_append(
+            endpoint.headers, "Content-type: application/json");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, endpoint.headers);
+      }
+
+      if (endpoint.options.useProxy) {
+        if (FLAGS_proxy_url.empty()) {
+          LOG(WARNING) << "Not enabling CURL proxy (proxy_url is empty!)";
+        } else {
+          curl_easy_setopt(curl, CURLOPT_PROXY, FLAGS_proxy_url.c_str());
+          curl_easy_setopt(curl, CURLOPT_PROXYPORT, FLAGS_proxy_port);
+        }
+      }
+    }
+
+    Request request = std::move(endpoint.queue.front());
+    endpoint.queue.pop_front();
+    if (request.stream && !request.stream->isAttached(request.streamReader)) {
+      LOG(ERROR) << "Dropped streamed request to endpoint " << endpoint.url
+                 << " (writer timed out waiting for it)";
+      continue;
+    }
+
+    // The body stays owned by inFlight until the transfer completes
+    endpoint.inFlight = std::move(request);
+    if (endpoint.inFlight->stream) {
+      // Unknown size, so this is sent with chunked transfer encoding
+      curl_easy_setopt(endpoint.easy, CURLOPT_POSTFIELDS, nullptr);
+      curl_easy_setopt(
+          endpoint.easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)-1);
+      curl_easy_setopt(
+          endpoint.easy, CURLOPT_READFUNCTION, &HttpPublisher::streamReadCb);
+      curl_easy_setopt(endpoint.easy, CURLOPT_READDATA, &endpoint);
+      endpoint.streamPaused = false;
+    } else {
+      const std::string& body = *endpoint.inFlight->body;
+      curl_easy_setopt(
+          endpoint.easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)body.size());
+      curl_easy_setopt(endpoint.easy, CURLOPT_POSTFIELDS, body.data());
+    }
+
+    CURLMcode mc = curl_multi_add_handle(multi_, endpoint.easy);
+    if (mc != CURLM_OK) {
+      LOG(ERROR) << "Unable to start request to endpoint " << endpoint.url
+                 << ": " << curl_multi_strerror(mc);
+      endpoint.queue.push_front(std::move(*endpoint.inFlight));
+      endpoint.inFlight.reset();
+    }
+  }
+}
+
+void
+HttpPublisher::resumeStreams() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& kv : endpoints_) {
+    Endpoint& endpoint = *kv.second;
+    if (endpoint.streamPaused && endpoint.inFlight &&
+        endpoint.inFlight->stream->isReadable(
+            endpoint.inFlight->streamReader)) {
+      endpoint.streamPaused = false;
+      curl_easy_pause(endpoint.easy, CURLPAUSE_CONT);
+    }
+  }
+}
+
+size_t
+HttpPublisher::streamReadCb(char* buf, size_t size, size_t nmemb, void* p) {
+  Endpoint* endpoint = static_cast<Endpoint*>(p);
+  const Request& request = *endpoint->inFlight;
+  size_t ret = request.stream->read(request.streamReader, buf, size * nmemb);
+  if (ret == CURL_READFUNC_PAUSE) {
+    endpoint->streamPaused = true;
+  }
+  return ret;
+}
+
+void
+HttpPublisher::processCompletedTransfers() {
+  int msgsLeft = 0;
+  while (CURLMsg* msg = curl_multi_info_read(multi_, &msgsLeft)) {
+    if (msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+    CURL* curl = msg->easy_handle;
+    CURLcode res = msg->data.result;
+    char* priv = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, &priv);
+    Endpoint* endpoint = reinterpret_cast<Endpoint*>(priv);
+    curl_multi_remove_handle(multi_, curl);
+    if (endpoint) {
+      finishRequest(*endpoint, res);
+    }
+  }
+}
+
+void
+HttpPublisher::finishRequest(Endpoint& endpoint, CURLcode res) {
+  long responseCode = 0;
+  if (res == CURLE_OK) {
+    curl_easy_getinfo(endpoint.easy, CURLINFO_RESPONSE_CODE, &responseCode);
+  }
+  Request request = std::move(*endpoint.inFlight);
+  endpoint.inFlight.reset();
+  if (request.stream) {
+    request.stream->detach(request.streamReader);
+    endpoint.streamPaused = false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (res == CURLE_OK && responseCode >= 200L && responseCode < 300L) {
+    // response code 204 is a success
+    LOG(INFO) << "Submitted data points to " << endpoint.url;
+    endpoint.retryAt = std::chrono::steady_clock::time_point();
+    unspool(endpoint);
+    return;
+  }
+
+  bool retryable;
+  if (res != CURLE_OK) {
+    LOG(WARNING) << "CURL error for endpoint " << endpoint.url << ": "
+                 << curl_easy_strerror(res);
+    retryable = true;
+  } else {
+    LOG(WARNING) << "Failed submitting data points to " << endpoint.url
+                 << " (HTTP " << responseCode << ")";
+    retryable = isRetryableHttpStatus(responseCode);
+  }
+  if (!retryable) {
+    return;
+  }
+
+  request.attempts++;
+  auto backoff = std::min(
+      std::chrono::milliseconds(FLAGS_http_publisher_retry_backoff_ms) *
+          (1 << std::min(request.attempts - 1, 16)),
+      kMaxRetryBackoff);
+  endpoint.retryAt = std::chrono::steady_clock::now() + backoff;
+  if (request.stream) {
+    // Streamed bodies can't be replayed (later ones are spooled while backing
+    // off)
+    LOG(ERROR) << "Dropped streamed request to endpoint " << endpoint.url;
+  } else if (request.attempts <= FLAGS_http_publisher_max_retries) {
+    endpoint.queue.push_front(std::move(request));
+  } else if (!spool(endpoint, *request.body)) {
+    LOG(ERROR) << "Dropped request to endpoint " << endpoint.url << " after "
+               << request.attempts << " attempts";
+  }
+}
+
+bool
+HttpPublisher::spool(Endpoint& endpoint, const std::string& body) {
+  if (endpoint.spoolDir.empty()) {
+    return false;
+  }
+  size_t maxBytes = (size_t)FLAGS_http_publisher_spool_max_mb << 20;
+  if (endpoint.spoolBytes + body.size() > maxBytes) {
+    LOG(ERROR) << "Spool for endpoint " << endpoint.url << " is full";
+    return false;
+  }
+  std::string path = nextSpoolPath(endpoint);
+  try {
+    folly::writeFileAtomic(path, body);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Unable to write spool file " << path << ": " << ex.what();
+    return false;
+  }
+  endpoint.spoolBytes += body.size();
+  return true;
+}
+
+bool
+HttpPublisher::spoolStream(Endpoint& endpoint, HttpStreamBody& body) {
+  if (endpoint.spoolDir.empty()) {
+    return false;
+  }
+  size_t maxBytes = (size_t)FLAGS_http_publisher_spool_max_mb << 20;
+  if (endpoint.spoolBytes >= maxBytes) {
+    LOG(ERROR) << "Spool for endpoint " << endpoint.url << " is full";
+    return false;
+  }
+  // Endpoints are never removed while the publisher is running
+  Endpoint* spoolEndpoint = &endpoint;
+  return body.addSpoolFile(
+      nextSpoolPath(endpoint),
+      maxBytes - endpoint.spoolBytes,
+      [this, spoolEndpoint](size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spoolEndpoint->spoolBytes += bytes;
+      });
+}
+
+std::string
+HttpPublisher::nextSpoolPath(Endpoint& endpoint) {
+  return folly::sformat(
+      "{}/{:020d}{}",
+      endpoint.spoolDir,
+      endpoint.spoolSeq++,
+      kSpoolFileExtension);
+}
+
+void
+HttpPublisher::unspool(Endpoint& endpoint) {
+  if (endpoint.spoolDir.empty() || endpoint.spoolBytes == 0) {
+    return;
+  }
+  for (const auto& path : getSpoolFiles(endpoint.spoolDir)) {
+    if (endpoint.queue.size() >= (size_t)FLAGS_http_publisher_queue_size) {
+      break;
+    }
+    auto body = std::make_shared<std::string>();
+    if (!folly::readFile(path.c_str(), *body)) {
+      LOG(ERROR) << "Unable to read spool file " << path;
+    } else {
+      Request request;
+      request.body = std::move(body);
+      endpoint.queue.push_back(std::move(request));
+    }
+    boost::system::error_code ec;
+    size_t size = boost::filesystem::file_size(path, ec);
+    endpoint.spoolBytes -= std::min(endpoint.spoolBytes, ec ? 0 : size);
+    boost::filesystem::remove(path, ec);
+  }
+}
+
+void
+HttpPublisher::shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& kv : endpoints_) {
+    Endpoint& endpoint = *kv.second;
+    if (endpoint.inFlight) {
+      curl_multi_remove_handle(multi_, endpoint.easy);
+      endpoint.queue.push_front(std::move(*endpoint.inFlight));
+      endpoint.inFlight.reset();
+    }
+    for (const Request& request : endpoint.queue) {
+      if (request.stream) {
+        request.stream->detach(request.streamReader);
+      } else {
+        spool(endpoint, *request.body);
+      }
+    }
+    endpoint.queue.clear();
+    if (endpoint.easy) {
+      curl_easy_cleanup(endpoint.easy);
+    }
+    if (endpoint.headers) {
+      curl_slist_free_all(endpoint.headers);
+    }
+  }
+  endpoints_.clear();
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
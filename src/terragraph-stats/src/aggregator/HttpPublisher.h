@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <curl/curl.h>
+#include <folly/File.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/*
+ * A request body that is produced while it is being sent, shared by one or
+ * more requests ("readers").
+ *
+ * Only the bytes that the slowest reader hasn't consumed yet are buffered.
+ * The writer blocks while that exceeds the buffer limit. A reader that makes
+ * no progress for the write timeout is detached, and its request is aborted.
+ *
+ * The body can also be copied to spool files as it is written, for endpoints
+ * that can't take a streamed request right now.
+ */
+class HttpStreamBody {
+ public:
+  HttpStreamBody(
+      size_t numReaders,
+      size_t maxBufferedBytes,
+      std::chrono::milliseconds writeTimeout,
+      std::function<void()> onData);
+
+  // Remove any unfinished spool files
+  ~HttpStreamBody();
+
+  // Append data. Returns false if no readers or spool files are left.
+  bool write(folly::StringPiece data);
+
+  // Mark the end of the body, and finish writing spool files
+  void close();
+
+  // Also write the body to the spool file "path" (via a temporary file), up to
+  // "maxBytes". On close(), "onSpooled" is called with the file size. Must be
+  // called before the first write(). Returns false if the file can't be
+  // created.
+  bool addSpoolFile(
+      const std::string& path,
+      size_t maxBytes,
+      std::function<void(size_t)> onSpooled);
+
+  // Copy up to "len" bytes for the given reader. Returns the number of bytes
+  // copied (0 at the end of the body), CURL_READFUNC_PAUSE if no data is
+  // available yet, or CURL_READFUNC_ABORT if the reader was detached.
+  size_t read(size_t reader, char* buf, size_t len);
+
+  // Return whether a read() by the given reader would not pause
+  bool isReadable(size_t reader) const;
+
+  // Return whether the given reader is still attached
+  bool isAttached(size_t reader) const;
+
+  // Stop tracking the given reader
+  void detach(size_t reader);
+
+ private:
+  // A spool file being written
+  struct SpoolFile {
+    // The final and temporary file paths
+    std::string path;
+    std::string tmpPath;
+
+    // The temporary file (closed if abandoned or finished)
+    folly::File file;
+
+    // Number of bytes written, and the limit
+    size_t bytes{0};
+    size_t maxBytes{0};
+
+    // Called with the file size once the file is complete
+    std::function<void(size_t)> onSpooled;
+  };
+
+  // Drop bytes that all attached readers have consumed (mutex_ must be held)
+  void trim();
+
+  // Append data to all spool files. Returns false if none are left.
+  bool writeSpoolFiles(folly::StringPiece data);
+
+  // Stop writing a spool file and remove it
+  void abandonSpoolFile(SpoolFile& spoolFile);
+
+  // Guards all fields below
+  mutable std::mutex mutex_;
+
+  // Signaled when readers consume data or detach
+  std::condition_variable readerCv_;
+
+  // Buffered data, starting at absolute offset base_
+  std::string data_;
+  size_t base_{0};
+
+  // Absolute read offset per reader (std::nullopt if detached)
+  std::vector<std::optional<size_t>> readerOffsets_;
+
+  // Whether close() was called
+  bool closed_{false};
+
+  // Block writes while this many bytes are buffered
+  const size_t maxBufferedBytes_;
+
+  // Max time to block a write before detaching the slowest readers
+  const std::chrono::milliseconds writeTimeout_;
+
+  // Called after new data is available (outside the lock)
+  std::function<void()> onData_;
+
+  // Spool files (writer only)
+  std::vector<SpoolFile> spoolFiles_;
+};
+
+/*
+ * Asynchronous HTTP POST publisher for the aggregator's data endpoints.
+ *
+ * All requests are driven by one curl multi handle on a single worker thread,
+ * and each endpoint keeps one reusable easy handle (and thus its connection)
+ * across requests. Every endpoint has a bounded queue and at most one request
+ * in flight, so a slow endpoint cannot grow threads or memory without bound.
+ *
+ * Failed requests are retried with exponential backoff. Requests that run out
+ * of retries, or that arrive while the endpoint's queue is full, are spooled
+ * to disk (if enabled) and re-queued after the endpoint accepts a request
+ * again; otherwise they are dropped. Streamed requests to an endpoint that is
+ * backing off or busy are spooled as they are written instead of being sent.
+ */
+class HttpPublisher {
+ public:
+  // Per-endpoint request options
+  struct Options {
+    // Whether to use the configured HTTP proxy
+    bool useProxy{false};
+
+    // Whether to send "Content-type: application/json"
+    bool jsonType{false};
+  };
+
+  HttpPublisher();
+
+  ~HttpPublisher();
+
+  // Queue a POST request. The body is shared (not copied) across endpoints.
+  //
+  // This is thread-safe and never blocks on the network. Returns false if the
+  // request was not queued (i.e. it was spooled or dropped).
+  bool post(
+      const std::string& url,
+      std::shared_ptr<const std::string> body,
+      const Options& options = Options());
+
+  // Queue a POST request to each URL with a body that is written afterwards
+  // (sent with chunked transfer encoding), and return that body. The caller
+  // must close() it once it is complete.
+  //
+  // Endpoints that are backing off or have queued requests get the body
+  // spooled (or dropped if spooling is disabled), so they never block the
+  // writer. Streamed requests can't be replayed, so a streamed request that
+  // fails is not retried.
+  std::shared_ptr<HttpStreamBody> postStream(
+      const std::vector<std::string>& urls,
+      const Options& options = Options());
+
+ private:
+  // A queued request
+  struct Request {
+    // The request body (unless streamed)
+    std::shared_ptr<const std::string> body;
+
+    // Number of failed attempts so far
+    int attempts{0};
+
+    // The streamed request body, and this request's reader index in it
+    std::shared_ptr<HttpStreamBody> stream;
+    size_t streamReader{0};
+  };
+
+  // State for one endpoint (URL + options)
+  struct Endpoint {
+    // The endpoint URL
+    std::string url;
+
+    // The request options
+    Options options;
+
+    // Pending requests (guarded by mutex_)
+    std::deque<Request> queue;
+
+    // The reusable easy handle (worker thread only)
+    CURL* easy{nullptr};
+
+    // Request headers (worker thread only)
+    curl_slist* headers{nullptr};
+
+    // The request in flight, if any (worker thread only)
+    std::optional<Request> inFlight;
+
+    // Don't start another request until this time (guarded by mutex_)
+    std::chrono::steady_clock::time_point retryAt;
+
+    // Whether the in-flight streamed request is waiting for data
+    // (worker thread only)
+    bool streamPaused{false};
+
+    // Spool directory for this endpoint (empty if spooling is disabled)
+    std::string spoolDir;
+
+    // Number of bytes currently spooled (guarded by mutex_)
+    size_t spoolBytes{0};
+
+    // Sequence number for the next spool file (guarded by mutex_)
+    uint64_t spoolSeq{0};
+  };
+
+  // Worker thread loop
+  void run();
+
+  // Start requests on idle endpoints
+  void startRequests();
+
+  // Resume paused streamed requests that have data to send
+  void resumeStreams();
+
+  // Handle completed transfers
+  void processCompletedTransfers();
+
+  // curl read callback for streamed request bodies
+  static size_t streamReadCb(char* buf, size_t size, size_t nmemb, void* p);
+
+  // Handle the result of an endpoint's in-flight request
+  void finishRequest(Endpoint& endpoint, CURLcode res);
+
+  // Return the endpoint for the given URL and options, creating it if needed
+  // (mutex_ must be held)
+  Endpoint& getEndpoint(const std::string& url, const Options& options);
+
+  // Wake up the worker thread
+  void wakeup();
+
+  // Return the path for the endpoint's next spool file (mutex_ must be held)
+  std::string nextSpoolPath(Endpoint& endpoint);
+
+  // Write a request body to the endpoint's spool (mutex_ must be held)
+  bool spool(Endpoint& endpoint, const std::string& body);
+
+  // Spool a streamed request body for the endpoint as it is written
+  // (mutex_ must be held)
+  bool spoolStream(Endpoint& endpoint, HttpStreamBody& body);
+
+  // Move spooled requests back into the endpoint's queue while there is room
+  // (mutex_ must be held)
+  void unspool(Endpoint& endpoint);
+
+  // Spool any queued requests and release all curl handles
+  void shutdown();
+
+  // Guards endpoint queues and spool state
+  std::mutex mutex_;
+
+  // All endpoints, keyed by URL and options
+  std::unordered_map<std::string, std::unique_ptr<Endpoint>> endpoints_;
+
+  // The curl multi handle (worker thread only)
+  CURLM* multi_{nullptr};
+
+  // The worker thread
+  std::thread thread_;
+
+  // Simple loop-breaker for thread_
+  std::atomic_bool stop_{false};
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
@@ -9,7 +9,6 @@
 
 #include <future>
 
-#include <curl/curl.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
@@ -18,6 +17,7 @@
 #include <thrift/lib/cpp/protocol/TProtocolTypes.h>
 
 #include "SharedObjects.h"
+#include "StatsJsonWriter.h"
 #include "../common/Consts.h"
 #include "e2e/common/JsonUtils.h"
 
@@ -51,32 +51,6 @@ DEFINE_int32(
     2000,
     "ZMQ read timeout in milliseconds for fetching the topology from the "
     "controller");
-DEFINE_int32(curl_timeout_s, 10, "cURL timeout for the entire request");
-DEFINE_string(proxy_url, "", "IPv6 to IPv4 proxy URL (ex. 'http://[2001::1]')");
-DEFINE_int32(proxy_port, 8080, "IPv6 to IPv4 proxy port");
-
-extern "C" {
-struct HTTPDataStruct {
-  char* data;
-  size_t size;
-};
-
-static size_t
-curlWriteCb(void* content, size_t size, size_t nmemb, void* userp) {
-  size_t realSize = size * nmemb;
-  struct HTTPDataStruct* httpData = (struct HTTPDataStruct*)userp;
-  httpData->data =
-      (char*)realloc(httpData->data, httpData->size + realSize + 1);
-  if (httpData->data == nullptr) {
-    printf("Unable to allocate memory (realloc failed)\n");
-    return 0;
-  }
-  memcpy(&(httpData->data[httpData->size]), content, realSize);
-  httpData->size += realSize;
-  httpData->data[httpData->size] = 0;
-  return realSize;
-}
-}
 
 namespace facebook {
 namespace terragraph {
@@ -122,6 +96,7 @@ StatsApp::StatsApp(
 StatsApp::~StatsApp() {
   stopPublisherThread(dataPublisherThread_, dataPublisherStop_);
   stopPublisherThread(hfDataPublisherThread_, hfDataPublisherStop_);
+  // httpPublisher_ is destroyed after this, once nothing can post to it
 }
 
 void
@@ -349,83 +324,13 @@ StatsApp::pushCurlPostRequest(
     const std::string& postData,
     const bool useProxy,
     const bool jsonType) {
-  // start a new thread for the curl request to each endpoint so we don't block
+  // queue one shared copy of the body for every endpoint (does not block)
+  auto body = std::make_shared<const std::string>(postData);
+  HttpPublisher::Options options;
+  options.useProxy = useProxy;
+  options.jsonType = jsonType;
   for (const auto& endpoint : endpoints) {
-    std::thread asyncCurlThread([=]() {
-      bool success = false;
-      try {
-        curl_slist* slist = nullptr;
-        CURL* curl;
-        CURLcode res;
-        curl = curl_easy_init();
-        if (!curl) {
-          throw std::runtime_error("Unable to initialize CURL");
-        }
-
-        // add form parameters
-        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
-        // we can't verify the peer with our current image/lack of certs
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
-        curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postData.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, postData.length());
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 0);
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
-        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, FLAGS_curl_timeout_s);
-
-        if (jsonType != false) {
-          slist = curl_slist_append(slist, "Content-type: application/json");
-          curl_easy_setopt(curl, CURLOPT_HTTPHEADER, slist);
-        }
-
-        if (useProxy != false) {
-          if (FLAGS_proxy_url.empty()) {
-            LOG(WARNING) << "Not enabling CURL proxy (proxy_url is empty!)";
-          } else {
-            curl_easy_setopt(curl, CURLOPT_PROXY, FLAGS_proxy_url.c_str());
-            curl_easy_setopt(curl, CURLOPT_PROXYPORT, FLAGS_proxy_port);
-          }
-        }
-
-        // read data from request
-        struct HTTPDataStruct dataChunk;
-        dataChunk.data = (char*)malloc(1);
-        dataChunk.size = 0;
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curlWriteCb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)&dataChunk);
-        res = curl_easy_perform(curl);
-        if (res == CURLE_OK) {
-          long response_code;
-          curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-          // response code 204 is a success
-          if (response_code >= 200L || response_code < 300L) {
-            success = true;
-          }
-        }
-        // cleanup
-        if (slist != nullptr) {
-          curl_slist_free_all(slist);
-        }
-        curl_easy_cleanup(curl);
-        free(dataChunk.data);
-        if (res != CURLE_OK) {
-          LOG(WARNING) << "CURL error for endpoint " << endpoint << ": "
-                       << curl_easy_strerror(res);
-          return false;
-        }
-
-        if (success) {
-          LOG(INFO) << "Submitted data points to " << endpoint;
-        } else {
-          LOG(WARNING) << "Failed submitting data points to " << endpoint;
-        }
-      } catch (const std::runtime_error& ex) {
-        LOG(ERROR) << ex.what();
-      }
-      return success;
-    });
-    asyncCurlThread.detach();
+    httpPublisher_.post(endpoint, body, options);
   }
 }
 
@@ -447,14 +352,27 @@ StatsApp::pushQueuedStats(
     int interval,
     std::atomic_bool& publisherStop,
     const std::vector<std::string> endpoints) {
-  folly::dynamic dataPointsQueue = folly::dynamic::array;
-
   LOG(INFO) << "Processing queued stats from " << statsQueues.size()
             << " agents...";
 
+  // Stream the request to all endpoints as it is written (the request is only
+  // started once the first agent has any data points)
+  std::shared_ptr<HttpStreamBody> body;
+  StatsJsonWriter writer(
+      topology_.name, interval, [&](folly::StringPiece data) {
+        if (endpoints.empty()) {
+          return false;
+        }
+        if (!body) {
+          body = httpPublisher_.postStream(endpoints);
+        }
+        return body->write(data);
+      });
+
   // Process stats from each agent
+  const std::string kEmpty;
   for (const auto& kv : statsQueues) {
-    std::string agent = kv.first;
+    const std::string& agent = kv.first;
     auto& statsQueue = kv.second;
 
     LOG(INFO) << "Processing " << statsQueue.size() << " stats from " << agent;
@@ -470,69 +388,29 @@ StatsApp::pushQueuedStats(
     // Calculate rate using the previous (processed) sample for this agent
     auto& prevStatsQueue = prevStatsQueues[agent];
 
-    folly::dynamic statsMsgs = folly::dynamic::array;
-    for (const auto& currStatKv : statsQueue) {
-      double value = currStatKv.second.value;
-
-      // Calculate rate for counters
-      if (currStatKv.second.isCounter) {
-        // Skip processing this iteration if no data
-        auto prevCounter = prevStatsQueue.find(currStatKv.first);
-        if (prevCounter == prevStatsQueue.end()) {
-          continue;
-        }
-
-        double prevValue = prevCounter->second.value;
-        int64_t prevTime = prevCounter->second.timestamp;
-        double curValue = currStatKv.second.value;
-        int64_t curTime = currStatKv.second.timestamp;
-
-        // Only compute a rate if the current data point is newer
-        if (curTime <= prevTime) {
-          continue;
-        }
-
-        // Compute rate if the value changed
-        value = 0;
-        if (curValue > prevValue) {
-          value = (curValue - prevValue) /
-                  ((double)(curTime - prevTime) / 1000 /* ms */);
-        }
-      }
-
-      // Push computed data point
-      folly::dynamic stat = folly::dynamic::object("key", currStatKv.first)(
-          "ts", currStatKv.second.timestamp)("value", value);
-      statsMsgs.push_back(stat);
-    }
-    prevStatsQueue = statsQueue;
-    if (statsMsgs.empty()) {
-      continue;
-    }
-
-    // Add stats to queues
     auto nodeNameIt = nodeMacToName_.find(agent);
     auto siteIt = nodeMacToSite_.find(agent);
     if (nodeNameIt != nodeMacToName_.end() && siteIt != nodeMacToSite_.end()) {
       // Push stats from a known node
-      dataPointsQueue.push_back(folly::dynamic::object(
-          "mac", agent)("name", nodeNameIt->second)("site", siteIt->second)(
-          "stats", statsMsgs));
+      writer.writeAgent(
+          agent,
+          nodeNameIt->second,
+          siteIt->second,
+          statsQueue,
+          prevStatsQueue);
     } else {
       // Push stats from another source (e.g. controller)
-      dataPointsQueue.push_back(folly::dynamic::object(
-          "mac", agent)("name", "")("site", "")("stats", statsMsgs));
+      writer.writeAgent(agent, kEmpty, kEmpty, statsQueue, prevStatsQueue);
     }
+    prevStatsQueue = statsQueue;
   }
 
-  // Push the processed stats
-  if (!dataPointsQueue.empty()) {
-    folly::dynamic statsWriterRequest = folly::dynamic::object(
-        "topology", folly::dynamic::object("name", topology_.name))(
-        "agents", dataPointsQueue)("interval", interval);
-
-    string postString = folly::toJson(statsWriterRequest);
-    pushCurlPostRequest(endpoints, postString);
+  // Push the rest of the processed stats
+  if (!writer.finish()) {
+    LOG(ERROR) << "Stats request to all endpoints failed while streaming";
+  }
+  if (body) {
+    body->close();
   }
 }
 
@@ -627,7 +505,10 @@ StatsApp::periodicDataPublish() {
   // Spawn a new thread
   dataPublisherStop_ = false;
   dataPublisherThread_ =
-      std::thread([this, statsQueues, sysLogsQueue, eventsQueues]() {
+      std::thread([this,
+                   statsQueues = std::move(statsQueues),
+                   sysLogsQueue = std::move(sysLogsQueue),
+                   eventsQueues = std::move(eventsQueues)]() {
     // Process and push queues
     if (!statsQueues.empty()) {
       auto startTime = (int64_t)duration_cast<microseconds>(
@@ -676,7 +557,8 @@ StatsApp::periodicHighFrequencyDataPublish() {
 
   // Spawn new thread to process stats
   hfDataPublisherStop_ = false;
-  hfDataPublisherThread_ = std::thread([this, hfStatsQueues]() {
+  hfDataPublisherThread_ =
+      std::thread([this, hfStatsQueues = std::move(hfStatsQueues)]() {
     auto startTime = (int64_t)duration_cast<microseconds>(
                          system_clock::now().time_since_epoch())
                          .count();
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "AggrApp.h"
+#include "HttpPublisher.h"
 
 #include <thread>
 
@@ -92,7 +93,7 @@ class StatsApp final : public AggrApp {
   void handleStatsReport(
       const std::string& agent, const thrift::AggrStatsReport& statsReport);
 
-  // Sends a POST request, using curl, to the given URL in a new thread.
+  // Queues a POST request to each of the given URLs on httpPublisher_.
   void pushCurlPostRequest(
       const std::vector<std::string>& endpoints,
       const std::string& postData,
@@ -145,6 +146,9 @@ class StatsApp final : public AggrApp {
   // Simple loop-breaker in dataPublisherThread_
   std::atomic_bool dataPublisherStop_{false};
   std::atomic_bool hfDataPublisherStop_{false};
+
+  // Asynchronous POST publisher shared by all data endpoints
+  HttpPublisher httpPublisher_;
 };
 
 } // namesapce stats
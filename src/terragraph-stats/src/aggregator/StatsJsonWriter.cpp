@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "StatsJsonWriter.h"
+
+#include <cmath>
+
+#include <folly/Conv.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+
+namespace {
+// Default JSON serialization options (as used by folly::toJson)
+const folly::json::serialization_opts kJsonOpts;
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+StatsJsonWriter::StatsJsonWriter(
+    const std::string& topologyName, int interval, Sink sink, size_t flushBytes)
+    : topologyName_(topologyName),
+      interval_(interval),
+      sink_(std::move(sink)),
+      flushBytes_(flushBytes) {
+  buf_.reserve(flushBytes_ + 1024);
+}
+
+bool
+StatsJsonWriter::getStatValue(
+    const thrift::AggrStat& stat,
+    const AgentStats& prevStatsQueue,
+    double& value) {
+  value = stat.value;
+
+  // Calculate rate for counters
+  if (stat.isCounter) {
+    // Skip processing this iteration if no data
+    auto prevCounter = prevStatsQueue.find(stat.key);
+    if (prevCounter == prevStatsQueue.end()) {
+      return false;
+    }
+
+    double prevValue = prevCounter->second.value;
+    int64_t prevTime = prevCounter->second.timestamp;
+    double curValue = stat.value;
+    int64_t curTime = stat.timestamp;
+
+    // Only compute a rate if the current data point is newer
+    if (curTime <= prevTime) {
+      return false;
+    }
+
+    // Compute rate if the value changed
+    value = 0;
+    if (curValue > prevValue) {
+      value = (curValue - prevValue) /
+              ((double)(curTime - prevTime) / 1000 /* ms */);
+    }
+  }
+
+  // JSON can't represent these
+  return std::isfinite(value);
+}
+
+size_t
+StatsJsonWriter::writeAgent(
+    const std::string& mac,
+    const std::string& name,
+    const std::string& site,
+    const AgentStats& statsQueue,
+    const AgentStats& prevStatsQueue) {
+  if (finished_) {
+    return 0;
+  }
+
+  // The agent header is only kept if at least one data point follows, and
+  // nothing is flushed before that
+  size_t agentStart = buf_.size();
+  buf_ += agentCount_ == 0 ? "{\"topology\":{\"name\":" : ",";
+  if (agentCount_ == 0) {
+    folly::json::escapeString(topologyName_, buf_, kJsonOpts);
+    buf_ += "},\"interval\":";
+    folly::toAppend(interval_, &buf_);
+    buf_ += ",\"agents\":[";
+  }
+  buf_ += "{\"mac\":";
+  folly::json::escapeString(mac, buf_, kJsonOpts);
+  buf_ += ",\"name\":";
+  folly::json::escapeString(name, buf_, kJsonOpts);
+  buf_ += ",\"site\":";
+  folly::json::escapeString(site, buf_, kJsonOpts);
+  buf_ += ",\"stats\":[";
+
+  size_t count = 0;
+  for (const auto& kv : statsQueue) {
+    double value;
+    if (!getStatValue(kv.second, prevStatsQueue, value)) {
+      continue;
+    }
+    if (count++ > 0) {
+      buf_ += ',';
+    }
+    buf_ += "{\"key\":";
+    folly::json::escapeString(kv.first, buf_, kJsonOpts);
+    buf_ += ",\"ts\":";
+    folly::toAppend(kv.second.timestamp, &buf_);
+    buf_ += ",\"value\":";
+    folly::toAppend(value, &buf_);
+    buf_ += '}';
+    flush(false);
+  }
+
+  if (count == 0) {
+    buf_.resize(agentStart);
+    return 0;
+  }
+  buf_ += "]}";
+  agentCount_++;
+  return count;
+}
+
+bool
+StatsJsonWriter::finish() {
+  if (!finished_ && agentCount_ > 0) {
+    buf_ += "]}";
+    flush(true);
+  }
+  finished_ = true;
+  return !aborted_;
+}
+
+size_t
+StatsJsonWriter::getAgentCount() const {
+  return agentCount_;
+}
+
+void
+StatsJsonWriter::flush(bool force) {
+  if (buf_.empty() || (!force && buf_.size() < flushBytes_)) {
+    return;
+  }
+  if (!aborted_ && !sink_(buf_)) {
+    VLOG(2) << "Stats JSON sink stopped accepting output";
+    aborted_ = true;
+  }
+  buf_.clear();
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
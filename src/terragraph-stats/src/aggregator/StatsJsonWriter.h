@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Range.h>
+
+#include "stats/if/gen-cpp2/Aggregator_types.h"
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/*
+ * Incrementally writes the stats writer request sent to the aggregator's data
+ * endpoints, i.e. the same JSON document that used to be built as one
+ * folly::dynamic:
+ *
+ *   {"topology": {"name": ...}, "interval": ..., "agents": [
+ *     {"mac": ..., "name": ..., "site": ..., "stats": [
+ *       {"key": ..., "ts": ..., "value": ...}, ...]}, ...]}
+ *
+ * Output is handed to a sink in chunks of roughly "flushBytes", so memory use
+ * does not depend on the number of agents or stats. Nothing is written at all
+ * until the first agent with at least one data point.
+ */
+class StatsJsonWriter {
+ public:
+  // Stats queued for one agent
+  using AgentStats = std::unordered_map<std::string, thrift::AggrStat>;
+
+  // Receives the next chunk of output; returns false to stop writing
+  using Sink = std::function<bool(folly::StringPiece)>;
+
+  StatsJsonWriter(
+      const std::string& topologyName,
+      int interval,
+      Sink sink,
+      size_t flushBytes = 64 * 1024);
+
+  // Write the data points for one agent. Counters are converted to rates using
+  // the agent's previous stats queue, and are skipped if no earlier sample
+  // exists. Agents without any data points are omitted.
+  //
+  // Returns the number of data points written.
+  size_t writeAgent(
+      const std::string& mac,
+      const std::string& name,
+      const std::string& site,
+      const AgentStats& statsQueue,
+      const AgentStats& prevStatsQueue);
+
+  // Close the document and flush any remaining output.
+  // Returns false if the sink stopped accepting output.
+  bool finish();
+
+  // Return the number of agents written so far
+  size_t getAgentCount() const;
+
+  // Compute the published value of a stat, converting counters to rates.
+  // Returns false if no data point should be published.
+  static bool getStatValue(
+      const thrift::AggrStat& stat,
+      const AgentStats& prevStatsQueue,
+      double& value);
+
+ private:
+  // Hand buffered output to the sink once there is enough of it (or always,
+  // if "force" is set)
+  void flush(bool force);
+
+  // The topology name
+  const std::string topologyName_;
+
+  // The stats push interval (in seconds)
+  const int interval_;
+
+  // The output sink
+  Sink sink_;
+
+  // Flush to the sink once this many bytes are buffered
+  const size_t flushBytes_;
+
+  // Buffered output
+  std::string buf_;
+
+  // Number of agents written
+  size_t agentCount_{0};
+
+  // Whether the sink stopped accepting output
+  bool aborted_{false};
+
+  // Whether the document was closed
+  bool finished_{false};
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
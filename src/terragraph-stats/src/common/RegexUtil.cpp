@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RegexUtil.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+// Return the index just past the group starting at pattern[i] == '('
+size_t
+skipGroup(const std::string& pattern, size_t i) {
+  int depth = 0;
+  bool inClass = false;
+  for (; i < pattern.size(); i++) {
+    char c = pattern[i];
+    if (c == '\\') {
+      i++;
+    } else if (inClass) {
+      if (c == ']') {
+        inClass = false;
+      }
+    } else if (c == '[') {
+      inClass = true;
+      // A leading ']' (or '^]') is a literal
+      if (i + 1 < pattern.size() && pattern[i + 1] == '^') {
+        i++;
+      }
+      if (i + 1 < pattern.size() && pattern[i + 1] == ']') {
+        i++;
+      }
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')') {
+      if (--depth == 0) {
+        return i + 1;
+      }
+    }
+  }
+  return pattern.size();
+}
+
+// Return the index just past the character class starting at pattern[i] == '['
+size_t
+skipClass(const std::string& pattern, size_t i) {
+  i++;
+  if (i < pattern.size() && pattern[i] == '^') {
+    i++;
+  }
+  if (i < pattern.size() && pattern[i] == ']') {
+    i++;
+  }
+  for (; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == ']') {
+      return i + 1;
+    }
+  }
+  return pattern.size();
+}
+
+// Return the index just past the operand of the escape "\<escaped>" that ends
+// just before pattern[i]
+size_t
+skipEscapeOperand(const std::string& pattern, size_t i, char escaped) {
+  size_t maxLen = 0;
+  if (escaped == 'x') {
+    maxLen = 2;  // \xhh
+  } else if (escaped == 'u') {
+    maxLen = 4;  // \uhhhh
+  } else if (escaped == 'c') {
+    return std::min(i + 1, pattern.size());  // \cX
+  } else if (std::isdigit(static_cast<unsigned char>(escaped))) {
+    // \0 or backreference, followed by any number of digits
+    while (i < pattern.size() &&
+           std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+      i++;
+    }
+    return i;
+  }
+  size_t end = std::min(i + maxLen, pattern.size());
+  while (i < end && std::isxdigit(static_cast<unsigned char>(pattern[i]))) {
+    i++;
+  }
+  return i;
+}
+
+// Return whether the top level of the pattern contains an alternation
+bool
+hasTopLevelAlternation(const std::string& pattern) {
+  for (size_t i = 0; i < pattern.size(); i++) {
+    char c = pattern[i];
+    if (c == '\\') {
+      i++;
+    } else if (c == '(') {
+      i = skipGroup(pattern, i) - 1;
+    } else if (c == '[') {
+      i = skipClass(pattern, i) - 1;
+    } else if (c == '|') {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+std::string
+RegexUtil::getRequiredLiteral(const std::string& pattern) {
+  // Any top-level branch could match on its own
+  if (hasTopLevelAlternation(pattern)) {
+    return "";
+  }
+
+  std::string best;
+  std::string cur;
+  auto endRun = [&]() {
+    if (cur.size() > best.size()) {
+      best = cur;
+    }
+    cur.clear();
+  };
+
+  // Whether the previous atom was a literal character appended to "cur"
+  bool prevLiteral = false;
+  for (size_t i = 0; i < pattern.size();) {
+    char c = pattern[i];
+    if (c == '*' || c == '?' || c == '{' || c == '+') {
+      // Quantifier on the previous atom
+      if (prevLiteral && c != '+') {
+        cur.pop_back();  // the character may not occur at all
+      }
+      endRun();
+      if (c == '{') {
+        size_t end = pattern.find('}', i);
+        i = (end == std::string::npos) ? pattern.size() : end + 1;
+      } else {
+        i++;
+      }
+      if (i < pattern.size() && pattern[i] == '?') {
+        i++;  // non-greedy
+      }
+      prevLiteral = false;
+      continue;
+    }
+
+    if (c == '\\' && i + 1 < pattern.size()) {
+      char escaped = pattern[i + 1];
+      i += 2;
+      if (std::ispunct(static_cast<unsigned char>(escaped))) {
+        cur.push_back(escaped);
+        prevLiteral = true;
+      } else {
+        // Character class, assertion, backreference, control escape, etc.
+        // Skip the rest of a multi-character escape (e.g. "\x41", "\u00e9",
+        // "\cJ", "\12") so its operand isn't taken as literal characters.
+        i = skipEscapeOperand(pattern, i, escaped);
+        endRun();
+        prevLiteral = false;
+      }
+      continue;
+    }
+
+    if (c == '(') {
+      i = skipGroup(pattern, i);
+      endRun();
+      prevLiteral = false;
+    } else if (c == '[') {
+      i = skipClass(pattern, i);
+      endRun();
+      prevLiteral = false;
+    } else if (c == '.' || c == '^' || c == '$' || c == '\\') {
+      i++;
+      endRun();
+      prevLiteral = false;
+    } else {
+      i++;
+      cur.push_back(c);
+      prevLiteral = true;
+    }
+  }
+  endRun();
+  return best;
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
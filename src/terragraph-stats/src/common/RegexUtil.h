@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+class RegexUtil {
+ public:
+  // Return a literal substring that any match of the given (ECMAScript) regex
+  // must contain, or an empty string if none could be determined.
+  //
+  // This is used to cheaply reject inputs before running the regex engine.
+  static std::string getRequiredLiteral(const std::string& pattern);
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
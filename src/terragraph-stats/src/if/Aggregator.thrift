@@ -74,6 +74,20 @@ struct AggrStatsReport {
   2: list<string> events;
 }
 
+// All stats from one node for one push interval, stored column-wise.
+// Stat i is (keys[keyIdx[i]], entities[entityIdx[i]], timestamps[i],
+// values[i], isCounter[i]); keys and entities are dictionaries shared by all
+// stats in the batch.
+struct AggrStatsBatch {
+  1: list<string> keys;
+  2: list<string> entities;
+  3: list<i32> keyIdx;
+  4: list<i32> entityIdx;
+  5: list<i64> timestamps;
+  6: list<double> values;
+  7: list<bool> isCounter;
+}
+
 struct AggrSyslog {
   1: i64 timestamp;
   2: string index;
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "EventMatcher.h"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+#include <folly/ExceptionString.h>
+#include <folly/Format.h>
+
+#include "stats/common/RegexUtil.h"
+
+using apache::thrift::detail::TEnumMapFactory;
+using std::string;
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+EventMatcher::EventMatcher(
+    const std::unordered_map<string, thrift::EventFilter>& eventFilters) {
+  // Compile filters in name order, so that match results are deterministic
+  std::vector<string> names;
+  for (const auto& eventIt : eventFilters) {
+    names.push_back(eventIt.first);
+  }
+  std::sort(names.begin(), names.end());
+
+  for (const string& name : names) {
+    const auto& eventFilter = eventFilters.at(name);
+    try {
+      Filter filter;
+      filter.name = name;
+      filter.regex = std::regex(eventFilter.regex);
+      filter.level = TEnumMapFactory<thrift::EventLevel>::
+          makeNamesToValuesMap().at(eventFilter.level.c_str());
+      filter.requiredLiteral = RegexUtil::getRequiredLiteral(eventFilter.regex);
+      VLOG(3) << folly::format(
+          "Added event filter '{}': {} (required literal: '{}')",
+          name,
+          eventFilter.regex,
+          filter.requiredLiteral);
+      filters_.push_back(std::move(filter));
+    } catch (const std::regex_error& ex) {
+      LOG(ERROR) << folly::format(
+          "Ignoring malformed custom event regular expression, {}: {}",
+          eventFilter.regex,
+          folly::exceptionStr(ex));
+    } catch (const std::out_of_range& ex) {
+      LOG(ERROR) << folly::format(
+          "Ignoring invalid custom event level, {}: {}",
+          eventFilter.level,
+          folly::exceptionStr(ex));
+    }
+  }
+
+  buildAutomaton();
+}
+
+void
+EventMatcher::buildAutomaton() {
+  // Assign a character class to every byte used in a literal
+  for (size_t i = 0; i < filters_.size(); i++) {
+    const string& literal = filters_[i].requiredLiteral;
+    if (literal.empty()) {
+      unconditionalFilters_.push_back(i);
+      continue;
+    }
+    for (char c : literal) {
+      uint8_t& charClass = charClasses_[(uint8_t)c];
+      if (charClass == 0) {
+        charClass = numClasses_++;
+      }
+    }
+  }
+
+  // Build a trie of all literals (0 is the root, and a missing edge)
+  const uint32_t kNone = 0;
+  transitions_.assign(numClasses_, kNone);
+  outputs_.assign(1, {});
+  for (size_t i = 0; i < filters_.size(); i++) {
+    uint32_t state = 0;
+    for (char c : filters_[i].requiredLiteral) {
+      size_t index = state * numClasses_ + charClasses_[(uint8_t)c];
+      if (transitions_[index] == kNone) {
+        transitions_[index] = outputs_.size();
+        outputs_.emplace_back();
+        transitions_.resize(outputs_.size() * numClasses_, kNone);
+      }
+      state = transitions_[index];
+    }
+    if (state != 0) {
+      outputs_[state].push_back(i);
+    }
+  }
+
+  // Add failure transitions in breadth-first order, turning the trie into a
+  // DFA, and propagate outputs along failure links
+  std::vector<uint32_t> failure(outputs_.size(), 0);
+  std::deque<uint32_t> queue;
+  for (size_t c = 0; c < numClasses_; c++) {
+    uint32_t next = transitions_[c];
+    if (next != kNone) {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    uint32_t state = queue.front();
+    queue.pop_front();
+    for (size_t c = 0; c < numClasses_; c++) {
+      uint32_t& next = transitions_[state * numClasses_ + c];
+      uint32_t fallback = transitions_[failure[state] * numClasses_ + c];
+      if (next == kNone) {
+        next = fallback;
+      } else {
+        failure[next] = fallback;
+        outputs_[next].insert(
+            outputs_[next].end(),
+            outputs_[fallback].begin(),
+            outputs_[fallback].end());
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+void
+EventMatcher::match(
+    folly::StringPiece line, std::vector<size_t>& matches) const {
+  matches.clear();
+
+  // Find candidate filters by their required literals
+  uint32_t state = 0;
+  for (char c : line) {
+    state = transitions_[state * numClasses_ + charClasses_[(uint8_t)c]];
+    const auto& output = outputs_[state];
+    if (!output.empty()) {
+      matches.insert(matches.end(), output.begin(), output.end());
+    }
+  }
+  matches.insert(
+      matches.end(),
+      unconditionalFilters_.begin(),
+      unconditionalFilters_.end());
+  std::sort(matches.begin(), matches.end());
+  matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+  // Confirm candidates with the regex engine
+  matches.erase(
+      std::remove_if(
+          matches.begin(),
+          matches.end(),
+          [&](size_t i) {
+            return !std::regex_search(
+                line.begin(), line.end(), filters_[i].regex);
+          }),
+      matches.end());
+}
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include "e2e/if/gen-cpp2/Event_types.h"
+#include "e2e/if/gen-cpp2/NodeConfig_types.h"
+
+namespace facebook {
+namespace terragraph {
+namespace stats {
+
+/*
+ * EventMatcher matches log lines against a set of event filters at once.
+ *
+ * Each filter's regex gets a literal substring that every match must contain
+ * (if one can be found). All literals are compiled into one Aho-Corasick
+ * automaton, so a single scan of a line finds the candidate filters, and only
+ * those (plus filters without a literal) are confirmed with the regex engine.
+ */
+class EventMatcher {
+ public:
+  // A compiled event filter
+  struct Filter {
+    // The event name
+    std::string name;
+
+    // The compiled regex
+    std::regex regex;
+
+    // The event level
+    thrift::EventLevel level;
+
+    // A literal substring required for any match (may be empty)
+    std::string requiredLiteral;
+  };
+
+  // Compile the given event filters, keyed by event name (malformed filters
+  // are logged and ignored)
+  explicit EventMatcher(
+      const std::unordered_map<std::string, thrift::EventFilter>& eventFilters);
+
+  // Fill "matches" with the indices of all filters matching the line (in
+  // increasing order)
+  void match(folly::StringPiece line, std::vector<size_t>& matches) const;
+
+  // Return the filter at the given index
+  const Filter&
+  getFilter(size_t index) const {
+    return filters_[index];
+  }
+
+  // Return the number of compiled filters
+  size_t
+  size() const {
+    return filters_.size();
+  }
+
+ private:
+  // Build the automaton over the required literals of all filters
+  void buildAutomaton();
+
+  // The compiled filters
+  std::vector<Filter> filters_;
+
+  // Filters without a required literal, which are checked on every line
+  std::vector<size_t> unconditionalFilters_;
+
+  // Byte to character class in the automaton (0 for bytes not in any literal)
+  std::array<uint8_t, 256> charClasses_{};
+
+  // Number of character classes
+  size_t numClasses_{1};
+
+  // Automaton transitions, indexed by (state * numClasses_ + class)
+  std::vector<uint32_t> transitions_;
+
+  // Filters whose required literal was found upon reaching each state
+  std::vector<std::vector<size_t>> outputs_;
+};
+
+} // namespace stats
+} // namespace terragraph
+} // namespace facebook
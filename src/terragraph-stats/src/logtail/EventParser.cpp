@@ -7,10 +7,10 @@
 
 #include "EventParser.h"
 
-#include <stdexcept>
+#include <algorithm>
+#include <cctype>
 
 #include <fbzmq/service/monitor/ZmqMonitorClient.h>
-#include <folly/ExceptionString.h>
 #include <folly/Format.h>
 #include <folly/dynamic.h>
 
@@ -18,9 +18,48 @@ DEFINE_string(nms_publisher_host, "localhost", "NMS publisher Hostname or IP");
 DEFINE_int32(nms_publisher_port, 4231, "NMS publisher port");
 DEFINE_string(
     event_marker_suffix, ".marker.2", "EventParser marker file suffix");
+DEFINE_double(
+    event_rate_limit_per_s,
+    0.1,
+    "Maximum sustained rate of events logged for each event filter and "
+    "distinct log line, ignoring numbers (0 to disable rate limiting)");
+DEFINE_double(
+    event_rate_limit_burst,
+    5,
+    "Maximum number of events logged at once for each event filter and "
+    "distinct log line");
+DEFINE_int32(
+    event_suppressed_report_interval_s,
+    60,
+    "Interval at which to report the number of rate-limited events");
 
 using std::string;
 
+namespace {
+// Max distinct log lines rate-limited separately per event filter (others
+// share one rate limiter)
+const size_t kMaxRateLimitedLines{128};
+
+// Normalize a log line for rate limiting, replacing each run of digits (e.g.
+// timestamps, counters, IDs) with '#'
+void
+normalizeLine(folly::StringPiece line, string& normalized) {
+  normalized.clear();
+  bool inNumber = false;
+  for (char c : line) {
+    if (std::isdigit(static_cast<unsigned char>(c))) {
+      if (!inNumber) {
+        normalized.push_back('#');
+      }
+      inNumber = true;
+    } else {
+      normalized.push_back(c);
+      inNumber = false;
+    }
+  }
+}
+} // namespace
+
 namespace facebook {
 namespace terragraph {
 namespace stats {
@@ -50,56 +89,140 @@ EventParser::EventParser(
           myId_));
 
   for (const auto& sourcesIt : logTailParams_->sources) {
-    auto eventFilters = sourcesIt.second.eventFilters;
-    for (const auto& eventIt : eventFilters) {
-      auto& entry = processedEventFilters_[sourcesIt.first];
-      try {
-        entry.emplace(
-            eventIt.first,
-            ProcessedEventFilter(eventIt.second.regex, eventIt.second.level));
-      } catch (const std::regex_error& ex) {
-        LOG(ERROR) << folly::format(
-            "Ignoring malformed custom event regular expression, {}: {}",
-            eventIt.second.regex,
-            folly::exceptionStr(ex));
-      } catch (const std::out_of_range& ex) {
-        LOG(ERROR) << folly::format(
-            "Ignoring invalid custom event level, {}: {}",
-            eventIt.second.level,
-            folly::exceptionStr(ex));
-      }
+    if (!sourcesIt.second.eventFilters.empty()) {
+      processedEventFilters_.emplace(
+          sourcesIt.first, SourceEventFilters(sourcesIt.second.eventFilters));
     }
   }
+
+  if (FLAGS_event_rate_limit_per_s > 0 &&
+      FLAGS_event_suppressed_report_interval_s > 0) {
+    suppressedReportTimer_ = fbzmq::ZmqTimeout::make(
+        this, [this]() noexcept { reportSuppressedEvents(); });
+    suppressedReportTimer_->scheduleTimeout(
+        std::chrono::seconds(FLAGS_event_suppressed_report_interval_s),
+        true /* isPeriodic */);
+  }
+}
+
+EventParser::SourceEventFilters::SourceEventFilters(
+    const std::unordered_map<string, thrift::EventFilter>& eventFilters)
+    : matcher(eventFilters) {
+  rateLimiters.resize(matcher.size());
 }
 
 void
 EventParser::monitor() noexcept {
-  for (const auto& processedEventIt : processedEventFilters_) {
-    string source = processedEventIt.first;
-    auto& agent = tailAgents_.at(source);
-    agent.fetchLogLines(logsBuffer_, bufferSize_);
-
-    for (const auto& eventIt : processedEventIt.second) {
-      string eventName = eventIt.first;
-      ProcessedEventFilter eventFilter = eventIt.second;
-
-      for (const auto& line : logsBuffer_) {
-        // check if the log line matches the event regex
-        if (std::regex_search(line, eventFilter.regex)) {
-          VLOG(2) << "Matched event: " << eventName;
-
-          // log the event
-          eventClient_->logEventDynamic(
-              thrift::EventCategory::LOGTAIL,
-              thrift::EventId::LOG_BASED_EVENT,
-              eventFilter.level,
-              eventName,
-              folly::dynamic::object("source", source)("log", line));
+  for (auto& processedEventIt : processedEventFilters_) {
+    const string& source = processedEventIt.first;
+    auto agentIt = tailAgents_.find(source);
+    if (agentIt == tailAgents_.end()) {
+      continue; // log source is disabled
+    }
+
+    // Match all event filters against each new line in a single pass, without
+    // copying lines that do not match
+    auto& eventFilters = processedEventIt.second;
+    agentIt->second.fetchLogLines(
+        bufferSize_, [&](folly::StringPiece line) {
+          eventFilters.matcher.match(line, matches_);
+          for (size_t index : matches_) {
+            logEvent(source, eventFilters, index, line);
+          }
+        });
+  }
+}
+
+void
+EventParser::logEvent(
+    const string& source,
+    SourceEventFilters& eventFilters,
+    size_t index,
+    folly::StringPiece line) {
+  const auto& filter = eventFilters.matcher.getFilter(index);
+  VLOG(2) << "Matched event: " << filter.name;
+
+  if (FLAGS_event_rate_limit_per_s <= 0) {
+    sendEvent(source, eventFilters, index, line, 0);
+    return;
+  }
+
+  // Rate-limit each distinct line separately (up to a limit, after which the
+  // remaining lines share one rate limiter)
+  auto& lineRateLimiters = eventFilters.rateLimiters[index];
+  normalizeLine(line, normalizedLine_);
+  if (lineRateLimiters.size() >= kMaxRateLimitedLines &&
+      !lineRateLimiters.count(normalizedLine_)) {
+    normalizedLine_.clear();
+  }
+  auto& rateLimiter =
+      lineRateLimiters
+          .try_emplace(
+              normalizedLine_,
+              FLAGS_event_rate_limit_per_s,
+              std::max(FLAGS_event_rate_limit_burst, 1.0))
+          .first->second;
+  if (!rateLimiter.tokenBucket.consume(1.0)) {
+    if (rateLimiter.suppressedCount++ == 0) {
+      VLOG(2) << "Rate-limiting event: " << filter.name;
+    }
+    rateLimiter.lastSuppressedLine.assign(line.data(), line.size());
+    return;
+  }
+
+  sendEvent(source, eventFilters, index, line, rateLimiter.suppressedCount);
+  rateLimiter.suppressedCount = 0;
+}
+
+void
+EventParser::sendEvent(
+    const string& source,
+    const SourceEventFilters& eventFilters,
+    size_t index,
+    folly::StringPiece line,
+    uint32_t suppressedCount) {
+  const auto& filter = eventFilters.matcher.getFilter(index);
+  auto details = folly::dynamic::object("source", source)("log", line.str());
+  if (suppressedCount > 0) {
+    details["suppressed"] = suppressedCount;
+  }
+  eventClient_->logEventDynamic(
+      thrift::EventCategory::LOGTAIL,
+      thrift::EventId::LOG_BASED_EVENT,
+      filter.level,
+      filter.name,
+      details);
+}
+
+void
+EventParser::reportSuppressedEvents() {
+  for (auto& processedEventIt : processedEventFilters_) {
+    auto& eventFilters = processedEventIt.second;
+    for (size_t index = 0; index < eventFilters.rateLimiters.size(); index++) {
+      auto& lineRateLimiters = eventFilters.rateLimiters[index];
+      for (auto it = lineRateLimiters.begin(); it != lineRateLimiters.end();) {
+        auto& rateLimiter = it->second;
+        if (rateLimiter.suppressedCount > 0) {
+          // Report the last suppressed line along with the count
+          sendEvent(
+              processedEventIt.first,
+              eventFilters,
+              index,
+              rateLimiter.lastSuppressedLine,
+              rateLimiter.suppressedCount);
+          rateLimiter.suppressedCount = 0;
+          rateLimiter.lastSuppressedLine.clear();
+          ++it;
+        } else if (
+            rateLimiter.tokenBucket.available() >=
+            std::max(FLAGS_event_rate_limit_burst, 1.0)) {
+          // A full bucket is the same as a new one
+          it = lineRateLimiters.erase(it);
+        } else {
+          ++it;
         }
       }
     }
-
-    logsBuffer_.clear();
   }
 }
 
@@ -7,27 +7,32 @@
 
 #pragma once
 
+#include "EventMatcher.h"
 #include "LogTailer.h"
 
 #include <memory>
-#include <regex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include <fbzmq/async/ZmqTimeout.h>
 #include <fbzmq/zmq/Context.h>
+#include <folly/TokenBucket.h>
 
 #include "e2e/common/EventClient.h"
 #include "e2e/if/gen-cpp2/Event_types.h"
 #include "e2e/if/gen-cpp2/NodeConfig_types.h"
 
-using apache::thrift::detail::TEnumMapFactory;
-
 namespace facebook {
 namespace terragraph {
 namespace stats {
 
 /*
  * EventParser logs events that match user-defined regexes in config.
+ *
+ * Events are rate-limited per filter and distinct log line (ignoring numbers),
+ * so a log storm does not flood the event stream with identical events.
+ * Suppressed events are counted, and periodically reported.
  */
 class EventParser final : public LogTailer {
  public:
@@ -39,15 +44,30 @@ class EventParser final : public LogTailer {
       uint32_t bufferSize);
 
  private:
-  struct ProcessedEventFilter {
-    std::regex regex;
-    thrift::EventLevel level;
-
-    ProcessedEventFilter(const std::string& regex, const std::string& level) {
-      this->regex = std::regex(regex);
-      this->level = TEnumMapFactory<thrift::EventLevel>::
-          makeNamesToValuesMap().at(level.c_str());
-    }
+  // Rate limiting state for one distinct (normalized) log line of a filter
+  struct LineRateLimiter {
+    LineRateLimiter(double rate, double burst) : tokenBucket(rate, burst) {}
+
+    folly::TokenBucket tokenBucket;
+
+    // Number of events suppressed since the last event or report
+    uint32_t suppressedCount{0};
+
+    // The most recently suppressed line
+    std::string lastSuppressedLine;
+  };
+
+  // Event filters and rate limiting state for a log source
+  struct SourceEventFilters {
+    explicit SourceEventFilters(
+        const std::unordered_map<std::string, thrift::EventFilter>&
+            eventFilters);
+
+    // Matcher for all event filters of the source
+    EventMatcher matcher;
+
+    // Rate limiters for each filter in "matcher", keyed by normalized line
+    std::vector<std::unordered_map<std::string, LineRateLimiter>> rateLimiters;
   };
 
   // ZMQ ID
@@ -56,11 +76,37 @@ class EventParser final : public LogTailer {
   // Event client
   std::unique_ptr<EventClient> eventClient_;
 
-  std::unordered_map<
-      std::string /* log source */,
-      std::unordered_map<std::string /* event name */, ProcessedEventFilter>>
+  std::unordered_map<std::string /* log source */, SourceEventFilters>
       processedEventFilters_;
 
+  // Indices of the filters matching the current line
+  std::vector<size_t> matches_;
+
+  // Scratch buffer for the normalized current line
+  std::string normalizedLine_;
+
+  // Timer to report suppressed events
+  std::unique_ptr<fbzmq::ZmqTimeout> suppressedReportTimer_;
+
+  // Log the event for a matching filter, unless it is rate-limited
+  void logEvent(
+      const std::string& source,
+      SourceEventFilters& eventFilters,
+      size_t index,
+      folly::StringPiece line);
+
+  // Log an event for the given filter
+  void sendEvent(
+      const std::string& source,
+      const SourceEventFilters& eventFilters,
+      size_t index,
+      folly::StringPiece line,
+      uint32_t suppressedCount);
+
+  // Report events suppressed since the last report, and drop idle rate
+  // limiters
+  void reportSuppressedEvents();
+
   // From LogTailer
   void monitor() noexcept override;
 };
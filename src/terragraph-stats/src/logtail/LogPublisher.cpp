@@ -165,17 +165,14 @@ LogPublisher::fillSyslogBuffer() {
                          .count();
 
     uint32_t bufferCapacity = bufferSize_ - syslogsBuffer_.size();
-    agentIt.second.fetchLogLines(logsBuffer_, bufferCapacity);
-
-    for (const auto& line : logsBuffer_) {
-      thrift::AggrSyslog syslog{};
-      syslog.timestamp = timestamp++;
-      syslog.index = agentIt.first;
-      syslog.log = line;
-      syslogsBuffer_.push_back(syslog);
-    }
-
-    logsBuffer_.clear();
+    agentIt.second.fetchLogLines(
+        bufferCapacity, [&](folly::StringPiece line) {
+          thrift::AggrSyslog syslog{};
+          syslog.timestamp = timestamp++;
+          syslog.index = agentIt.first;
+          syslog.log = line.str();
+          syslogsBuffer_.push_back(std::move(syslog));
+        });
   }
 }
 
@@ -9,7 +9,10 @@
 
 #include <chrono>
 
+#include <folly/FileUtil.h>
 #include <folly/Format.h>
+#include <folly/String.h>
+#include <sys/inotify.h>
 
 using std::string;
 
@@ -17,6 +20,20 @@ namespace facebook {
 namespace terragraph {
 namespace stats {
 
+namespace {
+// inotify events which may indicate that a log file was created, rotated, or
+// removed (as opposed to just appended to)
+const uint32_t kReopenEventMask{
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO};
+
+// Returns the directory of a file, with a trailing slash (or "" if relative)
+string
+getDirPrefix(const string& filename) {
+  auto pos = filename.rfind('/');
+  return pos == string::npos ? "" : filename.substr(0, pos + 1);
+}
+} // namespace
+
 LogTailer::LogTailer(
     const string& macAddr,
     const string& configFileName,
@@ -25,8 +42,6 @@ LogTailer::LogTailer(
     uint32_t bufferSize)
     : macAddr_(macAddr), bufferSize_(bufferSize) {
 
-  logsBuffer_.reserve(bufferSize);
-
   NodeConfigWrapper nodeConfigWrapper(configFileName);
   logTailParams_ = nodeConfigWrapper.getLogTailParams();
   for (const auto& sourcesIt : logTailParams_->sources) {
@@ -41,12 +56,155 @@ LogTailer::LogTailer(
     }
   }
 
+  // Only read log files after inotify reports changes to them. Log sources
+  // which cannot be watched (e.g. if inotify is unavailable) are polled.
+  int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd < 0) {
+    PLOG(ERROR) << "Could not initialize inotify, polling log files instead";
+  } else {
+    inotifyFile_ = folly::File(inotifyFd, true /* ownsFd */);
+
+    // Drain events as they arrive so the kernel queue doesn't overflow between
+    // submissions (lines are still only read on the submission timer)
+    addSocketFd(inotifyFile_.fd(), ZMQ_POLLIN, [this](int) noexcept {
+      processFileEvents();
+    });
+  }
+  for (const auto& agentIt : tailAgents_) {
+    if (!watchLogDirectory(agentIt.second.getFilename())) {
+      unwatchedSources_.insert(agentIt.first);
+    }
+  }
+
   const bool makePeriodic = true;
-  periodicTimer_ = fbzmq::ZmqTimeout::make(this, [&]() noexcept { monitor(); });
+  periodicTimer_ = fbzmq::ZmqTimeout::make(this, [&]() noexcept {
+    pollUnwatchedSources();
+    processFileEvents();
+    monitor();
+  });
   periodicTimer_->scheduleTimeout(
       std::chrono::seconds(submissionInterval), makePeriodic);
 }
 
+LogTailer::~LogTailer() {
+  if (inotifyFile_) {
+    removeSocketFd(inotifyFile_.fd());
+  }
+
+  // The marker files are only written periodically, so save the latest
+  // positions to avoid re-reading lines after a restart
+  for (auto& agentIt : tailAgents_) {
+    agentIt.second.flushMarkerFile();
+  }
+}
+
+bool
+LogTailer::watchLogDirectory(const string& filename) {
+  if (!inotifyFile_) {
+    return false;
+  }
+
+  string prefix = getDirPrefix(filename);
+  int wd = inotify_add_watch(
+      inotifyFile_.fd(),
+      prefix.empty() ? "." : prefix.c_str(),
+      IN_MODIFY | kReopenEventMask);
+  if (wd < 0) {
+    VLOG(2) << folly::format(
+        "Could not watch directory of '{}': {}",
+        filename,
+        folly::errnoStr(errno));
+    return false;
+  }
+
+  watchedDirs_[wd] = prefix;
+  return true;
+}
+
+void
+LogTailer::pollUnwatchedSources() {
+  // The directory may not have existed yet
+  for (auto iter = unwatchedSources_.begin();
+       iter != unwatchedSources_.end();) {
+    auto agentIt = tailAgents_.find(*iter);
+    if (agentIt == tailAgents_.end()) {
+      iter = unwatchedSources_.erase(iter);
+      continue;
+    }
+    agentIt->second.notify(true /* reopen */);
+    if (watchLogDirectory(agentIt->second.getFilename())) {
+      iter = unwatchedSources_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void
+LogTailer::processFileEvents() noexcept {
+  if (!inotifyFile_) {
+    return;
+  }
+
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    ssize_t len = folly::readNoInt(inotifyFile_.fd(), buf, sizeof(buf));
+    if (len <= 0) {
+      if (len < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "Could not read inotify events";
+      }
+      break;
+    }
+
+    for (char* ptr = buf; ptr < buf + len;) {
+      const auto* event = reinterpret_cast<const struct inotify_event*>(ptr);
+      processFileEvent(*event);
+      ptr += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+
+void
+LogTailer::processFileEvent(const struct inotify_event& event) {
+  if (event.mask & IN_Q_OVERFLOW) {
+    // Events were dropped, so check everything
+    VLOG(2) << "inotify event queue overflowed";
+    for (auto& agentIt : tailAgents_) {
+      agentIt.second.notify(true /* reopen */);
+    }
+    return;
+  }
+
+  auto dirIt = watchedDirs_.find(event.wd);
+  if (dirIt == watchedDirs_.end()) {
+    return;
+  }
+
+  if (event.mask & IN_IGNORED) {
+    // The directory was removed, so fall back to polling its log files
+    for (auto& agentIt : tailAgents_) {
+      if (getDirPrefix(agentIt.second.getFilename()) == dirIt->second) {
+        agentIt.second.notify(true /* reopen */);
+        unwatchedSources_.insert(agentIt.first);
+      }
+    }
+    watchedDirs_.erase(dirIt);
+    return;
+  }
+
+  if (event.len == 0) {
+    return; // event on the directory itself
+  }
+
+  string filename = dirIt->second + event.name;
+  bool reopen = event.mask & kReopenEventMask;
+  for (auto& agentIt : tailAgents_) {
+    if (agentIt.second.getFilename() == filename) {
+      agentIt.second.notify(reopen);
+    }
+  }
+}
+
 } // namespace stats
 } // namespace terragraph
 } // namespace facebook
@@ -11,13 +11,17 @@
 
 #include <memory>
 #include <string>
-#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <fbzmq/async/ZmqTimeout.h>
+#include <folly/File.h>
 
 #include "e2e/common/NodeConfigWrapper.h"
 
+struct inotify_event;
+
 namespace facebook {
 namespace terragraph {
 namespace stats {
@@ -31,6 +35,9 @@ class LogTailer : public fbzmq::ZmqEventLoop {
       int32_t submissionInterval,
       uint32_t bufferSize);
 
+  // Write the marker file of each log source
+  virtual ~LogTailer();
+
  protected:
   std::string macAddr_;
 
@@ -40,9 +47,6 @@ class LogTailer : public fbzmq::ZmqEventLoop {
   // Log sources to tail
   std::unordered_map<std::string /* source name */, TailAgent> tailAgents_{};
 
-  // Internal buffer for unprocessed log lines
-  std::vector<std::string> logsBuffer_{};
-
   // LogTail params read from the node config wrapper
   std::shared_ptr<const thrift::LogTailParams> logTailParams_{nullptr};
 
@@ -50,6 +54,27 @@ class LogTailer : public fbzmq::ZmqEventLoop {
   // ZmqTimeout for performing periodic submission
   std::unique_ptr<fbzmq::ZmqTimeout> periodicTimer_{nullptr};
 
+  // inotify instance watching the log directories (closed if unavailable)
+  folly::File inotifyFile_;
+
+  // Path prefix (directory, with trailing slash) of each inotify watch
+  std::unordered_map<int /* watch descriptor */, std::string> watchedDirs_{};
+
+  // Log sources whose directories are not watched, which are polled instead
+  std::unordered_set<std::string> unwatchedSources_{};
+
+  // Add an inotify watch on the directory of the given log file
+  bool watchLogDirectory(const std::string& filename);
+
+  // Poll unwatched log files, and retry watching their directories
+  void pollUnwatchedSources();
+
+  // Read all queued inotify events, and notify the affected tail agents
+  void processFileEvents() noexcept;
+
+  // Notify the tail agents for a single inotify event
+  void processFileEvent(const struct inotify_event& event);
+
   virtual void monitor() noexcept = 0;
 };
 
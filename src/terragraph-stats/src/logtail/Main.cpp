@@ -8,6 +8,7 @@
 #include "EventParser.h"
 #include "LogPublisher.h"
 
+#include <fbzmq/async/StopEventLoopSignalHandler.h>
 #include <fbzmq/zmq/Context.h>
 #include <folly/init/Init.h>
 #include <folly/system/ThreadName.h>
@@ -26,6 +27,14 @@ DEFINE_uint32(buffer_size, 200, "Size of buffer holding file tail data");
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
+
+  // start signal handler before any thread
+  fbzmq::ZmqEventLoop mainEventLoop;
+  fbzmq::StopEventLoopSignalHandler handler(&mainEventLoop);
+  handler.registerSignalHandler(SIGINT);
+  handler.registerSignalHandler(SIGQUIT);
+  handler.registerSignalHandler(SIGTERM);
+
   fbzmq::Context context;
 
   // fail if we're missing the node id
@@ -60,6 +69,13 @@ main(int argc, char** argv) {
     LOG(INFO) << "EventParser thread got stopped...";
   });
 
+  LOG(INFO) << "Starting main event loop...";
+  mainEventLoop.run();
+  LOG(INFO) << "Main event loop got stopped";
+
+  // The log tailers write their marker files when destroyed
+  logPublisher.stop();
+  eventParser.stop();
   logPublisherThread.join();
   eventParserThread.join();
 
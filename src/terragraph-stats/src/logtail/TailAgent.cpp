@@ -7,6 +7,10 @@
 
 #include "TailAgent.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include <folly/ExceptionString.h>
 #include <folly/FileUtil.h>
 #include <folly/Format.h>
@@ -14,8 +18,22 @@
 #include <folly/json.h>
 #include <gflags/gflags.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-DEFINE_uint32(rotation_check_count, 10, "When to check for file rotation");
+DEFINE_uint32(
+    read_buffer_size,
+    64 * 1024,
+    "Size of the buffer used to read each log file, in bytes");
+DEFINE_int32(
+    marker_write_interval_s,
+    30,
+    "Minimum interval between marker file writes for each log file, unless "
+    "more than marker_write_bytes were read");
+DEFINE_uint32(
+    marker_write_bytes,
+    256 * 1024,
+    "Number of bytes read from a log file after which its marker file is "
+    "written, regardless of marker_write_interval_s");
 
 using std::string;
 
@@ -24,70 +42,184 @@ namespace terragraph {
 namespace stats {
 
 TailAgent::TailAgent(const string& filename, const string& markerSuffix)
-    : filename_(filename),
-      staleCount_(0),
-      markerPosition_(0),
-      markerFilename_(filename + markerSuffix),
-      markerInode_(0) {}
+    : filename_(filename), markerFilename_(filename + markerSuffix) {}
 
 void
-TailAgent::fetchLogLines(std::vector<string>& logsBuffer, uint32_t logCount) {
-  VLOG(4) << folly::format(
-      "Processing '{}', staleCount: {}", filename_, staleCount_);
-
-  if (staleCount_ <= 0) {
-    struct stat currentStat;
-    staleCount_ = FLAGS_rotation_check_count;
-
-    // Open file and get file stat
-    if (fileIfs_.is_open()) {
-      VLOG(4) << "File was not updated for a while. Closing file ...";
-      fileIfs_.close();
+TailAgent::notify(bool reopen) {
+  pending_ = true;
+  if (reopen) {
+    checkFile_ = true;
+  }
+}
+
+uint32_t
+TailAgent::fetchLogLines(
+    uint32_t logCount,
+    const std::function<void(folly::StringPiece line)>& onLine) {
+  uint32_t count = 0;
+  if (pending_) {
+    VLOG(4) << folly::format("Processing '{}'", filename_);
+
+    if (checkFile_) {
+      checkFile_ = false;
+      checkFile();
+    }
+
+    while (count < logCount) {
+      // Pass all complete lines in the buffer
+      while (count < logCount && bufferStart_ < bufferEnd_) {
+        const char* begin = buffer_.data() + bufferStart_;
+        const char* end = static_cast<const char*>(
+            memchr(begin, '\n', bufferEnd_ - bufferStart_));
+        if (end == nullptr) {
+          if (bufferStart_ > 0 || bufferEnd_ < buffer_.size()) {
+            break; // partial line, wait for more data
+          }
+          // The line does not fit in the buffer, so split it
+          end = buffer_.data() + bufferEnd_;
+        }
+
+        folly::StringPiece line(begin, end);
+        bufferStart_ =
+            std::min<size_t>(end - buffer_.data() + 1, bufferEnd_);
+        if (!line.empty()) {
+          onLine(line);
+          count++;
+        }
+      }
+
+      if (count >= logCount || !readMore()) {
+        break;
+      }
     }
 
-    if (stat(filename_.c_str(), &currentStat) != 0) {
-      // File does not exist
-      VLOG(4) << folly::format("File '{}' does not exist", filename_);
-      return;
+    if (file_) {
+      markerInode_ = inode_;
+      markerPosition_ = readOffset_ - (off_t)(bufferEnd_ - bufferStart_);
     }
+  }
 
-    VLOG(4) << folly::format("Opening file '{}'", filename_);
-    fileIfs_.open(filename_);
+  maybeWriteMarkerFile();
+  return count;
+}
 
-    if (readMarkerFile() && markerInode_ == currentStat.st_ino) {
-      // Same File. Seek to marker position
-      fileIfs_.seekg(markerPosition_);
-      VLOG(4) << "Opened same file as tracked >> seek to " << markerPosition_;
-    } else {
-      // Different file, or never tracked
-      VLOG(4) << folly::format(
-          "Opened different file than tracked. Inode (Tracked, New) ({}, {})",
-          markerInode_,
-          currentStat.st_ino);
-      markerInode_ = currentStat.st_ino;
-      markerPosition_ = 0;
+void
+TailAgent::checkFile() {
+  struct stat currentStat;
+  if (stat(filename_.c_str(), &currentStat) != 0) {
+    // File does not exist (keep reading the open file, if it was rotated)
+    VLOG(4) << folly::format("File '{}' does not exist", filename_);
+    return;
+  }
+
+  if (!file_) {
+    openFile(true /* resume */);
+  } else if (currentStat.st_ino != inode_) {
+    // Finish reading the old file before switching to the new one
+    VLOG(4) << folly::format(
+        "File '{}' was rotated. Inode (Open, New) ({}, {})",
+        filename_,
+        inode_,
+        currentStat.st_ino);
+    rotated_ = true;
+  } else if (currentStat.st_size < readOffset_) {
+    // File was truncated in place, so start over
+    LOG(INFO) << folly::format("File '{}' was truncated", filename_);
+    if (lseek(file_.fd(), 0, SEEK_SET) == 0) {
+      readOffset_ = 0;
+      bufferStart_ = bufferEnd_ = 0;
     }
   }
+}
 
-  string line;
-  while (logsBuffer.size() < logCount) {
-    auto line = getNextLine();
+bool
+TailAgent::openFile(bool resume) {
+  VLOG(4) << folly::format("Opening file '{}'", filename_);
+  try {
+    file_ = folly::File(filename_);
+  } catch (const std::system_error& ex) {
+    LOG(ERROR) << folly::format(
+        "Could not open file '{}': {}", filename_, folly::exceptionStr(ex));
+    return false;
+  }
 
-    if (line.length() > 0) {
-      // update pos
-      markerPosition_ = fileIfs_.tellg();
+  struct stat currentStat;
+  if (fstat(file_.fd(), &currentStat) != 0) {
+    PLOG(ERROR) << folly::format("Could not stat file '{}'", filename_);
+    file_.close();
+    return false;
+  }
 
-      logsBuffer.push_back(line);
+  inode_ = currentStat.st_ino;
+  readOffset_ = 0;
+  bufferStart_ = bufferEnd_ = 0;
+  rotated_ = false;
+  buffer_.resize(std::max<uint32_t>(FLAGS_read_buffer_size, 1));
 
-      // reset stale counter
-      staleCount_ = FLAGS_rotation_check_count;
-    } else {
-      staleCount_--;
-      break;
-    }
+  if (resume && readMarkerFile() && markerInode_ == inode_ &&
+      markerPosition_ <= currentStat.st_size &&
+      lseek(file_.fd(), markerPosition_, SEEK_SET) == markerPosition_) {
+    // Same File. Seek to marker position
+    readOffset_ = markerPosition_;
+    VLOG(4) << "Opened same file as tracked >> seek to " << markerPosition_;
+  } else {
+    // Different file, or never tracked
+    VLOG(4) << folly::format(
+        "Opened different file than tracked. Inode (Tracked, New) ({}, {})",
+        markerInode_,
+        inode_);
   }
+  return true;
+}
 
-  writeMarkerFile();
+bool
+TailAgent::readMore() {
+  if (!file_) {
+    pending_ = false;
+    return false;
+  }
+
+  // Move any partial line to the front of the buffer
+  if (bufferStart_ > 0) {
+    memmove(
+        buffer_.data(),
+        buffer_.data() + bufferStart_,
+        bufferEnd_ - bufferStart_);
+    bufferEnd_ -= bufferStart_;
+    bufferStart_ = 0;
+  }
+  if (bufferEnd_ == buffer_.size()) {
+    return false;
+  }
+
+  ssize_t bytesRead = folly::readNoInt(
+      file_.fd(), buffer_.data() + bufferEnd_, buffer_.size() - bufferEnd_);
+  if (bytesRead > 0) {
+    bufferEnd_ += bytesRead;
+    readOffset_ += bytesRead;
+    return true;
+  }
+  if (bytesRead < 0) {
+    PLOG(ERROR) << folly::format("Could not read file '{}'", filename_);
+    pending_ = false;
+    return false;
+  }
+
+  // End of file
+  if (!rotated_) {
+    pending_ = false;
+    return false;
+  }
+  if (bufferEnd_ > bufferStart_) {
+    // Terminate the last line of the old file
+    buffer_[bufferEnd_++] = '\n';
+    return true;
+  }
+  if (!openFile(false /* resume */)) {
+    pending_ = false;
+    return false;
+  }
+  return true;
 }
 
 bool
@@ -112,6 +244,8 @@ TailAgent::readMarkerFile() {
     if (markerFileData.count("inode") && markerFileData.count("position")) {
       markerInode_ = markerFileData.at("inode").getInt();
       markerPosition_ = markerFileData.at("position").getInt();
+      writtenMarkerInode_ = markerInode_;
+      writtenMarkerPosition_ = markerPosition_;
     } else {
       return false;
     }
@@ -134,18 +268,40 @@ TailAgent::writeMarkerFile() {
   return true;
 }
 
-string
-TailAgent::getNextLine() {
-  string line;
+void
+TailAgent::maybeWriteMarkerFile() {
+  if (markerInode_ == writtenMarkerInode_ &&
+      markerPosition_ == writtenMarkerPosition_) {
+    return; // no change
+  }
 
-  if (fileIfs_.is_open()) {
-    std::getline(fileIfs_, line);
-    if (fileIfs_.eof()) {
-      fileIfs_.clear();
-    }
+  // Avoid wearing out flash by rewriting the marker on every fetch, at the
+  // cost of re-reading some lines after a restart
+  auto now = std::chrono::steady_clock::now();
+  off_t bytes = markerInode_ == writtenMarkerInode_
+                    ? std::abs(markerPosition_ - writtenMarkerPosition_)
+                    : markerPosition_;
+  if ((uint64_t)bytes < FLAGS_marker_write_bytes &&
+      now - writtenMarkerTime_ <
+          std::chrono::seconds(FLAGS_marker_write_interval_s)) {
+    return;
   }
 
-  return line;
+  flushMarkerFile();
+}
+
+void
+TailAgent::flushMarkerFile() {
+  if (markerInode_ == writtenMarkerInode_ &&
+      markerPosition_ == writtenMarkerPosition_) {
+    return; // no change
+  }
+
+  writtenMarkerTime_ = std::chrono::steady_clock::now();
+  if (writeMarkerFile()) {
+    writtenMarkerInode_ = markerInode_;
+    writtenMarkerPosition_ = markerPosition_;
+  }
 }
 
 } // namespace stats
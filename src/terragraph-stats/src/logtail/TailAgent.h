@@ -7,12 +7,14 @@
 
 #pragma once
 
-#include <fstream>
+#include <chrono>
+#include <functional>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
-#include "e2e/if/gen-cpp2/NodeConfig_types.h"
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <sys/types.h>
 
 namespace facebook {
 namespace terragraph {
@@ -22,38 +24,95 @@ class TailAgent {
  public:
   TailAgent(const std::string& filename, const std::string& markerSuffix);
 
-  // Fill "logsBuffer" with up to "logCount" lines
-  void fetchLogLines(std::vector<std::string>& logsBuffer, uint32_t logCount);
+  // Call "onLine" for up to "logCount" new (non-empty) lines, and return the
+  // number of lines read.
+  //
+  // Lines point into an internal read buffer, and are only valid until
+  // "onLine" returns. Does nothing unless notify() was called since the file
+  // was last read to the end.
+  uint32_t fetchLogLines(
+      uint32_t logCount,
+      const std::function<void(folly::StringPiece line)>& onLine);
+
+  // Note that the log file may have changed. If "reopen" is set, the file may
+  // also have been created, rotated, or truncated, so check it by inode before
+  // reading.
+  void notify(bool reopen);
+
+  // Write the marker file now if the position has changed, regardless of the
+  // write budget (e.g. on shutdown)
+  void flushMarkerFile();
+
+  // Path + file name of the log source
+  const std::string&
+  getFilename() const {
+    return filename_;
+  }
 
  private:
   // Path + file name of the log source
   std::string filename_;
 
-  // File stream for reading from the log file
-  std::ifstream fileIfs_;
+  // The open log file (if any)
+  folly::File file_;
 
-  // The number of log files that the thread is behind on analyzing
-  int staleCount_;
+  // The serial number of the open log file
+  ino_t inode_{0};
 
-  // Line number for how far we have read into the file belonging to
-  // markerInode_
-  int32_t markerPosition_;
+  // Byte offset in the open log file up to which data was read into buffer_
+  off_t readOffset_{0};
+
+  // Read buffer, with unconsumed data in the range [bufferStart_, bufferEnd_)
+  std::vector<char> buffer_;
+  size_t bufferStart_{0};
+  size_t bufferEnd_{0};
+
+  // Whether the file may have new data to read
+  bool pending_{true};
+
+  // Whether the file should be checked for rotation/truncation before reading
+  bool checkFile_{true};
+
+  // Whether the file path now refers to a different file than the one open
+  // (i.e. the old file should be read to the end, then the new file opened)
+  bool rotated_{false};
 
   // Preset string to save the log file inode and position in case connection is
   // interrupted or the thread crashes
   std::string markerFilename_;
 
   // The serial number of the most recently accessed log file
-  ino_t markerInode_;
+  ino_t markerInode_{0};
+
+  // Byte offset of how far we have read into the file belonging to
+  // markerInode_
+  off_t markerPosition_{0};
+
+  // The inode and position last written to markerFilename_, and when
+  ino_t writtenMarkerInode_{0};
+  off_t writtenMarkerPosition_{0};
+  std::chrono::steady_clock::time_point writtenMarkerTime_{};
+
+  // Stat the log file, and open, reopen, or rewind it as needed
+  void checkFile();
+
+  // Open the log file, resuming from the marker position if "resume" is set
+  // and the marker refers to the same file
+  bool openFile(bool resume);
+
+  // Read more data from the open file into buffer_, opening the new file if it
+  // was rotated. Returns false if there is no more data to read.
+  bool readMore();
 
-  // Read the inode and position (line number) of the most recent log file
+  // Read the inode and position (byte offset) of the most recent log file
   bool readMarkerFile();
 
   // Update the inode and position in markerFilename_
   bool writeMarkerFile();
 
-  // Read the next line from the file stream
-  std::string getNextLine();
+  // Update markerFilename_ if the position has changed and the write budget
+  // (time or bytes since the last write) was exceeded
+  void maybeWriteMarkerFile();
 };
 
 } // namespace stats
@@ -5,8 +5,11 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <ctime>
+
 #include <glog/logging.h>
-#include "StatCache.h"
+#include "RadioTable.h"
 
 extern "C" {
 #include <net-snmp/net-snmp-config.h>
@@ -14,10 +17,12 @@ extern "C" {
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 }
 
-#include "Access.h"
 #include "Agent.h"
 
+using facebook::terragraph::RadioRow;
+using facebook::terragraph::RadioTableSnapshot;
 using facebook::terragraph::SnmpColumn;
+using facebook::terragraph::StatCache;
 
 namespace {
   // base OID to use for registration with net-snmp
@@ -26,17 +31,19 @@ namespace {
   // 15000 is randomly chosen not to conflict we existing MIB OIDs, but is not
   // registered
   const oid kBaseOid[] = {1, 3, 6, 1, 4, 1, 15000, 1, 1, 1};
+
+  // first and last accessible columns
+  const int kMinColumn{SnmpColumn::IF_NAME};
+  const int kMaxColumn{SnmpColumn::RSSI};
 }
 
 void
 initAgent() {
   netsnmp_table_registration_info* tableInfo;
   netsnmp_handler_registration* handlerRegistration;
-  netsnmp_iterator_info* iteratorInfo;
 
   // create the table registration information structures
   tableInfo = SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
-  iteratorInfo = SNMP_MALLOC_TYPEDEF(netsnmp_iterator_info);
 
   handlerRegistration = netsnmp_create_handler_registration(
       "tgRadioInterfacesTable",
@@ -45,7 +52,7 @@ initAgent() {
       OID_LENGTH(kBaseOid),
       HANDLER_CAN_RONLY);
 
-  if (!handlerRegistration || !tableInfo || !iteratorInfo) {
+  if (!handlerRegistration || !tableInfo) {
     snmp_log(LOG_ERR, "malloc failed in initAgent");
     return;
   }
@@ -56,23 +63,13 @@ initAgent() {
   // minimum and maximum accessible columns
   // the index is 1, so the first real column is 2
   // the max column must be the highest enum value in SnmpColumn
-  tableInfo->min_column = 2;
-  tableInfo->max_column = 7;
-
-  // iterator access routines
-  iteratorInfo->get_first_data_point = getFirstDataPoint;
-  iteratorInfo->get_next_data_point = getNextDataPoint;
-
-  iteratorInfo->make_data_context = convertContext;
-  iteratorInfo->free_data_context = dataFree;
-
-  // free data at the end of each 'loop' which is a single snmp request
-  iteratorInfo->free_loop_context_at_end = loopFree;
-
-  iteratorInfo->table_reginfo = tableInfo;
+  tableInfo->min_column = kMinColumn;
+  tableInfo->max_column = kMaxColumn;
 
   // register the table with the master net-snmp agent
-  netsnmp_register_table_iterator2(handlerRegistration, iteratorInfo);
+  // rows are looked up directly by index (instead of through a table
+  // iterator, which walks all rows for every request)
+  netsnmp_register_table(handlerRegistration, tableInfo);
 }
 
 void
@@ -91,6 +88,38 @@ setULongValue(netsnmp_variable_list* var, const u_long& value) {
   snmp_set_var_typed_value(var, ASN_GAUGE, &value, sizeof(u_long));
 }
 
+bool
+setColumnValue(netsnmp_variable_list* var, int column, const RadioRow& row) {
+  switch (column) {
+    case SnmpColumn::IF_NAME:
+      setStringValue(var, row.ifName);
+      return true;
+
+    case SnmpColumn::MAC_ADDR:
+      setStringValue(var, row.macAddr);
+      return true;
+
+    case SnmpColumn::REMOTE_MAC_ADDR:
+      setStringValue(var, row.remoteMacAddr);
+      return true;
+
+    case SnmpColumn::MCS:
+      setULongValue(var, row.radioStat.mcs);
+      return true;
+
+    case SnmpColumn::SNR:
+      setLongValue(var, row.radioStat.snr);
+      return true;
+
+    case SnmpColumn::RSSI:
+      setLongValue(var, row.radioStat.rssi);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 int
 requestHandler(
     netsnmp_mib_handler* mibHandler,
@@ -98,82 +127,72 @@ requestHandler(
     netsnmp_agent_request_info* agentRequestInfo,
     netsnmp_request_info* requests) {
   (void)mibHandler;
-  (void)handlerRegistration;
-
-  netsnmp_request_info* requestInfo;
-  netsnmp_table_request_info* tableInfo;
-  netsnmp_variable_list* var;
-
-  void* dataContext = NULL;
-
-  for (requestInfo = requests; requestInfo; requestInfo = requestInfo->next) {
-    var = requestInfo->requestvb;
-    if (requestInfo->processed != 0) {
-      continue;
-    }
-
-    switch (agentRequestInfo->mode) {
-      case MODE_GET: // 160
-        dataContext = netsnmp_extract_iterator_context(requestInfo);
-        if (dataContext == NULL) {
-          netsnmp_set_request_error(
-              agentRequestInfo, requestInfo, SNMP_NOSUCHINSTANCE);
-          continue;
-        }
-        break;
-      default:
-        LOG(ERROR) << "Unmatched request mode: " << agentRequestInfo->mode;
-    }
-
-    tableInfo = netsnmp_extract_table_info(requestInfo);
-
-    if (tableInfo == NULL) {
-      continue;
-    }
-
-    MibData* dataInfo = (MibData*)dataContext;
-    switch (agentRequestInfo->mode) {
-      case MODE_GET:
-        switch (tableInfo->colnum) {
-          case SnmpColumn::IF_NAME:
-            setStringValue(var, dataInfo->ifName);
-            break;
-
-          case SnmpColumn::MAC_ADDR:
-            setStringValue(var, dataInfo->macAddr);
-            break;
-
-          case SnmpColumn::REMOTE_MAC_ADDR:
-            setStringValue(var, dataInfo->remoteMacAddr);
-            break;
-
-          case SnmpColumn::MCS:
-            setULongValue(var, dataInfo->radioStat.mcs);
-            break;
-
-          case SnmpColumn::SNR:
-            setLongValue(var, dataInfo->radioStat.snr);
-            break;
-
-          case SnmpColumn::RSSI:
-            setLongValue(var, dataInfo->radioStat.rssi);
-            break;
-
-          default:
-            snmp_log(
-                LOG_ERR,
-                "problem encountered in requestHandler: "
-                "unknown column\n");
+
+  std::time_t now = std::time(nullptr);
+  StatCache::getRadioTableInstance()->withSnapshot(
+      [&](const RadioTableSnapshot& snapshot) {
+        for (netsnmp_request_info* requestInfo = requests; requestInfo;
+             requestInfo = requestInfo->next) {
+          if (requestInfo->processed != 0) {
+            continue;
+          }
+
+          netsnmp_table_request_info* tableInfo =
+              netsnmp_extract_table_info(requestInfo);
+          if (tableInfo == NULL) {
+            continue;
+          }
+
+          switch (agentRequestInfo->mode) {
+            case MODE_GET: { // 160
+              const RadioRow* row = nullptr;
+              if (tableInfo->number_indexes > 0 &&
+                  tableInfo->indexes->val.integer) {
+                row = snapshot.find(*tableInfo->indexes->val.integer, now);
+              }
+              if (row == nullptr ||
+                  !setColumnValue(
+                      requestInfo->requestvb, tableInfo->colnum, *row)) {
+                netsnmp_set_request_error(
+                    agentRequestInfo, requestInfo, SNMP_NOSUCHINSTANCE);
+              }
+              break;
+            }
+
+            case MODE_GETNEXT: { // 161
+              // walk the table in column-major order (as in an SNMP walk)
+              int column = std::max((int)tableInfo->colnum, kMinColumn);
+              long index = 0;
+              if (tableInfo->number_indexes > 0 &&
+                  tableInfo->indexes->val.integer) {
+                index = *tableInfo->indexes->val.integer;
+              }
+              const RadioRow* row = snapshot.findNext(index, now);
+              while (row == nullptr && ++column <= kMaxColumn) {
+                row = snapshot.findNext(0, now);
+              }
+              if (row == nullptr) {
+                // past the end of the table, leave the request unanswered so
+                // that net-snmp moves on to the next subtree
+                break;
+              }
+              tableInfo->colnum = column;
+              snmp_set_var_value(
+                  tableInfo->indexes, (void*)&row->index, sizeof(long));
+              netsnmp_table_build_oid(
+                  handlerRegistration, requestInfo, tableInfo);
+              setColumnValue(requestInfo->requestvb, column, *row);
+              break;
+            }
+
+            default:
+              snmp_log(
+                  LOG_ERR,
+                  "problem encountered in requestHandler: "
+                  "unsupported mode\n");
+          }
         }
-        break;
-
-      default:
-        snmp_log(
-            LOG_ERR,
-            "problem encountered in requestHandler: "
-            "unsupported mode\n");
-    }
-  }
+      });
 
   return SNMP_ERR_NOERROR;
 }
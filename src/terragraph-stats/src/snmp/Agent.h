@@ -7,7 +7,11 @@
 
 #pragma once
 
-#include "Access.h"
+namespace facebook {
+namespace terragraph {
+struct RadioRow;
+} // namespace terragraph
+} // namespace facebook
 
 /**
  * Initialize the MIB by registering our OID with the net-snmp library.
@@ -17,10 +21,21 @@ void initAgent();
 /**
  * Handler function for processing net-snmp request.
  *
- * This supports read-only operations (GET/GETNEXT/GETBULK requests)
+ * This supports read-only operations (GET/GETNEXT/GETBULK requests), which
+ * are answered from the current RadioTable snapshot.
  */
 Netsnmp_Node_Handler requestHandler;
 
+/**
+ * Set the value of a table column from a row into netsnmp_variable_list.
+ *
+ * Returns false for an unknown column.
+ */
+bool setColumnValue(
+    netsnmp_variable_list* var,
+    int column,
+    const facebook::terragraph::RadioRow& row);
+
 /**
  * Set ASN_OCTET_STR value into netsnmp_variable_list.
  */
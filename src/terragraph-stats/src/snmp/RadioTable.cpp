@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RadioTable.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace facebook {
+namespace terragraph {
+
+namespace {
+// max allowed age of node statistics before dropping the data
+const int kStatsMaxAgeSeconds{5};
+} // namespace
+
+RadioTableSnapshot::RadioTableSnapshot(std::vector<RadioRow> rows)
+    : rows_(std::move(rows)) {
+  std::sort(
+      rows_.begin(), rows_.end(), [](const RadioRow& a, const RadioRow& b) {
+        return a.index < b.index;
+      });
+}
+
+bool
+RadioTableSnapshot::isOutdated(const RadioRow& row, std::time_t now) {
+  return row.radioStat.lastUpdated < now - kStatsMaxAgeSeconds;
+}
+
+const RadioRow*
+RadioTableSnapshot::find(long index, std::time_t now) const {
+  auto it = std::lower_bound(
+      rows_.begin(), rows_.end(), index, [](const RadioRow& row, long i) {
+        return row.index < i;
+      });
+  if (it == rows_.end() || it->index != index || isOutdated(*it, now)) {
+    return nullptr;
+  }
+  return &(*it);
+}
+
+const RadioRow*
+RadioTableSnapshot::findNext(long index, std::time_t now) const {
+  auto it = std::upper_bound(
+      rows_.begin(), rows_.end(), index, [](long i, const RadioRow& row) {
+        return i < row.index;
+      });
+  for (; it != rows_.end(); ++it) {
+    if (!isOutdated(*it, now)) {
+      return &(*it);
+    }
+    VLOG(2) << "Skipping outdated metrics from: " << it->ifName;
+  }
+  return nullptr;
+}
+
+RadioTable::RadioTable()
+    : snapshot_(new RadioTableSnapshot(std::vector<RadioRow>())) {}
+
+RadioTable::~RadioTable() {
+  snapshot_.load()->retire();
+}
+
+void
+RadioTable::update(const StatCacheMap& radioStats) {
+  std::vector<RadioRow> rows;
+  for (const auto& localMacMap : radioStats) {
+    for (const auto& remoteMacMap : localMacMap.second) {
+      auto indexIt = indexes_.emplace(
+          std::make_pair(localMacMap.first, remoteMacMap.first), nextIndex_);
+      if (indexIt.second) {
+        nextIndex_++;
+      }
+
+      RadioRow row;
+      row.index = indexIt.first->second;
+      row.ifName = remoteMacMap.second.ifName;
+      row.macAddr = localMacMap.first;
+      row.remoteMacAddr = remoteMacMap.first;
+      row.radioStat = remoteMacMap.second;
+      rows.push_back(std::move(row));
+    }
+  }
+
+  auto snapshot = new RadioTableSnapshot(std::move(rows));
+  snapshot_.exchange(snapshot, std::memory_order_acq_rel)->retire();
+}
+
+} // namespace terragraph
+} // namespace facebook
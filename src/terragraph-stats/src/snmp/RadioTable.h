@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "StatCache.h"
+
+#include <atomic>
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/synchronization/Hazptr.h>
+
+namespace facebook {
+namespace terragraph {
+
+/**
+ * A row of tgRadioInterfacesTable.
+ */
+struct RadioRow {
+  // table index (ifIndex), stable for the lifetime of the agent
+  long index;
+  std::string ifName;
+  std::string macAddr;
+  std::string remoteMacAddr;
+  RadioStat radioStat;
+};
+
+/**
+ * An immutable snapshot of tgRadioInterfacesTable, sorted by index.
+ *
+ * Rows whose stats are outdated at lookup time are skipped, so a snapshot only
+ * needs to be rebuilt when stats change.
+ */
+class RadioTableSnapshot
+    : public folly::hazptr_obj_base<RadioTableSnapshot> {
+ public:
+  explicit RadioTableSnapshot(std::vector<RadioRow> rows);
+
+  /**
+   * Return the row with the given index, or nullptr if there is no such row or
+   * its stats are outdated.
+   */
+  const RadioRow* find(long index, std::time_t now) const;
+
+  /**
+   * Return the first row with an index greater than the given index and with
+   * current stats, or nullptr if there is none.
+   */
+  const RadioRow* findNext(long index, std::time_t now) const;
+
+  /**
+   * Return all rows, including outdated ones.
+   */
+  const std::vector<RadioRow>&
+  getRows() const {
+    return rows_;
+  }
+
+ private:
+  // Return whether the row's stats are outdated
+  static bool isOutdated(const RadioRow& row, std::time_t now);
+
+  std::vector<RadioRow> rows_;
+};
+
+/**
+ * Holder of the current tgRadioInterfacesTable snapshot.
+ *
+ * StatsSubscriber builds a new snapshot whenever it receives new stats, and
+ * swaps it in atomically. SNMP requests read the current snapshot without
+ * locking, protecting it with a hazard pointer. A replaced snapshot is freed
+ * once no request is still reading it.
+ */
+class RadioTable {
+ public:
+  RadioTable();
+  ~RadioTable();
+
+  RadioTable(const RadioTable&) = delete;
+  RadioTable& operator=(const RadioTable&) = delete;
+
+  /**
+   * Build and publish a new snapshot from the given radio stats.
+   *
+   * This must only be called from a single (writer) thread.
+   */
+  void update(const StatCacheMap& radioStats);
+
+  /**
+   * Invoke the function with the current snapshot, which stays valid until
+   * the function returns.
+   */
+  template <typename F>
+  auto
+  withSnapshot(F&& f) const {
+    folly::hazptr_holder<> holder = folly::make_hazard_pointer();
+    const RadioTableSnapshot* snapshot = holder.protect(snapshot_);
+    return f(*snapshot);
+  }
+
+ private:
+  // The current snapshot (never null)
+  std::atomic<RadioTableSnapshot*> snapshot_;
+
+  // Index assigned to each (local mac, remote mac) pair
+  std::map<std::pair<std::string, std::string>, long> indexes_;
+
+  // Next index to assign
+  long nextIndex_{1};
+};
+
+} // namespace terragraph
+} // namespace facebook
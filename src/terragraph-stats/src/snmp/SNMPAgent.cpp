@@ -23,7 +23,6 @@ extern "C" {
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 }
 
-#include "Access.h"
 #include "Agent.h"
 
 using namespace facebook::terragraph;
@@ -6,6 +6,7 @@
  */
 
 #include "StatCache.h"
+#include "RadioTable.h"
 
 #include <folly/Format.h>
 #include <glog/logging.h>
@@ -15,6 +16,7 @@ namespace terragraph {
 
 static folly::Singleton<folly::Synchronized<StatCacheMap>> statCache_;
 static folly::Singleton<folly::Synchronized<KeyNameCacheMap>> keyNameCache_;
+static folly::Singleton<RadioTable> radioTable_;
 
 std::shared_ptr<folly::Synchronized<StatCacheMap>>
 StatCache::getRadioStatsInstance() {
@@ -26,6 +28,11 @@ StatCache::getKeyNameCacheInstance() {
   return keyNameCache_.try_get();
 }
 
+std::shared_ptr<RadioTable>
+StatCache::getRadioTableInstance() {
+  return radioTable_.try_get();
+}
+
 std::unordered_map<std::string /* raw metric name */, LinkMetric>
 StatCache::generateLinkKeys(
     const std::vector<StatFormat>& statsFormat,
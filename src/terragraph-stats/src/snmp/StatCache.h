@@ -100,6 +100,8 @@ using StatCacheMap = std::unordered_map<
 using KeyNameCacheMap =
     std::unordered_map<std::string /* raw metric name */, LinkMetric>;
 
+class RadioTable;
+
 /**
  * Holder for statistic mappings for fast lookups.
  */
@@ -123,6 +125,13 @@ class StatCache {
   static std::shared_ptr<folly::Synchronized<KeyNameCacheMap>>
   getKeyNameCacheInstance();
 
+  /**
+   * Returns the RadioTable.
+   *
+   * Holds the tgRadioInterfacesTable snapshot served to SNMP requests.
+   */
+  static std::shared_ptr<RadioTable> getRadioTableInstance();
+
   /**
    * Generate mapping of raw key names coming from driver-if to LinkMetric.
    *
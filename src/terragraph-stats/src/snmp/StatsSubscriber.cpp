@@ -6,6 +6,7 @@
  */
 
 #include "StatsSubscriber.h"
+#include "RadioTable.h"
 #include "StatCache.h"
 
 #include "stats/common/StatInfo.h"
@@ -82,6 +83,7 @@ void
 StatsSubscriber::processCountersMessage(
     fbzmq::thrift::CounterValuesResponse& counters) {
   auto keyCache = StatCache::getKeyNameCacheInstance()->rlock();
+  bool changed = false;
   for (const auto& kv : counters.counters_ref().value()) {
     // parse key string into key + baseband entity
     const stats::StatInfo info(kv.first);
@@ -95,6 +97,7 @@ StatsSubscriber::processCountersMessage(
       auto linkMetric = keyIt->second;
       VLOG(2) << "Adding cache for: " << info.key << " = "
               << kv.second.value_ref().value();
+      changed = true;
       auto radioStats = StatCache::getRadioStatsInstance()->wlock();
       auto& radioStat =
           (*radioStats)[linkMetric.localMac][linkMetric.remoteMac];
@@ -117,6 +120,12 @@ StatsSubscriber::processCountersMessage(
       }
     }
   }
+
+  // publish a new table snapshot for SNMP requests
+  if (changed) {
+    StatCache::getRadioTableInstance()->update(
+        *StatCache::getRadioStatsInstance()->rlock());
+  }
 }
 
 } // namespace terragraph
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare matching log lines against a catalog of log-based event filters
+// using one std::regex per filter (the old EventParser) against EventMatcher.
+//
+// Lines are read from a recorded log storm (--log_file), e.g. a kernel or
+// firmware log captured from a node, or generated if no file is given.
+
+#include <regex>
+
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../logtail/EventMatcher.h"
+
+DEFINE_string(log_file, "", "Recorded log file to match (generated if empty)");
+DEFINE_int32(num_lines, 100000, "Number of log lines to generate");
+
+using namespace facebook::terragraph;
+using namespace facebook::terragraph::stats;
+
+namespace {
+// Log-based event filters across kernel, firmware, Open/R, and VPP logs
+const std::unordered_map<std::string, std::pair<std::string, std::string>>
+    kFilters = {
+        {"FW_ERROR", {"ERROR!!!", "ERROR"}},
+        {"rf_read_timedout", {"eth0: rf read timedout", "ERROR"}},
+        {"fw_assert", {"FW ASSERT: .*line [0-9]+", "ERROR"}},
+        {"fw_watchdog", {"wdt: firmware watchdog (timeout|reset)", "FATAL"}},
+        {"kernel_oops", {"Oops|BUG: |Kernel panic", "FATAL"}},
+        {"oom_killer", {"invoked oom-killer", "ERROR"}},
+        {"soft_lockup", {"soft lockup - CPU#[0-9]+ stuck", "ERROR"}},
+        {"nss_error", {"nss.*: (tx|rx) queue [0-9]+ stalled", "WARNING"}},
+        {"openr_adj_down", {"Neighbor .* is DOWN", "WARNING"}},
+        {"openr_kvstore_full", {"KvStore: .*too many keys", "ERROR"}},
+        {"openr_spark_error", {"Spark: failed to send hello", "WARNING"}},
+        {"vpp_buffer_alloc", {"vlib_buffer_alloc.*failed", "ERROR"}},
+        {"vpp_dpdk_error", {"dpdk: .*(link down|rx_missed)", "WARNING"}},
+        {"vpp_api_timeout", {"vapi: .*timed out", "WARNING"}},
+        {"gps_unlocked", {"GPS: lost (fix|sync)", "WARNING"}},
+        {"sfp_removed", {"sfp[0-9]: module removed", "INFO"}},
+};
+
+// Typical log lines during a log storm (mostly lines matching no filter)
+const std::vector<std::string> kLines = {
+    "kernel: [12345.678901] terragraph: wlan0: rx mgmt frame len 128",
+    "kernel: [12345.678902] nss-dp: tx queue 3 stalled, resetting",
+    "fw_trace: [1234567] bf: rx beam 12 tx beam 34 snr 15.5 rssi -55",
+    "fw_trace: [1234568] la: mcs 9 per 1e-3 txPower 21",
+    "openr[1234]: Spark: received hello from 00:00:00:10:0d:40",
+    "openr[1234]: Decision: route computation took 12ms",
+    "openr[1234]: Neighbor node-00.00.00.10.0d.40 is DOWN",
+    "vpp[567]: dpdk: TenGigabitEthernet0: rx_missed 42",
+    "vpp[567]: tg-link-input: dropped 3 packets",
+    "e2e_minion[890]: StatusApp: sent status report",
+    "kernel: [12345.678903] eth0: rf read timedout",
+    "fw_trace: [1234569] ERROR!!! tx fifo overflow",
+};
+
+const std::vector<std::string>&
+getLines() {
+  static const std::vector<std::string> lines = [] {
+    std::vector<std::string> l;
+    if (!FLAGS_log_file.empty()) {
+      std::string contents;
+      CHECK(folly::readFile(FLAGS_log_file.c_str(), contents))
+          << "Could not read " << FLAGS_log_file;
+      folly::split('\n', contents, l, true /* ignoreEmpty */);
+    } else {
+      for (int i = 0; i < FLAGS_num_lines; i++) {
+        l.push_back(kLines[i % kLines.size()]);
+      }
+    }
+    return l;
+  }();
+  return lines;
+}
+
+std::unordered_map<std::string, thrift::EventFilter>
+getEventFilters() {
+  std::unordered_map<std::string, thrift::EventFilter> eventFilters;
+  for (const auto& kv : kFilters) {
+    thrift::EventFilter filter;
+    filter.regex = kv.second.first;
+    filter.level = kv.second.second;
+    eventFilters[kv.first] = filter;
+  }
+  return eventFilters;
+}
+} // namespace
+
+BENCHMARK(StdRegexPerFilter, iters) {
+  std::vector<std::regex> regexes;
+  const std::vector<std::string>* lines;
+  BENCHMARK_SUSPEND {
+    for (const auto& kv : kFilters) {
+      regexes.push_back(std::regex(kv.second.first));
+    }
+    lines = &getLines();
+  }
+  size_t numMatches = 0;
+  for (size_t i = 0; i < iters; i++) {
+    for (const auto& regex : regexes) {
+      for (const std::string& line : *lines) {
+        numMatches += std::regex_search(line, regex);
+      }
+    }
+  }
+  folly::doNotOptimizeAway(numMatches);
+}
+
+BENCHMARK_RELATIVE(EventMatcherSinglePass, iters) {
+  std::unique_ptr<EventMatcher> matcher;
+  const std::vector<std::string>* lines;
+  BENCHMARK_SUSPEND {
+    matcher = std::make_unique<EventMatcher>(getEventFilters());
+    lines = &getLines();
+  }
+  size_t numMatches = 0;
+  std::vector<size_t> matches;
+  for (size_t i = 0; i < iters; i++) {
+    for (const std::string& line : *lines) {
+      matcher->match(line, matches);
+      numMatches += matches.size();
+    }
+  }
+  folly::doNotOptimizeAway(numMatches);
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
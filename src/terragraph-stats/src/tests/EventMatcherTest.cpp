@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <folly/init/Init.h>
+
+#include "../logtail/EventMatcher.h"
+
+using namespace facebook::terragraph;
+using namespace facebook::terragraph::stats;
+
+namespace {
+thrift::EventFilter
+makeFilter(const std::string& regex, const std::string& level = "ERROR") {
+  thrift::EventFilter filter;
+  filter.regex = regex;
+  filter.level = level;
+  return filter;
+}
+
+std::vector<std::string>
+getMatches(const EventMatcher& matcher, const std::string& line) {
+  std::vector<size_t> matches;
+  matcher.match(line, matches);
+  std::vector<std::string> names;
+  for (size_t index : matches) {
+    names.push_back(matcher.getFilter(index).name);
+  }
+  return names;
+}
+} // namespace
+
+TEST(EventMatcherTest, MatchesAllFilters) {
+  EventMatcher matcher(
+      {{"FW_ERROR", makeFilter("ERROR!!!")},
+       {"rf_read_timedout", makeFilter("eth0: rf read timedout")},
+       {"rf_timedout", makeFilter("rf read timedout", "WARNING")},
+       {"link_down", makeFilter("LINK_DOWN: [0-9a-f:]+", "INFO")},
+       {"any_panic", makeFilter("panic|Oops")}});
+  EXPECT_EQ(5, matcher.size());
+  EXPECT_EQ(thrift::EventLevel::WARNING, matcher.getFilter(4).level);
+
+  // Check twice, as matching must not change any state
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(
+        std::vector<std::string>({"FW_ERROR"}),
+        getMatches(matcher, "[fw] ERROR!!! assert at 0x1234"));
+    EXPECT_EQ(
+        std::vector<std::string>({"rf_read_timedout", "rf_timedout"}),
+        getMatches(matcher, "kernel: eth0: rf read timedout (ERROR!!)"));
+    EXPECT_EQ(
+        std::vector<std::string>({"rf_timedout"}),
+        getMatches(matcher, "kernel: eth1: rf read timedout"));
+    EXPECT_EQ(
+        std::vector<std::string>({"link_down"}),
+        getMatches(matcher, "LINK_DOWN: 00:00:00:10:0d:40"));
+    EXPECT_EQ(
+        std::vector<std::string>({"any_panic"}),
+        getMatches(matcher, "Kernel panic - not syncing"));
+
+    // Required literal found, but the regex does not match
+    EXPECT_TRUE(getMatches(matcher, "LINK_DOWN: none").empty());
+    EXPECT_TRUE(getMatches(matcher, "").empty());
+  }
+}
+
+TEST(EventMatcherTest, OverlappingLiterals) {
+  EventMatcher matcher(
+      {{"a", makeFilter("abcd")},
+       {"b", makeFilter("bc")},
+       {"c", makeFilter("bcde")},
+       {"d", makeFilter("x*cd")}});
+  EXPECT_EQ(std::vector<std::string>({"b"}), getMatches(matcher, "abce"));
+  EXPECT_EQ(
+      std::vector<std::string>({"a", "b", "c", "d"}),
+      getMatches(matcher, "abcde"));
+  EXPECT_EQ(
+      std::vector<std::string>({"b", "c", "d"}),
+      getMatches(matcher, "aabcbcde"));
+}
+
+TEST(EventMatcherTest, InvalidFilters) {
+  EventMatcher matcher(
+      {{"malformed", makeFilter("tgf.(")},
+       {"bad_level", makeFilter("foo", "NOT_A_LEVEL")},
+       {"valid", makeFilter("foo")}});
+  EXPECT_EQ(1, matcher.size());
+  EXPECT_EQ(std::vector<std::string>({"valid"}), getMatches(matcher, "foo"));
+}
+
+TEST(EventMatcherTest, Empty) {
+  EventMatcher matcher({});
+  EXPECT_EQ(0, matcher.size());
+  EXPECT_TRUE(getMatches(matcher, "ERROR!!!").empty());
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare encoding one push interval of stats for Kafka as one JSON AggrStat
+// per stat against one Compact-serialized AggrStatsBatch. Payload sizes and
+// heap allocations per stat are printed after the benchmarks run.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "../agent/KafkaStatsBatch.h"
+#include "e2e/common/JsonUtils.h"
+#include "stats/common/StatInfo.h"
+
+DEFINE_int32(num_stats, 10000, "Number of stats per push interval");
+
+using namespace facebook::terragraph;
+using namespace facebook::terragraph::stats;
+
+namespace {
+// Heap allocations made by this process
+std::atomic<size_t> numAllocations{0};
+
+const std::string kNodeMac{"00:00:00:10:0d:40"};
+
+// Raw counter keys, as queued by KafkaPublisher ("[key]\0[entity]" for
+// firmware stats)
+const std::vector<std::string>&
+getRawKeys() {
+  static const std::vector<std::string> keys = [] {
+    std::vector<std::string> k;
+    for (int i = 0; i < FLAGS_num_stats; i++) {
+      std::string key = folly::sformat(
+          "tgf.00:00:00:10:0d:{:02x}.staPkt.stat{}", i % 16, i / 16);
+      if (i % 2 == 0) {
+        key += '\0';
+        key += folly::sformat("00:00:00:10:0d:{:02x}", 0x40 + (i % 4));
+      }
+      k.push_back(std::move(key));
+    }
+    return k;
+  }();
+  return keys;
+}
+
+// Encode one interval as JSON messages, returning the total payload size
+size_t
+encodeJson(const std::vector<std::string>& rawKeys) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < rawKeys.size(); i++) {
+    const StatInfo info(rawKeys[i], kNodeMac);
+    thrift::AggrStat stat;
+    stat.timestamp = 1600000000 + i;
+    stat.key = info.key;
+    stat.isCounter = false;
+    stat.value = i;
+    stat.entity_ref() = info.entity;
+    bytes += JsonUtils::serializeToJson<thrift::AggrStat>(stat).size();
+  }
+  return bytes;
+}
+
+// Encode one interval as one batch, returning the payload size
+size_t
+encodeBatch(const std::vector<std::string>& rawKeys) {
+  KafkaStatsBatch batch;
+  for (size_t i = 0; i < rawKeys.size(); i++) {
+    const StatInfo info(rawKeys[i], kNodeMac);
+    batch.add(info.key, info.entity, 1600000000 + i, i, false);
+  }
+  return batch.serializeAndClear().size();
+}
+
+// Print payload size and allocations for one encoding pass
+void
+printStats(
+    const std::string& name,
+    size_t (*encode)(const std::vector<std::string>&)) {
+  const auto& rawKeys = getRawKeys();
+  size_t allocsBefore = numAllocations.load();
+  size_t bytes = encode(rawKeys);
+  size_t allocs = numAllocations.load() - allocsBefore;
+  LOG(INFO) << name << ": " << bytes << " bytes ("
+            << (double)bytes / rawKeys.size() << " per stat), " << allocs
+            << " allocations (" << (double)allocs / rawKeys.size()
+            << " per stat)";
+}
+} // namespace
+
+void*
+operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+// Reports time per stat
+BENCHMARK_MULTI(JsonPerStat, iters) {
+  const std::vector<std::string>* rawKeys;
+  BENCHMARK_SUSPEND {
+    rawKeys = &getRawKeys();
+  }
+  size_t bytes = 0;
+  for (size_t i = 0; i < iters; i++) {
+    bytes += encodeJson(*rawKeys);
+  }
+  folly::doNotOptimizeAway(bytes);
+  return iters * rawKeys->size();
+}
+
+BENCHMARK_RELATIVE_MULTI(ThriftCompactBatch, iters) {
+  const std::vector<std::string>* rawKeys;
+  BENCHMARK_SUSPEND {
+    rawKeys = &getRawKeys();
+  }
+  size_t bytes = 0;
+  for (size_t i = 0; i < iters; i++) {
+    bytes += encodeBatch(*rawKeys);
+  }
+  folly::doNotOptimizeAway(bytes);
+  return iters * rawKeys->size();
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  printStats("JSON per stat", encodeJson);
+  printStats("Thrift compact batch", encodeBatch);
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "../snmp/RadioTable.h"
+
+using namespace facebook::terragraph;
+
+namespace {
+RadioStat
+makeRadioStat(const std::string& ifName, std::time_t lastUpdated) {
+  RadioStat radioStat;
+  radioStat.ifName = ifName;
+  radioStat.lastUpdated = lastUpdated;
+  radioStat.snr = 20;
+  radioStat.mcs = 9;
+  radioStat.rssi = -50;
+  return radioStat;
+}
+
+// Return the ifNames of all rows in walk order
+std::vector<std::string>
+walk(const RadioTable& radioTable, std::time_t now) {
+  std::vector<std::string> ifNames;
+  radioTable.withSnapshot([&](const RadioTableSnapshot& snapshot) {
+    long index = 0;
+    while (const RadioRow* row = snapshot.findNext(index, now)) {
+      ifNames.push_back(row->ifName);
+      index = row->index;
+    }
+  });
+  return ifNames;
+}
+} // namespace
+
+TEST(RadioTableTest, Empty) {
+  RadioTable radioTable;
+  EXPECT_TRUE(walk(radioTable, std::time(nullptr)).empty());
+}
+
+TEST(RadioTableTest, StableIndexes) {
+  std::time_t now = std::time(nullptr);
+  RadioTable radioTable;
+  StatCacheMap radioStats;
+  radioStats["mac1"]["peer1"] = makeRadioStat("terra0", now);
+  radioTable.update(radioStats);
+  EXPECT_EQ(std::vector<std::string>({"terra0"}), walk(radioTable, now));
+
+  // new links are appended, and existing links keep their index
+  radioStats["mac0"]["peer2"] = makeRadioStat("terra1", now);
+  radioStats["mac1"]["peer0"] = makeRadioStat("terra2", now);
+  radioTable.update(radioStats);
+  radioTable.withSnapshot([&](const RadioTableSnapshot& snapshot) {
+    ASSERT_EQ(3, snapshot.getRows().size());
+    const RadioRow* row = snapshot.find(1, now);
+    ASSERT_NE(nullptr, row);
+    EXPECT_EQ("terra0", row->ifName);
+    EXPECT_EQ("mac1", row->macAddr);
+    EXPECT_EQ("peer1", row->remoteMacAddr);
+    EXPECT_EQ(nullptr, snapshot.find(4, now));
+  });
+  std::vector<std::string> ifNames = walk(radioTable, now);
+  ASSERT_EQ(3, ifNames.size());
+  EXPECT_EQ("terra0", ifNames[0]);
+}
+
+TEST(RadioTableTest, SkipsOutdatedRows) {
+  std::time_t now = std::time(nullptr);
+  RadioTable radioTable;
+  StatCacheMap radioStats;
+  radioStats["mac0"]["peer0"] = makeRadioStat("terra0", now);
+  radioTable.update(radioStats);
+  radioStats["mac0"]["peer1"] = makeRadioStat("terra1", now - 60);
+  radioTable.update(radioStats);
+  radioStats["mac0"]["peer2"] = makeRadioStat("terra2", now);
+  radioTable.update(radioStats);
+
+  EXPECT_EQ(
+      std::vector<std::string>({"terra0", "terra2"}), walk(radioTable, now));
+  radioTable.withSnapshot([&](const RadioTableSnapshot& snapshot) {
+    EXPECT_NE(nullptr, snapshot.find(1, now));
+    EXPECT_EQ(nullptr, snapshot.find(2, now));
+    EXPECT_NE(nullptr, snapshot.find(3, now));
+  });
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare an SNMP walk of tgRadioInterfacesTable through the old table
+// iterator (which copied every row out of the locked stats cache and scanned
+// all of them for each GETNEXT) against lookups in a RadioTable snapshot.
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../snmp/RadioTable.h"
+
+DEFINE_int32(num_links, 64, "Number of links in the radio table");
+
+using namespace facebook::terragraph;
+
+namespace {
+// Number of accessible columns walked (IF_NAME to RSSI)
+const int kNumColumns{6};
+
+StatCacheMap
+getRadioStats(std::time_t now) {
+  StatCacheMap radioStats;
+  for (int i = 0; i < FLAGS_num_links; i++) {
+    // 4 radios per node
+    const std::string localMac =
+        folly::sformat("00:00:00:10:0d:{:02x}", i % 4);
+    const std::string remoteMac = folly::sformat(
+        "00:00:00:{:02x}:{:02x}:{:02x}", i >> 16, (i >> 8) & 0xff, i & 0xff);
+    RadioStat& radioStat = radioStats[localMac][remoteMac];
+    radioStat.ifName = folly::sformat("terra{}", i);
+    radioStat.lastUpdated = now;
+    radioStat.snr = 20;
+    radioStat.mcs = 9;
+    radioStat.rssi = -50;
+  }
+  return radioStats;
+}
+} // namespace
+
+BENCHMARK(TableIteratorWalk, iters) {
+  folly::Synchronized<StatCacheMap> radioStats;
+  std::time_t now = std::time(nullptr);
+  BENCHMARK_SUSPEND {
+    radioStats = getRadioStats(now);
+  }
+  size_t numRows = 0;
+  for (size_t i = 0; i < iters; i++) {
+    for (int column = 0; column < kNumColumns; column++) {
+      long index = 0;
+      while (true) {
+        // copy all rows for the request
+        std::vector<RadioRow> rows;
+        {
+          auto lockedStats = radioStats.rlock();
+          for (const auto& localMacMap : *lockedStats) {
+            for (const auto& remoteMacMap : localMacMap.second) {
+              RadioRow row;
+              row.index = rows.size() + 1;
+              row.ifName = remoteMacMap.second.ifName;
+              row.macAddr = localMacMap.first;
+              row.remoteMacAddr = remoteMacMap.first;
+              row.radioStat = remoteMacMap.second;
+              rows.push_back(std::move(row));
+            }
+          }
+        }
+        // scan all rows for the next index
+        const RadioRow* next = nullptr;
+        for (const auto& row : rows) {
+          if (row.index > index && (!next || row.index < next->index)) {
+            next = &row;
+          }
+        }
+        if (!next) {
+          break;
+        }
+        index = next->index;
+        numRows++;
+      }
+    }
+  }
+  folly::doNotOptimizeAway(numRows);
+}
+
+BENCHMARK_RELATIVE(RadioTableSnapshotWalk, iters) {
+  RadioTable radioTable;
+  std::time_t now = std::time(nullptr);
+  BENCHMARK_SUSPEND {
+    radioTable.update(getRadioStats(now));
+  }
+  size_t numRows = 0;
+  for (size_t i = 0; i < iters; i++) {
+    for (int column = 0; column < kNumColumns; column++) {
+      long index = 0;
+      while (true) {
+        // one lookup per request (rows are only valid within withSnapshot)
+        long next = radioTable.withSnapshot(
+            [&](const RadioTableSnapshot& snapshot) {
+              const RadioRow* row = snapshot.findNext(index, now);
+              return row ? row->index : 0;
+            });
+        if (!next) {
+          break;
+        }
+        index = next;
+        numRows++;
+      }
+    }
+  }
+  folly::doNotOptimizeAway(numRows);
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare building the aggregator's stats writer request as one folly::dynamic
+// (serialized with folly::toJson) against streaming it with StatsJsonWriter,
+// for synthetic 100/500/2000-node stats queues. Peak heap usage while writing
+// one request is printed after the benchmarks run.
+
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <new>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "../aggregator/StatsJsonWriter.h"
+
+DEFINE_int32(stats_per_node, 400, "Number of queued stats per node");
+
+using namespace facebook::terragraph;
+using namespace facebook::terragraph::stats;
+
+namespace {
+// Live and peak heap bytes allocated through operator new
+std::atomic<size_t> liveBytes{0};
+std::atomic<size_t> peakBytes{0};
+
+const std::string kTopologyName{"benchmark"};
+const int kInterval{30};
+
+// Stats queues for all agents (as in StatsApp)
+using StatsQueues =
+    std::unordered_map<std::string, StatsJsonWriter::AgentStats>;
+
+struct Queues {
+  StatsQueues statsQueues;
+  StatsQueues prevStatsQueues;
+};
+
+// Build current and previous stats queues for the given number of nodes
+const Queues&
+getQueues(size_t numNodes) {
+  static std::map<size_t, Queues> cache;
+  auto iter = cache.find(numNodes);
+  if (iter != cache.end()) {
+    return iter->second;
+  }
+
+  Queues& queues = cache[numNodes];
+  for (size_t node = 0; node < numNodes; node++) {
+    std::string mac = folly::sformat(
+        "00:00:00:{:02x}:{:02x}:{:02x}",
+        (node >> 16) & 0xff,
+        (node >> 8) & 0xff,
+        node & 0xff);
+    auto& statsQueue = queues.statsQueues[mac];
+    auto& prevStatsQueue = queues.prevStatsQueues[mac];
+    for (int i = 0; i < FLAGS_stats_per_node; i++) {
+      thrift::AggrStat stat;
+      stat.key = folly::sformat("tgf.00:00:00:10:0d:{:02x}.stat{}", i % 4, i);
+      stat.isCounter = (i % 2 == 0);
+      stat.timestamp = 1600000030000 + i;
+      stat.value = 1000 + i;
+      thrift::AggrStat prevStat = stat;
+      prevStat.timestamp -= 30000;
+      prevStat.value -= i;
+      prevStatsQueue[stat.key] = prevStat;
+      statsQueue[stat.key] = std::move(stat);
+    }
+  }
+  return queues;
+}
+
+std::string
+getNodeName(const std::string& mac) {
+  return "node-" + mac;
+}
+
+// The previous implementation: build everything, then serialize it
+size_t
+writeDynamic(const Queues& queues) {
+  folly::dynamic dataPointsQueue = folly::dynamic::array;
+  for (const auto& kv : queues.statsQueues) {
+    const auto& prevStatsQueue = queues.prevStatsQueues.at(kv.first);
+    folly::dynamic statsMsgs = folly::dynamic::array;
+    for (const auto& currStatKv : kv.second) {
+      double value;
+      if (!StatsJsonWriter::getStatValue(
+              currStatKv.second, prevStatsQueue, value)) {
+        continue;
+      }
+      statsMsgs.push_back(folly::dynamic::object("key", currStatKv.first)(
+          "ts", currStatKv.second.timestamp)("value", value));
+    }
+    dataPointsQueue.push_back(folly::dynamic::object("mac", kv.first)(
+        "name", getNodeName(kv.first))("site", "site")("stats", statsMsgs));
+  }
+  folly::dynamic statsWriterRequest = folly::dynamic::object(
+      "topology", folly::dynamic::object("name", kTopologyName))(
+      "agents", dataPointsQueue)("interval", kInterval);
+  return folly::toJson(statsWriterRequest).size();
+}
+
+// Stream the request to a sink that just counts bytes
+size_t
+writeStreaming(const Queues& queues) {
+  size_t bytes = 0;
+  StatsJsonWriter writer(
+      kTopologyName, kInterval, [&bytes](folly::StringPiece data) {
+        bytes += data.size();
+        return true;
+      });
+  for (const auto& kv : queues.statsQueues) {
+    writer.writeAgent(
+        kv.first,
+        getNodeName(kv.first),
+        "site",
+        kv.second,
+        queues.prevStatsQueues.at(kv.first));
+  }
+  writer.finish();
+  return bytes;
+}
+
+// Return the peak heap usage (above the starting point) of one call
+template <typename Fn>
+size_t
+measurePeakBytes(Fn&& fn) {
+  size_t start = liveBytes.load();
+  peakBytes = start;
+  fn();
+  return peakBytes.load() - start;
+}
+} // namespace
+
+void*
+operator new(size_t size) {
+  if (void* p = std::malloc(size ? size : 1)) {
+    size_t n = malloc_usable_size(p);
+    size_t live = liveBytes.fetch_add(n) + n;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+  if (p) {
+    liveBytes.fetch_sub(malloc_usable_size(p));
+  }
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept {
+  operator delete(p);
+}
+
+void
+DynamicToJson(uint32_t iters, size_t numNodes) {
+  const Queues* queues;
+  BENCHMARK_SUSPEND {
+    queues = &getQueues(numNodes);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(writeDynamic(*queues));
+  }
+}
+
+void
+StreamingWriter(uint32_t iters, size_t numNodes) {
+  const Queues* queues;
+  BENCHMARK_SUSPEND {
+    queues = &getQueues(numNodes);
+  }
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(writeStreaming(*queues));
+  }
+}
+
+BENCHMARK_PARAM(DynamicToJson, 100)
+BENCHMARK_RELATIVE_PARAM(StreamingWriter, 100)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(DynamicToJson, 500)
+BENCHMARK_RELATIVE_PARAM(StreamingWriter, 500)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(DynamicToJson, 2000)
+BENCHMARK_RELATIVE_PARAM(StreamingWriter, 2000)
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+
+  for (size_t numNodes : {100, 500, 2000}) {
+    const Queues& queues = getQueues(numNodes);
+    size_t bytes = 0;
+    size_t dynamicPeak =
+        measurePeakBytes([&]() { bytes = writeDynamic(queues); });
+    size_t streamingPeak =
+        measurePeakBytes([&]() { writeStreaming(queues); });
+    LOG(INFO) << numNodes << " nodes (" << bytes / 1024
+              << " KiB request): peak heap " << dynamicPeak / 1024
+              << " KiB with folly::dynamic, " << streamingPeak / 1024
+              << " KiB streaming";
+  }
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare matching stat keys against the default stats blacklist and
+// high-frequency stats whitelist using one std::regex per pattern against
+// StatsKeyFilter.
+
+#include <regex>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../agent/StatsKeyFilter.h"
+
+DEFINE_int32(num_peers, 16, "Number of peers to generate link stat keys for");
+
+using namespace facebook::terragraph::stats;
+
+namespace {
+// Default patterns from the base node config
+const std::unordered_map<std::string, std::string> kPatterns = {
+    {"gpsSkyview", "tgd\\.gpsStat\\.[0-9]+\\..+"},
+    {"staPktStats",
+     ".*staPkt\\.(.*Fail|.*Ok|mcs|perE6|.*Ba|.*Ppdu|txPowerIndex|"
+     "linkAvailable|mgmtLinkUp)"},
+    {"phyStatusStats", ".*phystatus\\.(ssnrEst|srssi)"},
+    {"latpcStats", ".*noTrafficCountSF"},
+};
+
+// Per-link firmware stat names published by a node
+const std::vector<std::string> kLinkStatNames = {
+    "staPkt.txOk",
+    "staPkt.txFail",
+    "staPkt.rxOk",
+    "staPkt.rxFail",
+    "staPkt.mcs",
+    "staPkt.perE6",
+    "staPkt.txBa",
+    "staPkt.rxPpdu",
+    "staPkt.txPowerIndex",
+    "staPkt.txSlotTime",
+    "staPkt.rxDiscBuf",
+    "phystatus.ssnrEst",
+    "phystatus.srssi",
+    "phystatus.rxMcs",
+    "mgmtTx.bfTrainingReq",
+    "mgmtRx.bfTrainingRsp",
+    "bwhanLink.txSlotDur",
+    "latpcStats.noTrafficCountSF",
+    "latpcStats.txPowerIndex",
+    "tpcStats.tsf",
+    "miscLink.rxBeamIdx",
+};
+
+// Per-node stat keys
+const std::vector<std::string> kNodeKeys = {
+    "tgd.gpsStat.3.snr",
+    "tgd.gpsStat.3.elevation",
+    "tgd.gpsStat.numSats",
+    "tgf.00:00:00:00:00:00.miscSys.cpuLoadAvg",
+    "openr.ipv6.fib.routes",
+    "vpp.Terra0.tx_packets",
+    "memory.util",
+    "load-1",
+    "uptime",
+};
+
+const std::vector<std::string>&
+getKeys() {
+  static const std::vector<std::string> keys = [] {
+    std::vector<std::string> k = kNodeKeys;
+    for (int peer = 0; peer < FLAGS_num_peers; peer++) {
+      for (const std::string& name : kLinkStatNames) {
+        k.push_back(
+            folly::sformat("tgf.00:00:00:10:0d:{:02x}.{}", peer, name));
+      }
+    }
+    return k;
+  }();
+  return keys;
+}
+} // namespace
+
+BENCHMARK(StdRegexPerPattern, iters) {
+  std::vector<std::regex> regexes;
+  const std::vector<std::string>* keys;
+  BENCHMARK_SUSPEND {
+    for (const auto& kv : kPatterns) {
+      regexes.push_back(std::regex(kv.second));
+    }
+    keys = &getKeys();
+  }
+  size_t numMatches = 0;
+  for (size_t i = 0; i < iters; i++) {
+    for (const std::string& key : *keys) {
+      for (const auto& regex : regexes) {
+        if (std::regex_match(key, regex)) {
+          numMatches++;
+          break;
+        }
+      }
+    }
+  }
+  folly::doNotOptimizeAway(numMatches);
+}
+
+BENCHMARK_RELATIVE(StatsKeyFilterCold, iters) {
+  const std::vector<std::string>* keys;
+  BENCHMARK_SUSPEND {
+    keys = &getKeys();
+  }
+  size_t numMatches = 0;
+  for (size_t i = 0; i < iters; i++) {
+    // New filter per pass: every lookup is a memo miss
+    StatsKeyFilter filter(kPatterns, "benchmark");
+    for (const std::string& key : *keys) {
+      numMatches += filter.matches(key);
+    }
+  }
+  folly::doNotOptimizeAway(numMatches);
+}
+
+BENCHMARK_RELATIVE(StatsKeyFilterMemoized, iters) {
+  std::unique_ptr<StatsKeyFilter> filter;
+  const std::vector<std::string>* keys;
+  BENCHMARK_SUSPEND {
+    filter = std::make_unique<StatsKeyFilter>(kPatterns, "benchmark");
+    keys = &getKeys();
+    for (const std::string& key : *keys) {
+      filter->matches(key);
+    }
+  }
+  size_t numMatches = 0;
+  for (size_t i = 0; i < iters; i++) {
+    for (const std::string& key : *keys) {
+      numMatches += filter->matches(key);
+    }
+  }
+  folly::doNotOptimizeAway(numMatches);
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <folly/init/Init.h>
+
+#include "../agent/StatsKeyFilter.h"
+
+using namespace facebook::terragraph::stats;
+
+TEST(StatsKeyFilterTest, RequiredLiteral) {
+  EXPECT_EQ(
+      "tgd.gpsStat.",
+      StatsKeyFilter::getRequiredLiteral("tgd\\.gpsStat\\.[0-9]+\\..+"));
+  EXPECT_EQ(
+      "staPkt.",
+      StatsKeyFilter::getRequiredLiteral(".*staPkt\\.(.*Fail|.*Ok|mcs)"));
+  EXPECT_EQ(
+      "noTrafficCountSF",
+      StatsKeyFilter::getRequiredLiteral(".*noTrafficCountSF"));
+
+  // Optional characters are not required
+  EXPECT_EQ("ab", StatsKeyFilter::getRequiredLiteral("abc?d"));
+  EXPECT_EQ("yy.", StatsKeyFilter::getRequiredLiteral("x\\dyy\\.z*"));
+
+  // Operands of multi-character escapes are not literals
+  EXPECT_EQ("abc", StatsKeyFilter::getRequiredLiteral("abc\\x41\\.z"));
+  EXPECT_EQ("abc", StatsKeyFilter::getRequiredLiteral("abc\\u00e9\\.z"));
+  EXPECT_EQ("abc", StatsKeyFilter::getRequiredLiteral("abc\\cJ\\.z"));
+  EXPECT_EQ("abc", StatsKeyFilter::getRequiredLiteral("abc\\012\\.z"));
+  EXPECT_EQ("42abcd", StatsKeyFilter::getRequiredLiteral("x\\x4142abcd"));
+
+  // Top-level alternation has no required literal
+  EXPECT_EQ("", StatsKeyFilter::getRequiredLiteral("foo|bar"));
+  EXPECT_EQ("", StatsKeyFilter::getRequiredLiteral(".*"));
+}
+
+TEST(StatsKeyFilterTest, Matches) {
+  StatsKeyFilter filter(
+      {{"gpsSkyview", "tgd\\.gpsStat\\.[0-9]+\\..+"},
+       {"staPktStats", ".*staPkt\\.(.*Fail|.*Ok|mcs)"},
+       {"altStats", "foo|bar"},
+       {"malformed", "tgf.("}},
+      "test");
+  EXPECT_EQ(3, filter.size());
+
+  // Check twice to cover memoized results
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(filter.matches("tgd.gpsStat.12.snr"));
+    EXPECT_FALSE(filter.matches("tgd.gpsStat.x.snr"));
+    EXPECT_TRUE(filter.matches("tgf.00:00:00:10:0d:40.staPkt.txOk"));
+    EXPECT_TRUE(filter.matches("tgf.00:00:00:10:0d:40.staPkt.mcs"));
+    EXPECT_FALSE(filter.matches("tgf.00:00:00:10:0d:40.staPkt.txBa"));
+    EXPECT_FALSE(filter.matches("tgf.00:00:00:10:0d:40.staPkt.mcsx"));
+    EXPECT_TRUE(filter.matches("bar"));
+    EXPECT_FALSE(filter.matches("foobar"));
+  }
+}
+
+TEST(StatsKeyFilterTest, Empty) {
+  StatsKeyFilter filter({}, "test");
+  EXPECT_EQ(0, filter.size());
+  EXPECT_FALSE(filter.matches("tgf.00:00:00:10:0d:40.staPkt.txOk"));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
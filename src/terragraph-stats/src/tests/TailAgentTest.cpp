@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdio>
+
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "../logtail/TailAgent.h"
+
+DECLARE_uint32(read_buffer_size);
+DECLARE_uint32(marker_write_bytes);
+
+using namespace facebook::terragraph::stats;
+
+namespace {
+const std::string kMarkerSuffix{".marker.test"};
+} // namespace
+
+class TailAgentFixture : public ::testing::Test {
+ public:
+  void
+  SetUp() override {
+    char dir[] = "/tmp/tail_agent_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    dir_ = dir;
+    filename_ = dir_ + "/current";
+    FLAGS_read_buffer_size = 64 * 1024;
+    FLAGS_marker_write_bytes = 0; // write the marker on every change
+  }
+
+  void
+  TearDown() override {
+    for (const auto& name :
+         {filename_, filename_ + ".1", filename_ + kMarkerSuffix}) {
+      std::remove(name.c_str());
+    }
+    rmdir(dir_.c_str());
+  }
+
+ protected:
+  void
+  append(const std::string& contents) {
+    std::string existing;
+    folly::readFile(filename_.c_str(), existing);
+    ASSERT_TRUE(folly::writeFile(existing + contents, filename_.c_str()));
+  }
+
+  std::vector<std::string>
+  fetch(TailAgent& agent, uint32_t logCount = 100) {
+    std::vector<std::string> lines;
+    agent.fetchLogLines(logCount, [&lines](folly::StringPiece line) {
+      lines.push_back(line.str());
+    });
+    return lines;
+  }
+
+  std::string dir_;
+  std::string filename_;
+};
+
+TEST_F(TailAgentFixture, ReadsCompleteLines) {
+  append("first\n\nsecond\nthi");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(std::vector<std::string>({"first", "second"}), fetch(agent));
+
+  // Nothing is read until the agent is notified of a change
+  append("rd\n");
+  EXPECT_TRUE(fetch(agent).empty());
+  agent.notify(false);
+  EXPECT_EQ(std::vector<std::string>({"third"}), fetch(agent));
+  EXPECT_TRUE(fetch(agent).empty());
+}
+
+TEST_F(TailAgentFixture, LogCount) {
+  append("1\n2\n3\n4\n5\n");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(std::vector<std::string>({"1", "2"}), fetch(agent, 2));
+  EXPECT_EQ(std::vector<std::string>({"3", "4"}), fetch(agent, 2));
+  EXPECT_EQ(std::vector<std::string>({"5"}), fetch(agent, 2));
+  EXPECT_TRUE(fetch(agent, 2).empty());
+}
+
+TEST_F(TailAgentFixture, SplitsLongLines) {
+  FLAGS_read_buffer_size = 4;
+  append("abcdefghij\nkl\n");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(
+      std::vector<std::string>({"abcd", "efgh", "ij", "kl"}), fetch(agent));
+}
+
+TEST_F(TailAgentFixture, FollowsRotation) {
+  append("old1\n");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(std::vector<std::string>({"old1"}), fetch(agent));
+
+  // The rest of the old file is read before switching to the new file
+  append("old2\nold3");
+  ASSERT_EQ(0, rename(filename_.c_str(), (filename_ + ".1").c_str()));
+  append("new1\n");
+  agent.notify(true);
+  EXPECT_EQ(
+      std::vector<std::string>({"old2", "old3", "new1"}), fetch(agent));
+}
+
+TEST_F(TailAgentFixture, FollowsTruncation) {
+  append("line1\nline2\n");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(2, fetch(agent).size());
+
+  ASSERT_TRUE(folly::writeFile(std::string("new\n"), filename_.c_str()));
+  agent.notify(true);
+  EXPECT_EQ(std::vector<std::string>({"new"}), fetch(agent));
+}
+
+TEST_F(TailAgentFixture, ResumesFromMarker) {
+  append("line1\nline2\n");
+  {
+    TailAgent agent(filename_, kMarkerSuffix);
+    EXPECT_EQ(2, fetch(agent).size());
+  }
+
+  append("line3\n");
+  TailAgent agent(filename_, kMarkerSuffix);
+  EXPECT_EQ(std::vector<std::string>({"line3"}), fetch(agent));
+}
+
+int
+main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+  FLAGS_logtostderr = true;
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
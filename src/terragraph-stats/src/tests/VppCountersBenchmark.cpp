@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare reading VPP counters from the stats segment against forking
+// `vpp_get_stats`. This must be run on a node with VPP running.
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "../agent/VppCounters.h"
+
+DECLARE_bool(vpp_stats_segment);
+
+using namespace facebook::terragraph::stats;
+
+namespace {
+// Interface map passed to fetchStats() (empty: "vpp-terraX" stats are skipped)
+const std::unordered_map<std::string, std::pair<std::string, std::string>>
+    kTerraIfaceMap;
+
+void
+fetchVppStats(size_t iters, bool useStatSegment) {
+  FLAGS_vpp_stats_segment = useStatSegment;
+  VppCounters vppCounters;
+  size_t numStats = 0;
+  for (size_t i = 0; i < iters; i++) {
+    numStats += vppCounters.fetchStats(kTerraIfaceMap).size();
+  }
+  folly::doNotOptimizeAway(numStats);
+}
+} // namespace
+
+BENCHMARK(VppGetStatsSubprocess, iters) {
+  fetchVppStats(iters, false);
+}
+
+BENCHMARK_RELATIVE(VppStatSegment, iters) {
+  fetchVppStats(iters, true);
+}
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <glog/logging.h>
+#include <vapi/vapi.hpp>
+
+namespace openr
+{
+
+/**
+ * VapiPipeline keeps a window of VAPI requests outstanding on a connection,
+ * instead of waiting for the response to each request before sending the
+ * next one.
+ *
+ * VAPI stamps every request with a context and matches each reply to its
+ * request by context. Replies arrive in the order the requests were sent, so
+ * waiting for the oldest outstanding request completes everything sent before
+ * it, and submit() only blocks once the window is full.
+ *
+ * A request must stay alive until its response arrives, so the pipeline owns
+ * submitted requests until they complete. The response callback is invoked
+ * for each request, in submission order.
+ *
+ * The connection type is a template parameter so that the pipeline can be
+ * driven by a stand-in VAPI responder (see VapiPipelineBenchmark.cpp).
+ */
+template <class Connection, class Request> class VapiPipeline final
+{
+public:
+  using ResponseCallback = std::function<void (Request &)>;
+
+  VapiPipeline (Connection &connection, size_t window,
+                const std::string &apiName, ResponseCallback onResponse)
+      : connection_ (connection), window_ (std::max<size_t> (window, 1)),
+        apiName_ (apiName), onResponse_ (std::move (onResponse))
+  {
+  }
+
+  // Wait for all outstanding requests, as the connection still refers to them
+  ~VapiPipeline ()
+  {
+    drain ();
+  }
+
+  VapiPipeline (const VapiPipeline &) = delete;
+  VapiPipeline &operator= (const VapiPipeline &) = delete;
+
+  // Send a request, first waiting for the oldest outstanding request if the
+  // window is full.
+  void submit (std::unique_ptr<Request> req)
+  {
+    while (outstanding_.size () >= window_)
+      completeOldest ();
+
+    VLOG (3) << "Querying VAPI: " << apiName_;
+    vapi_error_e rv;
+    while ((rv = req->execute ()) == VAPI_EAGAIN && !outstanding_.empty ())
+      {
+        // The VAPI request queue is full, so make room for this request
+        completeOldest ();
+      }
+    if (rv != VAPI_OK)
+      {
+        // NOTE: Being strict about errors
+        LOG (FATAL) << apiName_ << " execution failed (error code " << rv
+                    << ")";
+      }
+    outstanding_.push_back (std::move (req));
+  }
+
+  // Wait for the responses to all outstanding requests.
+  void drain ()
+  {
+    while (!outstanding_.empty ())
+      completeOldest ();
+  }
+
+  // Number of requests sent but not yet completed
+  size_t numOutstanding () const
+  {
+    return outstanding_.size ();
+  }
+
+private:
+  void completeOldest ()
+  {
+    Request &req = *outstanding_.front ();
+    vapi_error_e rv;
+    do
+      {
+        rv = connection_.wait_for_response (req);
+      }
+    while (rv == VAPI_EAGAIN);
+
+    if (rv != VAPI_OK)
+      {
+        // NOTE: Being strict about errors
+        LOG (FATAL) << apiName_ << " response failed (error code " << rv
+                    << ")";
+      }
+
+    VLOG (3) << apiName_ << " succeeded.";
+    if (onResponse_)
+      onResponse_ (req);
+    outstanding_.pop_front ();
+  }
+
+  // The VAPI connection
+  Connection &connection_;
+
+  // Max number of requests outstanding at once
+  const size_t window_;
+
+  // API name, for logging
+  const std::string apiName_;
+
+  // Callback invoked with each completed request
+  ResponseCallback onResponse_;
+
+  // Requests sent but not yet completed, oldest first
+  std::deque<std::unique_ptr<Request>> outstanding_;
+};
+
+} // namespace openr
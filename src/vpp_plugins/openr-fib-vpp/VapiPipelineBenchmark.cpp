@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Compare waiting for each VAPI response before sending the next request
+// (window of 1, as VppClient::executeAndWait() does) against VapiPipeline.
+//
+// Requests are answered by a stand-in VAPI responder thread, which handles
+// requests in order with a fixed service time, and adds a fixed one-way
+// latency in each direction (e.g. shared memory queue wakeups in VPP).
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "VapiPipeline.h"
+
+DEFINE_int32 (responder_latency_us, 20,
+              "One-way latency between the client and the stand-in VAPI "
+              "responder, in microseconds");
+DEFINE_int32 (responder_service_us, 2,
+              "Time for the stand-in VAPI responder to handle a request, in "
+              "microseconds");
+DEFINE_int32 (pipeline_window, 32, "Number of outstanding requests");
+
+using namespace openr;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+void spinUntil (Clock::time_point t)
+{
+  while (Clock::now () < t)
+    {
+    }
+}
+
+class FakeConnection;
+
+// A stand-in VAPI request
+class FakeRequest
+{
+public:
+  explicit FakeRequest (FakeConnection &connection) : connection_ (connection)
+  {
+  }
+
+  vapi_error_e execute ();
+
+  // Context assigned by the connection when the request is sent
+  uint32_t context{0};
+
+private:
+  FakeConnection &connection_;
+};
+
+// A stand-in VAPI connection, answered by a responder thread
+class FakeConnection
+{
+public:
+  FakeConnection () : responderThread_ ([this] () { runResponder (); })
+  {
+  }
+
+  ~FakeConnection ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      stop_ = true;
+    }
+    requestCv_.notify_one ();
+    responderThread_.join ();
+  }
+
+  // Queue a request for the responder, returning its context
+  uint32_t send ()
+  {
+    std::lock_guard<std::mutex> lock (mutex_);
+    uint32_t context = ++nextContext_;
+    requests_.emplace_back (context, Clock::now ());
+    requestCv_.notify_one ();
+    return context;
+  }
+
+  // Wait for the reply matching the request's context
+  vapi_error_e wait_for_response (FakeRequest &req)
+  {
+    Clock::time_point repliedAt;
+    {
+      std::unique_lock<std::mutex> lock (mutex_);
+      replyCv_.wait (lock, [&] () { return replies_.count (req.context); });
+      repliedAt = replies_[req.context];
+      replies_.erase (req.context);
+    }
+    spinUntil (repliedAt + latency_);
+    return VAPI_OK;
+  }
+
+private:
+  void runResponder ()
+  {
+    while (true)
+      {
+        std::pair<uint32_t, Clock::time_point> request;
+        {
+          std::unique_lock<std::mutex> lock (mutex_);
+          requestCv_.wait (lock,
+                           [this] () { return stop_ || !requests_.empty (); });
+          if (stop_)
+            return;
+          request = requests_.front ();
+          requests_.pop_front ();
+        }
+
+        spinUntil (std::max (Clock::now (), request.second + latency_));
+        spinUntil (Clock::now () + serviceTime_);
+
+        {
+          std::lock_guard<std::mutex> lock (mutex_);
+          replies_[request.first] = Clock::now ();
+        }
+        replyCv_.notify_one ();
+      }
+  }
+
+  const std::chrono::microseconds latency_{FLAGS_responder_latency_us};
+  const std::chrono::microseconds serviceTime_{FLAGS_responder_service_us};
+
+  std::mutex mutex_;
+  std::condition_variable requestCv_;
+  std::condition_variable replyCv_;
+  bool stop_{false};
+  uint32_t nextContext_{0};
+
+  // Queued requests (context, time sent)
+  std::deque<std::pair<uint32_t, Clock::time_point>> requests_;
+
+  // Replies by context (time replied)
+  std::unordered_map<uint32_t, Clock::time_point> replies_;
+
+  std::thread responderThread_;
+};
+
+vapi_error_e FakeRequest::execute ()
+{
+  context = connection_.send ();
+  return VAPI_OK;
+}
+
+void runRequests (size_t iters, size_t window)
+{
+  std::unique_ptr<FakeConnection> connection;
+  BENCHMARK_SUSPEND
+  {
+    connection = std::make_unique<FakeConnection> ();
+  }
+
+  size_t numResponses = 0;
+  {
+    VapiPipeline<FakeConnection, FakeRequest> pipeline (
+        *connection, window, "fake_request",
+        [&numResponses] (FakeRequest &) { numResponses++; });
+    for (size_t i = 0; i < iters; i++)
+      {
+        pipeline.submit (std::make_unique<FakeRequest> (*connection));
+      }
+    pipeline.drain ();
+  }
+  folly::doNotOptimizeAway (numResponses);
+
+  BENCHMARK_SUSPEND
+  {
+    connection.reset ();
+  }
+}
+
+} // namespace
+
+BENCHMARK (ExecuteAndWait, iters)
+{
+  runRequests (iters, 1);
+}
+
+BENCHMARK_RELATIVE (Pipelined, iters)
+{
+  runRequests (iters, FLAGS_pipeline_window);
+}
+
+int main (int argc, char **argv)
+{
+  folly::init (&argc, &argv);
+  folly::runBenchmarks ();
+  return 0;
+}
@@ -8,8 +8,9 @@
 
 #include "VppClient.h"
 
+#include <algorithm>
 #include <chrono>
-#include <set>
+#include <exception>
 #include <stdexcept>
 
 #include <folly/Format.h>
@@ -23,6 +24,8 @@
 
 #include <vapi/tgcfg.api.vapi.hpp>
 
+#include "VapiPipeline.h"
+
 #define IPV4_ADDR_SZ 4
 #define IPV6_ADDR_SZ 16
 
@@ -111,33 +114,57 @@ void VppClient::syncRoutes (
 
   auto &cachedRoutes = unicastRoutes_[preference];
 
-  // Step-1 Dump all vpp routes which go via an interface we know about
-  auto oldRoutes = getRoutes (preference);
-  cachedRoutes.clear ();
-  for (auto const &route : oldRoutes)
+  // Step-1 On the first sync, seed the cache with the vpp routes which go via
+  // an interface we know about. Afterwards the cache mirrors what we have
+  // programmed in vpp, so there is no need to dump vpp's table again.
+  if (!syncedPreferences_.count (preference))
     {
-      cachedRoutes.emplace (route.dest_ref ().value (),
-                            route.nextHops_ref ().value ());
+      cachedRoutes.clear ();
+      for (auto const &route : getRoutes (preference))
+        {
+          cachedRoutes.emplace (route.dest_ref ().value (),
+                                route.nextHops_ref ().value ());
+        }
+      syncedPreferences_.insert (preference);
     }
 
-  // Step-2 Add or update new routes. Prepare set of new prefixes
-  std::set<thrift::IpPrefix> newPrefixes;
-  for (auto &route : routes)
+  // Step-2 Collect new routes whose nexthops differ from the cache
+  std::unordered_set<thrift::IpPrefix> newPrefixes;
+  std::vector<thrift::UnicastRoute> changedRoutes;
+  for (auto const &route : routes)
     {
-      newPrefixes.insert (route.dest_ref ().value ());
-      addRoute (preference, route);
+      const auto &prefix = route.dest_ref ().value ();
+      const auto &newNextHops = route.nextHops_ref ().value ();
+      newPrefixes.insert (prefix);
+      auto it = cachedRoutes.find (prefix);
+      if (it != cachedRoutes.end ()
+          && it->second.size () == newNextHops.size ()
+          && std::is_permutation (newNextHops.begin (), newNextHops.end (),
+                                  it->second.begin ()))
+        {
+          // Route is already programmed
+          continue;
+        }
+      changedRoutes.push_back (route);
     }
 
-  // Step-3 Remove old routes
-  for (auto &route : oldRoutes)
+  // Step-3 Collect old routes to remove (as routes without nexthops)
+  for (auto const &kv : cachedRoutes)
     {
-      if (newPrefixes.count (route.dest_ref ().value ()))
+      if (newPrefixes.count (kv.first))
         {
           // Route is specified in newRoutes
           continue;
         }
-      deleteRoute (preference, route.dest_ref ().value ());
+      thrift::UnicastRoute route;
+      route.dest_ref () = kv.first;
+      changedRoutes.emplace_back (std::move (route));
     }
+
+  LOG (INFO) << "Syncing " << routes.size () << " routes with preference "
+             << static_cast<int> (preference) << ": " << changedRoutes.size ()
+             << " routes to add, update, or delete";
+  addRoutes (preference, changedRoutes);
 }
 
 std::vector<openr::thrift::UnicastRoute>
@@ -250,157 +277,220 @@ std::string VppClient::getVppLoopbackLinkLocalAddr (const std::string &tapLLV6)
 
 void VppClient::addRoute (uint8_t preference,
                           const thrift::UnicastRoute &route)
+{
+  addRoutes (preference, {route});
+}
+
+void VppClient::addRoutes (uint8_t preference,
+                           const std::vector<thrift::UnicastRoute> &routes)
 {
   // Ensure thread safety
   evb_->checkIsInEventBaseThread ();
 
-  const auto &addr = route.dest_ref ()
-                         .value ()
-                         .prefixAddress_ref ()
-                         .value ()
-                         .addr_ref ()
-                         .value ();
-  const auto &newNextHops = route.nextHops_ref ().value ();
-  const auto &oldNextHops = folly::get_default (
-      unicastRoutes_[preference], route.dest_ref ().value (),
-      std::vector<thrift::NextHopThrift> ());
-
-  // Lambda function to add/del a nexthop from FIB
-  auto addDelNextHop = [&] (thrift::NextHopThrift const &nextHop, bool isAdd) {
-    LOG (INFO) << (isAdd ? "Adding" : "Deleting") << " path for "
-               << toString (route.dest_ref ().value ()) << " with preference "
-               << static_cast<int> (preference) << " " << toString (nextHop);
-    Ip_route_add_del req (connection_, 1 /* route_paths_array_size */);
-    auto &p = req.get_request ().get_payload ();
-    memset (&p, 0, sizeof (p));
-    p.is_add = isAdd;
-    p.is_multipath = true;
-    p.route.n_paths = 1;
-    p.route.prefix.len =
-        route.dest_ref ().value ().prefixLength_ref ().value ();
-    bool is_ipv6 = addr.size () == IPV6_ADDR_SZ;
-    if (is_ipv6)
-      {
-        p.route.prefix.address.af = ADDRESS_IP6;
-        memcpy (p.route.prefix.address.un.ip6, addr.data (), addr.size ());
+  auto &cachedRoutes = unicastRoutes_[preference];
 
-        p.route.paths[0].proto = FIB_API_PATH_NH_PROTO_IP6;
-        memcpy (p.route.paths[0].nh.address.ip6,
-                nextHop.address_ref ().value ().addr_ref ().value ().data (),
-                addr.size ());
-      }
-    else
-      {
-        p.route.prefix.address.af = ADDRESS_IP4;
-        memcpy (p.route.prefix.address.un.ip4, addr.data (), addr.size ());
+  // Compute the paths to delete and add for every route before sending
+  // anything to vpp. A route whose interfaces can't be resolved is skipped,
+  // and the first such error is rethrown once the other routes are programmed.
+  std::vector<PathUpdate> updates;
+  std::exception_ptr error;
+  for (const auto &route : routes)
+    {
+      const auto &prefix = route.dest_ref ().value ();
+      const auto &newNextHops = route.nextHops_ref ().value ();
+      const auto &oldNextHops = folly::get_default (
+          cachedRoutes, prefix, std::vector<thrift::NextHopThrift> ());
 
-        p.route.paths[0].proto = FIB_API_PATH_NH_PROTO_IP4;
-        memcpy (p.route.paths[0].nh.address.ip4,
-                nextHop.address_ref ().value ().addr_ref ().value ().data (),
-                addr.size ());
-      }
-    p.route.paths[0].preference = preference;
+      size_t numUpdates = updates.size ();
+      try
+        {
+          // Delete old nexthops first
+          for (const auto &oldNextHop : oldNextHops)
+            {
+              auto it = std::find (newNextHops.begin (), newNextHops.end (),
+                                   oldNextHop);
+              if (it != newNextHops.end ())
+                {
+                  // nexthop should remain programmed - skip removing
+                  continue;
+                }
+
+              updates.push_back (
+                  makePathUpdate (preference, prefix, oldNextHop, false));
+            }
 
-    if (nextHop.address_ref ().value ().ifName_ref ().has_value ())
-      {
-        const std::string &ifName =
-            nextHop.address_ref ().value ().ifName_ref ().value ();
+          // Add new nexthops
+          for (const auto &newNextHop : newNextHops)
+            {
+              auto it = std::find (oldNextHops.begin (), oldNextHops.end (),
+                                   newNextHop);
+              if (it != oldNextHops.end ())
+                {
+                  // next already programmed - skip adding again
+                  continue;
+                }
+
+              updates.push_back (
+                  makePathUpdate (preference, prefix, newNextHop, true));
+            }
+        }
+      catch (std::exception const &)
+        {
+          updates.erase (updates.begin () + numUpdates, updates.end ());
+          if (!error)
+            error = std::current_exception ();
+          continue;
+        }
 
-        // If it's a POP wired route - program the POP's VPP loopback
-        // link-local next-hop instead of tap's link-local. Routing will break
-        // otherwise.
-        if (ifName == FLAGS_pop_tap)
-          {
-            auto nextHopTap =
-                folly::IPAddress::fromBinary (
-                    folly::ByteRange (reinterpret_cast<const unsigned char *> (
-                                          nextHop.address_ref ()
-                                              .value ()
-                                              .addr_ref ()
-                                              .value ()
-                                              .data ()),
-                                      IPV6_ADDR_SZ))
-                    .str ();
-            std::string nextHopVppStr =
-                getVppLoopbackLinkLocalAddr (nextHopTap);
-            folly::IPAddress nextHopVpp = folly::IPAddress (nextHopVppStr);
-
-            LOG (INFO) << "POP route '" << nextHopTap
-                       << "' changed to VPP loop1 '" << nextHopVppStr << "'.";
-            memcpy (p.route.paths[0].nh.address.ip6, nextHopVpp.bytes (),
-                    addr.size ());
-          }
+      // Update local cache (before later routes in this batch are diffed)
+      if (newNextHops.size ())
+        {
+          cachedRoutes[prefix] = newNextHops;
+        }
+      else
+        {
+          cachedRoutes.erase (prefix);
+        }
+    }
 
-        p.route.paths[0].sw_if_index = ifaceToVppIndex (
-            nextHop.address_ref ().value ().ifName_ref ().value ());
-      }
-    else
-      {
-        p.route.paths[0].sw_if_index = ~0;
-      }
-    p.route.paths[0].weight =
-        static_cast<uint8_t> (nextHop.weight_ref ().value ());
+  programPaths (preference, updates);
 
-    if (executeAndWait (req, "ip_route_add_del"))
-      {
-        auto &reply = req.get_response ();
-        auto &rp = reply.get_payload ();
-        if (rp.retval != 0)
-          {
-            LOG (FATAL) << "ip_route_add_del returned error: " << rp.retval;
-          }
-      }
-  };
+  if (error)
+    std::rethrow_exception (error);
+}
 
-  // Delete old nexthops first
-  for (const auto &oldNextHop : oldNextHops)
+VppClient::PathUpdate VppClient::makePathUpdate (
+    uint8_t preference, const thrift::IpPrefix &prefix,
+    const thrift::NextHopThrift &nextHop, bool isAdd)
+{
+  LOG (INFO) << (isAdd ? "Adding" : "Deleting") << " path for "
+             << toString (prefix) << " with preference "
+             << static_cast<int> (preference) << " " << toString (nextHop);
+
+  const auto &addr =
+      prefix.prefixAddress_ref ().value ().addr_ref ().value ();
+  PathUpdate update;
+  update.isAdd = isAdd;
+  update.prefix = prefix;
+  update.nextHopAddr =
+      nextHop.address_ref ().value ().addr_ref ().value ().substr (
+          0, addr.size ());
+  update.swIfIndex = ~0;
+  update.weight = static_cast<uint8_t> (nextHop.weight_ref ().value ());
+
+  if (nextHop.address_ref ().value ().ifName_ref ().has_value ())
     {
-      auto it =
-          std::find (newNextHops.begin (), newNextHops.end (), oldNextHop);
-      if (it != newNextHops.end ())
+      const std::string &ifName =
+          nextHop.address_ref ().value ().ifName_ref ().value ();
+
+      // If it's a POP wired route - program the POP's VPP loopback
+      // link-local next-hop instead of tap's link-local. Routing will break
+      // otherwise.
+      if (ifName == FLAGS_pop_tap)
         {
-          // nexthop should remain programmed - skip removing
-          continue;
+          auto nextHopTap =
+              folly::IPAddress::fromBinary (
+                  folly::ByteRange (reinterpret_cast<const unsigned char *> (
+                                        nextHop.address_ref ()
+                                            .value ()
+                                            .addr_ref ()
+                                            .value ()
+                                            .data ()),
+                                    IPV6_ADDR_SZ))
+                  .str ();
+          std::string nextHopVppStr = getVppLoopbackLinkLocalAddr (nextHopTap);
+          folly::IPAddress nextHopVpp = folly::IPAddress (nextHopVppStr);
+
+          LOG (INFO) << "POP route '" << nextHopTap
+                     << "' changed to VPP loop1 '" << nextHopVppStr << "'.";
+          update.nextHopAddr = std::string (
+              reinterpret_cast<const char *> (nextHopVpp.bytes ()),
+              addr.size ());
         }
 
-      addDelNextHop (oldNextHop, false);
+      update.swIfIndex = ifaceToVppIndex (ifName);
     }
 
-  // Add new nexthops
-  for (const auto &newNextHop : newNextHops)
+  return update;
+}
+
+void VppClient::programPaths (uint8_t preference,
+                              const std::vector<PathUpdate> &updates)
+{
+  if (!connected_ || updates.empty ())
+    return;
+
+  // Bound the window by the response queue as well, so that vpp never has to
+  // wait for room to post a reply
+  size_t window = std::min (maxOutstandingRequests_, responseQueueSize_);
+  VapiPipeline<Connection, Ip_route_add_del> pipeline (
+      connection_, window, "ip_route_add_del", [] (Ip_route_add_del &req) {
+        auto &rp = req.get_response ().get_payload ();
+        if (rp.retval != 0)
+          {
+            LOG (FATAL) << "ip_route_add_del returned error: " << rp.retval;
+          }
+      });
+
+  for (const auto &update : updates)
     {
-      auto it =
-          std::find (oldNextHops.begin (), oldNextHops.end (), newNextHop);
-      if (it != oldNextHops.end ())
+      auto req = std::make_unique<Ip_route_add_del> (
+          connection_, 1 /* route_paths_array_size */);
+      auto &p = req->get_request ().get_payload ();
+      memset (&p, 0, sizeof (p));
+      p.is_add = update.isAdd;
+      p.is_multipath = true;
+      p.route.n_paths = 1;
+      p.route.prefix.len = update.prefix.prefixLength_ref ().value ();
+      const auto &addr =
+          update.prefix.prefixAddress_ref ().value ().addr_ref ().value ();
+      bool is_ipv6 = addr.size () == IPV6_ADDR_SZ;
+      if (is_ipv6)
         {
-          // next already programmed - skip adding again
-          continue;
+          p.route.prefix.address.af = ADDRESS_IP6;
+          memcpy (p.route.prefix.address.un.ip6, addr.data (), addr.size ());
+
+          p.route.paths[0].proto = FIB_API_PATH_NH_PROTO_IP6;
+          memcpy (p.route.paths[0].nh.address.ip6, update.nextHopAddr.data (),
+                  update.nextHopAddr.size ());
         }
+      else
+        {
+          p.route.prefix.address.af = ADDRESS_IP4;
+          memcpy (p.route.prefix.address.un.ip4, addr.data (), addr.size ());
 
-      addDelNextHop (newNextHop, true);
-    }
+          p.route.paths[0].proto = FIB_API_PATH_NH_PROTO_IP4;
+          memcpy (p.route.paths[0].nh.address.ip4, update.nextHopAddr.data (),
+                  update.nextHopAddr.size ());
+        }
+      p.route.paths[0].preference = preference;
+      p.route.paths[0].sw_if_index = update.swIfIndex;
+      p.route.paths[0].weight = update.weight;
 
-  // Update local cache
-  if (newNextHops.size ())
-    {
-      unicastRoutes_[preference][route.dest_ref ().value ()] = newNextHops;
-    }
-  else
-    {
-      unicastRoutes_[preference].erase (route.dest_ref ().value ());
+      pipeline.submit (std::move (req));
     }
+
+  pipeline.drain ();
 }
 
 void VppClient::deleteRoute (uint8_t preference,
                              const thrift::IpPrefix &prefix)
 {
-  // Ensure thread safety
-  evb_->checkIsInEventBaseThread ();
+  deleteRoutes (preference, {prefix});
+}
 
-  // add route with empty nexthops to remove all existing paths
-  thrift::UnicastRoute route;
-  route.dest_ref () = prefix;
-  addRoute (preference, route);
+void VppClient::deleteRoutes (uint8_t preference,
+                              const std::vector<thrift::IpPrefix> &prefixes)
+{
+  // add routes with empty nexthops to remove all existing paths
+  std::vector<thrift::UnicastRoute> routes;
+  for (const auto &prefix : prefixes)
+    {
+      thrift::UnicastRoute route;
+      route.dest_ref () = prefix;
+      routes.emplace_back (std::move (route));
+    }
+  addRoutes (preference, routes);
 }
 
 void VppClient::getCounters (std::map<std::string, int64_t> &counters)
@@ -436,9 +526,6 @@ void VppClient::sendKeepAlive ()
 template <class T>
 bool VppClient::executeAndWait (T &req, const std::string &apiName)
 {
-  // XXX: Convert this to process list of requests at a time to speed up
-  // the performance.
-
   // Ensure thread safety
   evb_->checkIsInEventBaseThread ();
 
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <optional>
+#include <unordered_set>
 
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
@@ -54,6 +55,18 @@ namespace openr
  * preference, to ensure the clients don't mess-up with each other's route in
  * HW.
  *
+ * > Note on Pipelining
+ * Route updates are sent to VPP through a VapiPipeline, which keeps a window
+ * of `ip_route_add_del` requests outstanding instead of waiting for the reply
+ * to each path before sending the next one. Batch APIs (`addRoutes`,
+ * `deleteRoutes`, `syncRoutes`) pipeline the paths of all their routes.
+ *
+ * > Note on Shadow FIB
+ * The route cache mirrors what this client programmed in VPP. The first
+ * `syncRoutes` for a preference seeds the cache from VPP's table (e.g. routes
+ * left over from a previous run); later syncs only program the difference
+ * between the cache and the new routes, without dumping VPP's table.
+ *
  * > Note on MPLS Support
  * Current implementation doesn't support MPLS, but VPP do support. For adding
  * MPLS support, we will need to support two things. 1) IP->MPLS routes and 2)
@@ -95,8 +108,14 @@ public:
 
   void addRoute (uint8_t preference, const openr::thrift::UnicastRoute &route);
 
+  void addRoutes (uint8_t preference,
+                  const std::vector<openr::thrift::UnicastRoute> &routes);
+
   void deleteRoute (uint8_t preference, const openr::thrift::IpPrefix &prefix);
 
+  void deleteRoutes (uint8_t preference,
+                     const std::vector<openr::thrift::IpPrefix> &prefixes);
+
   void syncRoutes (uint8_t preference,
                    const std::vector<openr::thrift::UnicastRoute> &routes);
 
@@ -114,6 +133,28 @@ public:
   std::string getVppLoopbackLinkLocalAddr (const std::string &tapLLV6);
 
 private:
+  // A single path to add to or delete from a route in VPP
+  struct PathUpdate
+  {
+    bool isAdd;
+    thrift::IpPrefix prefix;
+    // Binary next-hop address to program
+    std::string nextHopAddr;
+    uint32_t swIfIndex;
+    uint8_t weight;
+  };
+
+  // Build the update for a single path of a route, resolving its interface.
+  // Throws if the interface is unknown.
+  PathUpdate makePathUpdate (uint8_t preference,
+                             const thrift::IpPrefix &prefix,
+                             const thrift::NextHopThrift &nextHop, bool isAdd);
+
+  // Program the given path updates in order, keeping a window of requests
+  // outstanding
+  void programPaths (uint8_t preference,
+                     const std::vector<PathUpdate> &updates);
+
   void sendKeepAlive ();
 
   // Update interface name <-> index mappings
@@ -163,6 +204,9 @@ private:
       uint8_t /* preference aka clientId */,
       std::unordered_map<thrift::IpPrefix, std::vector<thrift::NextHopThrift>>>
       unicastRoutes_;
+
+  // Preferences whose route cache has been seeded from VPP's table
+  std::unordered_set<uint8_t> syncedPreferences_;
 };
 
 } // namespace openr
@@ -126,25 +126,25 @@ folly::Future<folly::Unit> VppFibHandler::future_addUnicastRoutes (
       return future;
     }
 
-  // Run all route updates in a single eventloop
+  // Run all route updates in a single eventloop, pipelined into vpp
   evb_->runInEventBaseThread ([this, preference = preference.value (),
                                promise = std::move (promise),
                                routes = std::move (routes)]() mutable {
-    for (auto &route : *routes)
+    try
       {
-        try
+        for (auto &route : *routes)
           {
             LOG (INFO) << "Updating route for prefix "
                        << toString (route.dest_ref ().value ()) << " with "
                        << route.nextHops_ref ().value ().size ()
                        << " nexthops";
-            vppClient_->addRoute (preference, route);
-          }
-        catch (std::exception const &e)
-          {
-            promise.setException (e);
-            return;
           }
+        vppClient_->addRoutes (preference, *routes);
+      }
+    catch (std::exception const &e)
+      {
+        promise.setException (e);
+        return;
       }
     promise.setValue ();
   });
@@ -168,18 +168,18 @@ folly::Future<folly::Unit> VppFibHandler::future_deleteUnicastRoutes (
   evb_->runInEventBaseThread ([this, preference = preference.value (),
                                promise = std::move (promise),
                                prefixes = std::move (prefixes)]() mutable {
-    for (auto &prefix : *prefixes)
+    try
       {
-        try
+        for (auto &prefix : *prefixes)
           {
             LOG (INFO) << "Deleting route for prefix " << toString (prefix);
-            vppClient_->deleteRoute (preference, prefix);
-          }
-        catch (std::exception const &e)
-          {
-            promise.setException (e);
-            return;
           }
+        vppClient_->deleteRoutes (preference, *prefixes);
+      }
+    catch (std::exception const &e)
+      {
+        promise.setException (e);
+        return;
       }
     promise.setValue ();
   });
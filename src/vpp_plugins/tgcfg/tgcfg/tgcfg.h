@@ -92,6 +92,9 @@ typedef struct
   int (*dynfield_lookup) (const char *name, struct rte_mbuf_dynfield *params);
   /* links */
   tgcfg_link_t *terra_links;
+  /* tg_sw_if_index of each link, packed for tg-link-input, with one extra
+   * trailing ~0 entry that out-of-range link ids are clamped to */
+  u32 *link_tg_sw_if_index;
   /* wigig info */
   tgcfg_wdev_t *wigig_devs;
   /* wired */
@@ -484,6 +484,8 @@ int tg_interface_enable (tgcfg_main_t *tm, u32 sw_if_index,
       vec_validate_init_empty (tm->terra_links,
                                RTE_WIGIG_MAX_PORTS * RTE_WIGIG_MAX_LINKS,
                                TG_LINK_INVALID);
+      vec_validate_init_empty (tm->link_tg_sw_if_index,
+                               vec_len (tm->terra_links), ~0u);
     }
 
   /* Create link interfaces */
@@ -526,6 +528,7 @@ int tg_interface_enable (tgcfg_main_t *tm, u32 sw_if_index,
       tl->bb_sw_if_index = sw_if_index;
       tl->tg_sw_if_index = thw->sw_if_index;
       tl->tg_peer_id = li->if_peer_id;
+      tm->link_tg_sw_if_index[li->if_nameunit] = thw->sw_if_index;
 
       if (enable_slowpath)
         {
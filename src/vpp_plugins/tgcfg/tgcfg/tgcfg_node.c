@@ -72,314 +72,233 @@ typedef enum
   TG_LINK_INPUT_N_NEXT,
 } tg_link_input_next_t;
 
+STATIC_ASSERT (TG_LINK_INPUT_NEXT_ETHERNET_INPUT == 0 &&
+                   TG_LINK_INPUT_NEXT_DROP == 1,
+               "next index is computed from the drop decision");
+
+/* Pointer to the link id dynfield of the mbuf behind a buffer */
+#define tg_link_input_link_id_ptr(b)                                      \
+  RTE_MBUF_DYNFIELD (rte_mbuf_from_vlib_buffer (b),                       \
+                     wigig_link_id_dynfield_offset, void *)
+
+/* Add a packet to the batched RX counters of its vpp-terra interface,
+ * flushing the batch when the interface changes */
+static_always_inline void
+tg_link_input_count (vlib_combined_counter_main_t *ccm, u32 thread_index,
+                     u32 tg_sw_if_index, u32 len, u32 *stats_sw_if_index,
+                     u32 *stats_n_packets, u32 *stats_n_bytes)
+{
+  if (PREDICT_FALSE (tg_sw_if_index == ~0))
+    return;
+
+  if (PREDICT_FALSE (tg_sw_if_index != *stats_sw_if_index))
+    {
+      if (*stats_n_packets > 0)
+        vlib_increment_combined_counter (ccm, thread_index, *stats_sw_if_index,
+                                         *stats_n_packets, *stats_n_bytes);
+      *stats_sw_if_index = tg_sw_if_index;
+      *stats_n_packets = *stats_n_bytes = 0;
+    }
+
+  *stats_n_packets += 1;
+  *stats_n_bytes += len;
+}
+
+static_always_inline void
+tg_link_input_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
+                     vlib_buffer_t **b, const u32 *lookup, u32 max_link,
+                     u32 n_left)
+{
+  while (n_left > 0)
+    {
+      if (b[0]->flags & VLIB_BUFFER_IS_TRACED)
+        {
+          u16 l0 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[0]));
+          tg_link_input_trace_t *t =
+              vlib_add_trace (vm, node, b[0], sizeof (*t));
+          t->bb_sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
+          t->tg_sw_if_index = lookup[clib_min (l0, max_link)];
+          t->next_index = t->tg_sw_if_index == ~0
+                              ? TG_LINK_INPUT_NEXT_DROP
+                              : TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
+        }
+      b++;
+      n_left--;
+    }
+}
+
 VLIB_NODE_FN (tg_link_input_node)
 (vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
 {
   vnet_main_t *vnm = vnet_get_main ();
-  tgcfg_main_t *tm;
+  tgcfg_main_t *tm = &tgcfg_main;
+  vlib_combined_counter_main_t *ccm =
+      vnm->interface_main.combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX;
   u32 thread_index = vm->thread_index;
-  u32 n_left_from, *from, *to_next;
-  tg_link_input_next_t next_index;
-  u32 packets_ok = 0, packets_dropped = 0;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 tg_sw_if_indices[VLIB_FRAME_SIZE], *tg = tg_sw_if_indices;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 n_left, *from;
+  u32 packets_dropped = 0;
   u32 stats_sw_if_index = node->runtime_data[0], stats_n_packets = 0,
       stats_n_bytes = 0;
+  /* Link ids past the last link map to the trailing ~0 entry */
+  const u32 *lookup = tm->link_tg_sw_if_index;
+  u32 max_link = vec_len (lookup) - 1;
+
+  ASSERT (vec_len (lookup) > 0);
 
   from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
 
-  tm = &tgcfg_main;
+  /* Trace before the RX interfaces are rewritten */
+  if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+    tg_link_input_trace (vm, node, bufs, lookup, max_link, n_left);
 
-  while (n_left_from > 0)
+  while (n_left >= 4)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      u16 l0, l1, l2, l3;
+      u32 len0, len1, len2, len3;
+      int all_valid, all_batched;
 
-      while (n_left_from >= 4 && n_left_to_next >= 2)
+      /* Prefetch next iteration. */
+      if (PREDICT_TRUE (n_left >= 8))
         {
-          u32 next0 = TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
-          u32 next1 = TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
-          u32 bb_sw_if_index0, bb_sw_if_index1;
-          u32 tg_sw_if_index0, tg_sw_if_index1;
-          u32 len0, len1;
-          u32 bi0, bi1, l0, l1;
-          vlib_buffer_t *b0, *b1;
-          struct rte_mbuf *m0, *m1;
-
-          /* Prefetch next iteration. */
-          {
-            vlib_buffer_t *p2, *p3;
-
-            p2 = vlib_get_buffer (vm, from[2]);
-            p3 = vlib_get_buffer (vm, from[3]);
-
-            vlib_prefetch_buffer_header (p2, LOAD);
-            vlib_prefetch_buffer_header (p3, LOAD);
-
-            CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
-            CLIB_PREFETCH (p3->data, CLIB_CACHE_LINE_BYTES, STORE);
-          }
-
-          /* speculatively enqueue b0 and b1 to the current next frame */
-          to_next[0] = bi0 = from[0];
-          to_next[1] = bi1 = from[1];
-          from += 2;
-          to_next += 2;
-          n_left_from -= 2;
-          n_left_to_next -= 2;
-
-          b0 = vlib_get_buffer (vm, bi0);
-          b1 = vlib_get_buffer (vm, bi1);
-
-          m0 = rte_mbuf_from_vlib_buffer (b0);
-          m1 = rte_mbuf_from_vlib_buffer (b1);
-
-          l0 = wigig_mbuf_link_id_get (m0);
-          l1 = wigig_mbuf_link_id_get (m1);
-
-          bb_sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-          bb_sw_if_index1 = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-
-          if (PREDICT_TRUE (l0 < vec_len (tm->terra_links)))
-            {
-              tgcfg_link_t *li;
-
-              li = vec_elt_at_index (tm->terra_links, l0);
-              tg_sw_if_index0 = li->tg_sw_if_index;
-              if (PREDICT_TRUE (tg_sw_if_index0 != ~0))
-                {
-                  vnet_buffer (b0)->sw_if_index[VLIB_RX] = tg_sw_if_index0;
-                  packets_ok++;
-                }
-              else
-                {
-                  packets_dropped++;
-                  next0 = TG_LINK_INPUT_NEXT_DROP;
-                }
-            }
-          else
-            {
-              tg_sw_if_index0 = ~0;
-              packets_dropped++;
-              next0 = TG_LINK_INPUT_NEXT_DROP;
-            }
-
-          if (PREDICT_TRUE (l1 < vec_len (tm->terra_links)))
-            {
-              tgcfg_link_t *li;
-
-              li = vec_elt_at_index (tm->terra_links, l1);
-              tg_sw_if_index1 = li->tg_sw_if_index;
-              if (PREDICT_TRUE (tg_sw_if_index1 != ~0))
-                {
-                  vnet_buffer (b1)->sw_if_index[VLIB_RX] = tg_sw_if_index1;
-                  packets_ok++;
-                }
-              else
-                {
-                  packets_dropped++;
-                  next1 = TG_LINK_INPUT_NEXT_DROP;
-                }
-            }
-          else
-            {
-              tg_sw_if_index1 = ~0;
-              packets_dropped++;
-              next1 = TG_LINK_INPUT_NEXT_DROP;
-            }
+          vlib_prefetch_buffer_header (b[4], STORE);
+          vlib_prefetch_buffer_header (b[5], STORE);
+          vlib_prefetch_buffer_header (b[6], STORE);
+          vlib_prefetch_buffer_header (b[7], STORE);
+
+          CLIB_PREFETCH (tg_link_input_link_id_ptr (b[4]), sizeof (u16), LOAD);
+          CLIB_PREFETCH (tg_link_input_link_id_ptr (b[5]), sizeof (u16), LOAD);
+          CLIB_PREFETCH (tg_link_input_link_id_ptr (b[6]), sizeof (u16), LOAD);
+          CLIB_PREFETCH (tg_link_input_link_id_ptr (b[7]), sizeof (u16), LOAD);
+        }
 
-          /* Increment stats for individual vpp-terra interfaces */
-          if (PREDICT_TRUE (tg_sw_if_index0 != ~0 || tg_sw_if_index1 != ~0))
-            {
-              /* Batch stat increments from the same vpp-terra interface so
-               * counters don't need to be incremented for every packet. */
-              len0 = b0->current_length;
-              len1 = b1->current_length;
+      l0 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[0]));
+      l1 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[1]));
+      l2 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[2]));
+      l3 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[3]));
 
-              stats_n_packets += 2;
-              stats_n_bytes += len0 + len1;
+      tg[0] = lookup[clib_min (l0, max_link)];
+      tg[1] = lookup[clib_min (l1, max_link)];
+      tg[2] = lookup[clib_min (l2, max_link)];
+      tg[3] = lookup[clib_min (l3, max_link)];
 
-              if (tg_sw_if_index0 != stats_sw_if_index ||
-                  tg_sw_if_index1 != stats_sw_if_index)
-                {
-                  stats_n_packets -= 2;
-                  stats_n_bytes -= len0 + len1;
-
-                  if (PREDICT_TRUE (tg_sw_if_index0 != ~0))
-                    vlib_increment_combined_counter (
-                        vnm->interface_main.combined_sw_if_counters +
-                            VNET_INTERFACE_COUNTER_RX,
-                        thread_index, tg_sw_if_index0, 1, len0);
-
-                  if (PREDICT_TRUE (tg_sw_if_index1 != ~0))
-                    vlib_increment_combined_counter (
-                        vnm->interface_main.combined_sw_if_counters +
-                            VNET_INTERFACE_COUNTER_RX,
-                        thread_index, tg_sw_if_index1, 1, len1);
-
-                  if (tg_sw_if_index0 == tg_sw_if_index1)
-                    {
-                      /* Increment counters for currently batched interface and
-                       * start batching for new interface. */
-                      if (stats_n_packets > 0)
-                        {
-                          vlib_increment_combined_counter (
-                              vnm->interface_main.combined_sw_if_counters +
-                                  VNET_INTERFACE_COUNTER_RX,
-                              thread_index, stats_sw_if_index, stats_n_packets,
-                              stats_n_bytes);
-                          stats_n_packets = stats_n_bytes = 0;
-                        }
-                      stats_sw_if_index = tg_sw_if_index0;
-                    }
-                }
-            }
+      len0 = b[0]->current_length;
+      len1 = b[1]->current_length;
+      len2 = b[2]->current_length;
+      len3 = b[3]->current_length;
 
-          if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)))
-            {
-              if (b0->flags & VLIB_BUFFER_IS_TRACED)
-                {
-                  tg_link_input_trace_t *t =
-                      vlib_add_trace (vm, node, b0, sizeof (*t));
-                  t->bb_sw_if_index = bb_sw_if_index0;
-                  t->tg_sw_if_index = tg_sw_if_index0;
-                  t->next_index = next0;
-                }
-              if (b1->flags & VLIB_BUFFER_IS_TRACED)
-                {
-                  tg_link_input_trace_t *t =
-                      vlib_add_trace (vm, node, b1, sizeof (*t));
-                  t->bb_sw_if_index = bb_sw_if_index1;
-                  t->tg_sw_if_index = tg_sw_if_index1;
-                  t->next_index = next1;
-                }
-            }
-
-          /* verify speculative enqueues, maybe switch current next frame */
-          vlib_validate_buffer_enqueue_x2 (vm, node, next_index, to_next,
-                                           n_left_to_next, bi0, bi1, next0,
-                                           next1);
+#ifdef CLIB_HAVE_VEC128
+      {
+        u32x4 tgv = u32x4_load_unaligned (tg);
+        all_valid = u32x4_is_all_zero ((u32x4) (tgv == u32x4_splat (~0)));
+        all_batched =
+            all_valid && u32x4_is_all_equal (tgv, stats_sw_if_index);
+      }
+#else
+      all_valid = (tg[0] != ~0) & (tg[1] != ~0) & (tg[2] != ~0) &
+                  (tg[3] != ~0);
+      all_batched = all_valid & (tg[0] == stats_sw_if_index) &
+                    (tg[1] == stats_sw_if_index) &
+                    (tg[2] == stats_sw_if_index) &
+                    (tg[3] == stats_sw_if_index);
+#endif
+
+      if (PREDICT_TRUE (all_valid))
+        {
+          vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tg[0];
+          vnet_buffer (b[1])->sw_if_index[VLIB_RX] = tg[1];
+          vnet_buffer (b[2])->sw_if_index[VLIB_RX] = tg[2];
+          vnet_buffer (b[3])->sw_if_index[VLIB_RX] = tg[3];
+          next[0] = next[1] = next[2] = next[3] =
+              TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
         }
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      else
         {
-          u32 bi0;
-          u32 l0;
-          vlib_buffer_t *b0;
-          u32 next0 = TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
-          u32 bb_sw_if_index0;
-          u32 tg_sw_if_index0;
-          u32 len0;
-          struct rte_mbuf *m0;
-
-          /* speculatively enqueue b0 to the current next frame */
-          bi0 = from[0];
-          to_next[0] = bi0;
-          from += 1;
-          to_next += 1;
-          n_left_from -= 1;
-          n_left_to_next -= 1;
-
-          b0 = vlib_get_buffer (vm, bi0);
-
-          m0 = rte_mbuf_from_vlib_buffer (b0);
-
-          l0 = wigig_mbuf_link_id_get (m0);
-
-          bb_sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-
-          if (PREDICT_TRUE (l0 < vec_len (tm->terra_links)))
+          /* Dropped packets keep their BB interface for error accounting */
+          int i;
+          for (i = 0; i < 4; i++)
             {
-              tgcfg_link_t *li;
-
-              li = vec_elt_at_index (tm->terra_links, l0);
-              tg_sw_if_index0 = li->tg_sw_if_index;
-              if (PREDICT_TRUE (tg_sw_if_index0 != ~0))
-                {
-                  vnet_buffer (b0)->sw_if_index[VLIB_RX] = tg_sw_if_index0;
-                  packets_ok++;
-                }
-              else
-                {
-                  packets_dropped++;
-                  next0 = TG_LINK_INPUT_NEXT_DROP;
-                }
+              next[i] = tg[i] == ~0;
+              if (tg[i] != ~0)
+                vnet_buffer (b[i])->sw_if_index[VLIB_RX] = tg[i];
             }
-          else
-            {
-              tg_sw_if_index0 = ~0;
-              packets_dropped++;
-              next0 = TG_LINK_INPUT_NEXT_DROP;
-            }
-
-          /* Increment stats for individual vpp-terra interfaces */
-          if (PREDICT_TRUE (tg_sw_if_index0 != ~0))
-            {
-              /* Batch stat increments from the same vpp-terra interface so
-               * counters don't need to be incremented for every packet. */
-              len0 = b0->current_length;
+          packets_dropped += next[0] + next[1] + next[2] + next[3];
+        }
 
-              stats_n_packets += 1;
-              stats_n_bytes += len0;
+      /* Increment stats for individual vpp-terra interfaces, batching
+       * consecutive packets from the same interface. */
+      if (PREDICT_TRUE (all_batched))
+        {
+          stats_n_packets += 4;
+          stats_n_bytes += len0 + len1 + len2 + len3;
+        }
+      else
+        {
+          tg_link_input_count (ccm, thread_index, tg[0], len0,
+                               &stats_sw_if_index, &stats_n_packets,
+                               &stats_n_bytes);
+          tg_link_input_count (ccm, thread_index, tg[1], len1,
+                               &stats_sw_if_index, &stats_n_packets,
+                               &stats_n_bytes);
+          tg_link_input_count (ccm, thread_index, tg[2], len2,
+                               &stats_sw_if_index, &stats_n_packets,
+                               &stats_n_bytes);
+          tg_link_input_count (ccm, thread_index, tg[3], len3,
+                               &stats_sw_if_index, &stats_n_packets,
+                               &stats_n_bytes);
+        }
 
-              if (tg_sw_if_index0 != stats_sw_if_index)
-                {
-                  stats_n_packets -= 1;
-                  stats_n_bytes -= len0;
-
-                  vlib_increment_combined_counter (
-                      vnm->interface_main.combined_sw_if_counters +
-                          VNET_INTERFACE_COUNTER_RX,
-                      thread_index, tg_sw_if_index0, 1, len0);
-
-                  /* Increment counters for currently batched interface and
-                   * start batching for new interface. */
-                  if (stats_n_packets > 0)
-                    {
-                      vlib_increment_combined_counter (
-                          vnm->interface_main.combined_sw_if_counters +
-                              VNET_INTERFACE_COUNTER_RX,
-                          thread_index, stats_sw_if_index, stats_n_packets,
-                          stats_n_bytes);
-                      stats_n_packets = stats_n_bytes = 0;
-                    }
-                  stats_sw_if_index = tg_sw_if_index0;
-                }
-            }
+      b += 4;
+      tg += 4;
+      next += 4;
+      n_left -= 4;
+    }
 
-          if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
-                             (b0->flags & VLIB_BUFFER_IS_TRACED)))
-            {
-              tg_link_input_trace_t *t =
-                  vlib_add_trace (vm, node, b0, sizeof (*t));
-              t->bb_sw_if_index = bb_sw_if_index0;
-              t->tg_sw_if_index = tg_sw_if_index0;
-              t->next_index = next0;
-            }
+  while (n_left > 0)
+    {
+      u16 l0 = wigig_mbuf_link_id_get (rte_mbuf_from_vlib_buffer (b[0]));
 
-          /* verify speculative enqueue, maybe switch current next frame */
-          vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
-                                           n_left_to_next, bi0, next0);
+      tg[0] = lookup[clib_min (l0, max_link)];
+      if (PREDICT_TRUE (tg[0] != ~0))
+        {
+          vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tg[0];
+          next[0] = TG_LINK_INPUT_NEXT_ETHERNET_INPUT;
+        }
+      else
+        {
+          next[0] = TG_LINK_INPUT_NEXT_DROP;
+          packets_dropped++;
         }
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      tg_link_input_count (ccm, thread_index, tg[0], b[0]->current_length,
+                           &stats_sw_if_index, &stats_n_packets,
+                           &stats_n_bytes);
+
+      b += 1;
+      tg += 1;
+      next += 1;
+      n_left -= 1;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   /* Increment any remaining batched stats */
   if (stats_n_packets > 0)
     {
-      vlib_increment_combined_counter (
-          vnm->interface_main.combined_sw_if_counters +
-              VNET_INTERFACE_COUNTER_RX,
-          thread_index, stats_sw_if_index, stats_n_packets, stats_n_bytes);
+      vlib_increment_combined_counter (ccm, thread_index, stats_sw_if_index,
+                                       stats_n_packets, stats_n_bytes);
       node->runtime_data[0] = stats_sw_if_index;
     }
 
   vlib_node_increment_counter (vm, node->node_index,
                                TG_LINK_INPUT_ERROR_DROPPED, packets_dropped);
   vlib_node_increment_counter (vm, node->node_index,
-                               TG_LINK_INPUT_ERROR_FORWARDED, packets_ok);
+                               TG_LINK_INPUT_ERROR_FORWARDED,
+                               frame->n_vectors - packets_dropped);
   return frame->n_vectors;
 }
 